@@ -17,10 +17,25 @@
 #include "ballistics/ballistics.h"
 
 #include <math.h>
+#include <stdlib.h>
 
-// Used to determine bore angle
-double zero_angle(DragFunction drag_function, double drag_coefficient, double vi, double sight_height, double zero_range,
-                  double y_intercept) {
+// Evaluates a drag model's retardation at velocity v, for zero_angle_drag().
+typedef double (*ZeroDrag)(const void* model, double drag_coefficient, double v);
+
+static double zero_drag_standard(const void* model, double drag_coefficient, double v) {
+  return retard(*(const DragFunction*)model, drag_coefficient, v);
+}
+
+static double zero_drag_table(const void* model, double drag_coefficient, double v) {
+  return retard_table((const DragTable*)model, drag_coefficient, v);
+}
+
+/**
+ * Determines the bore angle, with drag evaluating the model's retardation, so zero_angle() and zero_angle_table()
+ * share one integration.  Inlined with a constant drag, so each model gets a loop of its own.
+ */
+static inline double zero_angle_drag(ZeroDrag drag, const void* model, double drag_coefficient, double vi,
+                                     double sight_height, double zero_range, double y_intercept) {
 
   // Numerical Integration variables
   double t=0;
@@ -36,12 +51,15 @@ double zero_angle(DragFunction drag_function, double drag_coefficient, double vi
   double Gx=0, Gy=0; // Gravitational acceleration
 
   double angle=0; // The actual angle of the bore.
+  double y_zero=y_intercept/12; // The intercept is in inches; y is in feet.
 
   int quit=0; // We know it's time to quit our successive approximation loop when this is 1.
 
   // Start with a very coarse angular change, to quickly solve even large launch angle problems.
   da= deg_to_rad(14);
 
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_ZERO);
+
 
   // The general idea here is to start at 0 degrees elevation, and increase the elevation by 14 degrees
   // until we are above the correct elevation.  Then reduce the angular change by half, and begin reducing
@@ -53,14 +71,16 @@ double zero_angle(DragFunction drag_function, double drag_coefficient, double vi
     vx=vi*cos(angle);
     Gx=GRAVITY*sin(angle);
     Gy=GRAVITY*cos(angle);
+    BALLISTICS_STATS_ITERATION();
 
     for (t=0,x=0,y=-sight_height/12;x<=zero_range*3;t=t+dt) {
       vy1=vy;
       vx1=vx;
-      v=pow((pow(vx,2)+pow(vy,2)),0.5);
+      v=BALLISTICS_SPEED(vx,vy);
       dt=1/v;
+      BALLISTICS_STATS_STEP();
 
-      dv = retard(drag_function, drag_coefficient, v);
+      dv = drag(model, drag_coefficient, v);
       dvy = -dv*vy/v*dt;
       dvx = -dv*vx/v*dt;
 
@@ -72,7 +92,7 @@ double zero_angle(DragFunction drag_function, double drag_coefficient, double vi
       x=x+dt*(vx+vx1)/2;
       y=y+dt*(vy+vy1)/2;
       // Break early to save CPU time if we won't find a solution.
-      if (vy<0 && y<y_intercept) {
+      if (vy<0 && y<y_zero) {
         break;
       }
       if (vy>3*vx) {
@@ -80,11 +100,11 @@ double zero_angle(DragFunction drag_function, double drag_coefficient, double vi
       }
     }
 
-    if (y>y_intercept && da>0) {
+    if (y>y_zero && da>0) {
       da=-da/2;
     }
 
-    if (y<y_intercept && da<0) {
+    if (y<y_zero && da<0) {
       da=-da/2;
     }
 
@@ -92,5 +112,203 @@ double zero_angle(DragFunction drag_function, double drag_coefficient, double vi
     if (angle > deg_to_rad(45)) quit=1; // If we exceed the 45 degree launch angle, then the projectile just won't get there, so we stop trying.
   }
 
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_ZERO);
   return rad_to_deg(angle); // Convert to degrees for return value.
-}
\ No newline at end of file
+}
+
+// Used to determine bore angle
+double zero_angle(DragFunction drag_function, double drag_coefficient, double vi, double sight_height, double zero_range,
+                  double y_intercept) {
+  return zero_angle_drag(zero_drag_standard, &drag_function, drag_coefficient, vi, sight_height, zero_range,
+                         y_intercept);
+}
+
+// Used to determine bore angle with a custom drag table
+double zero_angle_table(const DragTable* table, double drag_coefficient, double vi, double sight_height,
+                        double zero_range, double y_intercept) {
+  return zero_angle_drag(zero_drag_table, table, drag_coefficient, vi, sight_height, zero_range, y_intercept);
+}
+
+// The number of reference trajectories shared by every entry of a zero_angles() table.
+#define ZERO_REFERENCES 3
+
+// The embedded profile solves zero_angles() tables on the stack, so bounds their length.
+#define ZERO_ANGLES_EMBEDDED_MAX 32
+
+/**
+ * One entry of a zero_angles() table, kept in range order so each reference trajectory can be read out in a
+ * single merge-walk.
+ */
+typedef struct {
+  double x;          // zero range, in feet
+  double y;          // intercept, in feet
+  double angle;      // current estimate of the bore angle, in radians
+  double heights[ZERO_REFERENCES]; // height at x on each reference trajectory, in feet
+  int index;         // position in the caller's arrays
+} ZeroEntry;
+
+static int ZeroEntry_compare(const void* a, const void* b) {
+  double xa = ((const ZeroEntry*)a)->x;
+  double xb = ((const ZeroEntry*)b)->x;
+  return (xa > xb) - (xa < xb);
+}
+
+/**
+ * Integrates one trajectory at the given bore angle, using the same integration as zero_angle(), and stores
+ * the height at every entry's range into heights[reference].
+ * @return the number of entries reached
+ */
+static int zero_reference(ZeroEntry* entries, int count, int reference, double angle, DragFunction drag_function,
+                          double drag_coefficient, double vi, double sight_height) {
+  double t=0, dt=0;
+  double v=0, vx=vi*cos(angle), vy=vi*sin(angle);
+  double vx1=0, vy1=0;
+  double dv=0, dvx=0, dvy=0;
+  double x=0, y=-sight_height/12;
+  double x1=0, y1=0;
+  double Gx=GRAVITY*sin(angle);
+  double Gy=GRAVITY*cos(angle);
+  int k=0;
+
+  BALLISTICS_STATS_ITERATION();
+  for (; k<count && entries[k].x<=0; k++) {
+    entries[k].heights[reference]=y;
+  }
+
+  for (t=0;k<count;t=t+dt) {
+    vy1=vy;
+    vx1=vx;
+    v=BALLISTICS_SPEED(vx,vy);
+    dt=1/v;
+    BALLISTICS_STATS_STEP();
+
+    dv = retard(drag_function, drag_coefficient, v);
+    dvy = -dv*vy/v*dt;
+    dvx = -dv*vx/v*dt;
+
+    vx=vx+dvx;
+    vy=vy+dvy;
+    vy=vy+dt*Gy;
+    vx=vx+dt*Gx;
+
+    x1=x;
+    y1=y;
+    x=x+dt*(vx+vx1)/2;
+    y=y+dt*(vy+vy1)/2;
+
+    for (; k<count && entries[k].x<=x; k++) {
+      entries[k].heights[reference]=y1+(entries[k].x-x1)/(x-x1)*(y-y1);
+    }
+
+    // Unlike zero_angle(), every reference has to run out to the furthest zero, so quit once the projectile
+    // is falling steeply rather than as soon as it drops below a single intercept.
+    if (fabs(vy)>fabs(3*vx)) {
+      break;
+    }
+  }
+
+  return k;
+}
+
+int zero_angles(double* angles, DragFunction drag_function, double drag_coefficient, double vi, double sight_height,
+                const double* zero_ranges, const double* y_intercepts, int count) {
+  ZeroEntry* entries;
+  double references[ZERO_REFERENCES];
+  int reached;
+  int pass;
+  int i, j;
+
+  if (count<=0) return 0;
+
+#ifdef BALLISTICS_EMBEDDED
+  ZeroEntry pool[ZERO_ANGLES_EMBEDDED_MAX];
+  if (count>ZERO_ANGLES_EMBEDDED_MAX) return ZERO_E_NO_MEMORY;
+  entries=pool;
+#else
+  entries=malloc(sizeof(ZeroEntry)*count);
+  if (!entries) return ZERO_E_NO_MEMORY;
+#endif
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_ZERO);
+
+  for (i=0;i<count;i++) {
+    entries[i].x=zero_ranges[i]*3;
+    entries[i].y=y_intercepts ? y_intercepts[i]/12 : 0;
+    entries[i].index=i;
+  }
+  qsort(entries, count, sizeof(ZeroEntry), ZeroEntry_compare);
+
+  // A level bore gives the first estimate: raising the bore by a small angle lifts the trajectory at range x
+  // by very nearly x*tan(angle).
+  reached=zero_reference(entries, count, 0, 0, drag_function, drag_coefficient, vi, sight_height);
+  for (i=0;i<reached;i++) {
+    entries[i].angle=entries[i].x>0 ? BALLISTICS_ATAN((entries[i].y-entries[i].heights[0])/entries[i].x) : 0;
+  }
+
+  // Height at a fixed range is a smooth, nearly linear function of the bore angle, so a quadratic through a few
+  // reference trajectories spanning every estimate pins down all the zeros at once.  A second pass, with the
+  // references re-spread over the refined estimates, confirms the result.
+  for (pass=0;pass<4 && reached>0;pass++) {
+    double lo=entries[0].angle, hi=entries[0].angle;
+    double change=0;
+
+    for (i=1;i<reached;i++) {
+      if (entries[i].angle<lo) lo=entries[i].angle;
+      if (entries[i].angle>hi) hi=entries[i].angle;
+    }
+    // Keep the references far enough apart for a well-conditioned fit.
+    if (hi-lo<moa_to_rad(1)) {
+      lo-=moa_to_rad(0.5);
+      hi+=moa_to_rad(0.5);
+    }
+    if (hi>deg_to_rad(45)) hi=deg_to_rad(45);
+
+    for (j=0;j<ZERO_REFERENCES;j++) {
+      references[j]=lo+(hi-lo)*j/(ZERO_REFERENCES-1);
+      int k=zero_reference(entries, reached, j, references[j], drag_function, drag_coefficient, vi, sight_height);
+      // The steepest reference decides how far every later reference needs to reach.
+      if (k<reached) reached=k;
+    }
+
+    for (i=0;i<reached;i++) {
+      ZeroEntry* e=&entries[i];
+      double a=e->angle;
+      int iteration;
+
+      // Newton's method on the Lagrange quadratic through the reference heights.
+      for (iteration=0;iteration<8;iteration++) {
+        double h=0, dh=0;
+        for (j=0;j<ZERO_REFERENCES;j++) {
+          double l=1, dl=0;
+          int q;
+          for (q=0;q<ZERO_REFERENCES;q++) {
+            if (q==j) continue;
+            double term=1/(references[j]-references[q]);
+            dl=dl*(a-references[q])*term+l*term;
+            l*=(a-references[q])*term;
+          }
+          h+=e->heights[j]*l;
+          dh+=e->heights[j]*dl;
+        }
+        if (dh==0) break;
+        double step=(e->y-h)/dh;
+        a+=step;
+        if (fabs(step)<moa_to_rad(0.0001)) break;
+      }
+
+      if (fabs(a-e->angle)>change) change=fabs(a-e->angle);
+      e->angle=a;
+    }
+
+    if (change<moa_to_rad(0.001)) break;
+  }
+
+  for (i=0;i<count;i++) {
+    angles[entries[i].index]=i<reached ? rad_to_deg(entries[i].angle) : NAN;
+  }
+
+#ifndef BALLISTICS_EMBEDDED
+  free(entries);
+#endif
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_ZERO);
+  return reached<count ? ZERO_E_OUT_OF_RANGE : 0;
+}
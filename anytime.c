@@ -0,0 +1,195 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/anytime.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The error estimate compares two levels every this many yards; the error grows too smoothly to need every yard.
+#define ANYTIME_ERROR_STRIDE 10
+
+struct AnytimeSolver {
+  Ballistics* solutions[2]; // the current level's, and the one the next level is solved into
+  int current;              // which of the two is the current level's
+  int level;
+  double error;             // in inches
+  double seconds;           // how long the current level took to solve
+
+  // The inputs, as for Ballistics_solve_modified_vertDeflect().
+  DragFunction drag_function;
+  double drag_coefficient;
+  double vi;
+  double sight_height;
+  double shooting_angle;
+  double zero_angle;
+  double wind_speed;
+  double wind_angle;
+  double caliber;
+  double bullet_length;
+  double temp;
+  double inHg;
+  double twist_denominator;
+  double velocity;
+  double bullet_grains;
+  double form_factor;
+};
+
+static double Anytime_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// The step a level is solved with, in feet.  The last level comes out at the solvers' own half foot.
+static double Anytime_step(int level) {
+  return ANYTIME_COARSEST_STEP_FEET / (1 << level);
+}
+
+/**
+ * The furthest apart two levels' paths are, in inches.  The coarser level's rows are at exact yards, so its path
+ * is interpolated to the range of each of the finer level's rows, which the default step records a little past
+ * their yards.
+ */
+static double Anytime_difference(Ballistics* coarse, Ballistics* fine) {
+  int rows = Ballistics_get_max_yardage(coarse) < Ballistics_get_max_yardage(fine) ?
+             Ballistics_get_max_yardage(coarse) : Ballistics_get_max_yardage(fine);
+  double worst = 0;
+  int i;
+
+  for (i = ANYTIME_ERROR_STRIDE; i < rows - 1; i += ANYTIME_ERROR_STRIDE) {
+    double x = Ballistics_get_range(fine, i);
+    double x0 = Ballistics_get_range(coarse, i);
+    double x1 = Ballistics_get_range(coarse, i + 1);
+    double p0 = Ballistics_get_path(coarse, i);
+    double p1 = Ballistics_get_path(coarse, i + 1);
+    double difference = fabs(Ballistics_get_path(fine, i) - (p0 + (x - x0) / (x1 - x0) * (p1 - p0)));
+    if (difference > worst) worst = difference;
+  }
+  return worst;
+}
+
+// Solves a level into the spare solution and makes it the current one.
+static void Anytime_solve(AnytimeSolver* solver, int level) {
+  Ballistics* previous = solver->solutions[solver->current];
+  Ballistics* next = solver->solutions[!solver->current];
+  double step = Anytime_step(level);
+  double start = Anytime_now();
+
+  Ballistics_set_step(next, step);
+  Ballistics_solve_modified_vertDeflect_into(next, solver->drag_function, solver->drag_coefficient, solver->vi,
+                                             solver->sight_height, solver->shooting_angle, solver->zero_angle,
+                                             solver->wind_speed, solver->wind_angle, solver->caliber,
+                                             solver->bullet_length, solver->temp, solver->inHg,
+                                             solver->twist_denominator, solver->velocity, solver->bullet_grains,
+                                             solver->form_factor);
+  solver->seconds = Anytime_now() - start;
+
+  // Halving the step halves the error, so the change from the last level is about this level's own error, of
+  // which the last level will still have the part in proportion to its step.
+  if (level > 0) solver->error = Anytime_difference(previous, next) * (1 - Anytime_step(ANYTIME_LEVELS - 1) / step);
+  solver->current = !solver->current;
+  solver->level = level;
+}
+
+int AnytimeSolver_start(AnytimeSolver** solver, int rows, DragFunction drag_function, double drag_coefficient,
+                        double vi, double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                        double wind_angle, double caliberInInches, double bulletLengthInInches, double temp,
+                        double inHg, double twistDenominator, double velocity, double bulletGrains,
+                        double formFactor) {
+  AnytimeSolver* s = calloc(1, sizeof(AnytimeSolver));
+
+  *solver = NULL;
+  if (!s) return ANYTIME_E_NO_MEMORY;
+  s->solutions[0] = Ballistics_alloc();
+  s->solutions[1] = Ballistics_alloc();
+  if (!s->solutions[0] || !s->solutions[1]) {
+    AnytimeSolver_free(s);
+    return ANYTIME_E_NO_MEMORY;
+  }
+  Ballistics_set_row_limit(s->solutions[0], rows);
+  Ballistics_set_row_limit(s->solutions[1], rows);
+
+  s->drag_function = drag_function;
+  s->drag_coefficient = drag_coefficient;
+  s->vi = vi;
+  s->sight_height = sight_height;
+  s->shooting_angle = shooting_angle;
+  s->zero_angle = zero_angle;
+  s->wind_speed = wind_speed;
+  s->wind_angle = wind_angle;
+  s->caliber = caliberInInches;
+  s->bullet_length = bulletLengthInInches;
+  s->temp = temp;
+  s->inHg = inHg;
+  s->twist_denominator = twistDenominator;
+  s->velocity = velocity;
+  s->bullet_grains = bulletGrains;
+  s->form_factor = formFactor;
+
+  Anytime_solve(s, 0);
+  Anytime_solve(s, 1);
+  *solver = s;
+  return 0;
+}
+
+void AnytimeSolver_free(AnytimeSolver* solver) {
+  if (solver) {
+    if (solver->solutions[0]) Ballistics_free(solver->solutions[0]);
+    if (solver->solutions[1]) Ballistics_free(solver->solutions[1]);
+    free(solver);
+  }
+}
+
+int AnytimeSolver_refine(AnytimeSolver* solver, double seconds, long steps) {
+  double start = Anytime_now();
+  long spent = 0;
+  int refined = 0;
+
+  while (solver->level < ANYTIME_LEVELS - 1) {
+    // The next level takes a step every so many feet out to where this one got to, and about twice as long.
+    long cost = (long)(Ballistics_get_max_yardage(solver->solutions[solver->current]) * 3 /
+                       Anytime_step(solver->level + 1));
+    if (steps > 0 && spent + cost > steps) break;
+    if (seconds > 0 && Anytime_now() - start + 2 * solver->seconds > seconds) break;
+
+    Anytime_solve(solver, solver->level + 1);
+    spent += cost;
+    refined++;
+  }
+  return refined;
+}
+
+Ballistics* AnytimeSolver_get_solution(const AnytimeSolver* solver) {
+  return solver->solutions[solver->current];
+}
+
+int AnytimeSolver_get_level(const AnytimeSolver* solver) {
+  return solver->level;
+}
+
+double AnytimeSolver_get_step(const AnytimeSolver* solver) {
+  return Anytime_step(solver->level);
+}
+
+double AnytimeSolver_get_error(const AnytimeSolver* solver) {
+  return solver->error;
+}
+
+int AnytimeSolver_is_final(const AnytimeSolver* solver) {
+  return solver->level == ANYTIME_LEVELS - 1;
+}
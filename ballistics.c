@@ -15,62 +15,303 @@
  */
 
 #include "ballistics/ballistics.h"
+#ifndef BALLISTICS_EMBEDDED
+#include "ballistics/siacci.h"
+#endif
 
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
-/**
- * A ballistics solution for a projectile at a certain yardage.
- */
+// The drag model a solution was solved with.
+typedef enum {
+  BALLISTICS_DRAG_STANDARD, // retard()
+  BALLISTICS_DRAG_TABLE,    // retard_table()
+  BALLISTICS_DRAG_MODIFIED  // retardModified()
+} BallisticsDrag;
+
+typedef struct {
+  BallisticsDrag drag;
+  DragFunction function;
+  const DragTable* table;
+  double coefficient;
+  double form_factor;
+  double hwind;
+} BallisticsDragModel;
+
+// The integrator's state at the top of a step: everything it needs to carry on from there.
 typedef struct {
-  double range_yards;
-  double path_inches;
-  double moa_correction;
-  double seconds;
-  double windage_inches;
-  double spindrift_inches;
-  double corrected_windage;
-  double windage_moa;
-  double corrected_windage_moa;
-  double v_fps; // total velocity -> vector product of vx and vy
-  double vx_fps; // velocity of projectile in the bore direction
-  double vy_fps; // velocity of projectile perpendicular to the bore direction
-} Point;
+  double t, x, y, vx, vy;
+} BallisticsCheckpoint;
+
+#define BALLISTICS_CHECKPOINTS (BALLISTICS_COMPUTATION_MAX_YARDS / BALLISTICS_CHECKPOINT_INTERVAL + 1)
 
+/**
+ * A ballistics solution.  Only the integrator's state is kept for each yard, one column per variable; every
+ * output derived from it (corrections in MOA, windage, spin drift) is computed when it is asked for, so solving
+ * costs no more than the integration itself.
+ */
 struct Ballistics {
-  Point *yardages;
+  double *x;  // range, in feet
+  double *y;  // path relative to the line of sight, in feet
+  double *t;  // time of flight, in seconds
+  double *v;  // total velocity -> vector product of vx and vy
+  double *vx; // velocity of projectile in the bore direction
+  double *vy; // velocity of projectile perpendicular to the bore direction
   int max_yardage;
+  int capacity; // rows the columns have room for
+
+  // Inputs the derived outputs depend on.
+  double vi;
+  double cwind;
+  int spin; // set by Ballistics_solve_modified_vertDeflect(), which adds vertical deflection and spin drift
+  double bullet_grains;
+  double twist_denominator;
+  double caliber;
+  double bullet_length;
+  double temp;
+  double inHg;
+
+  // Inputs the integration depends on, so it can be carried on after the solver returns.
+  BallisticsDragModel drag;
+  double gx, gy; // gravity, resolved along and across the bore
+  int row_limit; // rows a solve stops at, or 0 to fill the columns
+  double step;   // feet of flight per integration step, or 0 for the default half foot
+  // The shot, as given to the solver, for solving it again at another angle.
+  double sight_height;
+  double shooting_angle;
+  double zero_angle;
+  double wind_speed;
+  double wind_angle;
+  int complete;  // nonzero once the integration has run its course
+
+  // Where the integration stopped, and where it passed every BALLISTICS_CHECKPOINT_INTERVAL'th row.
+  BallisticsCheckpoint resume;
+  BallisticsCheckpoint checkpoints[BALLISTICS_CHECKPOINTS];
 };
 
-Ballistics* Ballistics_alloc() {
-  Ballistics* sln = malloc(sizeof(Ballistics));
-  sln->yardages = malloc(sizeof(Point) * BALLISTICS_COMPUTATION_MAX_YARDS);
+#define BALLISTICS_COLUMNS 6
+
+static void Ballistics_columns(Ballistics* ballistics, double* block, int rows) {
+  ballistics->capacity = rows;
+  ballistics->x = block;
+  ballistics->y = block + rows;
+  ballistics->t = block + 2*rows;
+  ballistics->v = block + 3*rows;
+  ballistics->vx = block + 4*rows;
+  ballistics->vy = block + 5*rows;
+}
+
+#ifdef BALLISTICS_EMBEDDED
+static Ballistics ballistics_pool[BALLISTICS_EMBEDDED_SOLUTIONS];
+static double ballistics_pool_columns[BALLISTICS_EMBEDDED_SOLUTIONS][BALLISTICS_COLUMNS * BALLISTICS_COMPUTATION_MAX_YARDS];
+static int ballistics_pool_used[BALLISTICS_EMBEDDED_SOLUTIONS];
+
+Ballistics* Ballistics_alloc(void) {
+  int i;
+  for (i = 0; i < BALLISTICS_EMBEDDED_SOLUTIONS; i++) {
+    if (!ballistics_pool_used[i]) {
+      Ballistics* sln = &ballistics_pool[i];
+      ballistics_pool_used[i] = 1;
+      memset(sln, 0, sizeof(Ballistics));
+      Ballistics_columns(sln, ballistics_pool_columns[i], BALLISTICS_COMPUTATION_MAX_YARDS);
+      return sln;
+    }
+  }
+  return NULL;
+}
+
+void Ballistics_free(Ballistics* ballistics) {
+  ballistics_pool_used[ballistics - ballistics_pool] = 0;
+}
+
+size_t Ballistics_compact(Ballistics* ballistics) {
+  // Pooled tables are a fixed size; there is nothing to give back.
+  return sizeof(Ballistics) + sizeof(ballistics_pool_columns[0]);
+}
+#else
+Ballistics* Ballistics_alloc(void) {
+  Ballistics* sln = calloc(1, sizeof(Ballistics));
+  double* block = malloc(sizeof(double) * BALLISTICS_COLUMNS * BALLISTICS_COMPUTATION_MAX_YARDS);
+  if (!sln || !block) {
+    free(sln);
+    free(block);
+    return NULL;
+  }
+  Ballistics_columns(sln, block, BALLISTICS_COMPUTATION_MAX_YARDS);
   return sln;
 }
 
 void Ballistics_free(Ballistics* ballistics) {
-  free(ballistics->yardages);
+  free(ballistics->x);
   free(ballistics);
 }
 
+// Moves a solution's columns into a block of the given number of rows, keeping the rows that fit.
+static int Ballistics_resize(Ballistics* ballistics, int rows) {
+  int kept = ballistics->max_yardage < rows ? ballistics->max_yardage : rows;
+  double* block = malloc(sizeof(double) * BALLISTICS_COLUMNS * rows);
+  double* old = ballistics->x;
+  double* columns[BALLISTICS_COLUMNS] = {ballistics->x, ballistics->y, ballistics->t,
+                                         ballistics->v, ballistics->vx, ballistics->vy};
+  int i;
+
+  if (!block) return BALLISTICS_E_NO_MEMORY;
+  for (i = 0; i < BALLISTICS_COLUMNS; i++) {
+    memcpy(block + i*rows, columns[i], sizeof(double) * kept);
+  }
+  Ballistics_columns(ballistics, block, rows);
+  free(old);
+  return 0;
+}
+
+size_t Ballistics_compact(Ballistics* ballistics) {
+  int rows = ballistics->max_yardage > 0 ? ballistics->max_yardage : 1;
+  if (rows < ballistics->capacity) Ballistics_resize(ballistics, rows);
+  return sizeof(Ballistics) + sizeof(double) * BALLISTICS_COLUMNS * ballistics->capacity;
+}
+#endif
+
+// Gyroscopic stability at a recorded yard, for the spin-compensated outputs.
+static inline double Ballistics_gs(Ballistics* ballistics, int yardage) {
+  return calculateGS(ballistics->bullet_grains, ballistics->twist_denominator, ballistics->caliber,
+                     ballistics->bullet_length, ballistics->v[yardage], ballistics->temp, ballistics->inHg);
+}
+
+// Vertical deflection caused by the crosswind acting on a spinning projectile, in MOA.
+static inline double Ballistics_deflection_moa(Ballistics* ballistics, int yardage) {
+  return calculateVerticalDeflection(Ballistics_gs(ballistics, yardage), ballistics->bullet_length,
+                                     ballistics->caliber) * ballistics->cwind;
+}
+
+static inline double Ballistics_path(Ballistics* ballistics, int i) {
+  double path = ballistics->y[i]*12;
+  if (ballistics->spin) {
+    path += tan(Ballistics_deflection_moa(ballistics, i) * (M_PI / (180.0 * 60.0))) * ballistics->x[i];
+  }
+  return path;
+}
+
+static inline double Ballistics_moa(Ballistics* ballistics, int i) {
+  double moa = -rad_to_moa(BALLISTICS_ATAN(ballistics->y[i] / ballistics->x[i]));
+  if (ballistics->spin) {
+    moa += Ballistics_deflection_moa(ballistics, i);
+  }
+  return moa;
+}
+
+static inline double Ballistics_windage(Ballistics* ballistics, int i) {
+  return windage(ballistics->cwind, ballistics->vi, ballistics->x[i], ballistics->t[i]);
+}
+
+static inline double Ballistics_spindrift(Ballistics* ballistics, int i) {
+  return ballistics->spin ? calculateSpinDriftOffsetIn(Ballistics_gs(ballistics, i), ballistics->t[i]) : 0;
+}
+
+// Converts a lateral offset in inches at a recorded yard into MOA.
+static inline double Ballistics_lateral_moa(Ballistics* ballistics, int i, double inches) {
+  return rad_to_moa(BALLISTICS_ATAN((inches/12) / ballistics->x[i]));
+}
+
+static inline double Ballistics_field(Ballistics* ballistics, BallisticsField field, int i) {
+  switch (field) {
+    case BALLISTICS_RANGE: return ballistics->x[i]/3;
+    case BALLISTICS_PATH: return Ballistics_path(ballistics, i);
+    case BALLISTICS_MOA: return Ballistics_moa(ballistics, i);
+    case BALLISTICS_TIME: return ballistics->t[i];
+    case BALLISTICS_WINDAGE: return Ballistics_windage(ballistics, i);
+    case BALLISTICS_WINDAGE_MOA: return Ballistics_lateral_moa(ballistics, i, Ballistics_windage(ballistics, i));
+    case BALLISTICS_SPINDRIFT: return Ballistics_spindrift(ballistics, i);
+    case BALLISTICS_CORRECTED_WINDAGE: return Ballistics_windage(ballistics, i) + Ballistics_spindrift(ballistics, i);
+    case BALLISTICS_CORRECTED_WINDAGE_MOA:
+      return Ballistics_lateral_moa(ballistics, i, Ballistics_windage(ballistics, i) + Ballistics_spindrift(ballistics, i));
+    case BALLISTICS_V: return ballistics->v[i];
+    case BALLISTICS_VX: return ballistics->vx[i];
+    case BALLISTICS_VY: return ballistics->vy[i];
+  }
+  return 0;
+}
+
+int Ballistics_get_rows(Ballistics* ballistics, BallisticsField field, int first, int count, double* out) {
+  const double* x = ballistics->x + first;
+  const double* t = ballistics->t + first;
+  int i;
+
+  if (first < 0 || first >= ballistics->max_yardage || count <= 0) return 0;
+  if (count > ballistics->max_yardage - first) count = ballistics->max_yardage - first;
+
+  // The outputs that are plain arithmetic on the columns get loops of their own, which the compiler vectorizes.
+  switch (field) {
+    case BALLISTICS_RANGE:
+      for (i = 0; i < count; i++) out[i] = x[i]/3;
+      return count;
+    case BALLISTICS_TIME:
+      memcpy(out, t, sizeof(double) * count);
+      return count;
+    case BALLISTICS_WINDAGE: {
+      double vw = ballistics->cwind*17.60;
+      double vi = ballistics->vi;
+      for (i = 0; i < count; i++) out[i] = vw*(t[i]-x[i]/vi);
+      return count;
+    }
+    case BALLISTICS_PATH:
+      if (!ballistics->spin) {
+        const double* y = ballistics->y + first;
+        for (i = 0; i < count; i++) out[i] = y[i]*12;
+        return count;
+      }
+      break;
+    case BALLISTICS_V:
+      memcpy(out, ballistics->v + first, sizeof(double) * count);
+      return count;
+    case BALLISTICS_VX:
+      memcpy(out, ballistics->vx + first, sizeof(double) * count);
+      return count;
+    case BALLISTICS_VY:
+      memcpy(out, ballistics->vy + first, sizeof(double) * count);
+      return count;
+    default:
+      break;
+  }
+
+  for (i = 0; i < count; i++) {
+    out[i] = Ballistics_field(ballistics, field, first + i);
+  }
+  return count;
+}
+
+const double* Ballistics_get_column(Ballistics* ballistics, BallisticsField field) {
+  switch (field) {
+    case BALLISTICS_TIME: return ballistics->t;
+    case BALLISTICS_V: return ballistics->v;
+    case BALLISTICS_VX: return ballistics->vx;
+    case BALLISTICS_VY: return ballistics->vy;
+    default: return NULL;
+  }
+}
+
+int Ballistics_get_max_yardage(Ballistics* ballistics) {
+  return ballistics->max_yardage;
+}
+
 double Ballistics_get_range(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].range_yards;
+    return ballistics->x[yardage]/3;
   }
   else return 0;
 }
 
 double Ballistics_get_path(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].path_inches;
+    return Ballistics_path(ballistics, yardage);
   }
   else return 0;
 }
 
 double Ballistics_get_moa(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].moa_correction;
+    return Ballistics_moa(ballistics, yardage);
   }
   else return 0;
 }
@@ -78,60 +319,60 @@ double Ballistics_get_moa(Ballistics* ballistics, int yardage) {
 
 double Ballistics_get_time(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].seconds;
+    return ballistics->t[yardage];
   }
   else return 0;
 }
 
 double Ballistics_get_windage(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].windage_inches;
+    return Ballistics_windage(ballistics, yardage);
   }
   else return 0;
 }
 double Ballistics_get_spindrift(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].spindrift_inches;
+    return Ballistics_spindrift(ballistics, yardage);
   }
   else return 0;
 }
 
 double Ballistics_get_windage_moa(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].windage_moa;
+    return Ballistics_field(ballistics, BALLISTICS_WINDAGE_MOA, yardage);
   }
   else return 0;
 }
 double Ballistics_get_corrected_windage(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].corrected_windage;
+    return Ballistics_field(ballistics, BALLISTICS_CORRECTED_WINDAGE, yardage);
   }
   else return 0;
 }
 
 double Ballistics_get_corrected_windage_moa(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].corrected_windage_moa;
+    return Ballistics_field(ballistics, BALLISTICS_CORRECTED_WINDAGE_MOA, yardage);
   }
   else return 0;
 }
 double Ballistics_get_v_fps(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].v_fps;
+    return ballistics->v[yardage];
   }
   else return 0;
 }
 
 double Ballistics_get_vx_fps(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].vx_fps;
+    return ballistics->vx[yardage];
   }
   else return 0;
 }
 
 double Ballistics_get_vy_fps(Ballistics* ballistics, int yardage) {
   if (yardage < ballistics->max_yardage) {
-    return ballistics->yardages[yardage].vy_fps;
+    return ballistics->vy[yardage];
   }
   else return 0;
 }
@@ -154,14 +395,14 @@ double calculateGS(double bulletGrains, double twistDenominator, double caliber,
   double l = lengthOfBullet / caliber;
 
   double uncorrectedGS = ((30 * m) / (
-  (pow(t,2))*
-  (pow(d,3))*
+  (BALLISTICS_POW(t,2))*
+  (BALLISTICS_POW(d,3))*
   (
-  l * (1 + pow(l,2))
+  l * (1 + BALLISTICS_POW(l,2))
   )
   ));
   double veloCorrection = velocity/(double)2800;
-  veloCorrection = cbrt(veloCorrection);
+  veloCorrection = BALLISTICS_CBRT(veloCorrection);
   double tempCorrection = (
   ((temp + 460) * 29.92)
   /
@@ -190,80 +431,427 @@ double calculateVerticalDeflection(double gs, double length, double caliber) {
  * \return the inches offset
  */
 double calculateSpinDriftOffsetIn(double gs, double tof) {
-  return -(1.25*(gs+1.2)*pow(tof,1.83));
+  return -(1.25*(gs+1.2)*BALLISTICS_POW(tof,1.83));
 }
 
 int Ballistics_solve(Ballistics** ballistics, DragFunction drag_function, double drag_coefficient, double vi,
                      double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
-  double t=0;
-  double dt=0;
-  double v=0;
-  double vx=0, vx1=0, vy=0, vy1=0;
-  double dv=0, dvx=0, dvy=0;
-  double x=0, y=0;
+  *ballistics = Ballistics_alloc();
+  if (!*ballistics) return BALLISTICS_E_NO_MEMORY;
+  return Ballistics_solve_into(*ballistics, drag_function, drag_coefficient, vi, sight_height, shooting_angle,
+                               zero_angle, wind_speed, wind_angle);
+}
 
-  double hwind = headwind(wind_speed, wind_angle);
-  double cwind = crosswind(wind_speed, wind_angle);
+/**
+ * Sets a solution up to integrate a trajectory from the muzzle; Ballistics_integrate() then takes it as far as it's
+ * asked to.  Every input the integration needs is kept in the solution, so it can be carried on later.
+ */
+static void Ballistics_start(Ballistics* sln, BallisticsDrag drag, DragFunction drag_function, const DragTable* table,
+                             double drag_coefficient, double form_factor, double vi, double sight_height,
+                             double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
+  sln->drag.drag = drag;
+  sln->drag.function = drag_function;
+  sln->drag.table = table;
+  sln->drag.coefficient = drag_coefficient;
+  sln->drag.form_factor = form_factor;
+  sln->drag.hwind = headwind(wind_speed, wind_angle);
+  sln->gy = GRAVITY*cos(deg_to_rad((shooting_angle + zero_angle)));
+  sln->gx = GRAVITY*sin(deg_to_rad((shooting_angle + zero_angle)));
 
-  double gy = GRAVITY*cos(deg_to_rad((shooting_angle + zero_angle)));
-  double gx = GRAVITY*sin(deg_to_rad((shooting_angle + zero_angle)));
+  sln->vi = vi;
+  sln->cwind = crosswind(wind_speed, wind_angle);
+  sln->spin = 0;
+  sln->sight_height = sight_height;
+  sln->shooting_angle = shooting_angle;
+  sln->zero_angle = zero_angle;
+  sln->wind_speed = wind_speed;
+  sln->wind_angle = wind_angle;
 
-  *ballistics = Ballistics_alloc();
+  sln->resume.t = 0;
+  sln->resume.x = 0;
+  sln->resume.y = -sight_height/12; // y is in feet
+  sln->resume.vx = vi * cos(deg_to_rad(zero_angle));
+  sln->resume.vy = vi * sin(deg_to_rad(zero_angle));
+  sln->max_yardage = 0;
+  sln->complete = 0;
+}
 
-  vx = vi * cos(deg_to_rad(zero_angle));
-  vy = vi * sin(deg_to_rad(zero_angle));
+// The retardation a drag model gives at velocity v, for the given kind of model.
+static inline double Ballistics_retard(const BallisticsDragModel* model, BallisticsDrag drag, double v) {
+  switch (drag) {
+    case BALLISTICS_DRAG_TABLE: return retard_table(model->table, model->coefficient, v+model->hwind);
+    case BALLISTICS_DRAG_MODIFIED: return retardModified(model->function, model->coefficient, v+model->hwind,
+                                                         model->form_factor);
+    default: return retard(model->function, model->coefficient, v+model->hwind);
+  }
+}
 
-  y = -sight_height/12; // y is in feet
+/**
+ * Integrates from where the solution left off until it has the given number of rows, the projectile climbs too
+ * steeply to go on, or the columns are full.  The step sequence is the same however the integration is split up,
+ * so a solution built in pieces is identical to one solved in one go.  Inlined with a constant drag, so each kind
+ * of model gets a loop of its own.
+ * @return the number of rows in the solution
+ */
+static inline int Ballistics_integrate_drag(Ballistics* sln, int rows, BallisticsDrag drag) {
+  double t = sln->resume.t;
+  double dt = 0;
+  double v = 0;
+  double vx = sln->resume.vx, vx1 = 0, vy = sln->resume.vy, vy1 = 0;
+  double dv = 0, dvx = 0, dvy = 0;
+  double x = sln->resume.x, y = sln->resume.y;
+  double gx = sln->gx, gy = sln->gy;
+  // A local copy, which the stores into the columns can't alias.
+  BallisticsDragModel model = sln->drag;
+  int n = sln->max_yardage;
 
-  int n = 0;
-  for (t = 0;; t = t + dt) {
-    vx1 = vx;
-    vy1 = vy;
-    v = pow(pow(vx,2)+pow(vy,2),0.5);
-    dt = 0.5/v;
+  if (rows > sln->capacity) rows = sln->capacity;
+  if (sln->complete || n >= rows) return n;
 
-    // Compute acceleration using the drag function retardation  
-    dv = retard(drag_function, drag_coefficient, v+hwind);
-    dvx = -(vx/v)*dv;
-    dvy = -(vy/v)*dv;
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+  // The integration runs in segments that end at each checkpoint's row, so taking the checkpoints costs the steps
+  // in between nothing.
+  for (;;) {
+    int stop = (n / BALLISTICS_CHECKPOINT_INTERVAL + 1) * BALLISTICS_CHECKPOINT_INTERVAL;
+    if (stop > rows) stop = rows;
+    if (n % BALLISTICS_CHECKPOINT_INTERVAL == 0) {
+      // The top of the step after the last row, which is still short of this one.
+      BallisticsCheckpoint* checkpoint = &sln->checkpoints[n / BALLISTICS_CHECKPOINT_INTERVAL];
+      checkpoint->t = t;
+      checkpoint->x = x;
+      checkpoint->y = y;
+      checkpoint->vx = vx;
+      checkpoint->vy = vy;
+    }
 
-    // Compute velocity, including the resolved gravity vectors.  
-    vx = vx + dt*dvx + dt*gx;
-    vy = vy + dt*dvy + dt*gy;
+    for (;;) {
+      vx1 = vx;
+      vy1 = vy;
+      v = BALLISTICS_SPEED(vx,vy);
+      dt = 0.5/v;
+      BALLISTICS_STATS_STEP();
 
-    if (x/3 >= n) {
-      Point* s = &(*ballistics)->yardages[n];
-      s->range_yards = x/3;
-      s->path_inches = y*12;
-      s->moa_correction = -rad_to_moa(atan(y / x));
-      s->seconds = t+dt;
-      s->windage_inches = windage(cwind, vi, x, t + dt);
-      s->windage_moa = rad_to_moa(atan((s->windage_inches/12) / x));
-      s->v_fps = v;
-      s->vx_fps = vx;
-      s->vy_fps = vy;
-      n++;
+      // Compute acceleration using the drag function retardation
+      dv = Ballistics_retard(&model, drag, v);
+      dvx = -(vx/v)*dv;
+      dvy = -(vy/v)*dv;
+
+      // Compute velocity, including the resolved gravity vectors.
+      vx = vx + dt*dvx + dt*gx;
+      vy = vy + dt*dvy + dt*gy;
+
+      // Vertical deflection and spin drift depend only on the recorded velocity and time, so the accessors
+      // work them out from the recorded state.
+      if (x/3 >= n) {
+        sln->x[n] = x;
+        sln->y[n] = y;
+        sln->t[n] = t+dt;
+        sln->v[n] = v;
+        sln->vx[n] = vx;
+        sln->vy[n] = vy;
+        n++;
+      }
+
+      // Compute position based on average velocity.
+      x = x + dt * (vx+vx1)/2;
+      y = y + dt * (vy+vy1)/2;
+      t = t + dt;
+
+      if (fabs(vy)>fabs(3*vx) || n>=BALLISTICS_COMPUTATION_MAX_YARDS) {
+        sln->complete = 1;
+        break;
+      }
+      if (n>=stop) break;
     }
+    if (sln->complete || n >= rows) break;
+  }
 
-    // Compute position based on average velocity.
-    x = x + dt * (vx+vx1)/2;
-    y = y + dt * (vy+vy1)/2;
+  // The state at the top of the next step, to carry on from.
+  sln->resume.t = t;
+  sln->resume.x = x;
+  sln->resume.y = y;
+  sln->resume.vx = vx;
+  sln->resume.vy = vy;
+  sln->max_yardage = n;
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
+  return n;
+}
 
-    if (fabs(vy)>fabs(3*vx) || n>=BALLISTICS_COMPUTATION_MAX_YARDS) break;
+/**
+ * Ballistics_integrate() for a step other than the default; a long step can pass several rows at once.  Each row
+ * the step passes is taken off the step's own path at exactly its yard, by the partial step that lands there, and
+ * recorded as the default step would record it: with the time at the end of a default step from there.
+ */
+static int Ballistics_integrate_step(Ballistics* sln, int rows) {
+  double step = sln->step;
+  double t = sln->resume.t;
+  double vx = sln->resume.vx, vy = sln->resume.vy;
+  double x = sln->resume.x, y = sln->resume.y;
+  double gx = sln->gx, gy = sln->gy;
+  BallisticsDragModel model = sln->drag;
+  int n = sln->max_yardage;
+
+  if (rows > sln->capacity) rows = sln->capacity;
+  if (sln->complete || n >= rows) return n;
+
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+  for (;;) {
+    double v = BALLISTICS_SPEED(vx,vy);
+    double dt = step/v;
+    double dv = Ballistics_retard(&model, model.drag, v);
+    double dvx = -(vx/v)*dv;
+    double dvy = -(vy/v)*dv;
+    double vx2 = vx + dt*dvx + dt*gx;
+    double vy2 = vy + dt*dvy + dt*gy;
+    double x2 = x + dt * (vx2+vx)/2;
+    BALLISTICS_STATS_STEP();
+
+    for (; n < rows && n*3 <= x2; n++) {
+      double d = n*3 - x;
+      double root = vx*vx + 2*(dvx + gx)*d;
+      double h = d > 0 ? 2*d / (vx + sqrt(root > 0 ? root : 0)) : 0;
+      double vxh = vx + h*dvx + h*gx;
+      double vyh = vy + h*dvy + h*gy;
+      double vh = BALLISTICS_SPEED(vxh, vyh);
+
+      if (n % BALLISTICS_CHECKPOINT_INTERVAL == 0) {
+        // The top of this step, which is short of the row.
+        BallisticsCheckpoint* checkpoint = &sln->checkpoints[n / BALLISTICS_CHECKPOINT_INTERVAL];
+        checkpoint->t = t;
+        checkpoint->x = x;
+        checkpoint->y = y;
+        checkpoint->vx = vx;
+        checkpoint->vy = vy;
+      }
+      sln->x[n] = x + h * (vxh+vx)/2;
+      sln->y[n] = y + h * (vyh+vy)/2;
+      sln->t[n] = t + h + 0.5/vh;
+      sln->v[n] = vh;
+      sln->vx[n] = vxh;
+      sln->vy[n] = vyh;
+    }
+
+    y = y + dt * (vy2+vy)/2;
+    x = x2;
+    t = t + dt;
+    vx = vx2;
+    vy = vy2;
+
+    if (fabs(vy)>fabs(3*vx) || n>=BALLISTICS_COMPUTATION_MAX_YARDS) {
+      sln->complete = 1;
+      break;
+    }
+    if (n>=rows) break;
   }
 
-  (*ballistics)->max_yardage = n;
+  sln->resume.t = t;
+  sln->resume.x = x;
+  sln->resume.y = y;
+  sln->resume.vx = vx;
+  sln->resume.vy = vy;
+  sln->max_yardage = n;
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
   return n;
 }
 
+static int Ballistics_integrate(Ballistics* sln, int rows) {
+  if (sln->step > 0) return Ballistics_integrate_step(sln, rows);
+  switch (sln->drag.drag) {
+    case BALLISTICS_DRAG_TABLE: return Ballistics_integrate_drag(sln, rows, BALLISTICS_DRAG_TABLE);
+    case BALLISTICS_DRAG_MODIFIED: return Ballistics_integrate_drag(sln, rows, BALLISTICS_DRAG_MODIFIED);
+    default: return Ballistics_integrate_drag(sln, rows, BALLISTICS_DRAG_STANDARD);
+  }
+}
+
+// The number of rows a fresh solve integrates.
+static inline int Ballistics_solve_rows(Ballistics* sln) {
+  return sln->row_limit > 0 ? sln->row_limit : sln->capacity;
+}
+
+int Ballistics_solve_into(Ballistics* sln, DragFunction drag_function, double drag_coefficient, double vi,
+                          double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
+  Ballistics_start(sln, BALLISTICS_DRAG_STANDARD, drag_function, NULL, drag_coefficient, 0, vi, sight_height,
+                   shooting_angle, zero_angle, wind_speed, wind_angle);
+  return Ballistics_integrate(sln, Ballistics_solve_rows(sln));
+}
+
+int Ballistics_solve_table(Ballistics** ballistics, const DragTable* table, double drag_coefficient, double vi,
+                           double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
+  *ballistics = Ballistics_alloc();
+  if (!*ballistics) return BALLISTICS_E_NO_MEMORY;
+  return Ballistics_solve_table_into(*ballistics, table, drag_coefficient, vi, sight_height, shooting_angle,
+                                     zero_angle, wind_speed, wind_angle);
+}
+
+int Ballistics_solve_table_into(Ballistics* sln, const DragTable* table, double drag_coefficient, double vi,
+                                double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
+  Ballistics_start(sln, BALLISTICS_DRAG_TABLE, G1, table, drag_coefficient, 0, vi, sight_height, shooting_angle,
+                   zero_angle, wind_speed, wind_angle);
+  return Ballistics_integrate(sln, Ballistics_solve_rows(sln));
+}
+
 int Ballistics_solve_modified_vertDeflect(Ballistics** ballistics, DragFunction drag_function, double drag_coefficient, double vi,
                      double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle, double caliberInInches, double bulletLengthInInches, double temp, double inHg, double twistDenominator, double velocity, double bulletGrains, double formFactor) {
+  *ballistics = Ballistics_alloc();
+  if (!*ballistics) return BALLISTICS_E_NO_MEMORY;
+  return Ballistics_solve_modified_vertDeflect_into(*ballistics, drag_function, drag_coefficient, vi, sight_height,
+                                                    shooting_angle, zero_angle, wind_speed, wind_angle, caliberInInches,
+                                                    bulletLengthInInches, temp, inHg, twistDenominator, velocity,
+                                                    bulletGrains, formFactor);
+}
+
+int Ballistics_solve_modified_vertDeflect_into(Ballistics* sln, DragFunction drag_function, double drag_coefficient, double vi,
+                     double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle, double caliberInInches, double bulletLengthInInches, double temp, double inHg, double twistDenominator, double velocity, double bulletGrains, double formFactor) {
+  Ballistics_start(sln, BALLISTICS_DRAG_MODIFIED, drag_function, NULL, drag_coefficient, formFactor, vi,
+                   sight_height, shooting_angle, zero_angle, wind_speed, wind_angle);
+  sln->spin = 1;
+  sln->bullet_grains = bulletGrains;
+  sln->twist_denominator = twistDenominator;
+  sln->caliber = caliberInInches;
+  sln->bullet_length = bulletLengthInInches;
+  sln->temp = temp;
+  sln->inHg = inHg;
+  return Ballistics_integrate(sln, Ballistics_solve_rows(sln));
+}
+
+void Ballistics_set_row_limit(Ballistics* ballistics, int rows) {
+  ballistics->row_limit = rows > 0 ? rows : 0;
+}
+
+void Ballistics_set_step(Ballistics* ballistics, double step_feet) {
+  ballistics->step = step_feet > 0 && step_feet != 0.5 ? step_feet : 0;
+}
+
+int Ballistics_is_complete(Ballistics* ballistics) {
+  return ballistics->complete;
+}
+
+int Ballistics_extend(Ballistics* ballistics, int rows) {
+  if (ballistics->max_yardage == 0) return 0;
+  if (rows > BALLISTICS_COMPUTATION_MAX_YARDS) rows = BALLISTICS_COMPUTATION_MAX_YARDS;
+#ifndef BALLISTICS_EMBEDDED
+  if (!ballistics->complete && rows > ballistics->capacity) {
+    // Grow geometrically, so scrolling out a few hundred yards at a time doesn't copy the columns every time.
+    int grown = ballistics->capacity * 2 > rows ? ballistics->capacity * 2 : rows;
+    if (grown > BALLISTICS_COMPUTATION_MAX_YARDS) grown = BALLISTICS_COMPUTATION_MAX_YARDS;
+    if (Ballistics_resize(ballistics, grown)) return BALLISTICS_E_NO_MEMORY;
+  }
+#endif
+  return Ballistics_integrate(ballistics, rows);
+}
+
+int Ballistics_get_state(Ballistics* ballistics, double range_yards, BallisticsState* state) {
+  BallisticsCheckpoint from;
+  double target = range_yards*3;
+  double gx = ballistics->gx, gy = ballistics->gy;
+  double step = ballistics->step > 0 ? ballistics->step : 0.5;
+  int k;
+
+  if (ballistics->max_yardage == 0 || !(range_yards >= 0) || target > ballistics->resume.x) {
+    return BALLISTICS_E_OUT_OF_RANGE;
+  }
+
+  // The last checkpoint short of the range.  Checkpoints fall short of their rows, and there is one for every row
+  // the integration has gone past.
+  k = (int)range_yards / BALLISTICS_CHECKPOINT_INTERVAL;
+  if (k > (ballistics->max_yardage - 1) / BALLISTICS_CHECKPOINT_INTERVAL) {
+    k = (ballistics->max_yardage - 1) / BALLISTICS_CHECKPOINT_INTERVAL;
+  }
+  from = ballistics->checkpoints[k];
+
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+  for (;;) {
+    double v = BALLISTICS_SPEED(from.vx, from.vy);
+    double dt = step/v;
+    double dv = Ballistics_retard(&ballistics->drag, ballistics->drag.drag, v);
+    double dvx = -(from.vx/v)*dv;
+    double dvy = -(from.vy/v)*dv;
+    double vx = from.vx + dt*dvx + dt*gx;
+    double vy = from.vy + dt*dvy + dt*gy;
+    double x = from.x + dt * (vx+from.vx)/2;
+    BALLISTICS_STATS_STEP();
+
+    if (x >= target) {
+      // The step passes the range: take the part of it that lands exactly there.  Position is quadratic in time
+      // over a step, so the partial step solves a quadratic, in the form that is stable for small steps.
+      double ax = dvx + gx;
+      double d = target - from.x;
+      double h = 2*d / (from.vx + sqrt(from.vx*from.vx + 2*ax*d));
+      state->t = from.t + h;
+      state->vx = from.vx + h*dvx + h*gx;
+      state->vy = from.vy + h*dvy + h*gy;
+      state->x = from.x + h * (state->vx+from.vx)/2;
+      state->y = from.y + h * (state->vy+from.vy)/2;
+      state->v = BALLISTICS_SPEED(state->vx, state->vy);
+      break;
+    }
+
+    from.y = from.y + dt * (vy+from.vy)/2;
+    from.x = x;
+    from.t = from.t + dt;
+    from.vx = vx;
+    from.vy = vy;
+  }
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
+  return 0;
+}
+
+/**
+ * A target's range paired with its position in the caller's array, so the targets can be walked in range
+ * order without reordering the caller's data.
+ */
+typedef struct {
+  double x;  // range, in feet
+  int index;
+} TargetOrder;
+
+static int TargetOrder_compare(const void* a, const void* b) {
+  double xa = ((const TargetOrder*)a)->x;
+  double xb = ((const TargetOrder*)b)->x;
+  return (xa > xb) - (xa < xb);
+}
+
+// Small target lists are sorted on the stack; only unusually long ones need the heap.
+#define TARGETS_STACK_ORDER 64
+
+int Ballistics_solve_targets(BallisticsTarget* targets, int count, DragFunction drag_function, double drag_coefficient,
+                             double vi, double sight_height, double shooting_angle, double zero_angle,
+                             double wind_speed, double wind_angle) {
   double t=0;
   double dt=0;
   double v=0;
   double vx=0, vx1=0, vy=0, vy1=0;
   double dv=0, dvx=0, dvy=0;
   double x=0, y=0;
+  double x1=0, y1=0;
+
+  TargetOrder stack_order[TARGETS_STACK_ORDER];
+  TargetOrder* order = stack_order;
+  int i;
+
+  if (count <= 0) return 0;
+  if (count > TARGETS_STACK_ORDER) {
+#ifdef BALLISTICS_EMBEDDED
+    return -1;
+#else
+    order = malloc(sizeof(TargetOrder) * count);
+    if (!order) return -1;
+#endif
+  }
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+
+  for (i = 0; i < count; i++) {
+    BallisticsTarget* target = &targets[i];
+    order[i].x = target->range_yards*3;
+    order[i].index = i;
+    target->path_inches = 0;
+    target->moa_correction = 0;
+    target->seconds = 0;
+    target->windage_inches = 0;
+    target->windage_moa = 0;
+    target->v_fps = 0;
+  }
+  qsort(order, count, sizeof(TargetOrder), TargetOrder_compare);
 
   double hwind = headwind(wind_speed, wind_angle);
   double cwind = crosswind(wind_speed, wind_angle);
@@ -271,57 +859,390 @@ int Ballistics_solve_modified_vertDeflect(Ballistics** ballistics, DragFunction
   double gy = GRAVITY*cos(deg_to_rad((shooting_angle + zero_angle)));
   double gx = GRAVITY*sin(deg_to_rad((shooting_angle + zero_angle)));
 
-  *ballistics = Ballistics_alloc();
-
   vx = vi * cos(deg_to_rad(zero_angle));
   vy = vi * sin(deg_to_rad(zero_angle));
 
   y = -sight_height/12; // y is in feet
 
-  int n = 0;
-  for (t = 0;; t = t + dt) {
+  int k = 0;
+  double max_x = BALLISTICS_COMPUTATION_MAX_YARDS*3;
+
+  // Targets at the muzzle are read straight from the initial conditions.
+  for (; k < count && order[k].x <= 0; k++) {
+    BallisticsTarget* target = &targets[order[k].index];
+    target->path_inches = y*12;
+    target->moa_correction = -rad_to_moa(BALLISTICS_ATAN(y / x));
+    target->v_fps = vi;
+  }
+
+  for (t = 0; k < count; t = t + dt) {
     vx1 = vx;
     vy1 = vy;
-    v = pow(pow(vx,2)+pow(vy,2),0.5);
+    v = BALLISTICS_SPEED(vx,vy);
     dt = 0.5/v;
+    BALLISTICS_STATS_STEP();
 
     // Compute acceleration using the drag function retardation
-    dv = retardModified(drag_function, drag_coefficient, v+hwind, formFactor);
+    dv = retard(drag_function, drag_coefficient, v+hwind);
     dvx = -(vx/v)*dv;
     dvy = -(vy/v)*dv;
 
     // Compute velocity, including the resolved gravity vectors.
     vx = vx + dt*dvx + dt*gx;
     vy = vy + dt*dvy + dt*gy;
-    double currentGs = calculateGS(bulletGrains, twistDenominator, caliberInInches, bulletLengthInInches, v, temp, inHg);
-    double windDeflectionOffsetMOA = calculateVerticalDeflection(currentGs, bulletLengthInInches, caliberInInches) * cwind;
-    double windDeflectionOffsetRad = windDeflectionOffsetMOA * (M_PI / (180.0 * 60.0));
-    if (x/3 >= n) {
-      Point* s = &(*ballistics)->yardages[n];
-      s->range_yards = x/3;
-      s->path_inches = y*12;
-      s->path_inches += tan(windDeflectionOffsetRad) * x;
-
-      s->moa_correction = -rad_to_moa(atan(y / x)) + windDeflectionOffsetMOA;
-      s->seconds = t+dt;
-      s->spindrift_inches = calculateSpinDriftOffsetIn(currentGs, s->seconds);
-      s->windage_inches = windage(cwind, vi, x, t + dt);
-      s->windage_moa = rad_to_moa(atan((s->windage_inches/12) / x));
-      s->corrected_windage = s->windage_inches + s->spindrift_inches;
-      s->corrected_windage_moa = rad_to_moa(atan((s->corrected_windage/12) / x));
-      s->v_fps = v;
-      s->vx_fps = vx;
-      s->vy_fps = vy;
-      n++;
-    }
 
     // Compute position based on average velocity.
+    x1 = x;
+    y1 = y;
     x = x + dt * (vx+vx1)/2;
     y = y + dt * (vy+vy1)/2;
 
-    if (fabs(vy)>fabs(3*vx) || n>=BALLISTICS_COMPUTATION_MAX_YARDS) break;
+    // Every target passed during this step is interpolated between the start and end of the step.
+    for (; k < count && order[k].x <= x; k++) {
+      BallisticsTarget* target = &targets[order[k].index];
+      double xt = order[k].x;
+      double f = (xt - x1) / (x - x1);
+      double yt = y1 + f*(y - y1);
+      target->path_inches = yt*12;
+      target->moa_correction = -rad_to_moa(BALLISTICS_ATAN(yt / xt));
+      target->seconds = t + f*dt;
+      target->windage_inches = windage(cwind, vi, xt, target->seconds);
+      target->windage_moa = rad_to_moa(BALLISTICS_ATAN((target->windage_inches/12) / xt));
+      target->v_fps = v + f*(BALLISTICS_SPEED(vx,vy) - v);
+    }
+
+    if (fabs(vy)>fabs(3*vx) || x>=max_x) break;
+  }
+
+#ifndef BALLISTICS_EMBEDDED
+  if (order != stack_order) free(order);
+#endif
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
+  return k;
+}
+
+#ifndef BALLISTICS_EMBEDDED
+// The spacing of the speeds the inclined-fire drag table is sampled at, in ft/s, and how far it goes, as a multiple
+// of the muzzle velocity, for shots steep enough downhill to speed up.
+#define INCLINE_SPEED_STEP 1.0
+#define INCLINE_SPEED_LIMIT 2
+
+struct BallisticsIncline {
+  // The cached shot's inputs.  Its columns belong to the cached solution and are never read.
+  Ballistics shot;
+
+  // The cached rows.
+  int rows;
+  double* x;
+  double* y;
+  double* t;
+  double* v;
+  double* vx;
+  double* vy;
+
+  // The cheap scheme's own integration of the cached shot, and the furthest it strays from the cached rows up to
+  // each row, in inches.
+  double* base_t;
+  double* base_y;
+  double* base_vx;
+  double* base_vy;
+  double* scheme_error;
+
+  // The drag per unit of speed, retard(v)/v, at every INCLINE_SPEED_STEP up to speeds*INCLINE_SPEED_STEP.
+  int speeds;
+  double* k;
+};
+
+// The cheap scheme's state at a row.
+typedef struct {
+  double t, y, vx, vy;
+} InclineState;
+
+// The drag per unit of speed at speed v, interpolated in the table; returns nonzero if v is off the table.
+static inline int Incline_k(const BallisticsIncline* incline, double v, double* k) {
+  double p = v / INCLINE_SPEED_STEP;
+  int i = (int)p;
+  if (!(i >= 1 && i < incline->speeds - 1)) return 1;
+  *k = incline->k[i] + (p - i) * (incline->k[i + 1] - incline->k[i]);
+  return 0;
+}
+
+/**
+ * One step of the cheap scheme, h feet down the line of sight: Heun's method in range, with the drag looked up
+ * instead of computed.  A step is a whole yard, six of the solvers' steps, and costs less than one of them.
+ * Returns nonzero if the speed ran off the drag table.
+ */
+static inline int Incline_step(const BallisticsIncline* incline, InclineState* s, double h, double gx, double gy) {
+  double vx = s->vx, vy = s->vy;
+  double k1, k2, vx2, vy2, dt1, dt2, dt;
+  double ax1, ay1, ax2, ay2;
+
+  if (Incline_k(incline, BALLISTICS_SPEED(vx, vy), &k1)) return 1;
+  ax1 = -k1*vx + gx;
+  ay1 = -k1*vy + gy;
+  dt1 = h / vx;
+  vx2 = vx + dt1*ax1;
+  vy2 = vy + dt1*ay1;
+  if (Incline_k(incline, BALLISTICS_SPEED(vx2, vy2), &k2)) return 1;
+  ax2 = -k2*vx2 + gx;
+  ay2 = -k2*vy2 + gy;
+  dt2 = h / vx2;
+
+  dt = (dt1 + dt2)/2;
+  s->vx = vx + dt*(ax1 + ax2)/2;
+  s->vy = vy + dt*(ay1 + ay2)/2;
+  s->y += h*(vy/vx + vy2/vx2)/2;
+  s->t += dt;
+  return 0;
+}
+
+// The cheap scheme's state at the muzzle, which is the cached shot's.
+static void Incline_muzzle(const BallisticsIncline* incline, InclineState* s) {
+  s->t = 0;
+  s->y = -incline->shot.sight_height/12;
+  s->vx = incline->shot.vi * cos(deg_to_rad(incline->shot.zero_angle));
+  s->vy = incline->shot.vi * sin(deg_to_rad(incline->shot.zero_angle));
+}
+
+int BallisticsIncline_build(BallisticsIncline** incline, Ballistics* solution) {
+  int rows = solution->max_yardage;
+  int speeds = (int)(INCLINE_SPEED_LIMIT * solution->vi / INCLINE_SPEED_STEP) + 2;
+  BallisticsIncline* c;
+  double* block;
+  InclineState s;
+  double worst = 0;
+  int i;
+
+  *incline = NULL;
+  if (rows < 2) return BALLISTICS_E_OUT_OF_RANGE;
+  c = malloc(sizeof(BallisticsIncline));
+  block = malloc(sizeof(double) * (11*rows + speeds));
+  if (!c || !block) {
+    free(c);
+    free(block);
+    return BALLISTICS_E_NO_MEMORY;
+  }
+  c->shot = *solution;
+  c->shot.x = c->shot.y = c->shot.t = c->shot.v = c->shot.vx = c->shot.vy = NULL;
+  c->x = block;
+  c->y = block + rows;
+  c->t = block + 2*rows;
+  c->v = block + 3*rows;
+  c->vx = block + 4*rows;
+  c->vy = block + 5*rows;
+  c->base_t = block + 6*rows;
+  c->base_y = block + 7*rows;
+  c->base_vx = block + 8*rows;
+  c->base_vy = block + 9*rows;
+  c->scheme_error = block + 10*rows;
+  c->k = block + 11*rows;
+  c->speeds = speeds;
+  memcpy(c->x, solution->x, sizeof(double) * rows);
+  memcpy(c->y, solution->y, sizeof(double) * rows);
+  memcpy(c->t, solution->t, sizeof(double) * rows);
+  memcpy(c->v, solution->v, sizeof(double) * rows);
+  memcpy(c->vx, solution->vx, sizeof(double) * rows);
+  memcpy(c->vy, solution->vy, sizeof(double) * rows);
+
+  c->k[0] = 0;
+  for (i = 1; i < speeds; i++) {
+    double v = i * INCLINE_SPEED_STEP;
+    c->k[i] = Ballistics_retard(&solution->drag, solution->drag.drag, v) / v;
+  }
+
+  // The cheap scheme's take on the cached shot, which the inclined shots are measured against.  A cached shot that
+  // runs off the table, which only a shot steeply downhill could, is cached as far as it stays on it.
+  Incline_muzzle(c, &s);
+  for (i = 0; i < rows; i++) {
+    if (i > 0 && Incline_step(c, &s, c->x[i] - c->x[i - 1], solution->gx, solution->gy)) break;
+    c->base_t[i] = s.t;
+    c->base_y[i] = s.y;
+    c->base_vx[i] = s.vx;
+    c->base_vy[i] = s.vy;
+    if (fabs(s.y - c->y[i])*12 > worst) worst = fabs(s.y - c->y[i])*12;
+    c->scheme_error[i] = worst;
+  }
+  c->rows = i;
+  *incline = c;
+  return 0;
+}
+
+void BallisticsIncline_free(BallisticsIncline* incline) {
+  if (incline) {
+    free(incline->x);
+    free(incline);
+  }
+}
+
+// Sets a solution up to solve the cached shot over again, in full, at another angle.
+static void Incline_restart(Ballistics* sln, const Ballistics* shot, double shooting_angle) {
+  Ballistics_start(sln, shot->drag.drag, shot->drag.function, shot->drag.table, shot->drag.coefficient,
+                   shot->drag.form_factor, shot->vi, shot->sight_height, shooting_angle, shot->zero_angle,
+                   shot->wind_speed, shot->wind_angle);
+  sln->spin = shot->spin;
+  sln->bullet_grains = shot->bullet_grains;
+  sln->twist_denominator = shot->twist_denominator;
+  sln->caliber = shot->caliber;
+  sln->bullet_length = shot->bullet_length;
+  sln->temp = shot->temp;
+  sln->inHg = shot->inHg;
+  sln->step = shot->step;
+}
+
+/**
+ * The state an integration would carry on from at a derived row.  A row from the default step is the top of its
+ * step, with the time and velocity at the end of it, so those are taken back off; the velocity at the top solves
+ * v' = v - dt*(k*v - g) with the drag k at the recorded speed.  A row from any other step is the state itself.
+ */
+static void Incline_state(const Ballistics* sln, int n, BallisticsCheckpoint* state) {
+  state->x = sln->x[n];
+  state->y = sln->y[n];
+  if (sln->step > 0) {
+    state->t = sln->t[n] - 0.5/sln->v[n];
+    state->vx = sln->vx[n];
+    state->vy = sln->vy[n];
+  }
+  else {
+    double dt = 0.5/sln->v[n];
+    double k = Ballistics_retard(&sln->drag, sln->drag.drag, sln->v[n]) / sln->v[n];
+    state->t = sln->t[n] - dt;
+    state->vx = (sln->vx[n] - dt*sln->gx) / (1 - dt*k);
+    state->vy = (sln->vy[n] - dt*sln->gy) / (1 - dt*k);
+  }
+}
+
+int Ballistics_solve_inclined_into(Ballistics* sln, const BallisticsIncline* incline, double shooting_angle,
+                                   double tolerance_inches, double* bound_inches) {
+  const Ballistics* shot = &incline->shot;
+  double change = fabs(deg_to_rad(shooting_angle - shot->shooting_angle));
+  // How much of the scheme's own error on the cached shot the difference between the two shots picks up: none at
+  // the cached angle, and in proportion to the change in gravity from there, up to twice the whole of it.
+  double scale = 8*sin(change/2) < 2 ? 8*sin(change/2) : 2;
+  int rows = Ballistics_solve_rows(sln);
+  double bound = 0;
+  int fallback = 0;
+  InclineState s;
+  int n;
+
+  if (rows > incline->rows) rows = incline->rows;
+  Incline_restart(sln, shot, shooting_angle);
+
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+  Incline_muzzle(incline, &s);
+  for (n = 0; n < rows; n++) {
+    double base_v = BALLISTICS_SPEED(incline->base_vx[n], incline->base_vy[n]);
+    double slope, error;
+    if (n > 0 && Incline_step(incline, &s, incline->x[n] - incline->x[n - 1], sln->gx, sln->gy)) {
+      fallback = 1;
+      break;
+    }
+    BALLISTICS_STATS_STEP();
+
+    // The cached row, moved by as much as the scheme moves the inclined shot from the cached one.
+    sln->x[n] = incline->x[n];
+    sln->y[n] = incline->y[n] + (s.y - incline->base_y[n]);
+    sln->t[n] = incline->t[n] + (s.t - incline->base_t[n]);
+    sln->v[n] = incline->v[n] + (BALLISTICS_SPEED(s.vx, s.vy) - base_v);
+    sln->vx[n] = incline->vx[n] + (s.vx - incline->base_vx[n]);
+    sln->vy[n] = incline->vy[n] + (s.vy - incline->base_vy[n]);
+    if (n % BALLISTICS_CHECKPOINT_INTERVAL == 0) {
+      Incline_state(sln, n, &sln->checkpoints[n / BALLISTICS_CHECKPOINT_INTERVAL]);
+    }
+
+    // An error across the path becomes an error in the path at a given range as the path steepens, by the square
+    // of the secant of its angle to the line of sight.
+    slope = sln->vy[n] / sln->vx[n];
+    error = incline->scheme_error[n] * scale * (1 + slope*slope);
+    if (error > bound) bound = error;
+    if (bound > tolerance_inches) {
+      fallback = 1;
+      break;
+    }
+    if (fabs(slope) > 1) {
+      // Falling at more than 45 degrees to the line of sight, which the cached shot gives no measure of.
+      if (fabs(slope) > 3) sln->complete = 1;
+      n++;
+      break;
+    }
   }
 
-  (*ballistics)->max_yardage = n;
+  if (!fallback) {
+    sln->max_yardage = n;
+    if (n >= BALLISTICS_COMPUTATION_MAX_YARDS) sln->complete = 1;
+
+    // Ballistics_extend() carries on from the last row.  A row from the default step is the top of its step, so
+    // that step is taken again to get past it.
+    Incline_state(sln, n - 1, &sln->resume);
+    if (!(sln->step > 0)) {
+      BallisticsCheckpoint* r = &sln->resume;
+      double v = BALLISTICS_SPEED(r->vx, r->vy);
+      double dt = 0.5/v;
+      double dv = Ballistics_retard(&sln->drag, sln->drag.drag, v);
+      double vx = r->vx + dt*(-(r->vx/v)*dv) + dt*sln->gx;
+      double vy = r->vy + dt*(-(r->vy/v)*dv) + dt*sln->gy;
+      r->x = r->x + dt * (vx+r->vx)/2;
+      r->y = r->y + dt * (vy+r->vy)/2;
+      r->t = r->t + dt;
+      r->vx = vx;
+      r->vy = vy;
+    }
+  }
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
+
+  if (fallback) {
+    // Off the drag table, or past the tolerance: solve it in full instead.
+    Incline_restart(sln, shot, shooting_angle);
+    bound = 0;
+    n = Ballistics_integrate(sln, Ballistics_solve_rows(sln));
+  }
+  if (bound_inches) *bound_inches = bound;
+  return n;
+}
+
+int Ballistics_solve_siacci(Ballistics** ballistics, const SiacciTables* tables, double drag_coefficient, double vi,
+                            double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                            double wind_angle) {
+  *ballistics = Ballistics_alloc();
+  if (!*ballistics) return BALLISTICS_E_NO_MEMORY;
+  return Ballistics_solve_siacci_into(*ballistics, tables, drag_coefficient, vi, sight_height, shooting_angle,
+                                      zero_angle, wind_speed, wind_angle);
+}
+
+int Ballistics_solve_siacci_into(Ballistics* sln, const SiacciTables* tables, double drag_coefficient, double vi,
+                                 double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                                 double wind_angle) {
+  int rows = Ballistics_solve_rows(sln);
+  int n, k;
+
+  Ballistics_start(sln, BALLISTICS_DRAG_STANDARD, SiacciTables_get_drag_function(tables), NULL, drag_coefficient, 0,
+                   vi, sight_height, shooting_angle, zero_angle, wind_speed, wind_angle);
+  // The tables leave the headwind out, so the integration that carries the rows on leaves it out too.
+  sln->drag.hwind = 0;
+  if (rows > sln->capacity) rows = sln->capacity;
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+  n = SiacciTables_trajectory(tables, drag_coefficient, vi, sight_height, shooting_angle, zero_angle, rows, sln->x,
+                              sln->y, sln->t, sln->v, sln->vx, sln->vy);
+
+  // Each row is the state at its yard, so it makes a checkpoint, and the last one a place to carry on from, as it
+  // is.  The row's time is at the end of a step from there; the state's is where it is.
+  for (k = 0; k * BALLISTICS_CHECKPOINT_INTERVAL < n; k++) {
+    int i = k * BALLISTICS_CHECKPOINT_INTERVAL;
+    sln->checkpoints[k].t = sln->t[i] - 0.5/sln->v[i];
+    sln->checkpoints[k].x = sln->x[i];
+    sln->checkpoints[k].y = sln->y[i];
+    sln->checkpoints[k].vx = sln->vx[i];
+    sln->checkpoints[k].vy = sln->vy[i];
+  }
+  if (n > 0) {
+    sln->resume.t = sln->t[n - 1] - 0.5/sln->v[n - 1];
+    sln->resume.x = sln->x[n - 1];
+    sln->resume.y = sln->y[n - 1];
+    sln->resume.vx = sln->vx[n - 1];
+    sln->resume.vy = sln->vy[n - 1];
+  }
+  sln->max_yardage = n;
+  if (n >= BALLISTICS_COMPUTATION_MAX_YARDS) sln->complete = 1;
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
   return n;
 }
+#endif
@@ -0,0 +1,113 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/batch.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// Indices claimed from the shared counter at a time; enough to keep contention on it negligible.
+#define BATCH_RUN 4
+
+/**
+ * The work shared by every thread of a Ballistics_parallel_for() call.
+ */
+typedef struct {
+  void (*body)(void* context, int index);
+  void* context;
+  int count;
+  atomic_int next;
+} ParallelJob;
+
+static void* ParallelJob_worker(void* arg) {
+  ParallelJob* job = arg;
+  int first, i;
+
+  while ((first = atomic_fetch_add(&job->next, BATCH_RUN)) < job->count) {
+    int last = first + BATCH_RUN < job->count ? first + BATCH_RUN : job->count;
+    for (i = first; i < last; i++) {
+      job->body(job->context, i);
+    }
+  }
+  return NULL;
+}
+
+void Ballistics_parallel_for(int count, int threads, void (*body)(void* context, int index), void* context) {
+  pthread_t workers[BATCH_MAX_THREADS];
+  ParallelJob job;
+  int started = 0;
+  int i;
+
+  if (count <= 0) return;
+  job.body = body;
+  job.context = context;
+  job.count = count;
+  atomic_init(&job.next, 0);
+
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads > (count + BATCH_RUN - 1) / BATCH_RUN) threads = (count + BATCH_RUN - 1) / BATCH_RUN;
+  if (threads > BATCH_MAX_THREADS) threads = BATCH_MAX_THREADS;
+
+  // The calling thread works too, so only threads-1 extra workers are needed.
+  for (i = 1; i < threads; i++) {
+    if (pthread_create(&workers[started], NULL, ParallelJob_worker, &job) == 0) started++;
+  }
+  ParallelJob_worker(&job);
+  for (i = 0; i < started; i++) {
+    pthread_join(workers[i], NULL);
+  }
+}
+
+static void Ballistics_solve_item(void* context, int index) {
+  BallisticsBatchItem* item = &((BallisticsBatchItem*)context)[index];
+
+  item->zero_angle = zero_angle(item->drag_function, item->drag_coefficient, item->vi, item->sight_height,
+                                item->zero_range, item->y_intercept);
+  item->status = Ballistics_solve_targets(item->targets, item->target_count, item->drag_function,
+                                          item->drag_coefficient, item->vi, item->sight_height, item->shooting_angle,
+                                          item->zero_angle, item->wind_speed, item->wind_angle);
+}
+
+void Ballistics_solve_batch(BallisticsBatchItem* items, int count, int threads) {
+  Ballistics_parallel_for(count, threads, Ballistics_solve_item, items);
+}
+
+/**
+ * The work shared by every thread of a Ballistics_solve_batch_into() call.
+ */
+typedef struct {
+  Ballistics** solutions;
+  BallisticsBatchItem* items;
+} SolutionBatch;
+
+static void Ballistics_solve_item_into(void* context, int index) {
+  SolutionBatch* batch = context;
+  BallisticsBatchItem* item = &batch->items[index];
+
+  item->zero_angle = zero_angle(item->drag_function, item->drag_coefficient, item->vi, item->sight_height,
+                                item->zero_range, item->y_intercept);
+  item->status = Ballistics_solve_into(batch->solutions[index], item->drag_function, item->drag_coefficient,
+                                       item->vi, item->sight_height, item->shooting_angle, item->zero_angle,
+                                       item->wind_speed, item->wind_angle);
+}
+
+void Ballistics_solve_batch_into(Ballistics** solutions, BallisticsBatchItem* items, int count, int threads) {
+  SolutionBatch batch;
+  batch.solutions = solutions;
+  batch.items = items;
+  Ballistics_parallel_for(count, threads, Ballistics_solve_item_into, &batch);
+}
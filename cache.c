@@ -0,0 +1,422 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/ballistics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define CACHE_SHARDS 16         // must be a power of two
+#define CACHE_BUCKETS 1024      // per shard; must be a power of two
+#define CACHE_KEY_VALUES 8
+
+// An estimate of what an entry costs beyond its result, used against the memory budget.
+#define CACHE_ENTRY_OVERHEAD 128
+
+typedef enum {
+  CACHE_SOLVE = 1, CACHE_ZERO_ANGLE, CACHE_PBR
+} CacheKind;
+
+typedef struct {
+  int kind;
+  int drag_function;
+  int64_t values[CACHE_KEY_VALUES];
+  int64_t exact;                // bit i is set where values[i] holds a value's bits rather than a multiple
+} CacheKey;
+
+struct BallisticsCacheEntry {
+  CacheKey key;
+  uint64_t hash;
+  atomic_int refs;              // one for the cache while the entry is in it, plus one per caller
+  int referenced;               // the CLOCK bit; guarded by the shard lock
+  size_t bytes;
+  BallisticsCacheEntry* next;   // hash chain
+
+  int result;
+  double angle;
+  Ballistics* ballistics;
+  struct PBR* pbr;
+};
+
+typedef struct {
+  pthread_mutex_t lock;
+  BallisticsCacheEntry* buckets[CACHE_BUCKETS];
+  BallisticsCacheEntry** ring;  // every entry in the shard, in clock order
+  int entries;
+  int capacity;
+  int hand;
+  size_t bytes;
+} CacheShard;
+
+struct BallisticsCache {
+  BallisticsCacheConfig config;
+  size_t shard_budget;
+  CacheShard shards[CACHE_SHARDS];
+
+  atomic_ullong hits;
+  atomic_ullong misses;
+  atomic_ullong evictions;
+};
+
+void BallisticsCache_default_config(BallisticsCacheConfig* config) {
+  config->memory_budget = 256u << 20;
+  config->drag_coefficient_quantum = 0.001;
+  config->velocity_quantum = 1;
+  config->sight_height_quantum = 0.01;
+  config->range_quantum = 1;
+  config->y_intercept_quantum = 0.01;
+  config->angle_quantum = 0.1;
+  config->zero_angle_quantum = moa_to_deg(0.01);
+  config->wind_speed_quantum = 0.1;
+  config->wind_angle_quantum = 0.1;
+  config->vital_size_quantum = 0.01;
+}
+
+BallisticsCache* BallisticsCache_alloc(const BallisticsCacheConfig* config) {
+  BallisticsCache* cache = calloc(1, sizeof(BallisticsCache));
+  int i;
+
+  if (!cache) return NULL;
+  if (config) cache->config = *config;
+  else BallisticsCache_default_config(&cache->config);
+  cache->shard_budget = cache->config.memory_budget / CACHE_SHARDS;
+
+  for (i = 0; i < CACHE_SHARDS; i++) {
+    pthread_mutex_init(&cache->shards[i].lock, NULL);
+  }
+  atomic_init(&cache->hits, 0);
+  atomic_init(&cache->misses, 0);
+  atomic_init(&cache->evictions, 0);
+  return cache;
+}
+
+static void CacheEntry_destroy(BallisticsCacheEntry* entry) {
+  if (entry->ballistics) Ballistics_free(entry->ballistics);
+  if (entry->pbr) PBR_free(entry->pbr);
+  free(entry);
+}
+
+void BallisticsCache_release(BallisticsCacheEntry* entry) {
+  if (atomic_fetch_sub_explicit(&entry->refs, 1, memory_order_acq_rel) == 1) {
+    CacheEntry_destroy(entry);
+  }
+}
+
+void BallisticsCache_free(BallisticsCache* cache) {
+  int i, j;
+
+  for (i = 0; i < CACHE_SHARDS; i++) {
+    CacheShard* shard = &cache->shards[i];
+    for (j = 0; j < shard->entries; j++) {
+      BallisticsCache_release(shard->ring[j]);
+    }
+    free(shard->ring);
+    pthread_mutex_destroy(&shard->lock);
+  }
+  free(cache);
+}
+
+/**
+ * Rounds a value to its quantum, keying the multiple into values[i] and returning the rounded value to solve with.
+ * A value too large for its multiple to fit the key is keyed on its exact bits instead.
+ * @return 0, or nonzero if the value is NaN or infinite, which there is nothing to solve for
+ */
+static int quantize(CacheKey* key, int i, double value, double quantum, double* rounded) {
+  double multiple;
+
+  if (!isfinite(value)) return 1;
+  multiple = quantum > 0 ? floor(value/quantum + 0.5) : 0;
+  // Past 2^53 the multiples are no longer whole numbers apart, and past 2^63 they don't fit the key at all.
+  if (quantum <= 0 || !(fabs(multiple) < 9007199254740992.0)) {
+    // No rounding: key on the exact bits.
+    memcpy(&key->values[i], &value, sizeof(value));
+    key->exact |= (int64_t)1 << i;
+    *rounded = value;
+    return 0;
+  }
+  key->values[i] = (int64_t)multiple;
+  *rounded = multiple*quantum;
+  return 0;
+}
+
+static uint64_t CacheKey_hash(const CacheKey* key) {
+  // splitmix64 finalizer over each field.
+  uint64_t h = (uint64_t)key->kind*0x9e3779b97f4a7c15ull ^ (uint64_t)key->drag_function ^ (uint64_t)key->exact << 32;
+  int i;
+  for (i = 0; i < CACHE_KEY_VALUES; i++) {
+    h ^= (uint64_t)key->values[i] + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+  }
+  return h;
+}
+
+static CacheShard* CacheKey_shard(BallisticsCache* cache, uint64_t hash) {
+  return &cache->shards[hash & (CACHE_SHARDS - 1)];
+}
+
+static BallisticsCacheEntry** CacheShard_bucket(CacheShard* shard, uint64_t hash) {
+  return &shard->buckets[(hash >> 8) & (CACHE_BUCKETS - 1)];
+}
+
+/**
+ * Looks up a key, taking a reference on the entry if it is found.  The caller holds the shard lock.
+ */
+static BallisticsCacheEntry* CacheShard_find(CacheShard* shard, const CacheKey* key, uint64_t hash) {
+  BallisticsCacheEntry* entry = *CacheShard_bucket(shard, hash);
+  for (; entry; entry = entry->next) {
+    if (entry->hash == hash && memcmp(&entry->key, key, sizeof(CacheKey)) == 0) {
+      entry->referenced = 1;
+      atomic_fetch_add_explicit(&entry->refs, 1, memory_order_relaxed);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Removes the entry under the clock hand.  The caller holds the shard lock.
+ */
+static void CacheShard_evict(BallisticsCache* cache, CacheShard* shard) {
+  for (;;) {
+    BallisticsCacheEntry* entry;
+    BallisticsCacheEntry** link;
+
+    if (shard->hand >= shard->entries) shard->hand = 0;
+    entry = shard->ring[shard->hand];
+    if (entry->referenced) {
+      // Recently used: give it another trip around the clock.
+      entry->referenced = 0;
+      shard->hand++;
+      continue;
+    }
+
+    for (link = CacheShard_bucket(shard, entry->hash); *link != entry; link = &(*link)->next) {}
+    *link = entry->next;
+
+    shard->ring[shard->hand] = shard->ring[--shard->entries];
+    shard->bytes -= entry->bytes;
+    atomic_fetch_add_explicit(&cache->evictions, 1, memory_order_relaxed);
+    BallisticsCache_release(entry);
+    return;
+  }
+}
+
+/**
+ * Inserts a freshly solved entry, unless another thread got there first, in which case the existing entry is
+ * returned and the fresh one discarded.  Either way the caller gets a referenced entry back.
+ */
+static BallisticsCacheEntry* BallisticsCache_insert(BallisticsCache* cache, BallisticsCacheEntry* fresh) {
+  CacheShard* shard = CacheKey_shard(cache, fresh->hash);
+  BallisticsCacheEntry* existing;
+
+  // Results that could never fit are handed straight to the caller without being cached.
+  if (fresh->bytes > cache->shard_budget) return fresh;
+
+  pthread_mutex_lock(&shard->lock);
+  existing = CacheShard_find(shard, &fresh->key, fresh->hash);
+  if (existing) {
+    pthread_mutex_unlock(&shard->lock);
+    BallisticsCache_release(fresh);
+    return existing;
+  }
+
+  while (shard->entries > 0 && shard->bytes + fresh->bytes > cache->shard_budget) {
+    CacheShard_evict(cache, shard);
+  }
+  if (shard->entries == shard->capacity) {
+    int capacity = shard->capacity ? shard->capacity*2 : 64;
+    BallisticsCacheEntry** ring = realloc(shard->ring, sizeof(BallisticsCacheEntry*)*capacity);
+    if (!ring) {
+      pthread_mutex_unlock(&shard->lock);
+      return fresh;
+    }
+    shard->ring = ring;
+    shard->capacity = capacity;
+  }
+
+  BallisticsCacheEntry** bucket = CacheShard_bucket(shard, fresh->hash);
+  fresh->next = *bucket;
+  *bucket = fresh;
+  shard->ring[shard->entries++] = fresh;
+  shard->bytes += fresh->bytes;
+  atomic_fetch_add_explicit(&fresh->refs, 1, memory_order_relaxed); // the cache's own reference
+  pthread_mutex_unlock(&shard->lock);
+  return fresh;
+}
+
+/**
+ * Finds a cached entry for the key, or returns NULL after counting a miss.
+ */
+static BallisticsCacheEntry* BallisticsCache_lookup(BallisticsCache* cache, const CacheKey* key, uint64_t hash) {
+  CacheShard* shard = CacheKey_shard(cache, hash);
+  BallisticsCacheEntry* entry;
+
+  pthread_mutex_lock(&shard->lock);
+  entry = CacheShard_find(shard, key, hash);
+  pthread_mutex_unlock(&shard->lock);
+
+  if (entry) atomic_fetch_add_explicit(&cache->hits, 1, memory_order_relaxed);
+  else atomic_fetch_add_explicit(&cache->misses, 1, memory_order_relaxed);
+  return entry;
+}
+
+static BallisticsCacheEntry* CacheEntry_alloc(const CacheKey* key, uint64_t hash) {
+  BallisticsCacheEntry* entry = calloc(1, sizeof(BallisticsCacheEntry));
+  if (!entry) return NULL;
+  entry->key = *key;
+  entry->hash = hash;
+  entry->bytes = CACHE_ENTRY_OVERHEAD;
+  atomic_init(&entry->refs, 1);
+  return entry;
+}
+
+int BallisticsCache_solve(BallisticsCache* cache, BallisticsCacheEntry** entry, DragFunction drag_function,
+                          double drag_coefficient, double vi, double sight_height, double shooting_angle,
+                          double zero_angle, double wind_speed, double wind_angle) {
+  const BallisticsCacheConfig* c = &cache->config;
+  CacheKey key;
+  uint64_t hash;
+
+  memset(&key, 0, sizeof(key));
+  key.kind = CACHE_SOLVE;
+  key.drag_function = drag_function;
+  *entry = NULL;
+  if (quantize(&key, 0, drag_coefficient, c->drag_coefficient_quantum, &drag_coefficient) ||
+      quantize(&key, 1, vi, c->velocity_quantum, &vi) ||
+      quantize(&key, 2, sight_height, c->sight_height_quantum, &sight_height) ||
+      quantize(&key, 3, shooting_angle, c->angle_quantum, &shooting_angle) ||
+      quantize(&key, 4, zero_angle, c->zero_angle_quantum, &zero_angle) ||
+      quantize(&key, 5, wind_speed, c->wind_speed_quantum, &wind_speed) ||
+      quantize(&key, 6, wind_angle, c->wind_angle_quantum, &wind_angle)) {
+    return BALLISTICS_E_ARGUMENTS;
+  }
+  hash = CacheKey_hash(&key);
+
+  *entry = BallisticsCache_lookup(cache, &key, hash);
+  if (!*entry) {
+    BallisticsCacheEntry* fresh = CacheEntry_alloc(&key, hash);
+    if (!fresh) return BALLISTICS_E_NO_MEMORY;
+    fresh->result = Ballistics_solve(&fresh->ballistics, drag_function, drag_coefficient, vi, sight_height,
+                                     shooting_angle, zero_angle, wind_speed, wind_angle);
+    if (fresh->result == BALLISTICS_E_NO_MEMORY) {
+      // Not cached: there may be memory for it next time.
+      CacheEntry_destroy(fresh);
+      return BALLISTICS_E_NO_MEMORY;
+    }
+    fresh->bytes += Ballistics_compact(fresh->ballistics);
+    *entry = BallisticsCache_insert(cache, fresh);
+  }
+  return (*entry)->result;
+}
+
+double BallisticsCache_zero_angle(BallisticsCache* cache, DragFunction drag_function, double drag_coefficient,
+                                  double vi, double sight_height, double zero_range, double y_intercept) {
+  const BallisticsCacheConfig* c = &cache->config;
+  BallisticsCacheEntry* entry;
+  CacheKey key;
+  uint64_t hash;
+  double angle;
+
+  memset(&key, 0, sizeof(key));
+  key.kind = CACHE_ZERO_ANGLE;
+  key.drag_function = drag_function;
+  if (quantize(&key, 0, drag_coefficient, c->drag_coefficient_quantum, &drag_coefficient) ||
+      quantize(&key, 1, vi, c->velocity_quantum, &vi) ||
+      quantize(&key, 2, sight_height, c->sight_height_quantum, &sight_height) ||
+      quantize(&key, 3, zero_range, c->range_quantum, &zero_range) ||
+      quantize(&key, 4, y_intercept, c->y_intercept_quantum, &y_intercept)) {
+    return NAN;
+  }
+  hash = CacheKey_hash(&key);
+
+  entry = BallisticsCache_lookup(cache, &key, hash);
+  if (!entry) {
+    BallisticsCacheEntry* fresh = CacheEntry_alloc(&key, hash);
+    angle = zero_angle(drag_function, drag_coefficient, vi, sight_height, zero_range, y_intercept);
+    if (!fresh) return angle;
+    fresh->angle = angle;
+    entry = BallisticsCache_insert(cache, fresh);
+  }
+  angle = entry->angle;
+  BallisticsCache_release(entry);
+  return angle;
+}
+
+int BallisticsCache_PBR_solve(BallisticsCache* cache, BallisticsCacheEntry** entry, DragFunction drag_function,
+                              double drag_coefficient, double vi, double sight_height, double vital_size) {
+  const BallisticsCacheConfig* c = &cache->config;
+  CacheKey key;
+  uint64_t hash;
+
+  memset(&key, 0, sizeof(key));
+  key.kind = CACHE_PBR;
+  key.drag_function = drag_function;
+  *entry = NULL;
+  if (quantize(&key, 0, drag_coefficient, c->drag_coefficient_quantum, &drag_coefficient) ||
+      quantize(&key, 1, vi, c->velocity_quantum, &vi) ||
+      quantize(&key, 2, sight_height, c->sight_height_quantum, &sight_height) ||
+      quantize(&key, 3, vital_size, c->vital_size_quantum, &vital_size)) {
+    return PBR_E_ARGUMENTS;
+  }
+  hash = CacheKey_hash(&key);
+
+  *entry = BallisticsCache_lookup(cache, &key, hash);
+  if (!*entry) {
+    BallisticsCacheEntry* fresh = CacheEntry_alloc(&key, hash);
+    if (!fresh) return PBR_E_NO_MEMORY;
+    fresh->result = PBR_solve(&fresh->pbr, drag_function, drag_coefficient, vi, sight_height, vital_size);
+    if (fresh->result) fresh->pbr = NULL;
+    if (fresh->result == PBR_E_NO_MEMORY) {
+      CacheEntry_destroy(fresh);
+      return PBR_E_NO_MEMORY;
+    }
+    *entry = BallisticsCache_insert(cache, fresh);
+  }
+  return (*entry)->result;
+}
+
+Ballistics* BallisticsCacheEntry_ballistics(const BallisticsCacheEntry* entry) {
+  return entry->ballistics;
+}
+
+struct PBR* BallisticsCacheEntry_pbr(const BallisticsCacheEntry* entry) {
+  return entry->pbr;
+}
+
+void BallisticsCache_stats(BallisticsCache* cache, BallisticsCacheStats* stats) {
+  int i;
+
+  stats->hits = atomic_load_explicit(&cache->hits, memory_order_relaxed);
+  stats->misses = atomic_load_explicit(&cache->misses, memory_order_relaxed);
+  stats->evictions = atomic_load_explicit(&cache->evictions, memory_order_relaxed);
+  stats->entries = 0;
+  stats->bytes = 0;
+  for (i = 0; i < CACHE_SHARDS; i++) {
+    CacheShard* shard = &cache->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    stats->entries += shard->entries;
+    stats->bytes += shard->bytes;
+    pthread_mutex_unlock(&shard->lock);
+  }
+}
@@ -0,0 +1,349 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/chebyshev.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHEBYSHEV_MAGIC "BLSTCHB1"
+#define CHEBYSHEV_BYTE_ORDER 0x01020304
+
+typedef struct {
+  uint32_t segments;  // pieces over the range
+  uint32_t first;     // the first of them in the piece table
+} ChebyshevSeries;
+
+typedef struct {
+  double start;       // the range the piece starts at, in yards; it ends where the next starts
+  uint32_t offset;    // the first coefficient
+  uint32_t count;
+} ChebyshevSegment;
+
+// The pieces of every channel as they are fitted, each with room for CHEBYSHEV_MAX_COEFFICIENTS coefficients.
+typedef struct {
+  int pieces;
+  double starts[CHEBYSHEV_CHANNELS * CHEBYSHEV_MAX_SEGMENTS];
+  int counts[CHEBYSHEV_CHANNELS * CHEBYSHEV_MAX_SEGMENTS];
+  double coefficients[CHEBYSHEV_CHANNELS * CHEBYSHEV_MAX_SEGMENTS * CHEBYSHEV_MAX_COEFFICIENTS];
+} ChebyshevPieces;
+
+// Exactly the serialized header; the piece table and the coefficients follow it in the same block.
+struct ChebyshevTrajectory {
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t size;
+  double max_range;
+  double vi;
+  ChebyshevSeries series[CHEBYSHEV_CHANNELS];
+};
+
+static inline const ChebyshevSegment* Chebyshev_segments(const ChebyshevTrajectory* trajectory) {
+  return (const ChebyshevSegment*)(trajectory + 1);
+}
+
+static inline uint32_t Chebyshev_segment_count(const ChebyshevTrajectory* trajectory) {
+  return trajectory->series[CHEBYSHEV_CHANNELS - 1].first + trajectory->series[CHEBYSHEV_CHANNELS - 1].segments;
+}
+
+static inline const double* Chebyshev_coefficients(const ChebyshevTrajectory* trajectory) {
+  return (const double*)(Chebyshev_segments(trajectory) + Chebyshev_segment_count(trajectory));
+}
+
+// Sums a Chebyshev series at u, from -1 to 1, by Clenshaw's recurrence.
+static inline double Chebyshev_sum(const double* c, int count, double u) {
+  double b1 = 0, b2 = 0;
+  int j;
+  for (j = count - 1; j > 0; j--) {
+    double b = 2*u*b1 - b2 + c[j];
+    b2 = b1;
+    b1 = b;
+  }
+  return u*b1 - b2 + c[0];
+}
+
+// The value at range p, in yards, by cubic interpolation through the rows around it, at ranges r.
+static double Chebyshev_sample(const double* r, const double* f, int rows, double p) {
+  int n = rows < 4 ? rows : 4;
+  int first = (int)p;
+  double value = 0;
+  int i, j;
+
+  // Rows fall at or a little past their yard, so the row just short of p is at most one before its yard.
+  first = first < rows - 1 ? first : rows - 1;
+  while (first > 0 && r[first] > p) first--;
+  first = first - 1 < rows - n ? first - 1 : rows - n;
+  first = first > 0 ? first : 0;
+  for (i = 0; i < n; i++) {
+    double weight = f[first + i];
+    for (j = 0; j < n; j++) {
+      if (j != i) weight *= (p - r[first + j]) / (r[first + i] - r[first + j]);
+    }
+    value += weight;
+  }
+  return value;
+}
+
+/**
+ * Fits one piece, from range a to b, with the series through CHEBYSHEV_MAX_COEFFICIENTS Chebyshev points cut off
+ * where the rest of it adds up to less than a quarter of the tolerance, and checks it against every yard inside.
+ * @return the number of coefficients kept, or 0 if the piece misses a yard by more than the tolerance
+ */
+static int Chebyshev_fit_segment(const double* r, const double* f, int rows, double a, double b, double tolerance,
+                                 double* c) {
+  double values[CHEBYSHEV_MAX_COEFFICIENTS];
+  double tail = 0;
+  int n = CHEBYSHEV_MAX_COEFFICIENTS;
+  int count, j, k, i;
+
+  for (k = 0; k < n; k++) {
+    double u = cos(M_PI * (k + 0.5) / n);
+    values[k] = Chebyshev_sample(r, f, rows, (a + b)/2 + u*(b - a)/2);
+  }
+  for (j = 0; j < n; j++) {
+    double sum = 0;
+    for (k = 0; k < n; k++) sum += values[k] * cos(M_PI * j * (k + 0.5) / n);
+    c[j] = sum * (j ? 2.0 : 1.0) / n;
+  }
+
+  for (count = n; count > 1 && tail + fabs(c[count - 1]) <= tolerance/4; count--) tail += fabs(c[count - 1]);
+  if (count == n && fabs(c[n - 1]) > tolerance/4) return 0;
+
+  for (i = (int)a > 0 ? (int)a - 1 : 0; i < rows && r[i] <= b; i++) {
+    if (r[i] >= a && fabs(Chebyshev_sum(c, count, (2*r[i] - a - b) / (b - a)) - f[i]) > tolerance) return 0;
+  }
+  return count;
+}
+
+/**
+ * Fits a channel from range a to b, halving the range wherever a piece doesn't fit, so pieces are short only
+ * around the kinks the drag functions put in the velocity and long everywhere else.
+ * @return 0, or CHEBYSHEV_E_TOLERANCE once a piece is as short as CHEBYSHEV_MAX_SEGMENTS pieces would be
+ */
+static int Chebyshev_fit_pieces(const double* r, const double* f, int rows, double a, double b, int depth,
+                                double tolerance, ChebyshevPieces* pieces) {
+  int n = pieces->pieces;
+  int count = Chebyshev_fit_segment(r, f, rows, a, b, tolerance, &pieces->coefficients[n*CHEBYSHEV_MAX_COEFFICIENTS]);
+  int status;
+
+  if (count) {
+    pieces->starts[n] = a;
+    pieces->counts[n] = count;
+    pieces->pieces++;
+    return 0;
+  }
+  if ((1 << depth) >= CHEBYSHEV_MAX_SEGMENTS) return CHEBYSHEV_E_TOLERANCE;
+  status = Chebyshev_fit_pieces(r, f, rows, a, (a + b)/2, depth + 1, tolerance, pieces);
+  if (status) return status;
+  return Chebyshev_fit_pieces(r, f, rows, (a + b)/2, b, depth + 1, tolerance, pieces);
+}
+
+int ChebyshevTrajectory_fit(ChebyshevTrajectory** trajectory, Ballistics* solution, const double* tolerances) {
+  static const double default_tolerances[CHEBYSHEV_CHANNELS] = {
+    CHEBYSHEV_PATH_TOLERANCE, CHEBYSHEV_TIME_TOLERANCE, CHEBYSHEV_VELOCITY_TOLERANCE, CHEBYSHEV_LAG_TOLERANCE
+  };
+  int rows = Ballistics_get_max_yardage(solution);
+  int first[CHEBYSHEV_CHANNELS + 1];
+  ChebyshevPieces* pieces = NULL;
+  double* f = NULL;
+  double* r = NULL;
+  ChebyshevTrajectory* fit = NULL;
+  ChebyshevSegment* table;
+  double* out;
+  size_t total = 0, size;
+  double vi;
+  int status = 0;
+  int c, i;
+
+  *trajectory = NULL;
+  if (!tolerances) tolerances = default_tolerances;
+  if (rows < 2) return CHEBYSHEV_E_ARGUMENTS;
+  for (c = 0; c < CHEBYSHEV_CHANNELS; c++) {
+    if (!(tolerances[c] > 0)) return CHEBYSHEV_E_ARGUMENTS;
+  }
+
+  pieces = malloc(sizeof(ChebyshevPieces));
+  f = malloc(sizeof(double) * rows);
+  r = malloc(sizeof(double) * rows);
+  if (!pieces || !f || !r) {
+    status = CHEBYSHEV_E_NO_MEMORY;
+    goto done;
+  }
+
+  // Each row is fitted at the range it was recorded at, rather than the yard it is filed under, which it can be
+  // up to a step past.  The first row is the muzzle, where the velocity is the muzzle velocity.
+  Ballistics_get_rows(solution, BALLISTICS_RANGE, 0, rows, r);
+  Ballistics_get_rows(solution, BALLISTICS_V, 0, 1, &vi);
+  if (!(r[rows - 1] > 0)) {
+    status = CHEBYSHEV_E_ARGUMENTS;
+    goto done;
+  }
+
+  pieces->pieces = 0;
+  for (c = 0; c < CHEBYSHEV_CHANNELS; c++) {
+    switch (c) {
+      case CHEBYSHEV_PATH: Ballistics_get_rows(solution, BALLISTICS_PATH, 0, rows, f); break;
+      case CHEBYSHEV_TIME: Ballistics_get_rows(solution, BALLISTICS_TIME, 0, rows, f); break;
+      case CHEBYSHEV_VELOCITY: Ballistics_get_rows(solution, BALLISTICS_V, 0, rows, f); break;
+      case CHEBYSHEV_LAG:
+        // The same time and range that windage() takes.
+        Ballistics_get_rows(solution, BALLISTICS_TIME, 0, rows, f);
+        for (i = 0; i < rows; i++) f[i] -= r[i]*3/vi;
+        break;
+    }
+    first[c] = pieces->pieces;
+    status = Chebyshev_fit_pieces(r, f, rows, 0, r[rows - 1], 0, tolerances[c], pieces);
+    if (status) goto done;
+  }
+  first[CHEBYSHEV_CHANNELS] = pieces->pieces;
+  for (i = 0; i < pieces->pieces; i++) total += pieces->counts[i];
+
+  size = sizeof(ChebyshevTrajectory) + sizeof(ChebyshevSegment)*pieces->pieces + sizeof(double)*total;
+  fit = calloc(1, size);
+  if (!fit) {
+    status = CHEBYSHEV_E_NO_MEMORY;
+    goto done;
+  }
+  memcpy(fit->magic, CHEBYSHEV_MAGIC, sizeof(fit->magic));
+  fit->byte_order = CHEBYSHEV_BYTE_ORDER;
+  fit->size = (uint32_t)size;
+  fit->max_range = r[rows - 1];
+  fit->vi = vi;
+  for (c = 0; c < CHEBYSHEV_CHANNELS; c++) {
+    fit->series[c].first = (uint32_t)first[c];
+    fit->series[c].segments = (uint32_t)(first[c + 1] - first[c]);
+  }
+
+  table = (ChebyshevSegment*)(fit + 1);
+  out = (double*)(table + pieces->pieces);
+  total = 0;
+  for (i = 0; i < pieces->pieces; i++) {
+    table[i].start = pieces->starts[i];
+    table[i].offset = (uint32_t)total;
+    table[i].count = (uint32_t)pieces->counts[i];
+    memcpy(&out[total], &pieces->coefficients[i*CHEBYSHEV_MAX_COEFFICIENTS], sizeof(double)*pieces->counts[i]);
+    total += pieces->counts[i];
+  }
+  *trajectory = fit;
+
+done:
+  free(pieces);
+  free(f);
+  free(r);
+  return status;
+}
+
+void ChebyshevTrajectory_free(ChebyshevTrajectory* trajectory) {
+  free(trajectory);
+}
+
+const void* ChebyshevTrajectory_bytes(const ChebyshevTrajectory* trajectory) {
+  return trajectory;
+}
+
+size_t ChebyshevTrajectory_size(const ChebyshevTrajectory* trajectory) {
+  return trajectory->size;
+}
+
+int ChebyshevTrajectory_load(ChebyshevTrajectory** trajectory, const void* bytes, size_t size) {
+  ChebyshevTrajectory header;
+  ChebyshevTrajectory* fit;
+  const ChebyshevSegment* table;
+  uint32_t pieces = 0;
+  size_t coefficients;
+  uint32_t i;
+  int c;
+
+  *trajectory = NULL;
+  if (size < sizeof(header)) return CHEBYSHEV_E_FORMAT;
+  memcpy(&header, bytes, sizeof(header));
+  if (memcmp(header.magic, CHEBYSHEV_MAGIC, sizeof(header.magic)) != 0 || header.byte_order != CHEBYSHEV_BYTE_ORDER ||
+      header.size != size || !(header.max_range > 0)) {
+    return CHEBYSHEV_E_FORMAT;
+  }
+
+  // Every channel's pieces have to follow on from the last's, and every piece has to lie inside the coefficients.
+  for (c = 0; c < CHEBYSHEV_CHANNELS; c++) {
+    if (header.series[c].first != pieces || header.series[c].segments < 1 ||
+        header.series[c].segments > CHEBYSHEV_MAX_SEGMENTS) {
+      return CHEBYSHEV_E_FORMAT;
+    }
+    pieces += header.series[c].segments;
+  }
+  if (size < sizeof(header) + sizeof(ChebyshevSegment)*pieces ||
+      (size - sizeof(header) - sizeof(ChebyshevSegment)*pieces) % sizeof(double) != 0) {
+    return CHEBYSHEV_E_FORMAT;
+  }
+
+  fit = malloc(size);
+  if (!fit) return CHEBYSHEV_E_NO_MEMORY;
+  memcpy(fit, bytes, size);
+  table = Chebyshev_segments(fit);
+  coefficients = (size - sizeof(header) - sizeof(ChebyshevSegment)*pieces) / sizeof(double);
+  for (i = 0; i < pieces; i++) {
+    if (table[i].count < 1 || table[i].count > CHEBYSHEV_MAX_COEFFICIENTS || table[i].count > coefficients ||
+        table[i].offset > coefficients - table[i].count) {
+      free(fit);
+      return CHEBYSHEV_E_FORMAT;
+    }
+  }
+  // And each channel's pieces have to start at the muzzle and run in order to the end.
+  for (c = 0; c < CHEBYSHEV_CHANNELS; c++) {
+    const ChebyshevSegment* series = &table[fit->series[c].first];
+    int ordered = series[0].start == 0;
+    for (i = 1; i < fit->series[c].segments; i++) {
+      ordered &= series[i].start > series[i - 1].start && series[i].start < fit->max_range;
+    }
+    if (!ordered) {
+      free(fit);
+      return CHEBYSHEV_E_FORMAT;
+    }
+  }
+  *trajectory = fit;
+  return 0;
+}
+
+double ChebyshevTrajectory_get_max_range(const ChebyshevTrajectory* trajectory) {
+  return trajectory->max_range;
+}
+
+double ChebyshevTrajectory_get(const ChebyshevTrajectory* trajectory, ChebyshevChannel channel, double range_yards) {
+  const ChebyshevSegment* series;
+  uint32_t lo, hi;
+  double b;
+
+  if (channel < CHEBYSHEV_PATH || channel >= CHEBYSHEV_CHANNELS) return 0;
+  if (!(range_yards >= 0 && range_yards <= trajectory->max_range)) return 0;
+
+  // The piece the range falls in, by bisecting at most log2(CHEBYSHEV_MAX_SEGMENTS) times.
+  series = &Chebyshev_segments(trajectory)[trajectory->series[channel].first];
+  lo = 0;
+  hi = trajectory->series[channel].segments - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi + 1) / 2;
+    if (series[mid].start <= range_yards) lo = mid;
+    else hi = mid - 1;
+  }
+  b = lo + 1 < trajectory->series[channel].segments ? series[lo + 1].start : trajectory->max_range;
+  return Chebyshev_sum(Chebyshev_coefficients(trajectory) + series[lo].offset, (int)series[lo].count,
+                       (2*range_yards - series[lo].start - b) / (b - series[lo].start));
+}
+
+double ChebyshevTrajectory_get_windage(const ChebyshevTrajectory* trajectory, double range_yards, double crosswind) {
+  return crosswind*17.60 * ChebyshevTrajectory_get(trajectory, CHEBYSHEV_LAG, range_yards);
+}
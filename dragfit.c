@@ -0,0 +1,260 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/ballistics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// The fewest decelerations a band needs for its fit to be kept.
+#define DRAGFIT_MIN_SAMPLES 8
+
+/**
+ * Running least-squares sums for ln(deceleration) against ln(velocity) in one band.
+ */
+typedef struct {
+  double n;
+  double sx, sy;
+  double sxx, sxy;
+} BandSums;
+
+/**
+ * The work shared by every thread of a DragFit_fit_files() call.
+ */
+typedef struct {
+  const char* const* paths;
+  int count;
+  const double* edges; // band lower bounds, fastest first
+  int bands;
+  int stride;
+
+  // Sums for each file, kept apart so the merge order never depends on the thread count.
+  BandSums* sums;
+  int* status;
+
+  pthread_mutex_t lock;
+  int next;
+} DragFitJob;
+
+static int compare_descending(const void* a, const void* b) {
+  double da = *(const double*)a;
+  double db = *(const double*)b;
+  return (da < db) - (da > db);
+}
+
+/**
+ * Streams one track file into its band sums.
+ * @return 0, or DRAGFIT_E_IO
+ */
+static int DragFit_file(DragFitJob* job, const char* path, BandSums* sums) {
+  double ring_x[DRAGFIT_MAX_STRIDE];
+  double ring_v[DRAGFIT_MAX_STRIDE];
+  char line[256];
+  int filled = 0; // samples in the current shot, up to the stride
+  int head = 0;
+  FILE* file = fopen(path, "r");
+
+  if (!file) return DRAGFIT_E_IO;
+
+  while (fgets(line, sizeof(line), file)) {
+    char* p = line;
+    char* end;
+    double x, v;
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0) {
+      filled = 0; // a new shot
+      continue;
+    }
+
+    x = strtod(p, &end);
+    if (end == p) continue;
+    p = end;
+    while (*p == ' ' || *p == '\t' || *p == ',') p++;
+    v = strtod(p, &end);
+    if (end == p) continue;
+
+    if (filled == job->stride) {
+      // ring[head] is the sample exactly stride samples back.
+      double dx = x - ring_x[head];
+      double dv = v - ring_v[head];
+      if (dx > 0 && dv < 0) {
+        double vm = (v + ring_v[head])/2;
+        double decel = -vm*dv/dx;
+        int b;
+        for (b = 0; b < job->bands; b++) {
+          if (vm > job->edges[b]) {
+            double lx = log(vm), ly = log(decel);
+            BandSums* s = &sums[b];
+            s->n += 1;
+            s->sx += lx;
+            s->sy += ly;
+            s->sxx += lx*lx;
+            s->sxy += lx*ly;
+            break;
+          }
+        }
+      }
+    }
+    else {
+      filled++;
+    }
+    ring_x[head] = x;
+    ring_v[head] = v;
+    head = (head + 1) % job->stride;
+  }
+
+  int error = ferror(file);
+  fclose(file);
+  return error ? DRAGFIT_E_IO : 0;
+}
+
+static void* DragFit_worker(void* arg) {
+  DragFitJob* job = arg;
+
+  for (;;) {
+    int i;
+    pthread_mutex_lock(&job->lock);
+    i = job->next++;
+    pthread_mutex_unlock(&job->lock);
+    if (i >= job->count) break;
+
+    job->status[i] = DragFit_file(job, job->paths[i], &job->sums[(size_t)i*job->bands]);
+  }
+  return NULL;
+}
+
+long DragFit_fit_files(DragTable* table, const char* const* paths, int count, const double* band_velocities,
+                       int bands, double drag_coefficient, int stride, int threads) {
+  DragFitJob job;
+  double edges[DRAG_TABLE_MAX_BANDS];
+  pthread_t workers[64];
+  long used = 0;
+  int started = 0;
+  int status = 0;
+  int i, b;
+
+  if (count <= 0 || bands <= 0 || bands > DRAG_TABLE_MAX_BANDS || stride <= 0 || stride > DRAGFIT_MAX_STRIDE ||
+      drag_coefficient <= 0) {
+    return DRAGFIT_E_ARGUMENTS;
+  }
+
+  memcpy(edges, band_velocities, sizeof(double)*bands);
+  qsort(edges, bands, sizeof(double), compare_descending);
+
+  job.paths = paths;
+  job.count = count;
+  job.edges = edges;
+  job.bands = bands;
+  job.stride = stride;
+  job.next = 0;
+  job.sums = calloc((size_t)count*bands, sizeof(BandSums));
+  job.status = calloc(count, sizeof(int));
+  if (!job.sums || !job.status) {
+    free(job.sums);
+    free(job.status);
+    return DRAGFIT_E_NO_MEMORY;
+  }
+  pthread_mutex_init(&job.lock, NULL);
+
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads > count) threads = count;
+  if (threads > (int)(sizeof(workers)/sizeof(workers[0]))) threads = sizeof(workers)/sizeof(workers[0]);
+
+  // The calling thread works too, so only threads-1 extra workers are needed.
+  for (i = 1; i < threads; i++) {
+    if (pthread_create(&workers[started], NULL, DragFit_worker, &job) == 0) started++;
+  }
+  DragFit_worker(&job);
+  for (i = 0; i < started; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  pthread_mutex_destroy(&job.lock);
+
+  // Merge every file's sums, in file order, into the first file's.
+  for (i = 0; i < count; i++) {
+    if (job.status[i]) status = job.status[i];
+    if (i == 0) continue;
+    for (b = 0; b < bands; b++) {
+      BandSums* into = &job.sums[b];
+      BandSums* from = &job.sums[(size_t)i*bands + b];
+      into->n += from->n;
+      into->sx += from->sx;
+      into->sy += from->sy;
+      into->sxx += from->sxx;
+      into->sxy += from->sxy;
+    }
+  }
+
+  table->count = 0;
+  for (b = 0; b < bands && !status; b++) {
+    BandSums* s = &job.sums[b];
+    double denominator = s->n*s->sxx - s->sx*s->sx;
+    if (s->n < DRAGFIT_MIN_SAMPLES || denominator <= 0) continue;
+
+    DragBand* band = &table->bands[table->count++];
+    band->velocity = edges[b];
+    band->mass = (s->n*s->sxy - s->sx*s->sy)/denominator;
+    band->acceleration = exp((s->sy - band->mass*s->sx)/s->n)*drag_coefficient;
+    used += (long)s->n;
+  }
+
+  free(job.sums);
+  free(job.status);
+
+  if (status) return status;
+  if (table->count == 0) return DRAGFIT_E_NO_DATA;
+  return used;
+}
+
+int DragTable_write(const DragTable* table, FILE* file) {
+  int i;
+
+  fprintf(file, "# velocity acceleration mass\n");
+  for (i = 0; i < table->count; i++) {
+    const DragBand* band = &table->bands[i];
+    fprintf(file, "%.17g %.17g %.17g\n", band->velocity, band->acceleration, band->mass);
+  }
+  return ferror(file) ? DRAGFIT_E_IO : 0;
+}
+
+int DragTable_read(DragTable* table, FILE* file) {
+  char line[256];
+
+  table->count = 0;
+  while (fgets(line, sizeof(line), file)) {
+    DragBand band;
+    int end = 0;
+    size_t skip = strspn(line, " \t\r\n");
+
+    if (!strchr(line, '\n') && !feof(file)) return DRAGFIT_E_FORMAT; // too long to be a table's line
+    if (line[skip] == '#' || line[skip] == '\0') continue;
+    // retard_table() takes the first band the velocity is above, so anything out of order would be wrong drag.
+    if (sscanf(line, "%lf %lf %lf %n", &band.velocity, &band.acceleration, &band.mass, &end) != 3 ||
+        line[end] != '\0' || !isfinite(band.velocity) || !isfinite(band.acceleration) || !isfinite(band.mass) ||
+        (table->count > 0 && !(band.velocity < table->bands[table->count - 1].velocity)) ||
+        table->count == DRAG_TABLE_MAX_BANDS) {
+      return DRAGFIT_E_FORMAT;
+    }
+    table->bands[table->count++] = band;
+  }
+
+  if (ferror(file)) return DRAGFIT_E_IO;
+  return table->count ? 0 : DRAGFIT_E_NO_DATA;
+}
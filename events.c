@@ -0,0 +1,225 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/ballistics.h"
+
+#include <math.h>
+
+// Regula falsi stops once the event is bracketed to this fraction of a step, or after this many iterations.
+#define EVENTS_REFINE_TOLERANCE 1e-10
+#define EVENTS_REFINE_ITERATIONS 60
+
+// Newton's method for zero_angle_refined() stops once a correction is this small, in degrees (1e-6 MOA).
+#define ZERO_REFINED_TOLERANCE (1e-6/60)
+#define ZERO_REFINED_ITERATIONS 20
+
+double BallisticsEvent_height(const BallisticsState* state, const void* inches) {
+  return state->y*12 - *(const double*)inches;
+}
+
+double BallisticsEvent_range(const BallisticsState* state, const void* yards) {
+  return state->x/3 - *(const double*)yards;
+}
+
+double BallisticsEvent_velocity(const BallisticsState* state, const void* fps) {
+  return state->v - *(const double*)fps;
+}
+
+double BallisticsEvent_apex(const BallisticsState* state, const void* unused) {
+  (void)unused;
+  return state->vy;
+}
+
+/**
+ * One integration step of length h from a state, with the acceleration held at its value at the start of the step,
+ * exactly as the solvers step.  Any h from 0 to the full step lands on the same path the full step takes.
+ */
+static void Events_step(const BallisticsState* from, double ax, double ay, double h, BallisticsState* to) {
+  to->t = from->t + h;
+  to->vx = from->vx + h*ax;
+  to->vy = from->vy + h*ay;
+  to->x = from->x + h*(from->vx + to->vx)/2;
+  to->y = from->y + h*(from->vy + to->vy)/2;
+  to->v = BALLISTICS_SPEED(to->vx, to->vy);
+}
+
+// Returns the direction of a sign change from before to after that the event counts, or 0.
+static int Events_crossing(double before, double after, int direction) {
+  if (before < 0 && after >= 0) return direction & EVENTS_RISING;
+  if (before > 0 && after <= 0) return direction & EVENTS_FALLING;
+  return 0;
+}
+
+/**
+ * Locates an event inside a step whose ends it takes the values f0 and f1 at, by the Illinois variant of regula
+ * falsi on the fraction of the step taken.
+ */
+static void Events_refine(const BallisticsEvent* event, const BallisticsState* from, double ax, double ay, double dt,
+                          double f0, double f1, BallisticsState* at) {
+  double a = 0, b = 1;
+  double fa = f0, fb = f1;
+  int side = 0;
+  int i;
+
+  *at = *from;
+  for (i = 0; i < EVENTS_REFINE_ITERATIONS; i++) {
+    double c = (a*fb - b*fa) / (fb - fa);
+    double fc;
+
+    Events_step(from, ax, ay, c*dt, at);
+    fc = event->function(at, event->context);
+    if (fc == 0 || b - a < EVENTS_REFINE_TOLERANCE) break;
+
+    // Whichever end stays put twice running has its value halved, so both ends close in.
+    if ((fc > 0) == (fb > 0)) {
+      b = c;
+      fb = fc;
+      if (side < 0) fa /= 2;
+      side = -1;
+    }
+    else {
+      a = c;
+      fa = fc;
+      if (side > 0) fb /= 2;
+      side = 1;
+    }
+  }
+}
+
+int Ballistics_find_events(BallisticsEventHit* hits, int max_hits, const BallisticsEvent* events, int event_count,
+                           DragFunction drag_function, double drag_coefficient, double vi, double sight_height,
+                           double shooting_angle, double zero_angle, double wind_speed, double wind_angle,
+                           double max_range_yards, double step_feet) {
+  double values[EVENTS_MAX];
+  BallisticsEventHit found[EVENTS_MAX];
+  BallisticsState state, next;
+  int count = 0;
+  int status = 0;
+  int stop = 0;
+  int e, i;
+
+  if (max_hits < 0 || event_count < 0 || event_count > EVENTS_MAX || vi <= 0) return EVENTS_E_ARGUMENTS;
+  if (step_feet <= 0) step_feet = EVENTS_DEFAULT_STEP_FEET;
+  if (max_range_yards <= 0) max_range_yards = BALLISTICS_COMPUTATION_MAX_YARDS;
+
+  double hwind = headwind(wind_speed, wind_angle);
+  double gy = GRAVITY*cos(deg_to_rad((shooting_angle + zero_angle)));
+  double gx = GRAVITY*sin(deg_to_rad((shooting_angle + zero_angle)));
+  double max_x = max_range_yards*3;
+
+  state.t = 0;
+  state.x = 0;
+  state.y = -sight_height/12; // y is in feet
+  state.vx = vi * cos(deg_to_rad(zero_angle));
+  state.vy = vi * sin(deg_to_rad(zero_angle));
+  state.v = BALLISTICS_SPEED(state.vx, state.vy);
+  for (e = 0; e < event_count; e++) values[e] = events[e].function(&state, events[e].context);
+
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_SOLVE);
+  while (count < max_hits && !stop && state.x < max_x) {
+    double dv, ax, ay, dt;
+    int step_found = 0;
+
+    if (fabs(state.vy) > fabs(3*state.vx)) {
+      status = EVENTS_E_TOO_FAST_VY;
+      break;
+    }
+    BALLISTICS_STATS_STEP();
+
+    // Compute acceleration using the drag function retardation, and take the step.
+    dv = retard(drag_function, drag_coefficient, state.v + hwind);
+    ax = -(state.vx/state.v)*dv + gx;
+    ay = -(state.vy/state.v)*dv + gy;
+    dt = step_feet / state.v;
+    Events_step(&state, ax, ay, dt, &next);
+
+    for (e = 0; e < event_count; e++) {
+      double value = events[e].function(&next, events[e].context);
+      int direction = Events_crossing(values[e], value, events[e].direction);
+      if (direction) {
+        // Insert in time order among the events of this step.
+        BallisticsEventHit hit;
+        hit.event = e;
+        hit.direction = direction;
+        Events_refine(&events[e], &state, ax, ay, dt, values[e], value, &hit.state);
+        for (i = step_found; i > 0 && found[i - 1].state.t > hit.state.t; i--) found[i] = found[i - 1];
+        found[i] = hit;
+        step_found++;
+      }
+      values[e] = value;
+    }
+
+    for (i = 0; i < step_found && count < max_hits; i++) {
+      hits[count++] = found[i];
+      if (events[found[i].event].terminal) {
+        stop = 1;
+        break;
+      }
+    }
+    state = next;
+  }
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_SOLVE);
+
+  if (status && count < max_hits) return status;
+  return count;
+}
+
+int zero_angle_refined(double* angle, DragFunction drag_function, double drag_coefficient, double vi,
+                       double sight_height, double zero_range, double y_intercept, double step_feet) {
+  BallisticsEvent event = {BallisticsEvent_range, &zero_range, EVENTS_RISING, 1};
+  BallisticsEventHit hit;
+  double a = 0;
+  int i;
+
+  *angle = 0;
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_ZERO);
+  for (i = 0; i < ZERO_REFINED_ITERATIONS; i++) {
+    double correction;
+    BALLISTICS_STATS_ITERATION();
+
+    if (Ballistics_find_events(&hit, 1, &event, 1, drag_function, drag_coefficient, vi, sight_height, 0, a, 0, 0,
+                               zero_range + 1, step_feet) != 1) {
+      // Short of the zero range: lob it higher, as far as zero_angle() would go.
+      if (a >= 45) break;
+      a = a + 5 < 45 ? a + 5 : 45;
+      continue;
+    }
+
+    // Raising the bore by an angle raises the point of impact at range x by about x times its tangent.
+    correction = rad_to_deg(atan((y_intercept/12 - hit.state.y) / hit.state.x));
+    a += correction;
+    if (fabs(correction) < ZERO_REFINED_TOLERANCE) {
+      BALLISTICS_STATS_END(BALLISTICS_PHASE_ZERO);
+      *angle = a;
+      return 0;
+    }
+  }
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_ZERO);
+  return ZERO_E_OUT_OF_RANGE;
+}
+
+double Ballistics_range_at_velocity(DragFunction drag_function, double drag_coefficient, double vi,
+                                    double sight_height, double shooting_angle, double zero_angle, double fps,
+                                    double step_feet) {
+  BallisticsEvent event = {BallisticsEvent_velocity, &fps, EVENTS_FALLING, 1};
+  BallisticsEventHit hit;
+
+  if (Ballistics_find_events(&hit, 1, &event, 1, drag_function, drag_coefficient, vi, sight_height, shooting_angle,
+                             zero_angle, 0, 0, 0, step_feet) != 1) {
+    return -1;
+  }
+  return hit.state.x/3;
+}
@@ -78,6 +78,7 @@ int main(void) {
 
 
   Ballistics_free(solution);
+  Ballistics_free(solution2);
 	
 	return 0;
 }
\ No newline at end of file
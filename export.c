@@ -0,0 +1,279 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/export.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPORT_MAX_FIELDS 64
+
+// Rows converted at a time; each field gets a scratch column this long.
+#define EXPORT_CHUNK_ROWS 1024
+
+// The most a CSV value can take, sign and terminator included, in either the fixed or the %.17g form.
+#define EXPORT_MAX_VALUE_CHARS 32
+
+struct BallisticsWriter {
+  FILE* file;
+  BallisticsExportFormat format;
+  int precision;
+  int field_count;
+  BallisticsField fields[EXPORT_MAX_FIELDS];
+  int error;
+
+  char* buffer;
+  size_t used;
+  double* scratch; // field_count columns of EXPORT_CHUNK_ROWS
+};
+
+static const char* const field_names[] = {
+  "range_yards", "path_inches", "moa_correction", "seconds", "windage_inches", "windage_moa", "spindrift_inches",
+  "corrected_windage_inches", "corrected_windage_moa", "v_fps", "vx_fps", "vy_fps"
+};
+
+static const uint64_t powers_of_ten[] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+const char* BallisticsWriter_field_name(BallisticsField field) {
+  if (field < BALLISTICS_RANGE || field > BALLISTICS_VY) return "unknown";
+  return field_names[field];
+}
+
+static int BallisticsWriter_drain(BallisticsWriter* writer) {
+  if (writer->error) return writer->error;
+  if (writer->used && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+    writer->error = EXPORT_E_IO;
+  }
+  writer->used = 0;
+  return writer->error;
+}
+
+// Makes room for size more bytes in the buffer.
+static inline int BallisticsWriter_reserve(BallisticsWriter* writer, size_t size) {
+  if (writer->used + size > EXPORT_BUFFER_SIZE) return BallisticsWriter_drain(writer);
+  return writer->error;
+}
+
+static void BallisticsWriter_append(BallisticsWriter* writer, const void* data, size_t size) {
+  // Anything at least as big as the buffer goes straight to the file rather than being copied through it.
+  if (size >= EXPORT_BUFFER_SIZE) {
+    if (BallisticsWriter_drain(writer) == 0 && fwrite(data, 1, size, writer->file) != size) {
+      writer->error = EXPORT_E_IO;
+    }
+    return;
+  }
+  if (BallisticsWriter_reserve(writer, size) == 0) {
+    memcpy(writer->buffer + writer->used, data, size);
+    writer->used += size;
+  }
+}
+
+static inline char* format_unsigned(char* out, uint64_t value) {
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (n) *out++ = digits[--n];
+  return out;
+}
+
+// Writes value with precision decimals, or exactly for a negative precision.
+static inline char* format_value(char* out, double value, int precision) {
+  double scaled;
+  uint64_t n, scale;
+  int i;
+
+  if (precision < 0) {
+    return out + snprintf(out, EXPORT_MAX_VALUE_CHARS, "%.17g", value);
+  }
+
+  scale = powers_of_ten[precision];
+  scaled = value * (double)scale;
+  // NaN, infinities and values too big to round through an integer fall back to printf.
+  if (!(fabs(scaled) < 9e15)) {
+    return out + snprintf(out, EXPORT_MAX_VALUE_CHARS, "%.17g", value);
+  }
+
+  n = (uint64_t)(fabs(scaled) + 0.5);
+  if (scaled < 0 && n) *out++ = '-';
+  out = format_unsigned(out, n / scale);
+  if (precision > 0) {
+    uint64_t fraction = n % scale;
+    *out++ = '.';
+    for (i = precision - 1; i >= 0; i--) {
+      out[i] = (char)('0' + fraction % 10);
+      fraction /= 10;
+    }
+    out += precision;
+  }
+  return out;
+}
+
+int BallisticsWriter_open(BallisticsWriter** writer, FILE* file, BallisticsExportFormat format,
+                          const BallisticsField* fields, int field_count, int precision) {
+  BallisticsWriter* w;
+  int i;
+
+  if (!file || field_count < 1 || field_count > EXPORT_MAX_FIELDS || precision > 9) return EXPORT_E_ARGUMENTS;
+  if (format != BALLISTICS_EXPORT_CSV && format != BALLISTICS_EXPORT_BINARY) return EXPORT_E_ARGUMENTS;
+  for (i = 0; i < field_count; i++) {
+    if (fields[i] < BALLISTICS_RANGE || fields[i] > BALLISTICS_VY) return EXPORT_E_ARGUMENTS;
+  }
+
+  w = calloc(1, sizeof(BallisticsWriter));
+  if (!w) return EXPORT_E_NO_MEMORY;
+  w->buffer = malloc(EXPORT_BUFFER_SIZE);
+  w->scratch = malloc(sizeof(double) * EXPORT_CHUNK_ROWS * field_count);
+  if (!w->buffer || !w->scratch) {
+    free(w->buffer);
+    free(w->scratch);
+    free(w);
+    return EXPORT_E_NO_MEMORY;
+  }
+  w->file = file;
+  w->format = format;
+  w->precision = precision;
+  w->field_count = field_count;
+  memcpy(w->fields, fields, sizeof(BallisticsField) * field_count);
+
+  if (format == BALLISTICS_EXPORT_CSV) {
+    BallisticsWriter_append(w, "id", 2);
+    for (i = 0; i < field_count; i++) {
+      const char* name = BallisticsWriter_field_name(fields[i]);
+      BallisticsWriter_append(w, ",", 1);
+      BallisticsWriter_append(w, name, strlen(name));
+    }
+    BallisticsWriter_append(w, "\n", 1);
+  }
+  else {
+    uint32_t header[2 + EXPORT_MAX_FIELDS];
+    header[0] = 0x01020304;
+    header[1] = (uint32_t)field_count;
+    for (i = 0; i < field_count; i++) header[2 + i] = (uint32_t)fields[i];
+    BallisticsWriter_append(w, "BLSTCOL1", 8);
+    BallisticsWriter_append(w, header, sizeof(uint32_t) * (2 + field_count));
+  }
+
+  *writer = w;
+  return 0;
+}
+
+// Converts rows first, first+stride, ... of one field into out.
+static void BallisticsWriter_convert(Ballistics* ballistics, BallisticsField field, int first, int rows, int stride,
+                                     double* out) {
+  int i;
+  if (stride == 1) {
+    Ballistics_get_rows(ballistics, field, first, rows, out);
+    return;
+  }
+  for (i = 0; i < rows; i++) {
+    Ballistics_get_rows(ballistics, field, first + i*stride, 1, &out[i]);
+  }
+}
+
+static void BallisticsWriter_write_csv(BallisticsWriter* w, Ballistics* ballistics, unsigned long long id,
+                                       int first, int rows, int stride) {
+  char prefix[24];
+  char* end = format_unsigned(prefix, id);
+  size_t prefix_length = (size_t)(end - prefix);
+  size_t row_chars = prefix_length + 1 + (size_t)w->field_count * (EXPORT_MAX_VALUE_CHARS + 1);
+  int done, i, f;
+
+  for (done = 0; done < rows && !w->error; done += EXPORT_CHUNK_ROWS) {
+    int chunk = rows - done < EXPORT_CHUNK_ROWS ? rows - done : EXPORT_CHUNK_ROWS;
+    for (f = 0; f < w->field_count; f++) {
+      BallisticsWriter_convert(ballistics, w->fields[f], first + done*stride, chunk, stride,
+                               w->scratch + f*EXPORT_CHUNK_ROWS);
+    }
+    for (i = 0; i < chunk; i++) {
+      char* out;
+      if (BallisticsWriter_reserve(w, row_chars)) return;
+      out = w->buffer + w->used;
+      memcpy(out, prefix, prefix_length);
+      out += prefix_length;
+      for (f = 0; f < w->field_count; f++) {
+        *out++ = ',';
+        out = format_value(out, w->scratch[f*EXPORT_CHUNK_ROWS + i], w->precision);
+      }
+      *out++ = '\n';
+      w->used = (size_t)(out - w->buffer);
+    }
+  }
+}
+
+static void BallisticsWriter_write_binary(BallisticsWriter* w, Ballistics* ballistics, unsigned long long id,
+                                          int first, int rows, int stride) {
+  uint64_t block_id = id;
+  uint32_t block_rows[2] = {(uint32_t)rows, 0};
+  int done, f;
+
+  BallisticsWriter_append(w, &block_id, sizeof(block_id));
+  BallisticsWriter_append(w, block_rows, sizeof(block_rows));
+  for (f = 0; f < w->field_count && !w->error; f++) {
+    const double* stored = Ballistics_get_column(ballistics, w->fields[f]);
+    if (stored && stride == 1) {
+      // Stored columns are written straight from the solution.
+      BallisticsWriter_append(w, stored + first, sizeof(double) * rows);
+      continue;
+    }
+    for (done = 0; done < rows && !w->error; done += EXPORT_CHUNK_ROWS) {
+      int chunk = rows - done < EXPORT_CHUNK_ROWS ? rows - done : EXPORT_CHUNK_ROWS;
+      BallisticsWriter_convert(ballistics, w->fields[f], first + done*stride, chunk, stride, w->scratch);
+      BallisticsWriter_append(w, w->scratch, sizeof(double) * chunk);
+    }
+  }
+}
+
+int BallisticsWriter_write(BallisticsWriter* writer, Ballistics* ballistics, unsigned long long id, int first,
+                           int count, int stride) {
+  int max_yardage = Ballistics_get_max_yardage(ballistics);
+  int rows;
+
+  if (writer->error) return writer->error;
+  if (first < 0 || count < 0 || stride < 1) return EXPORT_E_ARGUMENTS;
+
+  rows = first < max_yardage ? (max_yardage - 1 - first) / stride + 1 : 0;
+  if (rows > count) rows = count;
+
+  if (writer->format == BALLISTICS_EXPORT_CSV) {
+    BallisticsWriter_write_csv(writer, ballistics, id, first, rows, stride);
+  }
+  else {
+    BallisticsWriter_write_binary(writer, ballistics, id, first, rows, stride);
+  }
+  return writer->error ? writer->error : rows;
+}
+
+int BallisticsWriter_flush(BallisticsWriter* writer) {
+  if (BallisticsWriter_drain(writer) == 0 && fflush(writer->file) != 0) {
+    writer->error = EXPORT_E_IO;
+  }
+  return writer->error;
+}
+
+int BallisticsWriter_close(BallisticsWriter* writer) {
+  int status = BallisticsWriter_flush(writer);
+  free(writer->buffer);
+  free(writer->scratch);
+  free(writer);
+  return status;
+}
@@ -67,6 +67,39 @@ static inline double rad_to_moa(double rad) {
 double zero_angle(DragFunction drag_function, double drag_coefficient, double vi, double sight_height, double zero_range,
                   double y_intercept);
 
+/**
+ * The same as zero_angle(), for a custom drag table instead of one of the standard drag functions.
+ * @param table            The drag table, such as one fitted by DragFit_fit_files().
+ * @param drag_coefficient The coefficient of drag for the projectile, relative to the drag table.
+ * @param y_intercept      The height, in inches, at zero_range, as for zero_angle().
+ */
+double zero_angle_table(const DragTable* table, double drag_coefficient, double vi, double sight_height,
+                        double zero_range, double y_intercept);
+
+#define ZERO_E_OUT_OF_RANGE -1
+#define ZERO_E_NO_MEMORY    -2
+
+/**
+ * Determines the bore angles for a whole table of zero ranges at once.  Rather than bisecting each zero
+ * independently the way zero_angle() does, this integrates a handful of shared reference trajectories,
+ * reads every zero range off each of them, and solves each zero from a quadratic fit of height against bore
+ * angle.  A table of any length typically costs fewer than ten integrations.
+ * @param angles           Receives the bore angle, in degrees, for each zero range.  Zero ranges that cannot
+ *                         be reached are set to NAN.
+ * @param drag_function    G1, G2, G3, G5, G6, G7, or G8
+ * @param drag_coefficient The coefficient of drag for the projectile, for the supplied drag function.
+ * @param vi               The initial velocity of the projectile, in feet/s
+ * @param sight_height     The height of the sighting system above the bore centerline, in inches.
+ * @param zero_ranges      The ranges in yards, in any order, at which the projectile should cross each intercept.
+ * @param y_intercepts     The height, in inches, for the projectile to be at each zero range.  May be NULL for
+ *                         a target zero (0") at every range.
+ * @param count            The number of zero ranges.
+ * @return 0 on success, ZERO_E_OUT_OF_RANGE if any zero range could not be reached, or ZERO_E_NO_MEMORY (which,
+ *         in the embedded profile, means count was over 32).
+ */
+int zero_angles(double* angles, DragFunction drag_function, double drag_coefficient, double vi, double sight_height,
+                const double* zero_ranges, const double* y_intercepts, int count);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ANYTIME_E_NO_MEMORY -1
+
+// Levels of refinement.  The first steps ANYTIME_COARSEST_STEP_FEET at a time, each level after it halves the
+// step, and the last takes the solvers' own half-foot step.
+#define ANYTIME_LEVELS 7
+#define ANYTIME_COARSEST_STEP_FEET 32.0
+
+/**
+ * A solver for a frame budget: it has a usable trajectory right away and sharpens it as time allows.
+ *
+ * The integration error is close to proportional to the step, so a trajectory solved with a step 64 times the
+ * solvers' half foot costs a small fraction of a full solve and is off by inches, not feet, at long range.  Each
+ * refinement halves the step, which halves the error, and the difference between one level and the last is then
+ * an estimate of the error that is left.  The last level is exactly what Ballistics_solve_modified_vertDeflect()
+ * gives, so a caller that keeps refining ends up with the same answer as one that solved it outright, having spent
+ * about twice as long in all.
+ */
+typedef struct AnytimeSolver AnytimeSolver;
+
+/**
+ * Solves the two coarsest levels, so there is a trajectory and an error estimate from the start.  Every parameter
+ * from drag_function to formFactor has the same meaning as in Ballistics_solve_modified_vertDeflect().
+ * @param solver Receives the solver.
+ * @param rows   The number of yards to solve, or 0 to solve as far as the projectile goes.
+ * @return 0, or ANYTIME_E_NO_MEMORY
+ */
+int AnytimeSolver_start(AnytimeSolver** solver, int rows, DragFunction drag_function, double drag_coefficient,
+                        double vi, double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                        double wind_angle, double caliberInInches, double bulletLengthInInches, double temp,
+                        double inHg, double twistDenominator, double velocity, double bulletGrains,
+                        double formFactor);
+void AnytimeSolver_free(AnytimeSolver* solver);
+
+/**
+ * Refines level by level, for as long as the next level is expected to fit in what is left of the budgets.  A
+ * level's cost is predicted from the last one, which it doubles, and a level that is started is finished, so the
+ * budgets are kept to within the accuracy of that prediction.
+ * @param seconds The time budget, or 0 for no limit on time.
+ * @param steps   The budget in integration steps, or 0 for no limit on steps.
+ * @return the number of levels refined
+ */
+int AnytimeSolver_refine(AnytimeSolver* solver, double seconds, long steps);
+
+/**
+ * Returns the trajectory at the current level, for the Ballistics_get_*() accessors.  It stays owned by the solver,
+ * and is replaced by the next refinement.
+ */
+Ballistics* AnytimeSolver_get_solution(const AnytimeSolver* solver);
+
+// Returns the current level, from 0 to ANYTIME_LEVELS-1, and the step it was solved with, in feet.
+int AnytimeSolver_get_level(const AnytimeSolver* solver);
+double AnytimeSolver_get_step(const AnytimeSolver* solver);
+
+/**
+ * Returns the estimated error of the current trajectory: the furthest its path is expected to be from the last
+ * level's, in inches, over the whole trajectory.  It is 0 at the last level.
+ */
+double AnytimeSolver_get_error(const AnytimeSolver* solver);
+
+// Returns nonzero once the solver has reached the last level.
+int AnytimeSolver_is_final(const AnytimeSolver* solver);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
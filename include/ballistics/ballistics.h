@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -24,12 +26,24 @@ extern "C" {
 #include "angle.h"
 #include "atmosphere.h"
 #include "windage.h"
+#include "events.h"
 #include "pbr.h"
+#include "truing.h"
+#include "dragfit.h"
+#include "cache.h"
+#include "stats.h"
 
 typedef struct Ballistics Ballistics;
 
+// Allocates storage for a solution of up to BALLISTICS_COMPUTATION_MAX_YARDS rows, for the Ballistics_solve_*_into()
+// functions to fill and refill.  Returns NULL if there is no storage left.
+Ballistics* Ballistics_alloc(void);
+
 // Functions for retrieving data from a solution generated with solve()
 void Ballistics_free(Ballistics* ballistics);
+// Releases the storage past the end of a solution, which is otherwise sized for BALLISTICS_COMPUTATION_MAX_YARDS.
+// Returns the number of bytes the solution still holds.
+size_t Ballistics_compact(Ballistics* ballistics);
 
 // Returns range, in yards.
 double Ballistics_get_range(Ballistics* ballistics, int yardage);
@@ -54,6 +68,48 @@ double Ballistics_get_v_fps(Ballistics* ballistics, int yardage);
 double Ballistics_get_vx_fps(Ballistics* ballistics, int yardage);
 // Returns the velocity of the projectile perpendicular to the bore direction.
 double Ballistics_get_vy_fps(Ballistics* ballistics, int yardage);
+
+/**
+ * The outputs of a solution, for reading many yards at once with Ballistics_get_rows().
+ */
+typedef enum {
+  BALLISTICS_RANGE,                 // Ballistics_get_range()
+  BALLISTICS_PATH,                  // Ballistics_get_path()
+  BALLISTICS_MOA,                   // Ballistics_get_moa()
+  BALLISTICS_TIME,                  // Ballistics_get_time()
+  BALLISTICS_WINDAGE,               // Ballistics_get_windage()
+  BALLISTICS_WINDAGE_MOA,           // Ballistics_get_windage_moa()
+  BALLISTICS_SPINDRIFT,             // Ballistics_get_spindrift()
+  BALLISTICS_CORRECTED_WINDAGE,     // Ballistics_get_corrected_windage()
+  BALLISTICS_CORRECTED_WINDAGE_MOA, // Ballistics_get_corrected_windage_moa()
+  BALLISTICS_V,                     // Ballistics_get_v_fps()
+  BALLISTICS_VX,                    // Ballistics_get_vx_fps()
+  BALLISTICS_VY                     // Ballistics_get_vy_fps()
+} BallisticsField;
+
+/**
+ * Reads one output for a run of consecutive yards, the same values the single-yard accessors return.  Solutions
+ * only store the integrator's state, so derived outputs are computed here; doing a whole run at once skips the
+ * per-yard call and bounds check, and lets the simple outputs vectorize.
+ * @param field The output to read.
+ * @param first The first yard to read.
+ * @param count The number of yards to read.
+ * @param out   Receives count values.
+ * @return the number of yards read, which stops short at the end of the solution
+ */
+int Ballistics_get_rows(Ballistics* ballistics, BallisticsField field, int first, int count, double* out);
+
+/**
+ * Returns the stored column behind an output that needs no conversion (BALLISTICS_TIME, BALLISTICS_V, BALLISTICS_VX
+ * or BALLISTICS_VY), or NULL for the derived outputs, which have to be read with Ballistics_get_rows().  The column
+ * has Ballistics_get_max_yardage() entries and stays valid until the solution is solved into again, compacted or
+ * freed.
+ */
+const double* Ballistics_get_column(Ballistics* ballistics, BallisticsField field);
+
+// Returns the number of rows in the solution, the same value the solver returned.
+int Ballistics_get_max_yardage(Ballistics* ballistics);
+
  /**
  * 30m
  * ____
@@ -77,6 +133,19 @@ double calculateGS(double bulletGrains, double twistDenominator, double caliber,
  */
 double calculateVerticalDeflection(double gs, double length, double caliber);
 
+// Returned by the table solvers when there is no storage for another solution; in the embedded profile that means
+// every table in the pool is still in use.
+#define BALLISTICS_E_NO_MEMORY -1
+
+// Returned by Ballistics_get_state() for a range the solution doesn't reach.
+#define BALLISTICS_E_OUT_OF_RANGE -2
+
+// Returned by BallisticsCache_solve() for an input that is NaN or infinite.
+#define BALLISTICS_E_ARGUMENTS -3
+
+// Rows between the checkpoints a solution keeps for Ballistics_get_state().
+#define BALLISTICS_CHECKPOINT_INTERVAL 200
+
 // For very steep shooting angles, vx can actually become what you would think of as vy relative to the ground,
 // because vx is referencing the bore's axis.  All computations are carried out relative to the bore's axis, and
 // have very little to do with the ground's orientation.
@@ -104,11 +173,32 @@ double calculateVerticalDeflection(double gs, double length, double caliber);
  *                         useful data from the solution.
  * @return This function returns an integer representing the maximum valid range of the
  *         solution.  This also indicates the maximum number of rows in the solution matrix,
- *         and should not be exceeded in order to avoid a memory segmentation fault.
+ *         and should not be exceeded in order to avoid a memory segmentation fault.  Returns
+ *         BALLISTICS_E_NO_MEMORY, with ballistics set to NULL, if no storage could be allocated for the solution.
  */
 int Ballistics_solve(Ballistics** ballistics, DragFunction drag_function, double drag_coefficient, double vi,
                      double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle);
 
+/**
+ * The same as Ballistics_solve(), but overwrites a solution from Ballistics_alloc() (or an earlier solve) instead of
+ * allocating a new one, so repeated solves reuse the same storage.  A compacted solution only has room for as many
+ * rows as it had when it was compacted, and the solve stops there.
+ */
+int Ballistics_solve_into(Ballistics* ballistics, DragFunction drag_function, double drag_coefficient, double vi,
+                          double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle);
+
+/**
+ * The same as Ballistics_solve(), for a custom drag table instead of one of the standard drag functions.
+ * @param table            The drag table, such as one fitted by DragFit_fit_files().
+ * @param drag_coefficient The coefficient of drag for the projectile, relative to the drag table.
+ */
+int Ballistics_solve_table(Ballistics** ballistics, const DragTable* table, double drag_coefficient, double vi,
+                           double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle);
+// The same as Ballistics_solve_table(), into an existing solution like Ballistics_solve_into().
+int Ballistics_solve_table_into(Ballistics* ballistics, const DragTable* table, double drag_coefficient, double vi,
+                                double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                                double wind_angle);
+
 /**
  * \brief Vertical deflection and spindrift compensated version of the ballistics solver.
  * \param ballistics
@@ -132,6 +222,98 @@ int Ballistics_solve(Ballistics** ballistics, DragFunction drag_function, double
  */
 int Ballistics_solve_modified_vertDeflect(Ballistics** ballistics, DragFunction drag_function, double drag_coefficient, double vi,
                                           double sight_height, double shooting_angle, double zero_angle, double wind_speed, double wind_angle, double caliberInInches, double bulletLengthInInches, double temp, double inHg, double twistDenominator, double velocity, double bulletGrains, double formFactor);
+// The same as Ballistics_solve_modified_vertDeflect(), into an existing solution like Ballistics_solve_into().
+int Ballistics_solve_modified_vertDeflect_into(Ballistics* ballistics, DragFunction drag_function, double drag_coefficient,
+                                               double vi, double sight_height, double shooting_angle, double zero_angle,
+                                               double wind_speed, double wind_angle, double caliberInInches,
+                                               double bulletLengthInInches, double temp, double inHg,
+                                               double twistDenominator, double velocity, double bulletGrains,
+                                               double formFactor);
+
+/**
+ * Resumable solutions.
+ *
+ * A solution keeps the integrator's state where it stopped, along with everything the integration depends on, so
+ * it can be carried on later instead of solved again from the muzzle: a range card scrolled from 1000 to 2000
+ * yards only integrates the second 1000.  The steps are the same however a solution is built up, so an extended
+ * solution is identical, bit for bit, to one solved out to the same range in one go.  It also keeps a checkpoint
+ * every BALLISTICS_CHECKPOINT_INTERVAL rows, for Ballistics_get_state() to restart from.
+ */
+
+/**
+ * Caps the rows the solvers fill, so a solution can be solved only as far as it is needed and extended later.
+ * @param rows The most rows a solve fills, or 0 (the default) to solve as far as the projectile goes.
+ */
+void Ballistics_set_row_limit(Ballistics* ballistics, int rows);
+
+/**
+ * Sets the integration step the solvers take, in feet of flight.  The default half foot is what every table and
+ * test in this library is computed with; a longer step trades accuracy for time, roughly in proportion, and still
+ * fills a row at every yard, interpolated along the step that passes it.
+ * @param step_feet The step, or 0 for the default.
+ */
+void Ballistics_set_step(Ballistics* ballistics, double step_feet);
+
+/**
+ * Carries a solution on from where its solver or an earlier extension stopped.  A compacted solution is given room
+ * to grow, except in the embedded profile, whose solutions always have room for BALLISTICS_COMPUTATION_MAX_YARDS.
+ * @param rows The number of rows to extend the solution to, at most BALLISTICS_COMPUTATION_MAX_YARDS.  A solution
+ *             that already has that many, or has come to its end, is left as it is.
+ * @return the number of rows in the solution, which is 0 if it was never solved, or BALLISTICS_E_NO_MEMORY if it
+ *         couldn't be given room to grow, leaving it as it was
+ */
+int Ballistics_extend(Ballistics* ballistics, int rows);
+
+// Returns nonzero once a solution has come to its end, at the range its solver would stop at unlimited.
+int Ballistics_is_complete(Ballistics* ballistics);
+
+/**
+ * Finds the projectile's state at an exact range, not snapped to a recorded yard, by integrating forward from the
+ * nearest checkpoint short of it.  The last step is cut short to land exactly on the range, along the path the
+ * full step takes, so the state is on the solution's own trajectory.
+ * @param range_yards A range within the part of the trajectory solved so far.
+ * @param state       Receives the state; its time is the actual time of flight to the range.
+ * @return 0, or BALLISTICS_E_OUT_OF_RANGE
+ */
+int Ballistics_get_state(Ballistics* ballistics, double range_yards, BallisticsState* state);
+
+/**
+ * Inclined fire without a full solve.
+ *
+ * Changing only the shooting angle changes only how gravity resolves along and across the line of sight, so an
+ * inclined shot can be worked out from a level one already solved, the way the rifleman's rule does it, but with
+ * the drag accounted for.  A cheap integration, a yard at a time with the drag looked up in a table, is run at both
+ * the cached angle and the new one, and the difference between the two is added to the cached rows, so most of the
+ * cheap integration's own error cancels out.  What is left is bounded by how far the cheap integration strays from
+ * the cached shot itself, scaled up with the change in angle and with the steepness of the path.  The bound is 0 at
+ * the cached angle, where the cached rows come back unchanged.  Not in the embedded profile, which has no heap.
+ */
+typedef struct BallisticsIncline BallisticsIncline;
+
+/**
+ * Caches a solved shot, usually level, for Ballistics_solve_inclined_into().  The cache copies what it needs, so
+ * the solution can be freed or solved into again afterwards.
+ * @param incline  Receives the cache.
+ * @param solution A solution from any of the Ballistics_solve*() functions.
+ * @return 0, BALLISTICS_E_NO_MEMORY, or BALLISTICS_E_OUT_OF_RANGE if the solution has fewer than two rows
+ */
+int BallisticsIncline_build(BallisticsIncline** incline, Ballistics* solution);
+void BallisticsIncline_free(BallisticsIncline* incline);
+
+/**
+ * Solves the cached shot at another shooting angle, into an existing solution like Ballistics_solve_into().  The
+ * solution goes as far as the cached shot went, or until the path falls at more than 45 degrees to the line of
+ * sight, which the cached shot gives no measure of; Ballistics_extend() carries it on from there by integrating in
+ * full.  If the error bound would exceed the tolerance, the shot is solved in full instead, exactly as the solver
+ * that produced the cache would solve it.
+ * @param shooting_angle   The new shooting angle, in degrees.
+ * @param tolerance_inches The most error in the path to accept, in inches.
+ * @param bound_inches     If not NULL, receives the bound on the error in the path, in inches, or 0 if the shot
+ *                         was solved in full.
+ * @return the number of rows in the solution
+ */
+int Ballistics_solve_inclined_into(Ballistics* ballistics, const BallisticsIncline* incline, double shooting_angle,
+                                   double tolerance_inches, double* bound_inches);
 
 /**
  * \brief calculates spin drift offset
@@ -140,6 +322,37 @@ int Ballistics_solve_modified_vertDeflect(Ballistics** ballistics, DragFunction
  * \return
  */
 double calculateSpinDriftOffsetIn(double gs, double tof);
+
+/**
+ * A single target for Ballistics_solve_targets().  The caller fills in range_yards; the solver fills in
+ * everything else.  Targets the projectile never reaches are left with zeroed outputs, just like the
+ * Ballistics_get_*() accessors past the end of a solution.
+ */
+typedef struct {
+  double range_yards;       // in: range to the target, in yards.
+  double path_inches;       // out: projectile path, in inches, relative to the line of sight.
+  double moa_correction;    // out: elevation correction, in MOA.
+  double seconds;           // out: time of flight to the target.
+  double windage_inches;    // out: windage correction, in inches.
+  double windage_moa;       // out: windage correction, in MOA.
+  double v_fps;             // out: total projectile velocity at the target.
+} BallisticsTarget;
+
+/**
+ * Solves a single trajectory and reads it out at every requested target range.  The integration stops at the
+ * furthest target instead of running out to BALLISTICS_COMPUTATION_MAX_YARDS, and each target is interpolated
+ * between the two integration steps that bracket it rather than snapped to the nearest yard.
+ *
+ * The targets may be given in any order; they are merge-walked in range order as the integration proceeds.
+ * Every other parameter has the same meaning as in Ballistics_solve().
+ * @param targets The targets to solve for.  Only range_yards is read; all other fields are written.
+ * @param count   The number of entries in targets.
+ * @return The number of targets the projectile reached, or -1 if the targets could not be sorted (which, in the
+ *         embedded profile, means there were more than 64 of them).
+ */
+int Ballistics_solve_targets(BallisticsTarget* targets, int count, DragFunction drag_function, double drag_coefficient,
+                             double vi, double sight_height, double shooting_angle, double zero_angle,
+                             double wind_speed, double wind_angle);
 #ifdef __cplusplus
 } // extern "C"
 #endif
\ No newline at end of file
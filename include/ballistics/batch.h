@@ -0,0 +1,101 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The most worker threads a batch will start.
+#define BATCH_MAX_THREADS 64
+
+/**
+ * Determinism.
+ *
+ * Every batched and parallel entry point runs each item through the same scalar code a single call would, with no
+ * state shared between items, so an item's result never depends on the thread count, the batch size or where in
+ * the batch it sits.  Aggregates over items are made the same way whatever the order the items finish in: the
+ * counts Ballistics_sweep() and PBR_solve_grid() return are integers, and the error estimates BallisticsSurface_build()
+ * makes are kept per cell and only combined afterwards, in cell order.
+ *
+ * What's left is the compiler, which may contract a multiply and an add into a fused multiply-add in one copy of an
+ * expression and not in another, such as a solver's loop inlined in two places, and, on x87, keep intermediates in
+ * extended precision.  The BALLISTICS_DETERMINISTIC CMake option builds with both turned off (-ffp-contract=off and
+ * -fexcess-precision=standard, where the compiler has them), so the same inputs give the same bits on any build of
+ * the same source for the same target.  It costs the few percent that fused multiply-adds save on hardware that
+ * has them.  Neither -ffast-math nor anything like it is ever used, so the order of operations is always the one
+ * written.
+ */
+
+/**
+ * Runs body(context, i) for every i from 0 to count-1, spread over worker threads.  Indices are handed out in
+ * small runs from a shared counter, so uneven work balances itself; each index runs exactly once, but in no
+ * particular order.  The calling thread works too.
+ * @param threads The number of threads, or 0 to use every online CPU.
+ */
+void Ballistics_parallel_for(int count, int threads, void (*body)(void* context, int index), void* context);
+
+/**
+ * One load to zero and solve in a batch.  The caller fills in the inputs; Ballistics_solve_batch() fills in the
+ * outputs.
+ */
+typedef struct {
+  // in: the load, with drag_coefficient already corrected for the atmosphere
+  DragFunction drag_function;
+  double drag_coefficient;
+  double vi;
+  double sight_height;
+  // in: the zero, as for zero_angle()
+  double zero_range;    // yards
+  double y_intercept;   // inches
+  // in: the shot, as for Ballistics_solve()
+  double shooting_angle;
+  double wind_speed;
+  double wind_angle;
+  // in/out: the ranges to read, as for Ballistics_solve_targets()
+  BallisticsTarget* targets;
+  int target_count;
+
+  // out: the bore angle from zero_angle(), in degrees
+  double zero_angle;
+  // out: the number of targets reached, or a negative error from Ballistics_solve_targets()
+  int status;
+} BallisticsBatchItem;
+
+/**
+ * Zeroes and solves every item, in parallel.  Each item gets exactly what zero_angle() followed by
+ * Ballistics_solve_targets() would give it, whatever the thread count.
+ * @param threads The number of threads, or 0 to use every online CPU.
+ */
+void Ballistics_solve_batch(BallisticsBatchItem* items, int count, int threads);
+
+/**
+ * Zeroes every item and solves its whole trajectory, in parallel, rather than reading it at targets.  Each
+ * solution gets exactly what zero_angle() followed by Ballistics_solve_into() would give it, whatever the thread
+ * count.  The items' targets are ignored.
+ * @param solutions One solution per item, from Ballistics_alloc() or an earlier solve, to solve into.
+ * @param items     The items; status receives the number of rows, or a negative error, as Ballistics_solve_into()
+ *                  returns.
+ * @param threads   The number of threads, or 0 to use every online CPU.
+ */
+void Ballistics_solve_batch_into(Ballistics** solutions, BallisticsBatchItem* items, int count, int threads);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
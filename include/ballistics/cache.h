@@ -0,0 +1,138 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "drag.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct Ballistics;
+struct PBR;
+
+/**
+ * A thread-safe cache of solutions, keyed by inputs rounded to a fixed precision.  The solvers run on the
+ * rounded inputs, so every request that rounds to the same key really does share the same solution.
+ *
+ * The cache is split into shards, each with its own lock, and each shard evicts with the CLOCK algorithm once its
+ * share of the memory budget is used up.  Solving happens outside the locks.
+ */
+typedef struct BallisticsCache BallisticsCache;
+
+/**
+ * A shared, immutable cached result.  Every entry handed out by the cache must be given back with
+ * BallisticsCache_release(); the result stays valid until then, even if the cache evicts it in the meantime.
+ */
+typedef struct BallisticsCacheEntry BallisticsCacheEntry;
+
+/**
+ * How finely inputs are told apart.  Every input is rounded to a multiple of its quantum before solving, except
+ * one too large to have a multiple below 2^53, which is kept exactly as it is.
+ */
+typedef struct {
+  size_t memory_budget;              // Bytes of solutions to hold before evicting.
+  double drag_coefficient_quantum;
+  double velocity_quantum;           // ft/s
+  double sight_height_quantum;       // inches
+  double range_quantum;              // yards (zero range)
+  double y_intercept_quantum;        // inches
+  double angle_quantum;              // degrees (shooting angle)
+  double zero_angle_quantum;         // degrees (bore angle passed to the solver)
+  double wind_speed_quantum;         // mi/hr
+  double wind_angle_quantum;         // degrees
+  double vital_size_quantum;         // inches
+} BallisticsCacheConfig;
+
+typedef struct {
+  unsigned long long hits;
+  unsigned long long misses;
+  unsigned long long evictions;
+  unsigned long long entries;        // entries currently held
+  size_t bytes;                      // bytes currently held
+} BallisticsCacheStats;
+
+/**
+ * Fills in a configuration with a 256 MB budget and UI-level precision: 0.001 BC, 1 ft/s, 0.01", 1 yard,
+ * 0.1 degree, 0.1 mi/hr, and 0.01 MOA of bore angle.
+ */
+void BallisticsCache_default_config(BallisticsCacheConfig* config);
+
+/**
+ * @param config The configuration, or NULL for BallisticsCache_default_config().
+ * @return the new cache, or NULL if out of memory
+ */
+BallisticsCache* BallisticsCache_alloc(const BallisticsCacheConfig* config);
+
+/**
+ * Frees the cache.  Entries still held by callers stay valid until they are released.
+ */
+void BallisticsCache_free(BallisticsCache* cache);
+
+/**
+ * Cached Ballistics_solve().
+ * @param entry Receives the cache entry; read it with BallisticsCacheEntry_ballistics() and release it when done.
+ * @return the same as Ballistics_solve(); or, with entry NULL and nothing cached, BALLISTICS_E_NO_MEMORY if there
+ *         was no memory for the entry or the solution, or BALLISTICS_E_ARGUMENTS if an input is NaN or infinite,
+ *         such as an unreachable zero from zero_angles()
+ */
+int BallisticsCache_solve(BallisticsCache* cache, BallisticsCacheEntry** entry, DragFunction drag_function,
+                          double drag_coefficient, double vi, double sight_height, double shooting_angle,
+                          double zero_angle, double wind_speed, double wind_angle);
+
+/**
+ * Cached zero_angle(), with y_intercept in inches as there.  Zero angles are small enough to be copied out, so no
+ * entry needs releasing.  An input that is NaN or infinite gives NaN, as an unreachable zero does in zero_angles().
+ */
+double BallisticsCache_zero_angle(BallisticsCache* cache, DragFunction drag_function, double drag_coefficient,
+                                  double vi, double sight_height, double zero_range, double y_intercept);
+
+/**
+ * Cached PBR_solve().
+ * @param entry Receives the cache entry; read it with BallisticsCacheEntry_pbr() and release it when done.
+ * @return the same as PBR_solve(); or, with entry NULL and nothing cached, PBR_E_NO_MEMORY if there was no memory
+ *         for the entry or the result, or PBR_E_ARGUMENTS if an input is NaN or infinite
+ */
+int BallisticsCache_PBR_solve(BallisticsCache* cache, BallisticsCacheEntry** entry, DragFunction drag_function,
+                              double drag_coefficient, double vi, double sight_height, double vital_size);
+
+/**
+ * The solution held by an entry from BallisticsCache_solve().  It is shared: read it, but don't free it.
+ */
+struct Ballistics* BallisticsCacheEntry_ballistics(const BallisticsCacheEntry* entry);
+
+/**
+ * The result held by an entry from BallisticsCache_PBR_solve(), or NULL if PBR_solve() failed.  It is shared:
+ * read it, but don't free it.
+ */
+struct PBR* BallisticsCacheEntry_pbr(const BallisticsCacheEntry* entry);
+
+/**
+ * Gives an entry back to the cache.
+ */
+void BallisticsCache_release(BallisticsCacheEntry* entry);
+
+/**
+ * Reads the cache's counters.
+ */
+void BallisticsCache_stats(BallisticsCache* cache, BallisticsCacheStats* stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,118 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHEBYSHEV_E_NO_MEMORY -1
+#define CHEBYSHEV_E_ARGUMENTS -2
+#define CHEBYSHEV_E_TOLERANCE -3
+#define CHEBYSHEV_E_FORMAT    -4
+
+// The most coefficients in one piece, and the most pieces a channel is split into, which is also the shortest
+// piece as a fraction of the range.
+#define CHEBYSHEV_MAX_COEFFICIENTS 16
+#define CHEBYSHEV_MAX_SEGMENTS 256
+
+/**
+ * A solution compressed into piecewise Chebyshev series, one per output channel.
+ *
+ * Each channel's range is halved until the Chebyshev series over every piece, cut off after the last coefficient
+ * that matters at the channel's tolerance, is within tolerance of every row of the solution inside it.  The smooth
+ * stretches of a trajectory take one long piece of a dozen or so coefficients, and only the transonic region, where
+ * the drag functions put kinks in the velocity, takes short ones.  A value at any range is a bisection of the
+ * channel's pieces, at most log2(CHEBYSHEV_MAX_SEGMENTS) steps, and at most CHEBYSHEV_MAX_COEFFICIENTS
+ * multiply-adds: about 20 ns, whatever the range.  Rows are fitted at the range they were recorded at, which is up
+ * to a step past the yard they are filed under, so the fit at a whole yard is the trajectory there rather than
+ * the row.
+ *
+ * The whole thing is one block of memory that is also its serialized form, in the host's byte order:
+ *   header:  char magic[8] = "BLSTCHB1", uint32 byte-order mark 0x01020304, uint32 size in bytes,
+ *            double max range in yards, double muzzle velocity, then for each channel uint32 pieces,
+ *            uint32 first piece
+ *   pieces:  for each piece of each channel in turn, double start in yards, uint32 first coefficient,
+ *            uint32 coefficient count
+ *   then the coefficients, as doubles.
+ * At the default tolerances a trajectory to 1000 yards takes 400 to 900 bytes in all and one to 2000 yards 700 to
+ * 2000, against 48 bytes per yard for the solution it came from.
+ */
+typedef struct ChebyshevTrajectory ChebyshevTrajectory;
+
+typedef enum {
+  CHEBYSHEV_PATH,     // Ballistics_get_path(), in inches
+  CHEBYSHEV_TIME,     // Ballistics_get_time(), in seconds
+  CHEBYSHEV_VELOCITY, // Ballistics_get_v_fps()
+  CHEBYSHEV_LAG,      // the time of flight less the time in a vacuum, in seconds, that crosswind drift goes with
+  CHEBYSHEV_CHANNELS
+} ChebyshevChannel;
+
+// The default tolerances: 0.01 in, 10 us, 0.1 ft/s, and the 10 us that keeps windage in a 10 mi/hr wind to 0.002 in.
+#define CHEBYSHEV_PATH_TOLERANCE 0.01
+#define CHEBYSHEV_TIME_TOLERANCE 1e-5
+#define CHEBYSHEV_VELOCITY_TOLERANCE 0.1
+#define CHEBYSHEV_LAG_TOLERANCE 1e-5
+
+/**
+ * Fits a solution.  The fit copies what it needs, so the solution can be freed or solved into again afterwards.
+ * @param trajectory Receives the fit.
+ * @param solution   A solution from any of the Ballistics_solve*() functions.
+ * @param tolerances The largest error to allow at any yard of the solution in each channel, in the channel's
+ *                   units, or NULL for the defaults above.
+ * @return 0, CHEBYSHEV_E_NO_MEMORY, CHEBYSHEV_E_ARGUMENTS if the solution has fewer than two rows or a tolerance
+ *         isn't positive, or CHEBYSHEV_E_TOLERANCE if a channel can't be fitted that closely with pieces
+ *         1/CHEBYSHEV_MAX_SEGMENTS of the range long
+ */
+int ChebyshevTrajectory_fit(ChebyshevTrajectory** trajectory, Ballistics* solution, const double* tolerances);
+void ChebyshevTrajectory_free(ChebyshevTrajectory* trajectory);
+
+/**
+ * The serialized form: size bytes, starting at the fit itself.  Cache or send it as it is.
+ */
+const void* ChebyshevTrajectory_bytes(const ChebyshevTrajectory* trajectory);
+size_t ChebyshevTrajectory_size(const ChebyshevTrajectory* trajectory);
+
+/**
+ * Reads a serialized fit back, checking it is whole and was written on a machine of the same byte order.
+ * @return 0, CHEBYSHEV_E_NO_MEMORY, or CHEBYSHEV_E_FORMAT if the bytes aren't a fit
+ */
+int ChebyshevTrajectory_load(ChebyshevTrajectory** trajectory, const void* bytes, size_t size);
+
+// Returns the furthest range the fit covers, in yards.
+double ChebyshevTrajectory_get_max_range(const ChebyshevTrajectory* trajectory);
+
+/**
+ * Evaluates a channel at any range from 0 to the furthest the fit covers, whole yards or not.
+ * @return the channel's value, or 0 outside the fit, like the solution's accessors
+ */
+double ChebyshevTrajectory_get(const ChebyshevTrajectory* trajectory, ChebyshevChannel channel, double range_yards);
+
+/**
+ * The windage for a crosswind, in inches, from the lag: Ballistics_get_windage() for a solution with that crosswind,
+ * whatever the crosswind of the solution that was fitted.
+ * @param crosswind The crosswind, in mi/hr, as crosswind() resolves it from a wind speed and angle.
+ */
+double ChebyshevTrajectory_get_windage(const ChebyshevTrajectory* trajectory, double range_yards, double crosswind);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -20,7 +20,32 @@
 extern "C" {
 #endif
 
+#ifdef BALLISTICS_EMBEDDED
+/**
+ * The embedded profile (the BALLISTICS_EMBEDDED CMake option) never touches the heap.  Solutions come from a
+ * static pool of BALLISTICS_EMBEDDED_SOLUTIONS tables of BALLISTICS_EMBEDDED_MAX_YARDS rows each, and PBR results
+ * from a pool of BALLISTICS_EMBEDDED_PBRS; allocating from an exhausted pool fails instead of blocking.  The pools
+ * are not locked, so only one thread may solve at a time.
+ *
+ * Every integration step moves the projectile 0.5 ft along its path, and solving stops once it falls steeper than
+ * vy = 3*vx, so each step advances at least 0.5/sqrt(10) ft downrange.  A table therefore takes at most
+ * BALLISTICS_EMBEDDED_MAX_STEPS steps, each of them a fixed amount of arithmetic, which bounds the cycle count of
+ * every solve.
+ */
+#ifndef BALLISTICS_EMBEDDED_MAX_YARDS
+#define BALLISTICS_EMBEDDED_MAX_YARDS 2000
+#endif
+#ifndef BALLISTICS_EMBEDDED_SOLUTIONS
+#define BALLISTICS_EMBEDDED_SOLUTIONS 1
+#endif
+#ifndef BALLISTICS_EMBEDDED_PBRS
+#define BALLISTICS_EMBEDDED_PBRS 1
+#endif
+#define BALLISTICS_EMBEDDED_MAX_STEPS (19*BALLISTICS_EMBEDDED_MAX_YARDS + 1)
+#define BALLISTICS_COMPUTATION_MAX_YARDS BALLISTICS_EMBEDDED_MAX_YARDS
+#else
 #define BALLISTICS_COMPUTATION_MAX_YARDS 50000
+#endif
 #define GRAVITY (-32.194)
 
 #ifdef __cplusplus
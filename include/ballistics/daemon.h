@@ -0,0 +1,84 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The wire protocol of ballisticsd, the solver daemon.
+ *
+ * Clients connect to the daemon's Unix domain socket and write requests; the daemon writes one response for every
+ * request, though not necessarily in the order they were sent, so clients match them up by id.  Both are the
+ * structures below in the host's byte order, truncated after the last target actually used: a request is
+ * BallisticsdRequest_size(target_count) bytes, and a response BallisticsdResponse_size(target_count).  A daemon
+ * with no memory left to hold a response closes the connection instead, so no request goes unanswered unnoticed.
+ *
+ * Each request is zeroed with zero_angle() and solved with Ballistics_solve_targets(), exactly as
+ * Ballistics_solve_batch() would.
+ */
+
+#define BALLISTICSD_MAGIC 0x31534442 // "BDS1"
+#define BALLISTICSD_MAX_TARGETS 64
+#define BALLISTICSD_SOCKET "/tmp/ballisticsd.sock"
+
+// Response statuses besides the number of targets reached and the Ballistics_solve_targets() errors.
+#define BALLISTICSD_E_BAD_REQUEST -100
+#define BALLISTICSD_E_NO_MEMORY   -101 // the daemon couldn't take the request on; it may be retried
+
+typedef struct {
+  uint32_t magic;        // BALLISTICSD_MAGIC
+  uint32_t id;           // chosen by the client and echoed in the response
+  int32_t drag_function; // G1..G8
+  int32_t target_count;  // 0 to BALLISTICSD_MAX_TARGETS
+  double drag_coefficient;
+  double vi;
+  double sight_height;
+  double zero_range;     // yards
+  double y_intercept;    // inches
+  double shooting_angle;
+  double wind_speed;
+  double wind_angle;
+  double ranges[BALLISTICSD_MAX_TARGETS]; // in yards
+} BallisticsdRequest;
+
+typedef struct {
+  uint32_t magic;       // BALLISTICSD_MAGIC
+  uint32_t id;          // the request's id
+  int32_t status;       // the number of targets reached, or a negative error
+  int32_t target_count; // the request's target_count
+  double zero_angle;    // in degrees
+  BallisticsTarget targets[BALLISTICSD_MAX_TARGETS];
+} BallisticsdResponse;
+
+static inline size_t BallisticsdRequest_size(int target_count) {
+  return offsetof(BallisticsdRequest, ranges) + sizeof(double) * (size_t)target_count;
+}
+
+static inline size_t BallisticsdResponse_size(int target_count) {
+  return offsetof(BallisticsdResponse, targets) + sizeof(BallisticsTarget) * (size_t)target_count;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
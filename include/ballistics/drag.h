@@ -18,6 +18,9 @@
 
 #include <math.h>
 
+#include "fastmath.h"
+#include "stats.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -37,6 +40,8 @@ static inline double retard(DragFunction drag_function, double drag_coefficient,
   double acceleration = -1;
   double mass = -1;
 
+  BALLISTICS_STATS_RETARD(vp);
+
   switch(drag_function) {
     case G1:
       if (vp > 4230) {     acceleration = 1.477404177730177e-04; mass = 1.9565; }
@@ -138,7 +143,7 @@ static inline double retard(DragFunction drag_function, double drag_coefficient,
   }
 
   if (acceleration != -1 && mass != -1 && vp > 0 && vp < 10000) {
-    return acceleration * pow(vp,mass)/drag_coefficient;
+    return acceleration * BALLISTICS_POW(vp,mass)/drag_coefficient;
   }
   else {
     return -1;
@@ -149,6 +154,8 @@ static inline double retard(DragFunction drag_function, double drag_coefficient,
   double acceleration = -1;
   double mass = -1;
 
+  BALLISTICS_STATS_RETARD(vp);
+
   switch(drag_function) {
     case G1:
       if (vp > 4230) {     acceleration = 1.477404177730177e-04; mass = 1.9565; }
@@ -251,7 +258,7 @@ static inline double retard(DragFunction drag_function, double drag_coefficient,
   double adjusted_drag_coefficient = drag_coefficient / formFactor;
 
   if (acceleration != -1 && mass != -1 && vp > 0 && vp < 10000) {
-    return acceleration * pow(vp,mass)/adjusted_drag_coefficient;
+    return acceleration * BALLISTICS_POW(vp,mass)/adjusted_drag_coefficient;
   }
   else {
     return -1;
@@ -259,6 +266,48 @@ static inline double retard(DragFunction drag_function, double drag_coefficient,
 }
 
 
+#define DRAG_TABLE_MAX_BANDS 64
+
+/**
+ * One velocity band of a custom drag table, in the same power-law form as the bands of retard().
+ */
+typedef struct {
+  double velocity;     // The band applies to velocities above this, in ft/s.
+  double acceleration;
+  double mass;
+} DragBand;
+
+/**
+ * A custom drag function, such as one fitted from doppler radar tracks by DragFit_fit_files().  Bands are
+ * ordered from the fastest to the slowest, exactly like the chains of comparisons in retard().
+ */
+typedef struct {
+  int count;
+  DragBand bands[DRAG_TABLE_MAX_BANDS];
+} DragTable;
+
+/**
+ * Calculates ballistic retardation from a custom drag table.
+ * @param table            The drag table.
+ * @param drag_coefficient The coefficient of drag for the projectile, relative to the drag table.
+ * @param vp               The Velocity of the projectile.
+ * @return The projectile drag retardation velocity, in ft/s per second, or -1 below the slowest band.
+ */
+static inline double retard_table(const DragTable* table, double drag_coefficient, double vp) {
+  int i;
+
+  BALLISTICS_STATS_RETARD(vp);
+
+  if (vp > 0 && vp < 10000) {
+    for (i = 0; i < table->count; i++) {
+      if (vp > table->bands[i].velocity) {
+        return table->bands[i].acceleration * BALLISTICS_POW(vp, table->bands[i].mass)/drag_coefficient;
+      }
+    }
+  }
+  return -1;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "drag.h"
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRAGFIT_E_IO        -1
+#define DRAGFIT_E_NO_DATA   -2
+#define DRAGFIT_E_NO_MEMORY -3
+#define DRAGFIT_E_ARGUMENTS -4
+#define DRAGFIT_E_FORMAT    -5
+
+// The widest velocity difference DragFit_fit_files() will take, in samples.
+#define DRAGFIT_MAX_STRIDE 256
+
+/**
+ * Fits a custom drag table to doppler radar tracks.
+ *
+ * Each track file is plain text with one sample per line: the range in feet and the velocity in ft/s, separated
+ * by whitespace or a comma.  Blank lines and lines starting with '#' separate shots, and every file starts a new
+ * shot.  Files are streamed a line at a time, so they can be any size, and are spread across worker threads.
+ *
+ * The deceleration between each sample and the one stride samples before it is binned by velocity, and every
+ * band gets a least-squares power-law fit of the same form retard() uses.  Bands with too few samples are
+ * dropped, leaving the next slower band to cover them.
+ *
+ * The table is fitted against velocity rather than as a Cd(Mach) curve, because retard() and the solvers take
+ * drag as a retardation in ft/s at standard air, with the atmosphere folded into the drag coefficient by
+ * atmosphere_correction(), and have no speed of sound to look a Mach number up with.  At standard air the two
+ * are the same curve: a band's retardation a*v^m is a drag coefficient proportional to v^(m-2), at a Mach number
+ * of v over 1116.45 ft/s, so the bands' velocities divided by that are the curve's Mach breakpoints.
+ *
+ * The tracks carry only range and velocity, so gravity's component along the path can't be separated from drag
+ * and is counted as part of it: g*sin(angle) along a path at that angle to level, under 0.6 ft/s^2 within a degree
+ * of it.  That is small beside drag for the near-level tracks radar is used for, but a steeply rising track makes
+ * the table overstate drag and a falling one understate it.
+ * @param table            Receives the fitted table, ready for Ballistics_solve_table() and zero_angle_table().
+ * @param paths            The track files.
+ * @param count            The number of track files.
+ * @param band_velocities  The lower velocity bound of each band, in ft/s, in any order.
+ * @param bands            The number of bands; no more than DRAG_TABLE_MAX_BANDS.
+ * @param drag_coefficient The drag coefficient the table will be used with.  The tracks' projectile is given
+ *                         exactly this coefficient; 1 gives a table of absolute retardation.
+ * @param stride           How many samples apart to difference velocities; larger values smooth radar noise.
+ * @param threads          The number of worker threads, or 0 to use every online CPU.
+ * @return the number of decelerations used for the fit, or one of the DRAGFIT_E_* errors.
+ */
+long DragFit_fit_files(DragTable* table, const char* const* paths, int count, const double* band_velocities,
+                       int bands, double drag_coefficient, int stride, int threads);
+
+/**
+ * Writes a drag table as text, one "velocity acceleration mass" band per line.
+ * @return 0, or DRAGFIT_E_IO
+ */
+int DragTable_write(const DragTable* table, FILE* file);
+
+/**
+ * Reads a drag table written by DragTable_write().  Blank lines and lines starting with '#' are skipped.
+ * @return 0, DRAGFIT_E_IO, DRAGFIT_E_NO_DATA if the file holds no bands, or DRAGFIT_E_FORMAT if a line isn't three
+ *         finite numbers, the velocities don't fall strictly from one band to the next as retard_table() needs,
+ *         or there are more than DRAG_TABLE_MAX_BANDS bands
+ */
+int DragTable_read(DragTable* table, FILE* file);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
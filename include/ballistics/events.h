@@ -0,0 +1,130 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "angle.h"
+#include "drag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENTS_E_ARGUMENTS -1
+#define EVENTS_E_TOO_FAST_VY -2
+
+// The most events one integration can watch.
+#define EVENTS_MAX 16
+
+// The step the solvers take, in feet of flight, and the default here.
+#define EVENTS_DEFAULT_STEP_FEET 0.5
+
+// The speed of sound at standard conditions, and the speed below which flight is transonic, in ft/s.
+#define EVENTS_SPEED_OF_SOUND_FPS 1116.45
+#define EVENTS_TRANSONIC_FPS (1.2*EVENTS_SPEED_OF_SOUND_FPS)
+
+/**
+ * Event detection inside the integrator.
+ *
+ * The solvers find things like zero crossings and the apex by checking flags after each step, so what they find is
+ * snapped to the step it happened in, and the step has to stay small for the answers to be good.  Here each event
+ * is a function of the projectile's state that changes sign where the event happens.  The integrator evaluates
+ * every event after every step, and when one changes sign it finds the root inside the step by regula falsi
+ * (the Illinois variant), re-taking a partial step from the start of the step each time.  A partial step is the
+ * exact continuation of the integrator's own step, so the located event is exact for the trajectory being
+ * integrated, whatever the step size, and steps can be made much longer than the solvers' half foot.
+ */
+
+/**
+ * The projectile's state, in the line-of-sight frame the solvers integrate in.
+ */
+typedef struct {
+  double t;  // time of flight, in seconds
+  double x;  // distance along the line of sight, in feet
+  double y;  // height above the line of sight, in feet
+  double vx; // velocity along the line of sight, in ft/s
+  double vy; // velocity across it, in ft/s
+  double v;  // total velocity, in ft/s
+} BallisticsState;
+
+typedef double (*BallisticsEventFunction)(const BallisticsState* state, const void* context);
+
+// Which sign changes count as the event.
+#define EVENTS_RISING  1 // negative to positive
+#define EVENTS_FALLING 2 // positive to negative
+#define EVENTS_EITHER  3
+
+typedef struct {
+  BallisticsEventFunction function;
+  const void* context;  // passed to function
+  int direction;        // EVENTS_RISING, EVENTS_FALLING or EVENTS_EITHER
+  int terminal;         // nonzero to stop the integration the first time the event happens
+} BallisticsEvent;
+
+typedef struct {
+  int event;             // the index of the event that happened
+  int direction;         // EVENTS_RISING or EVENTS_FALLING
+  BallisticsState state; // the state where it happened
+} BallisticsEventHit;
+
+// Event functions for the common events.  Each takes a pointer to a double as its context.
+double BallisticsEvent_height(const BallisticsState* state, const void* inches);  // height above the line of sight
+double BallisticsEvent_range(const BallisticsState* state, const void* yards);    // range
+double BallisticsEvent_velocity(const BallisticsState* state, const void* fps);   // total velocity
+// No context: vy, which falls through zero at the apex.
+double BallisticsEvent_apex(const BallisticsState* state, const void* unused);
+
+/**
+ * Integrates a trajectory and reports every event that happens, in the order they happen.  Every parameter from
+ * drag_function to wind_angle has the same meaning as in Ballistics_solve().
+ * @param hits            Receives the events that happened.
+ * @param max_hits        The integration stops once this many events have happened.
+ * @param events          The events to watch for.
+ * @param event_count     The number of events, at most EVENTS_MAX.
+ * @param max_range_yards The range to stop at, or 0 for BALLISTICS_COMPUTATION_MAX_YARDS.
+ * @param step_feet       The integration step, in feet of flight, or 0 for EVENTS_DEFAULT_STEP_FEET.
+ * @return the number of events that happened, EVENTS_E_TOO_FAST_VY if the projectile climbed too steeply to keep
+ *         integrating before max_hits events or a terminal event, or EVENTS_E_ARGUMENTS
+ */
+int Ballistics_find_events(BallisticsEventHit* hits, int max_hits, const BallisticsEvent* events, int event_count,
+                           DragFunction drag_function, double drag_coefficient, double vi, double sight_height,
+                           double shooting_angle, double zero_angle, double wind_speed, double wind_angle,
+                           double max_range_yards, double step_feet);
+
+/**
+ * The same zero as zero_angle(), found by Newton's method on the height at the zero range, which an event
+ * locates exactly.  It converges to far better than zero_angle()'s 0.01 MOA in a handful of trajectories, each only
+ * out to the zero range.
+ * @param angle       Receives the bore angle, in degrees.
+ * @param y_intercept The height at the zero range, in inches, as for zero_angle().
+ * @param step_feet   The integration step, in feet of flight, or 0 for EVENTS_DEFAULT_STEP_FEET.
+ * @return 0, or ZERO_E_OUT_OF_RANGE if the projectile can't be made to reach the zero range
+ */
+int zero_angle_refined(double* angle, DragFunction drag_function, double drag_coefficient, double vi,
+                       double sight_height, double zero_range, double y_intercept, double step_feet);
+
+/**
+ * Finds the range, in yards, at which the projectile slows to fps: EVENTS_TRANSONIC_FPS for the start of
+ * transonic flight, or EVENTS_SPEED_OF_SOUND_FPS for subsonic.  The other parameters are as in Ballistics_solve().
+ * @return the range, or -1 if the projectile never slows that much within BALLISTICS_COMPUTATION_MAX_YARDS
+ */
+double Ballistics_range_at_velocity(DragFunction drag_function, double drag_coefficient, double vi,
+                                    double sight_height, double shooting_angle, double zero_angle, double fps,
+                                    double step_feet);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,96 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXPORT_E_IO        -1
+#define EXPORT_E_NO_MEMORY -2
+#define EXPORT_E_ARGUMENTS -3
+
+// Bytes a writer buffers before handing them to its file.
+#define EXPORT_BUFFER_SIZE (1 << 20)
+
+/**
+ * Streams many solutions to one file.
+ *
+ * BALLISTICS_EXPORT_CSV writes a header line naming the columns ("id" and then one per field), then one line per
+ * exported yard.  Values are written with a fixed number of decimals, which is much faster than printf; a negative
+ * precision writes every value with %.17g instead, which reads back exactly.
+ *
+ * BALLISTICS_EXPORT_BINARY writes a columnar file that reads back exactly, in the host's byte order:
+ *   header:  char magic[8] = "BLSTCOL1", uint32 byte-order mark 0x01020304, uint32 field count,
+ *            then one uint32 BallisticsField per field
+ *   blocks:  one per solution: uint64 id, uint32 rows, uint32 zero, then for each field in header order, rows
+ *            doubles
+ * Each block can be read by seeking straight to any column, and the file ends after the last block.
+ */
+typedef enum {
+  BALLISTICS_EXPORT_CSV,
+  BALLISTICS_EXPORT_BINARY
+} BallisticsExportFormat;
+
+typedef struct BallisticsWriter BallisticsWriter;
+
+/**
+ * Starts writing to a file, and buffers the header.  All the writer's memory is allocated here; writing does no
+ * allocation at all.
+ * @param writer      Receives the writer.
+ * @param file        The file to write to, which the writer does not close.
+ * @param format      BALLISTICS_EXPORT_CSV or BALLISTICS_EXPORT_BINARY.
+ * @param fields      The outputs to export, in column order.  Fields may repeat.
+ * @param field_count The number of fields, from 1 to 64.
+ * @param precision   CSV only: decimals per value, at most 9, or negative for exact values.
+ * @return 0, EXPORT_E_ARGUMENTS or EXPORT_E_NO_MEMORY
+ */
+int BallisticsWriter_open(BallisticsWriter** writer, FILE* file, BallisticsExportFormat format,
+                          const BallisticsField* fields, int field_count, int precision);
+
+/**
+ * Appends count yards of a solution, every stride yards starting at first.  Rows past the end of the solution are
+ * left out.
+ * @param id An identifier for the solution, written with each of its rows (CSV) or its block (binary).
+ * @return the number of rows written, or EXPORT_E_IO or EXPORT_E_ARGUMENTS.  Once a write fails, every later call
+ *         fails too.
+ */
+int BallisticsWriter_write(BallisticsWriter* writer, Ballistics* ballistics, unsigned long long id, int first,
+                           int count, int stride);
+
+/**
+ * Hands everything buffered so far to the file and flushes it.
+ * @return 0 or EXPORT_E_IO
+ */
+int BallisticsWriter_flush(BallisticsWriter* writer);
+
+/**
+ * Flushes and frees the writer.
+ * @return 0, or EXPORT_E_IO if any write failed
+ */
+int BallisticsWriter_close(BallisticsWriter* writer);
+
+// The CSV column name for a field, such as "path_inches".
+const char* BallisticsWriter_field_name(BallisticsField field);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
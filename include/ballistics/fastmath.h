@@ -0,0 +1,127 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Fixed-cost replacements for the libm functions the solvers call on every step.  Each one is a range reduction
+ * followed by a fixed-degree polynomial, with no loops and no data-dependent iteration counts, so it costs the
+ * same number of cycles for every argument.  They are accurate to about 1e-12 relative, far below anything the
+ * 0.5 ft integration step can resolve.
+ *
+ * The solvers only use them in the embedded profile (BALLISTICS_EMBEDDED); the full build keeps calling libm
+ * through the BALLISTICS_* macros at the bottom of this file.  Subnormal and non-finite arguments are not handled.
+ */
+
+// Base-2 logarithm, for x > 0.
+static inline double fast_log2(double x) {
+  uint64_t bits;
+  double m, s, s2;
+  int e;
+
+  memcpy(&bits, &x, sizeof(bits));
+  e = (int)((bits >> 52) & 0x7ff) - 1023;
+  bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+  memcpy(&m, &bits, sizeof(m)); // x = m * 2^e, with m in [1, 2)
+  if (m > M_SQRT2) {
+    m *= 0.5;
+    e++;
+  }
+
+  // ln(m) = 2 atanh(s), and |s| <= 0.172 once m is within [sqrt(1/2), sqrt(2)].
+  s = (m - 1) / (m + 1);
+  s2 = s*s;
+  return e + 2*M_LOG2E*s*(1 + s2*(1.0/3 + s2*(1.0/5 + s2*(1.0/7 + s2*(1.0/9 + s2*(1.0/11 + s2*(1.0/13)))))));
+}
+
+// 2 raised to z.  Results are clamped to the normal range of a double.
+static inline double fast_exp2(double z) {
+  uint64_t bits;
+  double scale, r;
+  int k;
+
+  if (z > 1023) z = 1023;
+  if (z < -1022) z = -1022;
+  k = (int)(z + (z >= 0 ? 0.5 : -0.5));
+  r = (z - k) * M_LN2; // |r| <= ln(2)/2
+
+  bits = (uint64_t)(k + 1023) << 52;
+  memcpy(&scale, &bits, sizeof(scale));
+  return scale * (1 + r*(1 + r*(1.0/2 + r*(1.0/6 + r*(1.0/24 + r*(1.0/120 + r*(1.0/720 + r*(1.0/5040
+         + r*(1.0/40320 + r*(1.0/362880 + r*(1.0/3628800 + r*(1.0/39916800))))))))))));
+}
+
+// x raised to y, for x > 0.  Returns 0 for any other x.
+static inline double fast_pow(double x, double y) {
+  return x > 0 ? fast_exp2(y * fast_log2(x)) : 0;
+}
+
+// Cube root.
+static inline double fast_cbrt(double x) {
+  double a = fabs(x);
+  double r;
+
+  if (a == 0) return 0;
+  r = fast_exp2(fast_log2(a) / 3);
+  r -= (r*r*r - a) / (3*r*r); // one Newton step brings it to full precision
+  return x < 0 ? -r : r;
+}
+
+// Arctangent, in radians.
+static inline double fast_atan(double x) {
+  const double sqrt3 = 1.7320508075688772;
+  double a = fabs(x);
+  double offset = 0;
+  double s, r;
+  int invert = a > 1;
+
+  if (invert) a = 1 / a;
+  // atan(a) = pi/6 + atan((a*sqrt(3) - 1) / (sqrt(3) + a)) brings a down to at most tan(pi/12).
+  if (a > 0.2679491924311227) {
+    a = (a*sqrt3 - 1) / (sqrt3 + a);
+    offset = M_PI / 6;
+  }
+  s = a*a;
+  r = offset + a*(1 - s*(1.0/3 - s*(1.0/5 - s*(1.0/7 - s*(1.0/9 - s*(1.0/11 - s*(1.0/13 - s*(1.0/15
+      - s*(1.0/17 - s*(1.0/19))))))))));
+  if (invert) r = M_PI_2 - r;
+  return x < 0 ? -r : r;
+}
+
+// The math the solvers use on their hot paths.
+#ifdef BALLISTICS_EMBEDDED
+#define BALLISTICS_POW(x, y) fast_pow((x), (y))
+#define BALLISTICS_CBRT(x) fast_cbrt(x)
+#define BALLISTICS_ATAN(x) fast_atan(x)
+#define BALLISTICS_SPEED(vx, vy) sqrt((vx)*(vx) + (vy)*(vy))
+#else
+#define BALLISTICS_POW(x, y) pow((x), (y))
+#define BALLISTICS_CBRT(x) cbrt(x)
+#define BALLISTICS_ATAN(x) atan(x)
+#define BALLISTICS_SPEED(vx, vy) pow(pow((vx),2)+pow((vy),2),0.5)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
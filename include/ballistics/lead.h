@@ -0,0 +1,108 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LEAD_E_NO_MEMORY    -1
+#define LEAD_E_ARGUMENTS    -2
+#define LEAD_E_OUT_OF_RANGE -3
+
+/**
+ * Leads for moving targets, read off a solved trajectory without solving it again.
+ *
+ * A target's motion is given by its speed, in mi/hr, and its heading relative to the line of fire, in degrees:
+ *   0 degrees is moving straight away from the shooter
+ *   90 degrees is crossing from left to right
+ *   180 degrees is coming straight at the shooter
+ *   270 or -90 degrees is crossing from right to left.
+ * The bullet meets the target where the target will be after the time of flight to that point, so a target moving
+ * away is met further out, and later, than its range when the shot is fired.  Leads are measured at that meeting
+ * point and are positive to the right: hold that far ahead of the target in the direction it is crossing.
+ */
+
+typedef struct LeadTimeline LeadTimeline;
+
+/**
+ * Builds a time-indexed view of a solution: time of flight at every whole yard and range at evenly spaced times,
+ * so either can be looked up from the other in constant time.  The view copies what it needs, so the solution
+ * can be freed or solved into again afterwards.
+ * @param timeline Receives the view.
+ * @param solution A solution from any of the Ballistics_solve*() functions.
+ * @return 0, LEAD_E_NO_MEMORY, or LEAD_E_ARGUMENTS if the solution has fewer than two rows
+ */
+int LeadTimeline_build(LeadTimeline** timeline, Ballistics* solution);
+void LeadTimeline_free(LeadTimeline* timeline);
+
+// Returns the furthest range, in yards, and the longest time of flight, in seconds, the view covers.
+double LeadTimeline_get_max_range(const LeadTimeline* timeline);
+double LeadTimeline_get_max_time(const LeadTimeline* timeline);
+
+// Returns the time of flight, in seconds, to range_yards, or -1 past the end of the view.
+double LeadTimeline_time_at(const LeadTimeline* timeline, double range_yards);
+
+// Returns the range, in yards, the projectile has reached after seconds, or -1 past the end of the view.
+double LeadTimeline_range_at(const LeadTimeline* timeline, double seconds);
+
+/**
+ * The lead for one target.
+ */
+typedef struct {
+  double range_yards;   // where the bullet meets the target
+  double seconds;       // the time of flight to that point
+  double inches;        // how far the target moves across the line of fire in that time
+  double moa;           // the same lead as an angle, in MOA
+  double mil;           // and in milliradians
+} Lead;
+
+/**
+ * Works out the lead for one moving target.
+ * @param range_yards The target's range when the shot is fired.
+ * @param speed       The target's speed, in mi/hr.
+ * @param heading     The target's heading relative to the line of fire, in degrees, as described above.
+ * @return 0, or LEAD_E_OUT_OF_RANGE if the bullet meets the target past the end of the view, leaving lead zeroed
+ */
+int Lead_solve(const LeadTimeline* timeline, double range_yards, double speed, double heading, Lead* lead);
+
+typedef enum {
+  LEAD_INCHES,
+  LEAD_MOA,
+  LEAD_MIL
+} LeadUnit;
+
+/**
+ * Fills a table of leads for every combination of target speed, heading and range, the same values Lead_solve()
+ * gives.  Each speed and heading is resolved into its components once, and the ranges are then a straight loop of
+ * table lookups and arithmetic, which the compiler vectorizes.
+ * @param ranges   The targets' ranges when the shot is fired, in yards.
+ * @param speeds   The targets' speeds, in mi/hr.
+ * @param headings The targets' headings, in degrees.
+ * @param unit     LEAD_INCHES, LEAD_MOA or LEAD_MIL.
+ * @param out      Receives speed_count * heading_count * range_count leads, ranges varying fastest:
+ *                 out[(s * heading_count + h) * range_count + r].  Targets the bullet can't reach get 0.
+ * @return the number of targets the bullet reaches, or LEAD_E_ARGUMENTS
+ */
+int Lead_grid(const LeadTimeline* timeline, const double* ranges, int range_count, const double* speeds,
+              int speed_count, const double* headings, int heading_count, LeadUnit unit, double* out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -24,6 +24,8 @@ extern "C" {
 
 #define PBR_E_OUT_OF_RANGE -1
 #define PBR_E_TOO_FAST_VY  -2
+#define PBR_E_NO_MEMORY    -3 // no memory for the result; in the embedded profile, every pooled result is in use
+#define PBR_E_ARGUMENTS    -4
 
 struct PBR;
 
@@ -78,6 +80,55 @@ void PBR_free(struct PBR* pbr);
 int PBR_solve(struct PBR** pbr, DragFunction drag_function, double drag_coefficient, double vi,
               double sight_height, double vital_size);
 
+/**
+ * The same point blank range as PBR_solve(), found with events (see events.h) instead of flags snapped to the
+ * step.  The bore angle is solved to put the apex at half the vital size with each trial trajectory ending at its
+ * apex, and then one trajectory locates the zeros, the PBR bounds and the height at 100 yards exactly.  That is
+ * both much faster and more accurate than PBR_solve(), so results can differ from it by a yard where the exact
+ * answer is close to a whole yard.
+ * @param step_feet The integration step, in feet of flight, or 0 for EVENTS_DEFAULT_STEP_FEET.
+ * @return 0 if pbr exists, or a negative PBR_E_* error
+ */
+int PBR_solve_refined(struct PBR** pbr, DragFunction drag_function, double drag_coefficient, double vi,
+                      double sight_height, double vital_size, double step_feet);
+
+#ifndef BALLISTICS_EMBEDDED
+/**
+ * One cell of a point blank range grid: the same results as PBR_solve_refined(), read from the caller's array
+ * rather than an allocated PBR.
+ */
+typedef struct {
+  int status;               // 0, or the negative PBR_E_* error PBR_solve_refined() would have returned
+  int near_zero_yards;
+  int far_zero_yards;
+  int min_PBR_yards;
+  int max_PBR_yards;
+  int sight_in_at_100yards; // in 100ths of an inch, as PBR_get_sight_in_at_100yards()
+  double angle;             // the bore angle, in degrees
+} PBRResult;
+
+/**
+ * Solves the point blank range of one load for every combination of vital size and sight height, in parallel.
+ *
+ * Sight height only shifts the trajectory down; the bore angle for a cell depends only on the height the apex has
+ * to reach above the bore line, half the vital size plus the sight height.  Cells that share that height, which a
+ * grid of evenly spaced sizes and heights has plenty of, share the search for the bore angle, which is most of
+ * PBR_solve_refined()'s work, and each cell then fires just one trajectory of its own.  The first cell with a given
+ * apex height gets exactly what PBR_solve_refined() gives it; the others can differ from it by as much as it can
+ * differ from itself between equivalent sight heights, a yard where the exact answer is close to a whole yard.
+ * @param results       Receives vital_count * sight_count cells, sight heights varying fastest:
+ *                      results[v * sight_count + s].
+ * @param vital_sizes   The vital zone sizes, in inches.
+ * @param sight_heights The sight heights, in inches.
+ * @param step_feet     The integration step, in feet of flight, or 0 for EVENTS_DEFAULT_STEP_FEET.
+ * @param threads       The number of threads, or 0 to use every online CPU.
+ * @return the number of cells solved, PBR_E_NO_MEMORY, or PBR_E_ARGUMENTS
+ */
+int PBR_solve_grid(PBRResult* results, DragFunction drag_function, double drag_coefficient, double vi,
+                   const double* vital_sizes, int vital_count, const double* sight_heights, int sight_count,
+                   double step_feet, int threads);
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIPELINE_E_NO_MEMORY -1
+#define PIPELINE_E_ARGUMENTS -2
+
+/**
+ * A memoized solve pipeline for live updates: weather, then atmosphere_correction(), then zero_angle(), then
+ * Ballistics_solve(), then a range card read off the solution.
+ *
+ * Each stage remembers the values it last ran with, and an update reruns only the stages one of whose own inputs
+ * has moved since.  A change of wind reruns the solve and the card but keeps the corrected drag coefficient and the
+ * zero; a change of card ranges reruns only the card.  Every value has a tolerance, 0 to begin with, and a stage
+ * counts a value as changed only once it has moved by more than its tolerance from the value the stage last ran
+ * with, so a run of small weather ticks can't creep past the tolerance unnoticed.  The stages' own outputs, the
+ * corrected drag coefficient and the zero, have tolerances too: a temperature tick that does rerun the correction
+ * needn't rerun the zero and the solve, if the coefficient barely moved.
+ *
+ * With every tolerance 0, an update gives exactly what running every stage again would.
+ */
+typedef struct BallisticsPipeline BallisticsPipeline;
+
+/**
+ * The values the stages depend on: the inputs, as for the functions of the stages that take them, and then the
+ * outputs of the correction and zero stages.
+ */
+typedef enum {
+  PIPELINE_DRAG_FUNCTION,              // a DragFunction; any change is material, whatever its tolerance
+  PIPELINE_DRAG_COEFFICIENT,           // at standard atmosphere
+  PIPELINE_VELOCITY,                   // ft/s
+  PIPELINE_SIGHT_HEIGHT,               // inches
+  PIPELINE_ZERO_RANGE,                 // yards
+  PIPELINE_Y_INTERCEPT,                // inches
+  PIPELINE_ALTITUDE,                   // feet
+  PIPELINE_BAROMETER,                  // in Hg
+  PIPELINE_TEMPERATURE,                // degrees F
+  PIPELINE_RELATIVE_HUMIDITY,          // fraction, 0 to 1
+  PIPELINE_SHOOTING_ANGLE,             // degrees
+  PIPELINE_WIND_SPEED,                 // mi/hr
+  PIPELINE_WIND_ANGLE,                 // degrees
+  PIPELINE_CORRECTED_DRAG_COEFFICIENT, // output of PIPELINE_CORRECTION
+  PIPELINE_ZERO_ANGLE,                 // output of PIPELINE_ZERO, in degrees
+  PIPELINE_VALUES
+} BallisticsPipelineValue;
+
+// The stages, as bits of what BallisticsPipeline_update() reran.
+typedef enum {
+  PIPELINE_CORRECTION = 1, // atmosphere_correction()
+  PIPELINE_ZERO = 2,       // zero_angle(), with the corrected coefficient
+  PIPELINE_SOLVE = 4,      // Ballistics_solve(), likewise
+  PIPELINE_CARD = 8        // the range card
+} BallisticsPipelineStage;
+
+/**
+ * Creates a pipeline with every input 0 except the drag function, G1, and standard air as atmosphere_correction()
+ * defines it: 0 feet, 29.53 in Hg, 59 degrees and 0.78 humidity.  Nothing is computed until the first update.
+ * @return the new pipeline, or NULL if out of memory
+ */
+BallisticsPipeline* BallisticsPipeline_alloc(void);
+void BallisticsPipeline_free(BallisticsPipeline* pipeline);
+
+/**
+ * Sets an input, or the tolerance of any value.  Nothing is recomputed until the next update.
+ * @return 0, or PIPELINE_E_ARGUMENTS for a value that isn't an input, or a negative tolerance
+ */
+int BallisticsPipeline_set(BallisticsPipeline* pipeline, BallisticsPipelineValue value, double x);
+int BallisticsPipeline_set_tolerance(BallisticsPipeline* pipeline, BallisticsPipelineValue value, double tolerance);
+
+/**
+ * Sets the ranges the card reads, in yards.  The card reads the solution's row for each range's whole yard, and
+ * gives zeroes past the end of the solution.
+ * @return 0, PIPELINE_E_NO_MEMORY or PIPELINE_E_ARGUMENTS
+ */
+int BallisticsPipeline_set_card(BallisticsPipeline* pipeline, const double* ranges, int count);
+
+/**
+ * Brings every stage up to date with the inputs, rerunning only what the changes since the last update invalidate.
+ * A stage that fails stays out of date, so the next update tries it again.
+ * @return the PIPELINE_* bits of the stages that reran, or a negative error from Ballistics_solve()
+ */
+int BallisticsPipeline_update(BallisticsPipeline* pipeline);
+
+// Returns a value: an input as last set, or a stage output as of the last update.
+double BallisticsPipeline_get(const BallisticsPipeline* pipeline, BallisticsPipelineValue value);
+
+// Returns the solution as of the last update, or NULL before the first.  It belongs to the pipeline.
+Ballistics* BallisticsPipeline_get_solution(const BallisticsPipeline* pipeline);
+
+/**
+ * Returns the card as of the last update: one target per range, in the order they were set, with the outputs
+ * Ballistics_solve_targets() gives, read from the solution's rows.
+ * @param count Receives the number of targets.
+ */
+const BallisticsTarget* BallisticsPipeline_get_card(const BallisticsPipeline* pipeline, int* count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,187 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A real-time fire-control loop.
+ *
+ * Sensors push updates into an RtChannel, a block of shared memory holding a lock-free single-producer,
+ * single-consumer ring of inputs and a seqlock-protected solution.  The solver thread polls the ring with
+ * RtSolver_poll(), which merges every pending update, re-solves only what they invalidate, and publishes the new
+ * solution; any number of readers pick it up with RtChannel_read() without ever blocking the solver.
+ *
+ * Nothing after setup allocates or makes a system call (timestamps come from the vDSO clock), and every solve is
+ * bounded: at most RT_ZERO_ITERATIONS trajectories out to the zero range when the atmosphere has changed (with
+ * zero_angle() as the fallback should those not converge), plus one trajectory out to the target.
+ */
+
+#define RT_E_FULL        -1
+#define RT_E_IO          -2
+#define RT_E_ARGUMENTS   -3
+
+// Inputs the ring holds before the producer sees RT_E_FULL.  A power of two.
+#define RT_RING_CAPACITY 1024
+
+// The most warm-started zeroing iterations one solve will run before falling back to zero_angle().
+#define RT_ZERO_ITERATIONS 4
+
+// Which fields of an RtInput an update carries.
+#define RT_INPUT_RANGE      1 // range_yards, from the rangefinder
+#define RT_INPUT_ANGLE      2 // shooting_angle, from the inclinometer
+#define RT_INPUT_WIND       4 // wind_speed and wind_angle
+#define RT_INPUT_ATMOSPHERE 8 // altitude, barometer, temperature and relative_humidity
+
+/**
+ * One sensor update.  Only the fields named in fields are read; the rest keep their last values.
+ */
+typedef struct {
+  uint32_t fields;
+  uint32_t reserved;
+  uint64_t timestamp_ns; // when the reading was taken, from RtChannel_now_ns()
+  double range_yards;
+  double shooting_angle;
+  double wind_speed;
+  double wind_angle;
+  double altitude;
+  double barometer;
+  double temperature;
+  double relative_humidity;
+} RtInput;
+
+/**
+ * A published solution.
+ */
+typedef struct {
+  uint64_t input_timestamp_ns;  // timestamp of the newest update it reflects
+  uint64_t solved_timestamp_ns; // when it was published
+  uint64_t inputs;              // updates consumed since the solver started
+  int32_t status;               // 1 if the target was reached, 0 if it is out of range, or a negative error
+  int32_t zeroed;               // 1 if this solve had to re-zero for a new atmosphere
+  int32_t resolved;             // 1 if this solve integrated the trajectory, 0 if it reused the last one
+  double range_yards;
+  double drag_coefficient;      // corrected for the atmosphere
+  double zero_angle;            // in degrees
+  double path_inches;
+  double moa_correction;
+  double windage_inches;
+  double windage_moa;
+  double seconds;
+  double v_fps;
+} RtSolution;
+
+typedef struct RtChannel RtChannel;
+
+/**
+ * Maps a channel in POSIX shared memory, so sensors, the solver and displays can be separate processes.
+ * @param name   The shared memory object's name, such as "/ballistics-rt".
+ * @param create Nonzero to create (or reset) the channel, zero to attach to an existing one.
+ * @return 0, RT_E_IO, or RT_E_ARGUMENTS if an existing object is not a channel
+ */
+int RtChannel_open(RtChannel** channel, const char* name, int create);
+
+// Unmaps a channel from RtChannel_open(); the shared memory object itself stays until RtChannel_unlink().
+void RtChannel_close(RtChannel* channel);
+int RtChannel_unlink(const char* name);
+
+// The size of a channel, for callers that place one in memory of their own.
+size_t RtChannel_size(void);
+
+// Prepares size bytes of suitably aligned memory as an empty channel, and returns it.
+RtChannel* RtChannel_init(void* memory);
+
+// Producer side: queues an update.  Returns 0, or RT_E_FULL if the solver has fallen RT_RING_CAPACITY behind.
+int RtChannel_push(RtChannel* channel, const RtInput* input);
+
+// Consumer side: takes the oldest queued update.  Returns 1 if there was one, otherwise 0.
+int RtChannel_pop(RtChannel* channel, RtInput* input);
+
+// Replaces the published solution.  Only the solver thread may publish.
+void RtChannel_publish(RtChannel* channel, const RtSolution* solution);
+
+/**
+ * Reads a consistent copy of the published solution, retrying while a publish is in progress.
+ * @return the number of solutions published so far; 0 means solution was not written
+ */
+uint64_t RtChannel_read(RtChannel* channel, RtSolution* solution);
+
+// A monotonic timestamp, in nanoseconds.
+uint64_t RtChannel_now_ns(void);
+
+/**
+ * The solver's state: a fixed load, the latest value of every input, and what it can reuse from the last solve.
+ * Owned by the caller; the solver never allocates.
+ */
+typedef struct {
+  DragFunction drag_function;
+  double drag_coefficient; // at standard conditions
+  double vi;
+  double sight_height;
+  double zero_range;
+
+  // Relative change in the corrected drag coefficient that the zero tolerates before it is solved again.  0, the
+  // default, re-zeroes on any change to the atmosphere.
+  double zero_tolerance;
+
+  RtInput state;
+  uint64_t inputs;
+  uint32_t stale; // RT_INPUT_* fields that have changed since the last solve
+
+  double corrected_drag_coefficient;
+  double zero_drag_coefficient; // the corrected drag coefficient zero_angle was solved for
+  double zero_angle;
+  double headwind;              // the headwind target was solved for
+  BallisticsTarget target;
+  int target_status;
+} RtSolver;
+
+/**
+ * Sets up a solver for a load zeroed at zero_range under standard conditions, with no wind, a level shot and a
+ * target at the zero range until updates say otherwise.
+ */
+void RtSolver_init(RtSolver* solver, DragFunction drag_function, double drag_coefficient, double vi,
+                   double sight_height, double zero_range);
+
+// Merges one update into the solver's inputs.
+void RtSolver_update(RtSolver* solver, const RtInput* input);
+
+/**
+ * Solves for the current inputs, doing only the work their changes call for: a new atmosphere re-zeroes from the
+ * previous zero, a new range, angle, atmosphere or headwind re-solves the trajectory, and a crosswind on its own
+ * only rescales the windage of the last trajectory.  The headwind counts as unchanged within a billionth of the
+ * wind speed or of a mile an hour, whichever is more, since headwind() of a wind straight across is a rounding
+ * error rather than 0.
+ */
+void RtSolver_solve(RtSolver* solver, RtSolution* solution);
+
+/**
+ * One pass of the real-time loop: merges every update waiting in the channel and, if there were any, solves and
+ * publishes.
+ * @return the number of updates merged
+ */
+int RtSolver_poll(RtSolver* solver, RtChannel* channel);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
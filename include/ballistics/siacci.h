@@ -0,0 +1,113 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIACCI_E_NO_MEMORY -1
+#define SIACCI_E_ARGUMENTS -2
+
+// The speeds the tables cover, in ft/s, and their spacing.  A trajectory ends where it slows below the slowest.
+#define SIACCI_MIN_FPS 100.0
+#define SIACCI_MAX_FPS 5000.0
+#define SIACCI_SPEED_STEP 1.0
+
+/**
+ * Siacci's method: trajectories from tables instead of integration, for screening many loads where an estimate
+ * will do.
+ *
+ * In flat fire the path is close enough to straight that the drag can be taken to act along the bore, at the
+ * pseudo-velocity u, the velocity along the bore line.  Then dx/du = -u/r(u) and dt/du = -1/r(u) for the drag
+ * function's retardation r, which depends only on u, and the range, time of flight and the two integrals of 1/u^2
+ * that give the drop can all be integrated once per drag function, as functions of u, and read off for any shot.
+ * The ballistic coefficient only scales them, so one set of tables serves every projectile on that drag function.
+ * A point on the trajectory is then a table lookup and a handful of arithmetic, with no stepping at all.
+ *
+ * The approximations are the flat fire and gravity acting only across the line of sight: the component of gravity
+ * along it, which slows an uphill shot and speeds a downhill one, and the headwind are left out.  Measured against
+ * Ballistics_solve(), level and with no wind, the largest difference in the path out to each range, in inches:
+ *                           500 yd   1000 yd   1500 yd   2000 yd
+ *   G7 0.243 at 2750 ft/s     0.01      0.07       0.7       3.7
+ *   G1 0.5 at 2900 ft/s       0.01      0.05       0.4       2.5
+ *   G7 0.15 at 3200 ft/s      0.01      0.2        1.6       8.2
+ *   G1 0.2 at 1100 ft/s       0.25      4.3       44       410
+ *   G1 0.1 at 1000 ft/s       0.8      43
+ * which is 0.1% of the drop or less while the projectile is supersonic, and up to a few percent for slow, steep
+ * trajectories.  The time of flight is within a millisecond and the velocity within 2 ft/s to 1000 yards for the
+ * supersonic loads.  Each 10 degrees of shooting angle adds about 0.5% of the drop for them, and 3% for the
+ * subsonic ones.
+ *
+ * A trajectory filled out at every yard costs about a twelfth of a solve, and a handful of targets with
+ * Siacci_solve_targets() about a thousandth.
+ */
+typedef struct SiacciTables SiacciTables;
+
+/**
+ * Integrates the tables for one drag function, from SIACCI_MAX_FPS down to SIACCI_MIN_FPS.
+ * @param tables        Receives the tables.
+ * @param drag_function G1, G2, G5, G6, G7 or G8.
+ * @return 0, SIACCI_E_NO_MEMORY, or SIACCI_E_ARGUMENTS if retard() has no table for the drag function
+ */
+int SiacciTables_build(SiacciTables** tables, DragFunction drag_function);
+void SiacciTables_free(SiacciTables* tables);
+
+// Returns the drag function the tables were built for.
+DragFunction SiacciTables_get_drag_function(const SiacciTables* tables);
+
+/**
+ * Fills out a trajectory at every yard from the tables, in the form a solver stores it: range, path and time
+ * in feet and seconds, and velocities in ft/s, with the time of each yard, like the solvers', at the end of a half
+ * foot step from there.  Every parameter from drag_coefficient to zero_angle has the same meaning as in
+ * Ballistics_solve(), for the drag function the tables were built for.
+ * @param rows The number of yards to fill.
+ * @return the number of yards filled, which stops short where the projectile slows below SIACCI_MIN_FPS
+ */
+int SiacciTables_trajectory(const SiacciTables* tables, double drag_coefficient, double vi, double sight_height,
+                            double shooting_angle, double zero_angle, int rows, double* x, double* y, double* t,
+                            double* v, double* vx, double* vy);
+
+/**
+ * The same as Ballistics_solve_into(), from the tables instead of by integration, for every accessor to read as it
+ * would a solved trajectory.  The solution keeps its inputs, and Ballistics_extend() and Ballistics_get_state()
+ * carry on from it by integrating.  Only the wind's crosswind counts, there as in the tables: the headwind is left
+ * out of the integration too, so an extended solution is one model throughout.
+ * @return the number of rows in the solution
+ */
+int Ballistics_solve_siacci_into(Ballistics* ballistics, const SiacciTables* tables, double drag_coefficient,
+                                 double vi, double sight_height, double shooting_angle, double zero_angle,
+                                 double wind_speed, double wind_angle);
+// The same as Ballistics_solve_siacci_into(), into a new solution like Ballistics_solve().
+int Ballistics_solve_siacci(Ballistics** ballistics, const SiacciTables* tables, double drag_coefficient, double vi,
+                            double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                            double wind_angle);
+
+/**
+ * The same as Ballistics_solve_targets(), from the tables: each target costs a search of the tables and no more,
+ * whatever its range, which is what screening a great many loads at a few ranges calls for.
+ * @return the number of targets the projectile reaches, or SIACCI_E_ARGUMENTS
+ */
+int Siacci_solve_targets(BallisticsTarget* targets, int count, const SiacciTables* tables, double drag_coefficient,
+                         double vi, double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                         double wind_angle);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,141 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Solver instrumentation.  Counting and timing is only compiled in when BALLISTICS_STATS is defined (the
+ * BALLISTICS_ENABLE_STATS CMake option); otherwise the instrumentation macros below expand to nothing and the
+ * functions report zeros.
+ *
+ * Everything is counted per thread, so reading the counters never contends with solves on other threads.
+ */
+
+typedef enum {
+  BALLISTICS_PHASE_SOLVE,   // Ballistics_solve() and its variants
+  BALLISTICS_PHASE_ZERO,    // zero_angle(), zero_angle_table() and zero_angles()
+  BALLISTICS_PHASE_PBR,     // PBR_solve()
+  BALLISTICS_PHASE_TRUING,  // Truing_solve()
+  BALLISTICS_PHASES
+} BallisticsPhase;
+
+// retard() calls are counted in 100 ft/s velocity bands, which is about as fine as the standard drag tables'.
+#define BALLISTICS_STATS_VELOCITY_BANDS 100
+#define BALLISTICS_STATS_VELOCITY_BAND_WIDTH 100
+
+// Latency histograms have one bucket per power of two nanoseconds.
+#define BALLISTICS_STATS_LATENCY_BUCKETS 40
+
+/**
+ * What one top-level solve cost.  Nested solves (the zeroing inside Truing_solve(), say) are included in the
+ * solve that called them.
+ */
+typedef struct {
+  BallisticsPhase phase;
+  unsigned long steps;       // integration steps
+  unsigned long iterations;  // successive approximation iterations and reference trajectories
+  unsigned long retard_calls[BALLISTICS_STATS_VELOCITY_BANDS];
+  unsigned long long nanoseconds;
+} BallisticsSolveStats;
+
+/**
+ * Everything the calling thread has done since it started or last called BallisticsStats_reset().
+ */
+typedef struct {
+  unsigned long steps;
+  unsigned long iterations;
+  unsigned long retard_calls[BALLISTICS_STATS_VELOCITY_BANDS];
+  unsigned long calls[BALLISTICS_PHASES];
+  unsigned long long nanoseconds[BALLISTICS_PHASES];
+  // latency[phase][b] counts calls that took between 2^(b-1) and 2^b nanoseconds.
+  unsigned long latency[BALLISTICS_PHASES][BALLISTICS_STATS_LATENCY_BUCKETS];
+} BallisticsThreadStats;
+
+/**
+ * Receives a marker at the start and end of every solve, such as for forwarding to __itt_task_begin() or to a
+ * perf user-space probe.  Called on the solving thread.
+ */
+typedef void (*BallisticsStatsHook)(void* context, BallisticsPhase phase, int begin);
+
+/**
+ * Copies the stats of the calling thread's most recent top-level solve.
+ */
+void BallisticsStats_last(BallisticsSolveStats* stats);
+
+/**
+ * Copies the calling thread's running totals.
+ */
+void BallisticsStats_thread(BallisticsThreadStats* stats);
+
+/**
+ * Zeroes the calling thread's running totals.
+ */
+void BallisticsStats_reset(void);
+
+/**
+ * Installs a marker hook for every thread, or removes it with NULL.  Install it before solving starts.
+ */
+void BallisticsStats_set_hook(BallisticsStatsHook hook, void* context);
+
+/**
+ * The name of a phase, for reports and markers.
+ */
+const char* BallisticsStats_phase_name(BallisticsPhase phase);
+
+#ifdef BALLISTICS_STATS
+
+// Instrumentation points used inside the solvers.
+void BallisticsStats_begin(BallisticsPhase phase);
+void BallisticsStats_end(BallisticsPhase phase);
+
+typedef struct {
+  BallisticsSolveStats current;
+  BallisticsSolveStats last;
+  BallisticsThreadStats totals;
+  int depth;
+  unsigned long long started[8];
+} BallisticsStatsState;
+
+extern __thread BallisticsStatsState ballistics_stats_state;
+
+#define BALLISTICS_STATS_BEGIN(phase) BallisticsStats_begin(phase)
+#define BALLISTICS_STATS_END(phase) BallisticsStats_end(phase)
+#define BALLISTICS_STATS_STEP() (ballistics_stats_state.current.steps++)
+#define BALLISTICS_STATS_ITERATION() (ballistics_stats_state.current.iterations++)
+#define BALLISTICS_STATS_RETARD(vp) do { \
+    int band_ = (int)((vp)/BALLISTICS_STATS_VELOCITY_BAND_WIDTH); \
+    if (band_ < 0) band_ = 0; \
+    if (band_ >= BALLISTICS_STATS_VELOCITY_BANDS) band_ = BALLISTICS_STATS_VELOCITY_BANDS - 1; \
+    ballistics_stats_state.current.retard_calls[band_]++; \
+  } while (0)
+
+#else
+
+#define BALLISTICS_STATS_BEGIN(phase) ((void)0)
+#define BALLISTICS_STATS_END(phase) ((void)0)
+#define BALLISTICS_STATS_STEP() ((void)0)
+#define BALLISTICS_STATS_ITERATION() ((void)0)
+#define BALLISTICS_STATS_RETARD(vp) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
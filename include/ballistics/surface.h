@@ -0,0 +1,159 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SURFACE_E_NO_MEMORY    -1
+#define SURFACE_E_ARGUMENTS    -2
+#define SURFACE_E_IO           -3
+#define SURFACE_E_FORMAT       -4
+#define SURFACE_E_OUT_OF_RANGE -5
+
+// The most points along one axis.
+#define SURFACE_MAX_POINTS 4096
+
+// How BallisticsSurface_query() answered.
+#define SURFACE_INTERPOLATED 1 // from the grid
+#define SURFACE_SOLVED       2 // by the solver, for a query outside the grid or in a cell estimated past tolerance
+
+/**
+ * A precomputed response surface: the solver's answers over a grid of shots and ranges, for answering queries
+ * inside the grid with no solving at all.
+ *
+ * The grid spans the ballistic coefficient, muzzle velocity, zero range, shooting angle and target range.  The air
+ * density only ever enters the solver through the ballistic coefficient, which it divides, so a query's density
+ * ratio is folded into its coefficient and the grid needs no axis of its own for it.  Every shot is zeroed by
+ * zero_angle() in the same air, on the level, and then fired at the shooting angle, with no wind; windage comes
+ * from the lag, the time of flight less the time in a vacuum, which crosswind drift is proportional to.  A
+ * headwind, which the solver counts as a change in airspeed, is outside what the grid covers, so queries take only
+ * a crosswind.
+ *
+ * A query inside the grid interpolates multilinearly between the 32 grid points around it, in about a tenth of a
+ * microsecond.  One outside it, or in a cell whose estimated error is more than BallisticsSurface_set_tolerance()
+ * allows, is solved in full, by zero_angle() and Ballistics_solve_targets().
+ *
+ * The builder samples every grid point with the solver, and then estimates the interpolation's error cell by cell.
+ * It solves halfway along an edge of each cell in every axis, where the error from that axis's curvature is largest,
+ * and at the cell's centre, and records the sum of the edges' errors, or the centre's if that is larger, as the
+ * estimated error of each output.  The estimate is not a bound: it samples only the edges out of each cell's first
+ * corner, and multilinear interpolation misses the cross terms of a surface, such as the square of one axis times
+ * another, as well as its squares, so the error elsewhere in a cell can be larger.  It is only as good as the grid
+ * is fine, and a cell that straddles the transonic kinks of the drag functions can hide a much larger error.
+ *
+ * The surface is one block, written to a file as it is and mapped back in read-only, in the host's byte order:
+ *   char magic[8] = "BLSTSRF1", uint32 byte-order mark 0x01020304, uint32 drag function, uint64 size in bytes,
+ *   double sight height, double minimum and then maximum of each axis, uint32 count of each axis, uint32 zero,
+ *   double estimated error of each output, then the values: each grid point's outputs in turn, with the range varying
+ *   fastest and the ballistic coefficient slowest, then each cell of the shot axes' estimated error in each output,
+ *   in the same order.
+ */
+typedef struct BallisticsSurface BallisticsSurface;
+
+typedef enum {
+  SURFACE_DRAG_COEFFICIENT, // at the air density the surface is queried with
+  SURFACE_VELOCITY,         // muzzle velocity, in ft/s
+  SURFACE_ZERO_RANGE,       // in yards
+  SURFACE_ANGLE,            // shooting angle, in degrees
+  SURFACE_RANGE,            // target range, in yards
+  SURFACE_AXES
+} BallisticsSurfaceAxisName;
+
+typedef enum {
+  SURFACE_PATH,     // path_inches
+  SURFACE_SECONDS,  // seconds
+  SURFACE_LAG,      // seconds of lag, which windage_inches is the crosswind's drift over
+  SURFACE_V,        // v_fps
+  SURFACE_OUTPUTS
+} BallisticsSurfaceOutput;
+
+typedef struct {
+  double min;
+  double max;
+  int count;        // evenly spaced points from min to max, from 2 to SURFACE_MAX_POINTS
+} BallisticsSurfaceAxis;
+
+typedef struct {
+  DragFunction drag_function;
+  double sight_height;
+  BallisticsSurfaceAxis axes[SURFACE_AXES];
+} BallisticsSurfaceConfig;
+
+/**
+ * Builds a surface by solving every shot in the grid, spread over threads, and estimates its error.
+ * @param surface Receives the surface.
+ * @param threads The number of threads, or 0 to use every online CPU.
+ * @return 0, SURFACE_E_NO_MEMORY, SURFACE_E_ARGUMENTS, or SURFACE_E_OUT_OF_RANGE if a shot in the grid doesn't
+ *         reach the furthest range
+ */
+int BallisticsSurface_build(BallisticsSurface** surface, const BallisticsSurfaceConfig* config, int threads);
+
+/**
+ * Writes a surface to a file, for BallisticsSurface_map() to read.
+ * @return 0 or SURFACE_E_IO
+ */
+int BallisticsSurface_write(const BallisticsSurface* surface, FILE* file);
+
+/**
+ * Maps a written surface into memory, read-only, so every process that maps it shares the one copy.
+ * @return 0, SURFACE_E_NO_MEMORY, SURFACE_E_IO, or SURFACE_E_FORMAT if the file isn't a whole surface written on
+ *         a machine of the same byte order
+ */
+int BallisticsSurface_map(BallisticsSurface** surface, const char* path);
+
+// Frees a built surface or unmaps a mapped one.
+void BallisticsSurface_free(BallisticsSurface* surface);
+
+// Returns the surface's configuration, and the builder's estimate of the interpolation's error in each output, in its
+// units; the estimate is not a bound.
+void BallisticsSurface_get_config(const BallisticsSurface* surface, BallisticsSurfaceConfig* config);
+double BallisticsSurface_get_estimated_error(const BallisticsSurface* surface, BallisticsSurfaceOutput output);
+
+/**
+ * Sets the largest estimated error in an output that a query is answered from the grid with.  A query in a cell
+ * whose estimate is larger, in any output, is solved instead, as one outside the grid is.  Every tolerance starts
+ * out infinite.  The estimate covers a cell of the shot axes at every range, and is not a bound.
+ * @param tolerance In the output's units; for SURFACE_LAG, seconds.
+ */
+void BallisticsSurface_set_tolerance(BallisticsSurface* surface, BallisticsSurfaceOutput output, double tolerance);
+
+/**
+ * Answers one target, from the grid if the shot lies inside it in a cell within tolerance, and by solving it
+ * otherwise.
+ * @param target           The target; only range_yards is read, and every other field is written, as in
+ *                         Ballistics_solve_targets().
+ * @param drag_coefficient The ballistic coefficient at standard density.
+ * @param density_ratio    The air density as a fraction of standard: drag_coefficient divided by what
+ *                         atmosphere_correction() makes of it.
+ * @param crosswind        The crosswind, in mi/hr, as crosswind() resolves it from a wind speed and angle.
+ * @return SURFACE_INTERPOLATED, SURFACE_SOLVED, SURFACE_E_ARGUMENTS, or SURFACE_E_OUT_OF_RANGE if the shot was
+ *         solved and the projectile doesn't reach the target
+ */
+int BallisticsSurface_query(const BallisticsSurface* surface, BallisticsTarget* target, double drag_coefficient,
+                            double vi, double zero_range, double density_ratio, double shooting_angle,
+                            double crosswind);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
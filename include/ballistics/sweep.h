@@ -0,0 +1,131 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SWEEP_E_NO_MEMORY -1
+#define SWEEP_E_ARGUMENTS -2
+#define SWEEP_E_CANCELLED -3
+
+/**
+ * Load development sweeps: every combination of ballistic coefficient, muzzle velocity, rifling twist, bullet length
+ * and atmosphere, compared at a set of ranges, in parallel.
+ *
+ * Twist and bullet length never enter the integration.  They only set the gyroscopic stability, calculateGS(), and
+ * through it the spin drift and the vertical deflection a crosswind gives a spinning bullet, which
+ * Ballistics_solve_modified_vertDeflect() works out from the solved trajectory as it is read.  So the sweep solves
+ * one trajectory per coefficient, velocity and atmosphere, and reads every twist and length off it.  The zero is
+ * taken once per coefficient and velocity, in the zero atmosphere, and held for every atmosphere the load is then
+ * fired in, as a rifle zeroed at home and taken elsewhere would be.  The stability factor is the product of a
+ * constant for the bullet and twist, a velocity correction and a temperature correction; the sweep works each of
+ * those out once, for the twist and length, the target and the atmosphere respectively, rather than once per cell.
+ */
+
+/**
+ * The air for one point of the atmosphere axis, as for atmosphere_correction().
+ */
+typedef struct {
+  double altitude;          // feet
+  double barometer;         // in Hg
+  double temperature;       // degrees F
+  double relative_humidity; // fraction, 0 to 1
+} BallisticsSweepAtmosphere;
+
+/**
+ * The axes of a sweep and everything held fixed across them.
+ */
+typedef struct {
+  // the load
+  DragFunction drag_function;
+  double form_factor;   // divides every drag coefficient, as in Ballistics_solve_modified_vertDeflect(); 0 for 1
+  double sight_height;  // inches
+  double bullet_grains;
+  double caliber;       // inches
+  // the zero, as for zero_angle(), taken in zero_atmosphere
+  double zero_range;    // yards
+  double y_intercept;   // inches
+  BallisticsSweepAtmosphere zero_atmosphere;
+  // the shot, as for Ballistics_solve()
+  double shooting_angle;
+  double wind_speed;
+  double wind_angle;
+
+  // the axes, each a list of values
+  const double* drag_coefficients;                // at standard atmosphere
+  int drag_coefficient_count;
+  const double* velocities;                       // muzzle velocities, ft/s
+  int velocity_count;
+  const double* twists;                           // inches per turn
+  int twist_count;
+  const double* lengths;                          // bullet lengths, inches
+  int length_count;
+  const BallisticsSweepAtmosphere* atmospheres;
+  int atmosphere_count;
+  const double* ranges;                           // yards
+  int range_count;
+
+  /**
+   * Called, if set, each time another trajectory is finished, with the number finished so far and the total, from
+   * whichever worker finished it but never by two at once.  Returning nonzero cancels the sweep: trajectories
+   * already under way finish, no more are started, and Ballistics_sweep() returns SWEEP_E_CANCELLED.
+   */
+  int (*progress)(void* context, int done, int total);
+  void* progress_context;
+} BallisticsSweep;
+
+/**
+ * One cell of a sweep's results, the same values a Ballistics_solve_modified_vertDeflect() solution gives for its
+ * row, but read at the exact range, as Ballistics_solve_targets() reads them.
+ */
+typedef struct {
+  double path_inches;       // with the crosswind's vertical deflection, as Ballistics_get_path()
+  double moa_correction;    // likewise, as Ballistics_get_moa()
+  double seconds;           // time of flight
+  double windage_inches;    // crosswind drift
+  double spin_drift_inches; // as Ballistics_get_spindrift()
+  double v_fps;             // velocity
+  double stability;         // gyroscopic stability factor at the target, calculateGS()
+} BallisticsSweepCell;
+
+// The number of cells a sweep fills, and where one combination's cell sits among them: the range varies fastest,
+// then the atmosphere, the length, the twist and the velocity, and the drag coefficient slowest.
+size_t BallisticsSweep_size(const BallisticsSweep* sweep);
+size_t BallisticsSweep_index(const BallisticsSweep* sweep, int drag_coefficient, int velocity, int twist, int length,
+                             int atmosphere, int range);
+
+/**
+ * Runs a sweep.
+ * @param cells       Receives BallisticsSweep_size() cells.  Ranges the bullet doesn't reach, and the cells of
+ *                    trajectories a cancelled sweep never solved, are zeroed.
+ * @param zero_angles Receives the bore angle, in degrees, of each drag coefficient and velocity, velocity varying
+ *                    fastest, or NULL.
+ * @param threads     The number of threads, or 0 to use every online CPU.
+ * @return the number of cells reached, SWEEP_E_CANCELLED, SWEEP_E_NO_MEMORY, or SWEEP_E_ARGUMENTS if any axis
+ *         is empty or any coefficient, velocity, twist, length or the caliber isn't positive
+ */
+long Ballistics_sweep(const BallisticsSweep* sweep, BallisticsSweepCell* cells, double* zero_angles, int threads);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,276 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ballistics.h"
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * A C++ layer over the C API.  Trajectories own their solution and free it when they go out of scope, and can be
+ * solved into over and over without allocating.  Columns are read through Span views, so reading a whole table
+ * costs one call per column rather than one call per yard.
+ */
+namespace ballistics {
+
+/**
+ * A view of contiguous values, after std::span.
+ */
+template <typename T>
+class Span {
+ public:
+  Span() : data_(nullptr), size_(0) {}
+  Span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+  T* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T& operator[](std::size_t i) const { return data_[i]; }
+  T* begin() const { return data_; }
+  T* end() const { return data_ + size_; }
+
+  // Up to count values starting at offset, clamped to the end of the view.
+  Span subspan(std::size_t offset, std::size_t count) const {
+    if (offset > size_) offset = size_;
+    if (count > size_ - offset) count = size_ - offset;
+    return Span(data_ + offset, count);
+  }
+
+ private:
+  T* data_;
+  std::size_t size_;
+};
+
+class TrajectoryPool;
+
+namespace detail {
+
+// A solution plus the buffers its derived columns are converted into.
+struct TrajectoryStorage {
+  TrajectoryStorage() : ballistics(Ballistics_alloc()) {
+    if (!ballistics) throw std::bad_alloc();
+  }
+  ~TrajectoryStorage() { Ballistics_free(ballistics); }
+  TrajectoryStorage(const TrajectoryStorage&) = delete;
+  TrajectoryStorage& operator=(const TrajectoryStorage&) = delete;
+
+  Ballistics* ballistics;
+  std::vector<double> columns[BALLISTICS_VY + 1];
+};
+
+} // namespace detail
+
+/**
+ * A solved trajectory.  Trajectories are move-only: each one owns its storage, and returns it to its pool (or frees
+ * it) when destroyed.  Solving again overwrites the previous solution in place.
+ *
+ * Spans returned by a trajectory stay valid until it is solved again, moved from or destroyed.  A moved-from
+ * trajectory has no storage: solving or extending it returns BALLISTICS_E_NO_MEMORY, and its columns are empty.
+ */
+class Trajectory {
+ public:
+  // A trajectory with storage of its own.  Throws std::bad_alloc if there is none.
+  Trajectory() : storage_(new detail::TrajectoryStorage()), pool_(nullptr), size_(0), converted_(0) {}
+
+  Trajectory(Trajectory&& other) noexcept
+      : storage_(other.storage_), pool_(other.pool_), size_(other.size_), converted_(other.converted_) {
+    other.storage_ = nullptr;
+    other.size_ = 0;
+  }
+
+  Trajectory& operator=(Trajectory&& other) noexcept {
+    if (this != &other) {
+      release();
+      storage_ = other.storage_;
+      pool_ = other.pool_;
+      size_ = other.size_;
+      converted_ = other.converted_;
+      other.storage_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  Trajectory(const Trajectory&) = delete;
+  Trajectory& operator=(const Trajectory&) = delete;
+
+  ~Trajectory() { release(); }
+
+  // Solves with Ballistics_solve_into(); returns the number of yards solved.
+  int solve(DragFunction drag_function, double drag_coefficient, double vi, double sight_height,
+            double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
+    if (!storage_) return solved(BALLISTICS_E_NO_MEMORY);
+    return solved(Ballistics_solve_into(storage_->ballistics, drag_function, drag_coefficient, vi, sight_height,
+                                        shooting_angle, zero_angle, wind_speed, wind_angle));
+  }
+
+  // Solves with Ballistics_solve_table_into(); returns the number of yards solved.
+  int solve(const DragTable& table, double drag_coefficient, double vi, double sight_height,
+            double shooting_angle, double zero_angle, double wind_speed, double wind_angle) {
+    if (!storage_) return solved(BALLISTICS_E_NO_MEMORY);
+    return solved(Ballistics_solve_table_into(storage_->ballistics, &table, drag_coefficient, vi, sight_height,
+                                              shooting_angle, zero_angle, wind_speed, wind_angle));
+  }
+
+  // Solves with Ballistics_solve_modified_vertDeflect_into(), whose parameters these are, in the same order;
+  // returns the number of yards solved.
+  int solve_spin(DragFunction drag_function, double drag_coefficient, double vi, double sight_height,
+                 double shooting_angle, double zero_angle, double wind_speed, double wind_angle,
+                 double caliber_inches, double bullet_length_inches, double temp, double inHg,
+                 double twist_denominator, double velocity, double bullet_grains, double form_factor) {
+    if (!storage_) return solved(BALLISTICS_E_NO_MEMORY);
+    return solved(Ballistics_solve_modified_vertDeflect_into(
+        storage_->ballistics, drag_function, drag_coefficient, vi, sight_height, shooting_angle, zero_angle,
+        wind_speed, wind_angle, caliber_inches, bullet_length_inches, temp, inHg, twist_denominator, velocity,
+        bullet_grains, form_factor));
+  }
+
+  // Carries the solution on with Ballistics_extend(); returns the number of yards solved, or BALLISTICS_E_NO_MEMORY.
+  int extend(int yards) {
+    if (!storage_) return solved(BALLISTICS_E_NO_MEMORY);
+    int extended = Ballistics_extend(storage_->ballistics, yards);
+    return extended < 0 ? extended : solved(extended);
+  }
+
+  // The number of yards in the solution.
+  std::size_t size() const { return size_; }
+
+  /**
+   * One output for every yard of the solution.  Stored columns are viewed directly; derived ones are converted
+   * the first time they are asked for after each solve, into buffers the trajectory keeps between solves.
+   */
+  Span<const double> column(BallisticsField field) {
+    if (!storage_ || size_ == 0) return Span<const double>();
+    const double* stored = Ballistics_get_column(storage_->ballistics, field);
+    if (stored) return Span<const double>(stored, size_);
+
+    std::vector<double>& column = storage_->columns[field];
+    if (!(converted_ & (1u << field))) {
+      column.resize(size_);
+      Ballistics_get_rows(storage_->ballistics, field, 0, (int)size_, column.data());
+      converted_ |= 1u << field;
+    }
+    return Span<const double>(column.data(), size_);
+  }
+
+  Span<const double> range() { return column(BALLISTICS_RANGE); }
+  Span<const double> path() { return column(BALLISTICS_PATH); }
+  Span<const double> moa() { return column(BALLISTICS_MOA); }
+  Span<const double> time() { return column(BALLISTICS_TIME); }
+  Span<const double> windage() { return column(BALLISTICS_WINDAGE); }
+  Span<const double> windage_moa() { return column(BALLISTICS_WINDAGE_MOA); }
+  Span<const double> spindrift() { return column(BALLISTICS_SPINDRIFT); }
+  Span<const double> corrected_windage() { return column(BALLISTICS_CORRECTED_WINDAGE); }
+  Span<const double> corrected_windage_moa() { return column(BALLISTICS_CORRECTED_WINDAGE_MOA); }
+  Span<const double> v_fps() { return column(BALLISTICS_V); }
+  Span<const double> vx_fps() { return column(BALLISTICS_VX); }
+  Span<const double> vy_fps() { return column(BALLISTICS_VY); }
+
+  // The underlying solution, for the C API.  Still owned by the trajectory.
+  Ballistics* get() const { return storage_ ? storage_->ballistics : nullptr; }
+
+ private:
+  friend class TrajectoryPool;
+
+  Trajectory(detail::TrajectoryStorage* storage, TrajectoryPool* pool)
+      : storage_(storage), pool_(pool), size_(0), converted_(0) {}
+
+  int solved(int yards) {
+    size_ = yards > 0 ? (std::size_t)yards : 0;
+    converted_ = 0;
+    return yards;
+  }
+
+  inline void release();
+
+  detail::TrajectoryStorage* storage_;
+  TrajectoryPool* pool_;
+  std::size_t size_;
+  unsigned converted_; // bit per BallisticsField whose derived column is up to date
+};
+
+/**
+ * Recycles trajectory storage, so code that solves short-lived trajectories in a loop allocates only until the pool
+ * has warmed up.  A pool may be shared between threads, and must outlive every trajectory acquired from it.
+ */
+class TrajectoryPool {
+ public:
+  TrajectoryPool() {}
+  TrajectoryPool(const TrajectoryPool&) = delete;
+  TrajectoryPool& operator=(const TrajectoryPool&) = delete;
+
+  ~TrajectoryPool() {
+    for (std::size_t i = 0; i < free_.size(); i++) delete free_[i];
+  }
+
+  // A trajectory backed by recycled storage, or new storage if none is free.  Throws std::bad_alloc.
+  Trajectory acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_.empty()) {
+        detail::TrajectoryStorage* storage = free_.back();
+        free_.pop_back();
+        return Trajectory(storage, this);
+      }
+    }
+    return Trajectory(new detail::TrajectoryStorage(), this);
+  }
+
+  // Allocates storage up front so the next count acquisitions don't have to.
+  void reserve(std::size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.reserve(count);
+    while (free_.size() < count) free_.push_back(new detail::TrajectoryStorage());
+  }
+
+  // The number of trajectories that can be acquired without allocating.
+  std::size_t available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+  }
+
+ private:
+  friend class Trajectory;
+
+  void release(detail::TrajectoryStorage* storage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    try {
+      free_.push_back(storage);
+    } catch (const std::bad_alloc&) {
+      delete storage;
+    }
+  }
+
+  std::mutex mutex_;
+  std::vector<detail::TrajectoryStorage*> free_;
+};
+
+inline void Trajectory::release() {
+  if (!storage_) return;
+  if (pool_) {
+    pool_->release(storage_);
+  } else {
+    delete storage_;
+  }
+  storage_ = nullptr;
+  size_ = 0;
+}
+
+} // namespace ballistics
@@ -0,0 +1,68 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "drag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Which parameters Truing_solve() is allowed to adjust.  Combine with |.
+#define TRUING_FIT_DRAG_COEFFICIENT 1
+#define TRUING_FIT_VELOCITY         2
+
+#define TRUING_E_NO_OBSERVATIONS -1
+#define TRUING_E_OUT_OF_RANGE    -2
+#define TRUING_E_NO_MEMORY       -3
+#define TRUING_E_NO_CONVERGENCE  -4
+
+/**
+ * An observed point of impact, measured relative to the point of aim.
+ */
+typedef struct {
+  double range_yards; // The range of the target, in yards.
+  double path_inches; // The observed impact, in inches, relative to the line of sight.  Below the aim is negative.
+} TruingObservation;
+
+/**
+ * Trues a load by fitting its drag coefficient and/or muzzle velocity to observed impacts, using
+ * Levenberg-Marquardt.  The rifle is assumed to be zeroed at zero_range for whatever parameters are being tried,
+ * so every evaluation re-zeroes with zero_angles() and then reads all observations off one trajectory with
+ * Ballistics_solve_targets(), which stops at the farthest observation.  All working storage is allocated once
+ * up front and reused between iterations.
+ * @param drag_coefficient In: the starting drag coefficient.  Out: the trued drag coefficient.
+ * @param vi               In: the starting muzzle velocity, in ft/s.  Out: the trued muzzle velocity.
+ * @param rms_inches       If not NULL, receives the root-mean-square miss of the fitted model, in inches.
+ * @param fit              TRUING_FIT_DRAG_COEFFICIENT, TRUING_FIT_VELOCITY, or both.
+ * @param observations     The observed impacts, in any order.
+ * @param count            The number of observations.
+ * @param drag_function    G1, G2, G3, G5, G6, G7, or G8
+ * @param sight_height     The height of the sighting system above the bore centerline, in inches.
+ * @param shooting_angle   The uphill or downhill shooting angle the observations were made at, in degrees.
+ * @param zero_range       The range the rifle is zeroed at, in yards.
+ * @param y_intercept      The height, in inches, of the zero at zero_range.  Usually 0.
+ * @return the number of iterations taken, or one of the TRUING_E_* errors.  drag_coefficient and vi are left
+ *         untouched on error.
+ */
+int Truing_solve(double* drag_coefficient, double* vi, double* rms_inches, int fit,
+                 const TruingObservation* observations, int count, DragFunction drag_function, double sight_height,
+                 double shooting_angle, double zero_range, double y_intercept);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
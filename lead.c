@@ -0,0 +1,226 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/lead.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Fixed-point iterations for the meeting point.  Each one shrinks the error by the ratio of the target's speed to
+// the bullet's, so even a fast target approaching a subsonic bullet is converged well below a thousandth of a yard.
+#define LEAD_MEET_ITERATIONS 6
+
+// Ranges a grid works through at a time, keeping their meeting points and times of flight on the stack.
+#define LEAD_GRID_CHUNK 256
+
+#define MPH_TO_YARDS_PER_SECOND (1760.0/3600)
+#define MPH_TO_INCHES_PER_SECOND 17.60
+
+struct LeadTimeline {
+  int yards;             // seconds_at_yard has yards+1 entries, for 0 through yards
+  double* seconds_at_yard;
+  double time_step;      // yards_at_time[k] is the range at k*time_step
+  double* yards_at_time; // yards+1 entries too
+};
+
+int LeadTimeline_build(LeadTimeline** timeline, Ballistics* solution) {
+  int rows = Ballistics_get_max_yardage(solution);
+  double* x;
+  double* t;
+  double* v;
+  LeadTimeline* view;
+  int i, j;
+
+  *timeline = NULL;
+  if (rows < 2) return LEAD_E_ARGUMENTS;
+
+  x = malloc(sizeof(double) * rows);
+  t = malloc(sizeof(double) * rows);
+  v = malloc(sizeof(double) * rows);
+  view = calloc(1, sizeof(LeadTimeline));
+  if (!x || !t || !v || !view) goto no_memory;
+  Ballistics_get_rows(solution, BALLISTICS_RANGE, 0, rows, x);
+  Ballistics_get_rows(solution, BALLISTICS_TIME, 0, rows, t);
+  Ballistics_get_rows(solution, BALLISTICS_V, 0, rows, v);
+
+  // A row records the position at the start of its integration step but the time at the end of it; take the
+  // step back off, so each time goes with its range.  The first row is then the muzzle, at (0, 0).
+  for (i = 0; i < rows; i++) t[i] -= 0.5 / v[i];
+
+  view->yards = (int)x[rows - 1];
+  view->seconds_at_yard = malloc(sizeof(double) * (view->yards + 1));
+  view->yards_at_time = malloc(sizeof(double) * (view->yards + 1));
+  if (!view->seconds_at_yard || !view->yards_at_time) goto no_memory;
+
+  // Rows are recorded at the first step past each yard; interpolate back to the whole yard.
+  for (i = 0, j = 0; i <= view->yards; i++) {
+    while (x[j + 1] < i) j++;
+    view->seconds_at_yard[i] = t[j] + (i - x[j]) / (x[j + 1] - x[j]) * (t[j + 1] - t[j]);
+  }
+
+  // And invert that into a range at each of as many evenly spaced times.
+  view->time_step = view->seconds_at_yard[view->yards] / view->yards;
+  for (i = 0, j = 0; i <= view->yards; i++) {
+    double seconds = i * view->time_step;
+    while (j < view->yards - 1 && view->seconds_at_yard[j + 1] < seconds) j++;
+    view->yards_at_time[i] = j + (seconds - view->seconds_at_yard[j]) /
+                                 (view->seconds_at_yard[j + 1] - view->seconds_at_yard[j]);
+  }
+  view->yards_at_time[view->yards] = view->yards;
+
+  free(x);
+  free(t);
+  free(v);
+  *timeline = view;
+  return 0;
+
+no_memory:
+  free(x);
+  free(t);
+  free(v);
+  LeadTimeline_free(view);
+  return LEAD_E_NO_MEMORY;
+}
+
+void LeadTimeline_free(LeadTimeline* timeline) {
+  if (timeline) {
+    free(timeline->seconds_at_yard);
+    free(timeline->yards_at_time);
+    free(timeline);
+  }
+}
+
+double LeadTimeline_get_max_range(const LeadTimeline* timeline) {
+  return timeline->yards;
+}
+
+double LeadTimeline_get_max_time(const LeadTimeline* timeline) {
+  return timeline->seconds_at_yard[timeline->yards];
+}
+
+// Linear interpolation in a table of yards+1 evenly spaced samples, at position p clamped to the table.
+static inline double LeadTimeline_lookup(const double* table, int yards, double p) {
+  int i;
+  p = p > 0 ? p : 0;
+  p = p < yards ? p : yards;
+  i = (int)p;
+  i = i < yards ? i : yards - 1;
+  return table[i] + (p - i) * (table[i + 1] - table[i]);
+}
+
+double LeadTimeline_time_at(const LeadTimeline* timeline, double range_yards) {
+  if (range_yards < 0 || range_yards > timeline->yards) return -1;
+  return LeadTimeline_lookup(timeline->seconds_at_yard, timeline->yards, range_yards);
+}
+
+double LeadTimeline_range_at(const LeadTimeline* timeline, double seconds) {
+  if (seconds < 0 || seconds > LeadTimeline_get_max_time(timeline)) return -1;
+  return LeadTimeline_lookup(timeline->yards_at_time, timeline->yards, seconds / timeline->time_step);
+}
+
+/**
+ * Finds where the bullet meets a target that starts at range_yards and recedes at radial yards/s: the fixed point of
+ * meet = range_yards + radial * time_at(meet).
+ * @param meet Receives the meeting range, which may fall outside the timeline.
+ * @return the time of flight to the meeting range, clamped to the timeline
+ */
+static inline double Lead_meet(const LeadTimeline* timeline, double range_yards, double radial, double* meet) {
+  double seconds = LeadTimeline_lookup(timeline->seconds_at_yard, timeline->yards, range_yards);
+  double r = range_yards;
+  int k;
+  for (k = 0; k < LEAD_MEET_ITERATIONS; k++) {
+    r = range_yards + radial * seconds;
+    seconds = LeadTimeline_lookup(timeline->seconds_at_yard, timeline->yards, r);
+  }
+  *meet = r;
+  return seconds;
+}
+
+// The angle a lateral lead in inches subtends at range_yards, in radians.
+static inline double Lead_angle(double inches, double range_yards) {
+  return atan((inches / 12) / fmax(range_yards * 3, 1e-9));
+}
+
+int Lead_solve(const LeadTimeline* timeline, double range_yards, double speed, double heading, Lead* lead) {
+  double radial = speed * cos(deg_to_rad(heading)) * MPH_TO_YARDS_PER_SECOND;
+  double lateral = speed * sin(deg_to_rad(heading)) * MPH_TO_INCHES_PER_SECOND;
+  double meet;
+  double seconds = Lead_meet(timeline, range_yards, radial, &meet);
+  double angle;
+
+  lead->range_yards = lead->seconds = lead->inches = lead->moa = lead->mil = 0;
+  if (range_yards < 0 || !(meet >= 0 && meet <= timeline->yards)) return LEAD_E_OUT_OF_RANGE;
+
+  lead->range_yards = meet;
+  lead->seconds = seconds;
+  lead->inches = lateral * seconds;
+  angle = Lead_angle(lead->inches, meet);
+  lead->moa = rad_to_moa(angle);
+  lead->mil = angle * 1000;
+  return 0;
+}
+
+int Lead_grid(const LeadTimeline* timeline, const double* ranges, int range_count, const double* speeds,
+              int speed_count, const double* headings, int heading_count, LeadUnit unit, double* out) {
+  double meets[LEAD_GRID_CHUNK];
+  double seconds[LEAD_GRID_CHUNK];
+  int reached = 0;
+  int s, h, first, k, r;
+
+  if (range_count < 0 || speed_count < 0 || heading_count < 0 || unit < LEAD_INCHES || unit > LEAD_MIL) {
+    return LEAD_E_ARGUMENTS;
+  }
+
+  for (s = 0; s < speed_count; s++) {
+    for (h = 0; h < heading_count; h++) {
+      double radial = speeds[s] * cos(deg_to_rad(headings[h])) * MPH_TO_YARDS_PER_SECOND;
+      double lateral = speeds[s] * sin(deg_to_rad(headings[h])) * MPH_TO_INCHES_PER_SECOND;
+      double* row = &out[((size_t)s * heading_count + h) * range_count];
+
+      for (first = 0; first < range_count; first += LEAD_GRID_CHUNK) {
+        int count = range_count - first < LEAD_GRID_CHUNK ? range_count - first : LEAD_GRID_CHUNK;
+        const double* chunk_ranges = ranges + first;
+        double* chunk = row + first;
+
+        // Lead_meet(), turned inside out: each fixed-point iteration is a straight, branch-free pass over the
+        // chunk, which the compiler vectorizes.
+        for (r = 0; r < count; r++) {
+          meets[r] = chunk_ranges[r];
+          seconds[r] = LeadTimeline_lookup(timeline->seconds_at_yard, timeline->yards, chunk_ranges[r]);
+        }
+        for (k = 0; k < LEAD_MEET_ITERATIONS; k++) {
+          for (r = 0; r < count; r++) {
+            meets[r] = chunk_ranges[r] + radial * seconds[r];
+            seconds[r] = LeadTimeline_lookup(timeline->seconds_at_yard, timeline->yards, meets[r]);
+          }
+        }
+        for (r = 0; r < count; r++) {
+          int inside = (chunk_ranges[r] >= 0) & (meets[r] >= 0) & (meets[r] <= timeline->yards);
+          chunk[r] = inside ? lateral * seconds[r] : 0;
+          reached += inside;
+        }
+        if (unit == LEAD_INCHES) continue;
+
+        // And the conversion to an angle, in a pass of its own.
+        for (r = 0; r < count; r++) {
+          double angle = Lead_angle(chunk[r], meets[r]);
+          chunk[r] = unit == LEAD_MOA ? rad_to_moa(angle) : angle * 1000;
+        }
+      }
+    }
+  }
+  return reached;
+}
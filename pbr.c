@@ -15,6 +15,9 @@
  */
 
 #include "ballistics/ballistics.h"
+#ifndef BALLISTICS_EMBEDDED
+#include "ballistics/batch.h"
+#endif
 
 #include <stdlib.h>
 #include <math.h>
@@ -53,9 +56,33 @@ int PBR_get_sight_in_at_100yards(struct PBR* pbr) {
   return pbr->sight_in_at_100yards;
 }
 
+#ifdef BALLISTICS_EMBEDDED
+static struct PBR pbr_pool[BALLISTICS_EMBEDDED_PBRS];
+static int pbr_pool_used[BALLISTICS_EMBEDDED_PBRS];
+
+static struct PBR* PBR_alloc() {
+  int i;
+  for (i = 0; i < BALLISTICS_EMBEDDED_PBRS; i++) {
+    if (!pbr_pool_used[i]) {
+      pbr_pool_used[i] = 1;
+      return &pbr_pool[i];
+    }
+  }
+  return NULL;
+}
+
+void PBR_free(struct PBR* pbr) {
+  pbr_pool_used[pbr - pbr_pool] = 0;
+}
+#else
+static struct PBR* PBR_alloc() {
+  return malloc(sizeof(struct PBR));
+}
+
 void PBR_free(struct PBR* pbr) {
   free(pbr);
 }
+#endif
 
 int PBR_solve(struct PBR** pbr, DragFunction drag_function, double drag_coefficient, double vi,
               double sight_height, double vital_size) {
@@ -92,7 +119,9 @@ int PBR_solve(struct PBR** pbr, DragFunction drag_function, double drag_coeffici
 
   int status = 0;
 
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_PBR);
   while (quit==0){
+    BALLISTICS_STATS_ITERATION();
 
     Gy=GRAVITY*cos(deg_to_rad((ShootingAngle + ZAngle)));
     Gx=GRAVITY*sin(deg_to_rad((ShootingAngle + ZAngle)));
@@ -120,8 +149,9 @@ int PBR_solve(struct PBR** pbr, DragFunction drag_function, double drag_coeffici
       status = 0;
 
       vx1=vx, vy1=vy;
-      v=pow(pow(vx,2)+pow(vy,2),0.5);
+      v=BALLISTICS_SPEED(vx,vy);
       dt=0.5/v;
+      BALLISTICS_STATS_STEP();
 
       // Compute acceleration using the drag function retardation
       dv = retard(drag_function,drag_coefficient,v);
@@ -196,11 +226,15 @@ int PBR_solve(struct PBR** pbr, DragFunction drag_function, double drag_coeffici
     if (fabs(Step)<(0.01/60)) quit=1;
   }
 
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_PBR);
   if (status) {
     return status;
   }
 
-  *pbr = malloc(sizeof(struct PBR));
+  *pbr = PBR_alloc();
+  if (!*pbr) {
+    return PBR_E_NO_MEMORY;
+  }
   (*pbr)->near_zero_yards = (int)(zero/3);
   (*pbr)->far_zero_yards = (int)(farzero/3);
   (*pbr)->min_PBR_yards = (int)(min_PBR_range/3);
@@ -208,4 +242,272 @@ int PBR_solve(struct PBR** pbr, DragFunction drag_function, double drag_coeffici
   (*pbr)->sight_in_at_100yards = tin100;
 
   return 0;
-}
\ No newline at end of file
+}
+
+// The height of the apex above the line of sight, in inches, for a bore angle.
+static int PBR_apex(double* apex_inches, DragFunction drag_function, double drag_coefficient, double vi,
+                    double sight_height, double angle, double step_feet) {
+  BallisticsEvent apex = {BallisticsEvent_apex, NULL, EVENTS_FALLING, 1};
+  BallisticsEventHit hit;
+  int found;
+
+  // Fired level or below, the projectile only ever falls: the apex is the muzzle.
+  if (angle <= 0) {
+    *apex_inches = -sight_height;
+    return 0;
+  }
+  found = Ballistics_find_events(&hit, 1, &apex, 1, drag_function, drag_coefficient, vi, sight_height, 0, angle,
+                                 0, 0, 0, step_feet);
+  if (found != 1) return found < 0 ? PBR_E_TOO_FAST_VY : PBR_E_OUT_OF_RANGE;
+  *apex_inches = hit.state.y*12;
+  return 0;
+}
+
+/**
+ * Finds the bore angle that puts the apex at half the vital size, by bracketing it and then closing in on it by
+ * regula falsi.
+ */
+static int PBR_refined_angle(double* angle, DragFunction drag_function, double drag_coefficient, double vi,
+                             double sight_height, double vital_size, double step_feet) {
+  double half = vital_size/2;
+  double lo = 0, hi = 0.1;
+  double f_lo, f_hi;
+  int side = 0;
+  int status;
+
+  f_lo = -sight_height - half;
+  for (;;) {
+    BALLISTICS_STATS_ITERATION();
+    status = PBR_apex(&f_hi, drag_function, drag_coefficient, vi, sight_height, hi, step_feet);
+    if (status) return status;
+    f_hi -= half;
+    if (f_hi >= 0) break;
+    lo = hi;
+    f_lo = f_hi;
+    hi *= 2;
+    if (hi > 45) return PBR_E_OUT_OF_RANGE;
+  }
+  while (hi - lo > 0.0001/60) {
+    double mid = (lo*f_hi - hi*f_lo) / (f_hi - f_lo);
+    double f;
+    BALLISTICS_STATS_ITERATION();
+    status = PBR_apex(&f, drag_function, drag_coefficient, vi, sight_height, mid, step_feet);
+    if (status) return status;
+    f -= half;
+    if (f == 0) {
+      lo = hi = mid;
+      break;
+    }
+    if (f > 0) {
+      hi = mid;
+      f_hi = f;
+      if (side < 0) f_lo /= 2;
+      side = -1;
+    }
+    else {
+      lo = mid;
+      f_lo = f;
+      if (side > 0) f_hi /= 2;
+      side = 1;
+    }
+  }
+  *angle = (lo + hi)/2;
+  return 0;
+}
+
+// Fires one trajectory at the bore angle and reads the zeros, the PBR bounds and the sight-in off it.
+static int PBR_refined_read(struct PBR* pbr, DragFunction drag_function, double drag_coefficient, double vi,
+                            double sight_height, double vital_size, double angle, double step_feet) {
+  double half = vital_size/2;
+  double below = -half;
+  double zero = 0;
+  double at_100 = 100;
+  BallisticsEvent events[5] = {
+    {BallisticsEvent_height, &zero, EVENTS_RISING, 0},    // near zero
+    {BallisticsEvent_height, &zero, EVENTS_FALLING, 0},   // far zero
+    {BallisticsEvent_height, &below, EVENTS_FALLING, 0},  // max PBR
+    {BallisticsEvent_range, &at_100, EVENTS_RISING, 0},   // sight-in
+    {BallisticsEvent_height, &below, EVENTS_RISING, 0}    // min PBR, unless the muzzle is already inside it
+  };
+  int event_count = sight_height > half ? 5 : 4;
+  BallisticsEventHit hits[5];
+  double near_zero = 0, far_zero = 0, min_PBR = 0, max_PBR = 0, y_100 = 0;
+  int found, i;
+
+  // Each event happens once on the way up and down, so the trajectory ends with the last of them.
+  found = Ballistics_find_events(hits, event_count, events, event_count, drag_function, drag_coefficient, vi,
+                                 sight_height, 0, angle, 0, 0, 0, step_feet);
+  if (found != event_count) return found < 0 ? PBR_E_TOO_FAST_VY : PBR_E_OUT_OF_RANGE;
+  for (i = 0; i < found; i++) {
+    switch (hits[i].event) {
+      case 0: near_zero = hits[i].state.x; break;
+      case 1: far_zero = hits[i].state.x; break;
+      case 2: max_PBR = hits[i].state.x; break;
+      case 3: y_100 = hits[i].state.y; break;
+      case 4: min_PBR = hits[i].state.x; break;
+    }
+  }
+
+  pbr->near_zero_yards = (int)(near_zero/3);
+  pbr->far_zero_yards = (int)(far_zero/3);
+  pbr->min_PBR_yards = (int)(min_PBR/3);
+  pbr->max_PBR_yards = (int)(max_PBR/3);
+  pbr->sight_in_at_100yards = (int)((float)100*(float)y_100*(float)12);
+  return 0;
+}
+
+int PBR_solve_refined(struct PBR** pbr, DragFunction drag_function, double drag_coefficient, double vi,
+                      double sight_height, double vital_size, double step_feet) {
+  struct PBR result;
+  double angle;
+  int status;
+
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_PBR);
+  status = PBR_refined_angle(&angle, drag_function, drag_coefficient, vi, sight_height, vital_size, step_feet);
+  if (!status) {
+    status = PBR_refined_read(&result, drag_function, drag_coefficient, vi, sight_height, vital_size, angle,
+                              step_feet);
+  }
+  if (!status) {
+    *pbr = PBR_alloc();
+    if (*pbr) **pbr = result;
+    else status = PBR_E_NO_MEMORY;
+  }
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_PBR);
+  return status;
+}
+
+#ifndef BALLISTICS_EMBEDDED
+/**
+ * A cell of a grid, keyed by the height of its apex above the bore line: half its vital size plus its sight height.
+ */
+typedef struct {
+  double apex;
+  int index;
+} PBRGridKey;
+
+static int PBRGridKey_compare(const void* a, const void* b) {
+  const PBRGridKey* ka = a;
+  const PBRGridKey* kb = b;
+  if (ka->apex != kb->apex) return ka->apex < kb->apex ? -1 : 1;
+  return ka->index - kb->index;
+}
+
+// The bore angle one apex height's search found.
+typedef struct {
+  double angle;
+  int status;           // 0, or the search's PBR_E_* error
+} PBRGridSolve;
+
+/**
+ * The work shared by every thread of a PBR_solve_grid() call.  Each cell's result is written only by the thread
+ * reading that cell, and each search's outcome only by the thread solving it.
+ */
+typedef struct {
+  PBRResult* results;
+  DragFunction drag_function;
+  double drag_coefficient;
+  double vi;
+  const double* vital_sizes;
+  const double* sight_heights;
+  int sight_count;
+  double step_feet;
+  const int* solving;   // the cells that solve a bore angle, one per apex height
+  const int* shared;    // for each cell, the index into solving and solves of the search it takes its angle from
+  PBRGridSolve* solves; // the outcome of each search
+} PBRGrid;
+
+static void PBRGrid_angle(void* context, int index) {
+  PBRGrid* grid = context;
+  int cell = grid->solving[index];
+  PBRGridSolve* solve = &grid->solves[index];
+
+  solve->angle = 0;
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_PBR);
+  solve->status = PBR_refined_angle(&solve->angle, grid->drag_function, grid->drag_coefficient, grid->vi,
+                                     grid->sight_heights[cell % grid->sight_count],
+                                     grid->vital_sizes[cell / grid->sight_count], grid->step_feet);
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_PBR);
+}
+
+static void PBRGrid_read(void* context, int cell) {
+  PBRGrid* grid = context;
+  PBRResult* result = &grid->results[cell];
+  const PBRGridSolve* solved = &grid->solves[grid->shared[cell]];
+  struct PBR pbr = {0};
+
+  result->status = solved->status;
+  result->angle = solved->status ? 0 : solved->angle;
+  if (!result->status) {
+    BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_PBR);
+    result->status = PBR_refined_read(&pbr, grid->drag_function, grid->drag_coefficient, grid->vi,
+                                      grid->sight_heights[cell % grid->sight_count],
+                                      grid->vital_sizes[cell / grid->sight_count], result->angle, grid->step_feet);
+    BALLISTICS_STATS_END(BALLISTICS_PHASE_PBR);
+  }
+  result->near_zero_yards = pbr.near_zero_yards;
+  result->far_zero_yards = pbr.far_zero_yards;
+  result->min_PBR_yards = pbr.min_PBR_yards;
+  result->max_PBR_yards = pbr.max_PBR_yards;
+  result->sight_in_at_100yards = pbr.sight_in_at_100yards;
+}
+
+int PBR_solve_grid(PBRResult* results, DragFunction drag_function, double drag_coefficient, double vi,
+                   const double* vital_sizes, int vital_count, const double* sight_heights, int sight_count,
+                   double step_feet, int threads) {
+  int cells = vital_count * sight_count;
+  PBRGridKey* keys;
+  int* solving;
+  int* shared;
+  PBRGridSolve* solves;
+  PBRGrid grid;
+  int count = 0;
+  int solved = 0;
+  int i;
+
+  if (vital_count <= 0 || sight_count <= 0 || vi <= 0) return PBR_E_ARGUMENTS;
+  keys = malloc(sizeof(PBRGridKey) * cells);
+  solving = malloc(sizeof(int) * cells);
+  shared = malloc(sizeof(int) * cells);
+  solves = malloc(sizeof(PBRGridSolve) * cells);
+  if (!keys || !solving || !shared || !solves) {
+    free(keys);
+    free(solving);
+    free(shared);
+    free(solves);
+    return PBR_E_NO_MEMORY;
+  }
+
+  // Cells with the same apex height above the bore share its bore angle; the first of them solves it.
+  for (i = 0; i < cells; i++) {
+    keys[i].apex = vital_sizes[i / sight_count]/2 + sight_heights[i % sight_count];
+    keys[i].index = i;
+  }
+  qsort(keys, cells, sizeof(PBRGridKey), PBRGridKey_compare);
+  for (i = 0; i < cells; i++) {
+    if (i == 0 || keys[i].apex != keys[i - 1].apex) solving[count++] = keys[i].index;
+    shared[keys[i].index] = count - 1;
+  }
+
+  grid.results = results;
+  grid.drag_function = drag_function;
+  grid.drag_coefficient = drag_coefficient;
+  grid.vi = vi;
+  grid.vital_sizes = vital_sizes;
+  grid.sight_heights = sight_heights;
+  grid.sight_count = sight_count;
+  grid.step_feet = step_feet;
+  grid.solving = solving;
+  grid.shared = shared;
+  grid.solves = solves;
+  Ballistics_parallel_for(count, threads, PBRGrid_angle, &grid);
+  Ballistics_parallel_for(cells, threads, PBRGrid_read, &grid);
+
+  for (i = 0; i < cells; i++) solved += results[i].status == 0;
+  free(keys);
+  free(solving);
+  free(shared);
+  free(solves);
+  return solved;
+}
+#endif
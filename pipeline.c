@@ -0,0 +1,205 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/pipeline.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPELINE_STAGES 4
+
+#define PIPELINE_BIT(value) (1u << (value))
+
+// The values each stage depends on, in stage order.  The card depends on the solution itself, so it reruns whenever
+// the solve does, and otherwise only when its ranges change.
+static const unsigned pipeline_dependencies[PIPELINE_STAGES] = {
+  PIPELINE_BIT(PIPELINE_DRAG_COEFFICIENT) | PIPELINE_BIT(PIPELINE_ALTITUDE) | PIPELINE_BIT(PIPELINE_BAROMETER) |
+    PIPELINE_BIT(PIPELINE_TEMPERATURE) | PIPELINE_BIT(PIPELINE_RELATIVE_HUMIDITY),
+  PIPELINE_BIT(PIPELINE_DRAG_FUNCTION) | PIPELINE_BIT(PIPELINE_CORRECTED_DRAG_COEFFICIENT) |
+    PIPELINE_BIT(PIPELINE_VELOCITY) | PIPELINE_BIT(PIPELINE_SIGHT_HEIGHT) | PIPELINE_BIT(PIPELINE_ZERO_RANGE) |
+    PIPELINE_BIT(PIPELINE_Y_INTERCEPT),
+  PIPELINE_BIT(PIPELINE_DRAG_FUNCTION) | PIPELINE_BIT(PIPELINE_CORRECTED_DRAG_COEFFICIENT) |
+    PIPELINE_BIT(PIPELINE_VELOCITY) | PIPELINE_BIT(PIPELINE_SIGHT_HEIGHT) | PIPELINE_BIT(PIPELINE_SHOOTING_ANGLE) |
+    PIPELINE_BIT(PIPELINE_ZERO_ANGLE) | PIPELINE_BIT(PIPELINE_WIND_SPEED) | PIPELINE_BIT(PIPELINE_WIND_ANGLE),
+  0
+};
+
+struct BallisticsPipeline {
+  double values[PIPELINE_VALUES];                // the inputs as set, and the stage outputs as last computed
+  double tolerances[PIPELINE_VALUES];
+  double used[PIPELINE_STAGES][PIPELINE_VALUES]; // the values each stage last ran with
+  int current;                                   // the PIPELINE_* bits of the stages that are up to date
+
+  Ballistics* solution;
+  double* ranges;
+  BallisticsTarget* card;
+  int card_count;
+};
+
+BallisticsPipeline* BallisticsPipeline_alloc(void) {
+  BallisticsPipeline* pipeline = calloc(1, sizeof(BallisticsPipeline));
+  if (!pipeline) return NULL;
+  pipeline->solution = Ballistics_alloc();
+  if (!pipeline->solution) {
+    free(pipeline);
+    return NULL;
+  }
+  // Standard conditions, as atmosphere_correction() defines them.
+  pipeline->values[PIPELINE_DRAG_FUNCTION] = G1;
+  pipeline->values[PIPELINE_BAROMETER] = 29.53;
+  pipeline->values[PIPELINE_TEMPERATURE] = 59;
+  pipeline->values[PIPELINE_RELATIVE_HUMIDITY] = 0.78;
+  return pipeline;
+}
+
+void BallisticsPipeline_free(BallisticsPipeline* pipeline) {
+  if (pipeline) {
+    Ballistics_free(pipeline->solution);
+    free(pipeline->ranges);
+    free(pipeline->card);
+    free(pipeline);
+  }
+}
+
+int BallisticsPipeline_set(BallisticsPipeline* pipeline, BallisticsPipelineValue value, double x) {
+  if (value < 0 || value >= PIPELINE_CORRECTED_DRAG_COEFFICIENT) return PIPELINE_E_ARGUMENTS;
+  pipeline->values[value] = x;
+  return 0;
+}
+
+int BallisticsPipeline_set_tolerance(BallisticsPipeline* pipeline, BallisticsPipelineValue value, double tolerance) {
+  if (value < 0 || value >= PIPELINE_VALUES || !(tolerance >= 0)) return PIPELINE_E_ARGUMENTS;
+  pipeline->tolerances[value] = tolerance;
+  return 0;
+}
+
+int BallisticsPipeline_set_card(BallisticsPipeline* pipeline, const double* ranges, int count) {
+  double* copy;
+  BallisticsTarget* card;
+
+  if (count < 0 || (count > 0 && !ranges)) return PIPELINE_E_ARGUMENTS;
+  copy = malloc(sizeof(double) * (count > 0 ? count : 1));
+  card = calloc(count > 0 ? count : 1, sizeof(BallisticsTarget));
+  if (!copy || !card) {
+    free(copy);
+    free(card);
+    return PIPELINE_E_NO_MEMORY;
+  }
+  if (count > 0) memcpy(copy, ranges, sizeof(double) * count);
+  free(pipeline->ranges);
+  free(pipeline->card);
+  pipeline->ranges = copy;
+  pipeline->card = card;
+  pipeline->card_count = count;
+  pipeline->current &= ~PIPELINE_CARD;
+  return 0;
+}
+
+// Whether any value a stage depends on has moved by more than its tolerance since the stage last ran.
+static int Pipeline_changed(const BallisticsPipeline* pipeline, int stage) {
+  unsigned dependencies = pipeline_dependencies[stage];
+  int value;
+
+  for (value = 0; value < PIPELINE_VALUES; value++) {
+    double moved;
+    if (!(dependencies & PIPELINE_BIT(value))) continue;
+    moved = fabs(pipeline->values[value] - pipeline->used[stage][value]);
+    if (value == PIPELINE_DRAG_FUNCTION ? moved != 0 : !(moved <= pipeline->tolerances[value])) return 1;
+  }
+  return 0;
+}
+
+static void Pipeline_read_card(BallisticsPipeline* pipeline) {
+  Ballistics* solution = pipeline->solution;
+  int rows = Ballistics_get_max_yardage(solution);
+  int i;
+
+  for (i = 0; i < pipeline->card_count; i++) {
+    BallisticsTarget* target = &pipeline->card[i];
+    int yard = (int)pipeline->ranges[i];
+
+    memset(target, 0, sizeof(BallisticsTarget));
+    target->range_yards = pipeline->ranges[i];
+    if (yard < 0 || yard >= rows) continue;
+    target->path_inches = Ballistics_get_path(solution, yard);
+    target->moa_correction = Ballistics_get_moa(solution, yard);
+    target->seconds = Ballistics_get_time(solution, yard);
+    target->windage_inches = Ballistics_get_windage(solution, yard);
+    target->windage_moa = Ballistics_get_windage_moa(solution, yard);
+    target->v_fps = Ballistics_get_v_fps(solution, yard);
+  }
+}
+
+int BallisticsPipeline_update(BallisticsPipeline* pipeline) {
+  double* values = pipeline->values;
+  int ran = 0;
+  int stage;
+
+  for (stage = 0; stage < PIPELINE_STAGES; stage++) {
+    int bit = 1 << stage;
+    int stale = !(pipeline->current & bit) || Pipeline_changed(pipeline, stage) ||
+                (bit == PIPELINE_CARD && (ran & PIPELINE_SOLVE));
+    if (!stale) continue;
+
+    switch (bit) {
+      case PIPELINE_CORRECTION:
+        values[PIPELINE_CORRECTED_DRAG_COEFFICIENT] =
+          atmosphere_correction(values[PIPELINE_DRAG_COEFFICIENT], values[PIPELINE_ALTITUDE],
+                                values[PIPELINE_BAROMETER], values[PIPELINE_TEMPERATURE],
+                                values[PIPELINE_RELATIVE_HUMIDITY]);
+        break;
+      case PIPELINE_ZERO:
+        values[PIPELINE_ZERO_ANGLE] =
+          zero_angle((DragFunction)values[PIPELINE_DRAG_FUNCTION], values[PIPELINE_CORRECTED_DRAG_COEFFICIENT],
+                     values[PIPELINE_VELOCITY], values[PIPELINE_SIGHT_HEIGHT], values[PIPELINE_ZERO_RANGE],
+                     values[PIPELINE_Y_INTERCEPT]);
+        break;
+      case PIPELINE_SOLVE: {
+        int status = Ballistics_solve_into(pipeline->solution, (DragFunction)values[PIPELINE_DRAG_FUNCTION],
+                                           values[PIPELINE_CORRECTED_DRAG_COEFFICIENT], values[PIPELINE_VELOCITY],
+                                           values[PIPELINE_SIGHT_HEIGHT], values[PIPELINE_SHOOTING_ANGLE],
+                                           values[PIPELINE_ZERO_ANGLE], values[PIPELINE_WIND_SPEED],
+                                           values[PIPELINE_WIND_ANGLE]);
+        if (status < 0) {
+          pipeline->current &= ~(PIPELINE_SOLVE | PIPELINE_CARD);
+          return status;
+        }
+        break;
+      }
+      case PIPELINE_CARD:
+        Pipeline_read_card(pipeline);
+        break;
+    }
+    memcpy(pipeline->used[stage], values, sizeof(double) * PIPELINE_VALUES);
+    pipeline->current |= bit;
+    ran |= bit;
+  }
+  return ran;
+}
+
+double BallisticsPipeline_get(const BallisticsPipeline* pipeline, BallisticsPipelineValue value) {
+  return value >= 0 && value < PIPELINE_VALUES ? pipeline->values[value] : 0;
+}
+
+Ballistics* BallisticsPipeline_get_solution(const BallisticsPipeline* pipeline) {
+  return pipeline->current & PIPELINE_SOLVE ? pipeline->solution : NULL;
+}
+
+const BallisticsTarget* BallisticsPipeline_get_card(const BallisticsPipeline* pipeline, int* count) {
+  *count = pipeline->card_count;
+  return pipeline->card;
+}
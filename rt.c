@@ -0,0 +1,316 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/rt.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RT_MAGIC 0x31435452 // "RTC1"
+#define RT_CACHE_LINE 64
+#define RT_SOLUTION_WORDS (sizeof(RtSolution) / sizeof(uint64_t))
+
+// Converged once the zero range needs less correction than zero_angle() resolves.
+#define RT_ZERO_MOA 0.01
+
+_Static_assert(sizeof(RtSolution) % sizeof(uint64_t) == 0, "RtSolution must be whole words");
+_Static_assert((RT_RING_CAPACITY & (RT_RING_CAPACITY - 1)) == 0, "RT_RING_CAPACITY must be a power of two");
+
+/**
+ * The shared memory.  The producer's index, the consumer's index and the published solution each get their own
+ * cache lines so the two sides never write to the same line.  Indices count up forever; a slot is index modulo
+ * the capacity.
+ */
+struct RtChannel {
+  uint32_t magic;
+  uint32_t size;
+
+  _Alignas(RT_CACHE_LINE) atomic_uint_fast64_t head; // written only by the producer
+  _Alignas(RT_CACHE_LINE) atomic_uint_fast64_t tail; // written only by the consumer
+
+  // A seqlock: odd while a publish is in progress, and twice the number of publishes otherwise.
+  _Alignas(RT_CACHE_LINE) atomic_uint_fast64_t sequence;
+  atomic_uint_fast64_t solution[RT_SOLUTION_WORDS];
+
+  _Alignas(RT_CACHE_LINE) RtInput ring[RT_RING_CAPACITY];
+};
+
+size_t RtChannel_size(void) {
+  return sizeof(RtChannel);
+}
+
+RtChannel* RtChannel_init(void* memory) {
+  RtChannel* channel = memory;
+  size_t i;
+
+  memset(channel, 0, sizeof(RtChannel));
+  channel->magic = RT_MAGIC;
+  channel->size = sizeof(RtChannel);
+  atomic_init(&channel->head, 0);
+  atomic_init(&channel->tail, 0);
+  atomic_init(&channel->sequence, 0);
+  for (i = 0; i < RT_SOLUTION_WORDS; i++) atomic_init(&channel->solution[i], 0);
+  return channel;
+}
+
+int RtChannel_open(RtChannel** channel, const char* name, int create) {
+  struct stat status;
+  void* memory;
+  int fd;
+
+  *channel = NULL;
+  fd = shm_open(name, create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+  if (fd < 0) return RT_E_IO;
+  if (create ? ftruncate(fd, sizeof(RtChannel)) != 0 : fstat(fd, &status) != 0) {
+    close(fd);
+    return RT_E_IO;
+  }
+  if (!create && (size_t)status.st_size != sizeof(RtChannel)) {
+    close(fd);
+    return RT_E_ARGUMENTS;
+  }
+  memory = mmap(NULL, sizeof(RtChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) return RT_E_IO;
+
+  if (create) {
+    RtChannel_init(memory);
+  }
+  else if (((RtChannel*)memory)->magic != RT_MAGIC || ((RtChannel*)memory)->size != sizeof(RtChannel)) {
+    munmap(memory, sizeof(RtChannel));
+    return RT_E_ARGUMENTS;
+  }
+  *channel = memory;
+  return 0;
+}
+
+void RtChannel_close(RtChannel* channel) {
+  if (channel) munmap(channel, sizeof(RtChannel));
+}
+
+int RtChannel_unlink(const char* name) {
+  return shm_unlink(name) ? RT_E_IO : 0;
+}
+
+int RtChannel_push(RtChannel* channel, const RtInput* input) {
+  uint64_t head = atomic_load_explicit(&channel->head, memory_order_relaxed);
+  if (head - atomic_load_explicit(&channel->tail, memory_order_acquire) >= RT_RING_CAPACITY) return RT_E_FULL;
+  channel->ring[head & (RT_RING_CAPACITY - 1)] = *input;
+  atomic_store_explicit(&channel->head, head + 1, memory_order_release);
+  return 0;
+}
+
+int RtChannel_pop(RtChannel* channel, RtInput* input) {
+  uint64_t tail = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+  if (tail == atomic_load_explicit(&channel->head, memory_order_acquire)) return 0;
+  *input = channel->ring[tail & (RT_RING_CAPACITY - 1)];
+  atomic_store_explicit(&channel->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+void RtChannel_publish(RtChannel* channel, const RtSolution* solution) {
+  uint64_t words[RT_SOLUTION_WORDS];
+  uint64_t sequence = atomic_load_explicit(&channel->sequence, memory_order_relaxed);
+  size_t i;
+
+  memcpy(words, solution, sizeof(words));
+  atomic_store_explicit(&channel->sequence, sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  for (i = 0; i < RT_SOLUTION_WORDS; i++) {
+    atomic_store_explicit(&channel->solution[i], words[i], memory_order_relaxed);
+  }
+  atomic_store_explicit(&channel->sequence, sequence + 2, memory_order_release);
+}
+
+uint64_t RtChannel_read(RtChannel* channel, RtSolution* solution) {
+  uint64_t words[RT_SOLUTION_WORDS];
+  uint64_t before, after;
+  size_t i;
+
+  do {
+    before = atomic_load_explicit(&channel->sequence, memory_order_acquire);
+    if (before & 1) continue;
+    for (i = 0; i < RT_SOLUTION_WORDS; i++) {
+      words[i] = atomic_load_explicit(&channel->solution[i], memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    after = atomic_load_explicit(&channel->sequence, memory_order_relaxed);
+  } while ((before & 1) || before != after);
+
+  if (before) memcpy(solution, words, sizeof(words));
+  return before / 2;
+}
+
+uint64_t RtChannel_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void RtSolver_init(RtSolver* solver, DragFunction drag_function, double drag_coefficient, double vi,
+                   double sight_height, double zero_range) {
+  memset(solver, 0, sizeof(RtSolver));
+  solver->drag_function = drag_function;
+  solver->drag_coefficient = drag_coefficient;
+  solver->vi = vi;
+  solver->sight_height = sight_height;
+  solver->zero_range = zero_range;
+
+  // Standard conditions, as atmosphere_correction() defines them.
+  solver->state.range_yards = zero_range;
+  solver->state.barometer = 29.53;
+  solver->state.temperature = 59;
+  solver->state.relative_humidity = 0.78;
+
+  solver->corrected_drag_coefficient = drag_coefficient;
+  solver->zero_drag_coefficient = drag_coefficient;
+  solver->zero_angle = zero_angle(drag_function, drag_coefficient, vi, sight_height, zero_range, 0);
+  solver->stale = RT_INPUT_RANGE;
+}
+
+void RtSolver_update(RtSolver* solver, const RtInput* input) {
+  RtInput* state = &solver->state;
+
+  // Sensors repeat themselves far more often than they change, so only real changes cost a solve.
+  if ((input->fields & RT_INPUT_RANGE) && input->range_yards != state->range_yards) {
+    state->range_yards = input->range_yards;
+    solver->stale |= RT_INPUT_RANGE;
+  }
+  if ((input->fields & RT_INPUT_ANGLE) && input->shooting_angle != state->shooting_angle) {
+    state->shooting_angle = input->shooting_angle;
+    solver->stale |= RT_INPUT_ANGLE;
+  }
+  if ((input->fields & RT_INPUT_WIND) &&
+      (input->wind_speed != state->wind_speed || input->wind_angle != state->wind_angle)) {
+    state->wind_speed = input->wind_speed;
+    state->wind_angle = input->wind_angle;
+    solver->stale |= RT_INPUT_WIND;
+  }
+  if ((input->fields & RT_INPUT_ATMOSPHERE) &&
+      (input->altitude != state->altitude || input->barometer != state->barometer ||
+       input->temperature != state->temperature || input->relative_humidity != state->relative_humidity)) {
+    state->altitude = input->altitude;
+    state->barometer = input->barometer;
+    state->temperature = input->temperature;
+    state->relative_humidity = input->relative_humidity;
+    solver->stale |= RT_INPUT_ATMOSPHERE;
+  }
+  if (input->timestamp_ns > state->timestamp_ns) state->timestamp_ns = input->timestamp_ns;
+  solver->inputs++;
+}
+
+/**
+ * Re-zeroes for the corrected drag coefficient by Newton's method from the previous zero: the elevation
+ * correction a trajectory needs at the zero range is, to first order, exactly how far its bore angle is off.
+ * A small change in the atmosphere usually converges in one or two trajectories, each only out to the zero range.
+ */
+static void RtSolver_zero(RtSolver* solver) {
+  double angle = solver->zero_angle;
+  int i;
+
+  for (i = 0; i < RT_ZERO_ITERATIONS; i++) {
+    BallisticsTarget zero = {solver->zero_range};
+    if (Ballistics_solve_targets(&zero, 1, solver->drag_function, solver->corrected_drag_coefficient, solver->vi,
+                                 solver->sight_height, 0, angle, 0, 0) != 1) {
+      break;
+    }
+    if (fabs(zero.moa_correction) < RT_ZERO_MOA) {
+      solver->zero_angle = angle;
+      return;
+    }
+    angle += zero.moa_correction / 60;
+  }
+
+  solver->zero_angle = zero_angle(solver->drag_function, solver->corrected_drag_coefficient, solver->vi,
+                                  solver->sight_height, solver->zero_range, 0);
+}
+
+void RtSolver_solve(RtSolver* solver, RtSolution* solution) {
+  RtInput* state = &solver->state;
+  double hwind = headwind(state->wind_speed, state->wind_angle);
+  double cwind = crosswind(state->wind_speed, state->wind_angle);
+  int zeroed = 0, resolved = 0;
+
+  if (solver->stale & RT_INPUT_ATMOSPHERE) {
+    solver->corrected_drag_coefficient = atmosphere_correction(solver->drag_coefficient, state->altitude,
+                                                               state->barometer, state->temperature,
+                                                               state->relative_humidity);
+    if (fabs(solver->corrected_drag_coefficient / solver->zero_drag_coefficient - 1) > solver->zero_tolerance) {
+      RtSolver_zero(solver);
+      solver->zero_drag_coefficient = solver->corrected_drag_coefficient;
+      zeroed = 1;
+    }
+  }
+
+  // cos(deg_to_rad(90)) isn't quite 0, so a wind straight across still has a headwind in its last bits, which moves
+  // with the wind speed; only a headwind that really changed is worth a new trajectory.
+  if ((solver->stale & (RT_INPUT_RANGE | RT_INPUT_ANGLE | RT_INPUT_ATMOSPHERE)) ||
+      fabs(hwind - solver->headwind) > 1e-9 * (1 + fabs(state->wind_speed))) {
+    solver->target.range_yards = state->range_yards;
+    solver->target_status = Ballistics_solve_targets(&solver->target, 1, solver->drag_function,
+                                                     solver->corrected_drag_coefficient, solver->vi,
+                                                     solver->sight_height, state->shooting_angle,
+                                                     solver->zero_angle, state->wind_speed, state->wind_angle);
+    solver->headwind = hwind;
+    resolved = 1;
+  }
+  else if ((solver->stale & RT_INPUT_WIND) && solver->target_status == 1) {
+    // Only the crosswind changed, and windage is linear in it: the trajectory itself still stands.
+    BallisticsTarget* target = &solver->target;
+    double x = target->range_yards * 3;
+    target->windage_inches = windage(cwind, solver->vi, x, target->seconds);
+    target->windage_moa = rad_to_moa(atan((target->windage_inches / 12) / x));
+  }
+  solver->stale = 0;
+
+  solution->input_timestamp_ns = state->timestamp_ns;
+  solution->inputs = solver->inputs;
+  solution->status = solver->target_status;
+  solution->zeroed = zeroed;
+  solution->resolved = resolved;
+  solution->range_yards = solver->target.range_yards;
+  solution->drag_coefficient = solver->corrected_drag_coefficient;
+  solution->zero_angle = solver->zero_angle;
+  solution->path_inches = solver->target.path_inches;
+  solution->moa_correction = solver->target.moa_correction;
+  solution->windage_inches = solver->target.windage_inches;
+  solution->windage_moa = solver->target.windage_moa;
+  solution->seconds = solver->target.seconds;
+  solution->v_fps = solver->target.v_fps;
+  solution->solved_timestamp_ns = RtChannel_now_ns();
+}
+
+int RtSolver_poll(RtSolver* solver, RtChannel* channel) {
+  RtInput input;
+  RtSolution solution;
+  int count = 0;
+
+  while (RtChannel_pop(channel, &input)) {
+    RtSolver_update(solver, &input);
+    count++;
+  }
+  if (count) {
+    RtSolver_solve(solver, &solution);
+    RtChannel_publish(channel, &solution);
+  }
+  return count;
+}
@@ -0,0 +1,243 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/siacci.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+struct SiacciTables {
+  DragFunction drag_function;
+  int count; // entries, at SIACCI_MIN_FPS + i*SIACCI_SPEED_STEP
+
+  // For a ballistic coefficient of 1, integrated from SIACCI_MAX_FPS down to each speed u:
+  double* space; // S(u), the distance to slow to u, in feet
+  double* time;  // T(u), the time to slow to u, in seconds
+  double* slope; // P(u), the integral of dx/u^2, which the path's slope grows by g times
+  double* drop;  // Q(u), the integral of P dx, which the path drops by g times
+};
+
+// The tables' integrands, for a ballistic coefficient of 1.
+static double Siacci_space(DragFunction drag_function, double u) {
+  return u / retard(drag_function, 1, u);
+}
+
+static double Siacci_time(DragFunction drag_function, double u) {
+  return 1 / retard(drag_function, 1, u);
+}
+
+static double Siacci_slope(DragFunction drag_function, double u) {
+  return 1 / (u * retard(drag_function, 1, u));
+}
+
+int SiacciTables_build(SiacciTables** tables, DragFunction drag_function) {
+  int count = (int)((SIACCI_MAX_FPS - SIACCI_MIN_FPS) / SIACCI_SPEED_STEP) + 1;
+  SiacciTables* s;
+  double* block;
+  int i;
+
+  *tables = NULL;
+  if (drag_function < G1 || drag_function > G8 || retard(drag_function, 1, SIACCI_MIN_FPS) <= 0) {
+    return SIACCI_E_ARGUMENTS;
+  }
+  s = malloc(sizeof(SiacciTables));
+  block = malloc(sizeof(double) * 4 * count);
+  if (!s || !block) {
+    free(s);
+    free(block);
+    return SIACCI_E_NO_MEMORY;
+  }
+  s->drag_function = drag_function;
+  s->count = count;
+  s->space = block;
+  s->time = block + count;
+  s->slope = block + 2*count;
+  s->drop = block + 3*count;
+
+  // Simpson's rule over each interval, from the top down.  The drop integrates the slope over distance, so it
+  // takes the slope at the middle of the interval too.
+  i = count - 1;
+  s->space[i] = s->time[i] = s->slope[i] = s->drop[i] = 0;
+  for (i = count - 2; i >= 0; i--) {
+    double a = SIACCI_MIN_FPS + i * SIACCI_SPEED_STEP;
+    double b = a + SIACCI_SPEED_STEP;
+    double m = (a + b) / 2;
+    double h = SIACCI_SPEED_STEP / 6;
+    double half = SIACCI_SPEED_STEP / 12;
+    double space_a = Siacci_space(drag_function, a);
+    double space_m = Siacci_space(drag_function, m);
+    double space_b = Siacci_space(drag_function, b);
+    double slope_a = Siacci_slope(drag_function, a);
+    double slope_m = Siacci_slope(drag_function, m);
+    double slope_b = Siacci_slope(drag_function, b);
+    // The slope at the middle, by Simpson's rule over the upper half of the interval.
+    double p_m = s->slope[i + 1] + half * (slope_m + 4 * Siacci_slope(drag_function, (m + b) / 2) + slope_b);
+    double p_a;
+
+    s->space[i] = s->space[i + 1] + h * (space_a + 4*space_m + space_b);
+    s->time[i] = s->time[i + 1] +
+                 h * (Siacci_time(drag_function, a) + 4*Siacci_time(drag_function, m) + Siacci_time(drag_function, b));
+    s->slope[i] = p_a = s->slope[i + 1] + h * (slope_a + 4*slope_m + slope_b);
+    s->drop[i] = s->drop[i + 1] + h * (p_a*space_a + 4*p_m*space_m + s->slope[i + 1]*space_b);
+  }
+  *tables = s;
+  return 0;
+}
+
+void SiacciTables_free(SiacciTables* tables) {
+  if (tables) {
+    free(tables->space);
+    free(tables);
+  }
+}
+
+DragFunction SiacciTables_get_drag_function(const SiacciTables* tables) {
+  return tables->drag_function;
+}
+
+/**
+ * A shot, set up for reading off the tables: the tables' values at the muzzle velocity, and what the ballistic
+ * coefficient and the angles come to.
+ */
+typedef struct {
+  const SiacciTables* tables;
+  double bc;
+  double space0, time0, slope0, drop0; // the tables at the muzzle velocity
+  double y0, tan0, cos0, gy;
+} SiacciShot;
+
+/**
+ * Sets a shot up.  The muzzle velocity falls on the tables' evenly spaced speeds, so its values interpolate
+ * directly.
+ * @return nonzero if the muzzle velocity is off the tables
+ */
+static int Siacci_aim(SiacciShot* shot, const SiacciTables* tables, double drag_coefficient, double vi,
+                      double sight_height, double shooting_angle, double zero_angle) {
+  double p = (vi - SIACCI_MIN_FPS) / SIACCI_SPEED_STEP;
+  int i = (int)p;
+  double f;
+
+  if (!(drag_coefficient > 0) || !(i >= 0 && i < tables->count - 1)) return 1;
+  f = p - i;
+  shot->tables = tables;
+  shot->bc = drag_coefficient;
+  shot->space0 = tables->space[i] + f * (tables->space[i + 1] - tables->space[i]);
+  shot->time0 = tables->time[i] + f * (tables->time[i + 1] - tables->time[i]);
+  shot->slope0 = tables->slope[i] + f * (tables->slope[i + 1] - tables->slope[i]);
+  shot->drop0 = tables->drop[i] + f * (tables->drop[i + 1] - tables->drop[i]);
+  shot->y0 = -sight_height/12;
+  shot->tan0 = tan(deg_to_rad(zero_angle));
+  shot->cos0 = cos(deg_to_rad(zero_angle));
+  shot->gy = GRAVITY*cos(deg_to_rad((shooting_angle + zero_angle)));
+  return 0;
+}
+
+/**
+ * The state at range x, in feet, from the tables' entries i and i+1, which bracket the distance the projectile
+ * has covered there.  Everything is interpolated in distance, which the tables are smoothest in.
+ */
+static inline void Siacci_state(const SiacciShot* shot, int i, double x, BallisticsState* state) {
+  const SiacciTables* tables = shot->tables;
+  double s = shot->space0 + x / shot->bc;
+  double f = (tables->space[i] - s) / (tables->space[i] - tables->space[i + 1]);
+  double u = SIACCI_MIN_FPS + (i + f) * SIACCI_SPEED_STEP;
+  double time = tables->time[i] + f * (tables->time[i + 1] - tables->time[i]);
+  double slope = tables->slope[i] + f * (tables->slope[i + 1] - tables->slope[i]);
+  double drop = tables->drop[i] + f * (tables->drop[i + 1] - tables->drop[i]);
+  double bc = shot->bc;
+
+  // With x = bc*(S(u) - S(vi)): the time is bc*(T(u) - T(vi)), the slope grows by g times the integral of
+  // dx/u^2, bc*(P(u) - P(vi)), and the path drops by g times the integral of that.
+  state->x = x;
+  state->t = bc * (time - shot->time0);
+  state->y = shot->y0 + x*shot->tan0 + shot->gy * (bc*bc * (drop - shot->drop0) - bc * shot->slope0 * x);
+  state->vx = u * shot->cos0;
+  state->vy = state->vx * (shot->tan0 + shot->gy * bc * (slope - shot->slope0));
+  state->v = BALLISTICS_SPEED(state->vx, state->vy);
+}
+
+int SiacciTables_trajectory(const SiacciTables* tables, double drag_coefficient, double vi, double sight_height,
+                            double shooting_angle, double zero_angle, int rows, double* x, double* y, double* t,
+                            double* v, double* vx, double* vy) {
+  SiacciShot shot;
+  int i, n;
+
+  if (Siacci_aim(&shot, tables, drag_coefficient, vi, sight_height, shooting_angle, zero_angle)) return 0;
+
+  // Rows come in order of distance, so the bracketing entries only ever move down the tables.
+  i = (int)((vi - SIACCI_MIN_FPS) / SIACCI_SPEED_STEP);
+  for (n = 0; n < rows; n++) {
+    double s = shot.space0 + n*3 / drag_coefficient;
+    BallisticsState state;
+    while (i > 0 && tables->space[i] < s) i--;
+    if (tables->space[i] < s) break;
+    Siacci_state(&shot, i, n*3, &state);
+    x[n] = state.x;
+    y[n] = state.y;
+    t[n] = state.t + 0.5/state.v;
+    v[n] = state.v;
+    vx[n] = state.vx;
+    vy[n] = state.vy;
+  }
+  return n;
+}
+
+int Siacci_solve_targets(BallisticsTarget* targets, int count, const SiacciTables* tables, double drag_coefficient,
+                         double vi, double sight_height, double shooting_angle, double zero_angle, double wind_speed,
+                         double wind_angle) {
+  double cwind = crosswind(wind_speed, wind_angle);
+  // The entry at or just below the muzzle velocity, which Siacci_aim() checks has one above it.
+  int i_v = (int)((vi - SIACCI_MIN_FPS) / SIACCI_SPEED_STEP);
+  SiacciShot shot;
+  int reached = 0;
+  int k;
+
+  if (count < 0) return SIACCI_E_ARGUMENTS;
+  for (k = 0; k < count; k++) {
+    BallisticsTarget* target = &targets[k];
+    target->path_inches = target->moa_correction = target->seconds = 0;
+    target->windage_inches = target->windage_moa = target->v_fps = 0;
+  }
+  if (Siacci_aim(&shot, tables, drag_coefficient, vi, sight_height, shooting_angle, zero_angle)) return 0;
+
+  for (k = 0; k < count; k++) {
+    BallisticsTarget* target = &targets[k];
+    double x = target->range_yards*3;
+    double s = shot.space0 + x / drag_coefficient;
+    int lo = 0, hi = i_v + 1;
+    BallisticsState state;
+
+    if (!(x >= 0) || tables->space[0] < s) continue;
+    // The entries bracketing the distance: space[lo] >= s > space[hi], with space decreasing as speed rises.  The
+    // entry above the muzzle velocity is short of space0, so of every s a target can have.
+    while (hi - lo > 1) {
+      int mid = (lo + hi) / 2;
+      if (tables->space[mid] >= s) lo = mid;
+      else hi = mid;
+    }
+    Siacci_state(&shot, lo, x, &state);
+    target->path_inches = state.y*12;
+    target->seconds = state.t;
+    target->v_fps = state.v;
+    target->windage_inches = windage(cwind, vi, x, state.t);
+    if (x > 0) {
+      target->moa_correction = -rad_to_moa(BALLISTICS_ATAN(state.y / x));
+      target->windage_moa = rad_to_moa(BALLISTICS_ATAN((target->windage_inches/12) / x));
+    }
+    reached++;
+  }
+  return reached;
+}
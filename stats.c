@@ -0,0 +1,119 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/ballistics.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char* phase_names[BALLISTICS_PHASES] = {"solve", "zero", "pbr", "truing"};
+
+const char* BallisticsStats_phase_name(BallisticsPhase phase) {
+  if (phase < 0 || phase >= BALLISTICS_PHASES) return "unknown";
+  return phase_names[phase];
+}
+
+#ifdef BALLISTICS_STATS
+
+__thread BallisticsStatsState ballistics_stats_state;
+
+static BallisticsStatsHook stats_hook;
+static void* stats_hook_context;
+
+static unsigned long long now_nanoseconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+void BallisticsStats_begin(BallisticsPhase phase) {
+  BallisticsStatsState* state = &ballistics_stats_state;
+
+  if (state->depth == 0) {
+    memset(&state->current, 0, sizeof(state->current));
+    state->current.phase = phase;
+  }
+  if (stats_hook) stats_hook(stats_hook_context, phase, 1);
+  if (state->depth < (int)(sizeof(state->started)/sizeof(state->started[0]))) {
+    state->started[state->depth] = now_nanoseconds();
+  }
+  state->depth++;
+}
+
+void BallisticsStats_end(BallisticsPhase phase) {
+  BallisticsStatsState* state = &ballistics_stats_state;
+  unsigned long long elapsed = 0;
+  int bucket = 0;
+  int i;
+
+  state->depth--;
+  if (state->depth < (int)(sizeof(state->started)/sizeof(state->started[0]))) {
+    elapsed = now_nanoseconds() - state->started[state->depth];
+  }
+  if (stats_hook) stats_hook(stats_hook_context, phase, 0);
+
+  while (bucket < BALLISTICS_STATS_LATENCY_BUCKETS - 1 && (1ull << bucket) < elapsed) bucket++;
+  state->totals.calls[phase]++;
+  state->totals.nanoseconds[phase] += elapsed;
+  state->totals.latency[phase][bucket]++;
+
+  if (state->depth == 0) {
+    state->current.nanoseconds = elapsed;
+    state->totals.steps += state->current.steps;
+    state->totals.iterations += state->current.iterations;
+    for (i = 0; i < BALLISTICS_STATS_VELOCITY_BANDS; i++) {
+      state->totals.retard_calls[i] += state->current.retard_calls[i];
+    }
+    state->last = state->current;
+  }
+}
+
+void BallisticsStats_last(BallisticsSolveStats* stats) {
+  *stats = ballistics_stats_state.last;
+}
+
+void BallisticsStats_thread(BallisticsThreadStats* stats) {
+  *stats = ballistics_stats_state.totals;
+}
+
+void BallisticsStats_reset(void) {
+  memset(&ballistics_stats_state.totals, 0, sizeof(ballistics_stats_state.totals));
+}
+
+void BallisticsStats_set_hook(BallisticsStatsHook hook, void* context) {
+  stats_hook_context = context;
+  stats_hook = hook;
+}
+
+#else
+
+void BallisticsStats_last(BallisticsSolveStats* stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
+void BallisticsStats_thread(BallisticsThreadStats* stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
+void BallisticsStats_reset(void) {
+}
+
+void BallisticsStats_set_hook(BallisticsStatsHook hook, void* context) {
+  (void)hook;
+  (void)context;
+}
+
+#endif
@@ -0,0 +1,457 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/surface.h"
+#include "ballistics/batch.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SURFACE_MAGIC "BLSTSRF2"
+#define SURFACE_BYTE_ORDER 0x01020304
+
+// The shot axes, which each need a solve of their own, come before SURFACE_RANGE.
+#define SURFACE_SHOT_AXES SURFACE_RANGE
+#define SURFACE_CORNERS (1 << SURFACE_AXES)
+
+// Exactly the header written to a file; the values, and then each cell's estimated errors, follow it in the same
+// block.
+typedef struct {
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t drag_function;
+  uint64_t size;
+  double sight_height;
+  double min[SURFACE_AXES];
+  double max[SURFACE_AXES];
+  uint32_t count[SURFACE_AXES];
+  uint32_t reserved;
+  double estimated_error[SURFACE_OUTPUTS];
+} SurfaceHeader;
+
+struct BallisticsSurface {
+  SurfaceHeader* header;
+  const double* values;
+  size_t mapped;                // the bytes mapped, or 0 for a surface built in memory
+  size_t strides[SURFACE_AXES]; // values between neighbouring points along each axis
+  size_t corners[SURFACE_CORNERS]; // values from a cell's first corner to each of the others
+  double scale[SURFACE_AXES];   // points per unit along each axis
+  double* cell_errors;          // SURFACE_OUTPUTS for each cell, after the values
+  double tolerance[SURFACE_OUTPUTS]; // the largest estimated error a query is interpolated with
+};
+
+// The work shared by the threads building a surface.
+typedef struct {
+  BallisticsSurface* surface;
+  signed char* status;          // each shot's or cell's result
+} SurfaceBuild;
+
+static void Surface_index(BallisticsSurface* surface) {
+  const SurfaceHeader* header = surface->header;
+  size_t stride = SURFACE_OUTPUTS;
+  int a, corner;
+
+  for (a = SURFACE_AXES - 1; a >= 0; a--) {
+    surface->strides[a] = stride;
+    surface->scale[a] = (header->count[a] - 1) / (header->max[a] - header->min[a]);
+    stride *= header->count[a];
+  }
+  // Bit a of a corner's number is set where it is a point further along axis a.
+  for (corner = 0; corner < SURFACE_CORNERS; corner++) {
+    surface->corners[corner] = 0;
+    for (a = 0; a < SURFACE_AXES; a++) {
+      if (corner & (1 << a)) surface->corners[corner] += surface->strides[a];
+    }
+  }
+  surface->values = (const double*)(header + 1);
+  surface->cell_errors = (double*)surface->values + stride;
+  for (a = 0; a < SURFACE_OUTPUTS; a++) surface->tolerance[a] = INFINITY;
+}
+
+static inline double Surface_point(const SurfaceHeader* header, int axis, double position) {
+  return header->min[axis] + position * (header->max[axis] - header->min[axis]) / (header->count[axis] - 1);
+}
+
+// Splits a shot or cell number into its position along each shot axis, which has counts[a] shots or cells.
+static void Surface_shot(const SurfaceHeader* header, int index, int cells, int* position) {
+  int a;
+  for (a = SURFACE_SHOT_AXES - 1; a >= 0; a--) {
+    int count = (int)header->count[a] - cells;
+    position[a] = index % count;
+    index /= count;
+  }
+}
+
+/**
+ * Solves one shot out to count ranges, the first at offset points along the range axis and the rest a point apart,
+ * and stores each range's outputs in out.
+ * @return 0, SURFACE_E_NO_MEMORY, or SURFACE_E_OUT_OF_RANGE if the projectile doesn't reach the last range
+ */
+static int Surface_solve(const SurfaceHeader* header, const double* shot, double offset, int count, double* out) {
+  BallisticsTarget* targets = malloc(sizeof(BallisticsTarget) * count);
+  DragFunction drag_function = (DragFunction)header->drag_function;
+  double angle;
+  int reached, i;
+
+  if (!targets) return SURFACE_E_NO_MEMORY;
+  angle = zero_angle(drag_function, shot[SURFACE_DRAG_COEFFICIENT], shot[SURFACE_VELOCITY], header->sight_height,
+                     shot[SURFACE_ZERO_RANGE], 0);
+  for (i = 0; i < count; i++) targets[i].range_yards = Surface_point(header, SURFACE_RANGE, offset + i);
+  reached = Ballistics_solve_targets(targets, count, drag_function, shot[SURFACE_DRAG_COEFFICIENT],
+                                     shot[SURFACE_VELOCITY], header->sight_height, shot[SURFACE_ANGLE], angle, 0, 0);
+  for (i = 0; i < count; i++) {
+    out[i*SURFACE_OUTPUTS + SURFACE_PATH] = targets[i].path_inches;
+    out[i*SURFACE_OUTPUTS + SURFACE_SECONDS] = targets[i].seconds;
+    out[i*SURFACE_OUTPUTS + SURFACE_LAG] = targets[i].seconds - targets[i].range_yards*3 / shot[SURFACE_VELOCITY];
+    out[i*SURFACE_OUTPUTS + SURFACE_V] = targets[i].v_fps;
+  }
+  free(targets);
+  return reached == count ? 0 : SURFACE_E_OUT_OF_RANGE;
+}
+
+/**
+ * Interpolates every output multilinearly at a point, given as its position along each axis in points from the
+ * axis's minimum, as the sum of the cell's 32 corners, each weighted by how near the point is to it along every axis.
+ */
+static void Surface_interpolate(const BallisticsSurface* surface, const double* position, double* out) {
+  double weights[SURFACE_CORNERS];
+  double sum[SURFACE_OUTPUTS] = {0};
+  const double* cell = surface->values;
+  int a, c, o;
+
+  weights[0] = 1;
+  for (a = 0; a < SURFACE_AXES; a++) {
+    int i = (int)position[a];
+    double f;
+    i = i < (int)surface->header->count[a] - 2 ? i : (int)surface->header->count[a] - 2;
+    f = position[a] - i;
+    cell += i * surface->strides[a];
+    for (c = 0; c < 1 << a; c++) {
+      weights[c + (1 << a)] = weights[c] * f;
+      weights[c] *= 1 - f;
+    }
+  }
+  // Summed locally, so the compiler needn't fear out aliasing the values.
+  for (c = 0; c < SURFACE_CORNERS; c++) {
+    const double* corner = cell + surface->corners[c];
+    for (o = 0; o < SURFACE_OUTPUTS; o++) sum[o] += weights[c] * corner[o];
+  }
+  for (o = 0; o < SURFACE_OUTPUTS; o++) out[o] = sum[o];
+}
+
+static void Surface_build_shot(void* context, int index) {
+  SurfaceBuild* build = context;
+  const SurfaceHeader* header = build->surface->header;
+  int position[SURFACE_SHOT_AXES];
+  double shot[SURFACE_SHOT_AXES];
+  size_t offset = 0;
+  int a;
+
+  Surface_shot(header, index, 0, position);
+  for (a = 0; a < SURFACE_SHOT_AXES; a++) {
+    shot[a] = Surface_point(header, a, position[a]);
+    offset += position[a] * build->surface->strides[a];
+  }
+  build->status[index] = (signed char)Surface_solve(header, shot, 0, header->count[SURFACE_RANGE],
+                                                    (double*)build->surface->values + offset);
+}
+
+/**
+ * Solves the shot at point, a position along each shot axis, out to count ranges from offset points along the range
+ * axis, and finds the largest error of the interpolation there in each output.
+ * @return 0, or the error Surface_solve() returned
+ */
+static int Surface_measure(const BallisticsSurface* surface, double* point, double offset, int count,
+                           double* errors) {
+  const SurfaceHeader* header = surface->header;
+  double shot[SURFACE_SHOT_AXES];
+  double interpolated[SURFACE_OUTPUTS];
+  double* solved = malloc(sizeof(double) * SURFACE_OUTPUTS * count);
+  int status, a, r, o;
+
+  if (!solved) return SURFACE_E_NO_MEMORY;
+  for (a = 0; a < SURFACE_SHOT_AXES; a++) shot[a] = Surface_point(header, a, point[a]);
+  status = Surface_solve(header, shot, offset, count, solved);
+
+  for (o = 0; o < SURFACE_OUTPUTS; o++) errors[o] = 0;
+  for (r = 0; r < count; r++) {
+    point[SURFACE_RANGE] = offset + r;
+    Surface_interpolate(surface, point, interpolated);
+    for (o = 0; o < SURFACE_OUTPUTS; o++) {
+      errors[o] = fmax(errors[o], fabs(interpolated[o] - solved[r*SURFACE_OUTPUTS + o]));
+    }
+  }
+  free(solved);
+  return status;
+}
+
+/**
+ * Estimates the interpolation's error in a cell, from the errors halfway along an edge out of the cell's first
+ * corner in each axis, where that axis's curvature does the most harm, added together, and the error at the centre,
+ * where they all peak together.  This is an estimate and not a bound: the other edges and the cross terms that
+ * multilinear interpolation misses go unsampled.
+ */
+static void Surface_estimate_cell(void* context, int index) {
+  SurfaceBuild* build = context;
+  const SurfaceHeader* header = build->surface->header;
+  int ranges = header->count[SURFACE_RANGE];
+  int position[SURFACE_SHOT_AXES];
+  double point[SURFACE_AXES];
+  double edge[SURFACE_OUTPUTS];
+  double* errors = &build->surface->cell_errors[(size_t)index * SURFACE_OUTPUTS];
+  int status, a, b, o;
+
+  Surface_shot(header, index, 1, position);
+  for (o = 0; o < SURFACE_OUTPUTS; o++) errors[o] = 0;
+  for (a = 0; a <= SURFACE_AXES; a++) {
+    // Each shot axis's edge is solved at every range, the range axis's at the first corner halfway between ranges,
+    // and the centre halfway along everything.
+    for (b = 0; b < SURFACE_SHOT_AXES; b++) point[b] = position[b] + (a == b || a == SURFACE_AXES ? 0.5 : 0);
+    if (a < SURFACE_SHOT_AXES) status = Surface_measure(build->surface, point, 0, ranges, edge);
+    else status = Surface_measure(build->surface, point, 0.5, ranges - 1, edge);
+    if (status) {
+      build->status[index] = (signed char)status;
+      return;
+    }
+    for (o = 0; o < SURFACE_OUTPUTS; o++) {
+      errors[o] = a < SURFACE_AXES ? errors[o] + edge[o] : fmax(errors[o], edge[o]);
+    }
+  }
+  build->status[index] = 0;
+}
+
+// Counts the grid's shots, or with cells set its cells, or returns 0 if there are too many to number.
+static int Surface_count(const SurfaceHeader* header, int cells) {
+  double count = 1;
+  int a;
+  for (a = 0; a < SURFACE_SHOT_AXES; a++) count *= header->count[a] - cells;
+  return count < 1 << 30 ? (int)count : 0;
+}
+
+static int Surface_check(const SurfaceHeader* header) {
+  double values = SURFACE_OUTPUTS;
+  int a;
+
+  if (header->drag_function < G1 || header->drag_function > G8) return 0;
+  for (a = 0; a < SURFACE_AXES; a++) {
+    if (header->count[a] < 2 || header->count[a] > SURFACE_MAX_POINTS || !(header->min[a] < header->max[a])) return 0;
+    values *= header->count[a];
+  }
+  if (!(header->min[SURFACE_DRAG_COEFFICIENT] > 0) || !(header->min[SURFACE_VELOCITY] > 0) ||
+      !(header->min[SURFACE_ZERO_RANGE] > 0) || !(header->min[SURFACE_RANGE] >= 0)) {
+    return 0;
+  }
+  return values * sizeof(double) < (double)SIZE_MAX / 2 && Surface_count(header, 0) > 0;
+}
+
+static size_t Surface_size(const SurfaceHeader* header) {
+  size_t values = SURFACE_OUTPUTS;
+  int a;
+  for (a = 0; a < SURFACE_AXES; a++) values *= header->count[a];
+  values += (size_t)SURFACE_OUTPUTS * Surface_count(header, 1);
+  return sizeof(SurfaceHeader) + sizeof(double) * values;
+}
+
+int BallisticsSurface_build(BallisticsSurface** surface, const BallisticsSurfaceConfig* config, int threads) {
+  SurfaceHeader header;
+  SurfaceBuild build;
+  BallisticsSurface* built;
+  int shots, cells, status = 0;
+  int a, i, o;
+
+  *surface = NULL;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SURFACE_MAGIC, sizeof(header.magic));
+  header.byte_order = SURFACE_BYTE_ORDER;
+  header.drag_function = (uint32_t)config->drag_function;
+  header.sight_height = config->sight_height;
+  for (a = 0; a < SURFACE_AXES; a++) {
+    header.min[a] = config->axes[a].min;
+    header.max[a] = config->axes[a].max;
+    header.count[a] = config->axes[a].count > 0 ? (uint32_t)config->axes[a].count : 0;
+  }
+  if (!Surface_check(&header)) return SURFACE_E_ARGUMENTS;
+  header.size = Surface_size(&header);
+  shots = Surface_count(&header, 0);
+  cells = Surface_count(&header, 1);
+
+  built = calloc(1, sizeof(BallisticsSurface));
+  build.surface = built;
+  build.status = malloc(shots);
+  if (!built || !build.status || !(built->header = malloc(header.size))) {
+    status = SURFACE_E_NO_MEMORY;
+    goto done;
+  }
+  memcpy(built->header, &header, sizeof(header));
+  Surface_index(built);
+
+  Ballistics_parallel_for(shots, threads, Surface_build_shot, &build);
+  for (i = 0; i < shots && !status; i++) status = build.status[i];
+  if (status) goto done;
+
+  Ballistics_parallel_for(cells, threads, Surface_estimate_cell, &build);
+  for (i = 0; i < cells && !status; i++) status = build.status[i];
+  if (status) goto done;
+  for (i = 0; i < cells; i++) {
+    for (o = 0; o < SURFACE_OUTPUTS; o++) {
+      built->header->estimated_error[o] = fmax(built->header->estimated_error[o],
+                                               built->cell_errors[i*SURFACE_OUTPUTS + o]);
+    }
+  }
+  *surface = built;
+  built = NULL;
+
+done:
+  free(build.status);
+  BallisticsSurface_free(built);
+  return status;
+}
+
+int BallisticsSurface_write(const BallisticsSurface* surface, FILE* file) {
+  if (fwrite(surface->header, 1, surface->header->size, file) != surface->header->size) return SURFACE_E_IO;
+  return fflush(file) == 0 ? 0 : SURFACE_E_IO;
+}
+
+int BallisticsSurface_map(BallisticsSurface** surface, const char* path) {
+  struct stat status;
+  BallisticsSurface* mapped;
+  SurfaceHeader* header;
+  int fd;
+
+  *surface = NULL;
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return SURFACE_E_IO;
+  if (fstat(fd, &status) != 0) {
+    close(fd);
+    return SURFACE_E_IO;
+  }
+  if ((size_t)status.st_size < sizeof(SurfaceHeader)) {
+    close(fd);
+    return SURFACE_E_FORMAT;
+  }
+  header = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (header == MAP_FAILED) return SURFACE_E_IO;
+
+  if (memcmp(header->magic, SURFACE_MAGIC, sizeof(header->magic)) != 0 || header->byte_order != SURFACE_BYTE_ORDER ||
+      !Surface_check(header) || header->size != (uint64_t)status.st_size || Surface_size(header) != header->size) {
+    munmap(header, (size_t)status.st_size);
+    return SURFACE_E_FORMAT;
+  }
+  mapped = calloc(1, sizeof(BallisticsSurface));
+  if (!mapped) {
+    munmap(header, (size_t)status.st_size);
+    return SURFACE_E_NO_MEMORY;
+  }
+  mapped->header = header;
+  mapped->mapped = (size_t)status.st_size;
+  Surface_index(mapped);
+  *surface = mapped;
+  return 0;
+}
+
+void BallisticsSurface_free(BallisticsSurface* surface) {
+  if (!surface) return;
+  if (surface->mapped) munmap(surface->header, surface->mapped);
+  else free(surface->header);
+  free(surface);
+}
+
+void BallisticsSurface_get_config(const BallisticsSurface* surface, BallisticsSurfaceConfig* config) {
+  const SurfaceHeader* header = surface->header;
+  int a;
+
+  config->drag_function = (DragFunction)header->drag_function;
+  config->sight_height = header->sight_height;
+  for (a = 0; a < SURFACE_AXES; a++) {
+    config->axes[a].min = header->min[a];
+    config->axes[a].max = header->max[a];
+    config->axes[a].count = (int)header->count[a];
+  }
+}
+
+double BallisticsSurface_get_estimated_error(const BallisticsSurface* surface, BallisticsSurfaceOutput output) {
+  if (output < SURFACE_PATH || output >= SURFACE_OUTPUTS) return 0;
+  return surface->header->estimated_error[output];
+}
+
+void BallisticsSurface_set_tolerance(BallisticsSurface* surface, BallisticsSurfaceOutput output, double tolerance) {
+  if (output < SURFACE_PATH || output >= SURFACE_OUTPUTS) return;
+  surface->tolerance[output] = tolerance;
+}
+
+// Whether the builder's estimate for the cell a position lies in is within the tolerance in every output.
+static int Surface_tolerable(const BallisticsSurface* surface, const double* position) {
+  const SurfaceHeader* header = surface->header;
+  const double* errors;
+  size_t cell = 0;
+  int a, o;
+
+  for (a = 0; a < SURFACE_SHOT_AXES; a++) {
+    int i = (int)position[a];
+    i = i < (int)header->count[a] - 2 ? i : (int)header->count[a] - 2;
+    cell = cell * (header->count[a] - 1) + i;
+  }
+  errors = &surface->cell_errors[cell * SURFACE_OUTPUTS];
+  for (o = 0; o < SURFACE_OUTPUTS; o++) {
+    if (!(errors[o] <= surface->tolerance[o])) return 0;
+  }
+  return 1;
+}
+
+int BallisticsSurface_query(const BallisticsSurface* surface, BallisticsTarget* target, double drag_coefficient,
+                            double vi, double zero_range, double density_ratio, double shooting_angle,
+                            double crosswind) {
+  const SurfaceHeader* header = surface->header;
+  DragFunction drag_function = (DragFunction)header->drag_function;
+  double shot[SURFACE_AXES];
+  double position[SURFACE_AXES];
+  double out[SURFACE_OUTPUTS];
+  double x = target->range_yards*3;
+  int a;
+
+  if (!(drag_coefficient > 0) || !(density_ratio > 0) || !(vi > 0)) return SURFACE_E_ARGUMENTS;
+  shot[SURFACE_DRAG_COEFFICIENT] = drag_coefficient / density_ratio;
+  shot[SURFACE_VELOCITY] = vi;
+  shot[SURFACE_ZERO_RANGE] = zero_range;
+  shot[SURFACE_ANGLE] = shooting_angle;
+  shot[SURFACE_RANGE] = target->range_yards;
+
+  for (a = 0; a < SURFACE_AXES; a++) {
+    if (!(shot[a] >= header->min[a] && shot[a] <= header->max[a])) break;
+    position[a] = (shot[a] - header->min[a]) * surface->scale[a];
+  }
+  if (a < SURFACE_AXES || !Surface_tolerable(surface, position)) {
+    double angle = zero_angle(drag_function, shot[SURFACE_DRAG_COEFFICIENT], vi, header->sight_height, zero_range, 0);
+    int reached = Ballistics_solve_targets(target, 1, drag_function, shot[SURFACE_DRAG_COEFFICIENT], vi,
+                                           header->sight_height, shooting_angle, angle, crosswind, 90);
+    return reached == 1 ? SURFACE_SOLVED : SURFACE_E_OUT_OF_RANGE;
+  }
+
+  Surface_interpolate(surface, position, out);
+  target->path_inches = out[SURFACE_PATH];
+  target->moa_correction = -rad_to_moa(atan((out[SURFACE_PATH]/12) / x));
+  target->seconds = out[SURFACE_SECONDS];
+  target->windage_inches = crosswind*17.60 * out[SURFACE_LAG];
+  target->windage_moa = x > 0 ? rad_to_moa(atan((target->windage_inches/12) / x)) : 0;
+  target->v_fps = out[SURFACE_V];
+  return SURFACE_INTERPOLATED;
+}
@@ -0,0 +1,236 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/sweep.h"
+#include "ballistics/batch.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The work shared by every thread of a sweep, with what the sweep memoizes.
+ */
+typedef struct {
+  const BallisticsSweep* sweep;
+  BallisticsSweepCell* cells;
+  double form_factor;
+  double cwind;
+  double* zero_angles;   // per coefficient and velocity
+  double* stability;     // calculateGS() before its corrections, per twist and length
+  double* temperature;   // calculateGS()'s temperature correction, per atmosphere
+
+  atomic_long reached;
+  atomic_int cancelled;
+  atomic_int failed;     // a trajectory ran out of memory
+  pthread_mutex_t lock;  // serializes the progress callback
+  int done;
+  int total;
+} SweepJob;
+
+size_t BallisticsSweep_size(const BallisticsSweep* sweep) {
+  return (size_t)sweep->drag_coefficient_count * sweep->velocity_count * sweep->twist_count * sweep->length_count *
+         sweep->atmosphere_count * sweep->range_count;
+}
+
+size_t BallisticsSweep_index(const BallisticsSweep* sweep, int drag_coefficient, int velocity, int twist, int length,
+                             int atmosphere, int range) {
+  size_t index = drag_coefficient;
+  index = index * sweep->velocity_count + velocity;
+  index = index * sweep->twist_count + twist;
+  index = index * sweep->length_count + length;
+  index = index * sweep->atmosphere_count + atmosphere;
+  return index * sweep->range_count + range;
+}
+
+// The drag coefficient a load flies with in the given air, with the form factor applied as retardModified() does.
+static inline double Sweep_drag_coefficient(const SweepJob* job, double drag_coefficient,
+                                            const BallisticsSweepAtmosphere* air) {
+  return atmosphere_correction(drag_coefficient, air->altitude, air->barometer, air->temperature,
+                               air->relative_humidity) / job->form_factor;
+}
+
+// Counts one more trajectory finished, and cancels the sweep if the progress callback asks.
+static void Sweep_finished(SweepJob* job) {
+  const BallisticsSweep* sweep = job->sweep;
+  if (!sweep->progress) return;
+  pthread_mutex_lock(&job->lock);
+  job->done++;
+  if (!atomic_load(&job->cancelled) && sweep->progress(sweep->progress_context, job->done, job->total)) {
+    atomic_store(&job->cancelled, 1);
+  }
+  pthread_mutex_unlock(&job->lock);
+}
+
+static void Sweep_zero(void* context, int index) {
+  SweepJob* job = context;
+  const BallisticsSweep* sweep = job->sweep;
+  int b = index / sweep->velocity_count;
+  int v = index % sweep->velocity_count;
+
+  if (atomic_load(&job->cancelled)) return;
+  job->zero_angles[index] = zero_angle(sweep->drag_function,
+                                       Sweep_drag_coefficient(job, sweep->drag_coefficients[b],
+                                                              &sweep->zero_atmosphere),
+                                       sweep->velocities[v], sweep->sight_height, sweep->zero_range,
+                                       sweep->y_intercept);
+  Sweep_finished(job);
+}
+
+/**
+ * Solves one coefficient, velocity and atmosphere, and fills in every twist and length from it.  A trajectory the
+ * sweep was cancelled before solving, or that ran out of memory, leaves every target unreached, and so its cells
+ * zeroed.
+ */
+static void Sweep_trajectory(void* context, int index) {
+  SweepJob* job = context;
+  const BallisticsSweep* sweep = job->sweep;
+  int a = index % sweep->atmosphere_count;
+  int v = index / sweep->atmosphere_count % sweep->velocity_count;
+  int b = index / sweep->atmosphere_count / sweep->velocity_count;
+  int count = sweep->range_count;
+  BallisticsTarget* targets = malloc(sizeof(BallisticsTarget) * count + sizeof(double) * count);
+  double* velocity_correction;
+  long reached = 0;
+  int t, l, r;
+
+  if (!targets) {
+    atomic_store(&job->failed, 1);
+    return;
+  }
+  velocity_correction = (double*)(targets + count);
+
+  memset(targets, 0, sizeof(BallisticsTarget) * count);
+  if (!atomic_load(&job->cancelled)) {
+    for (r = 0; r < count; r++) targets[r].range_yards = sweep->ranges[r];
+    if (Ballistics_solve_targets(targets, count, sweep->drag_function,
+                                 Sweep_drag_coefficient(job, sweep->drag_coefficients[b], &sweep->atmospheres[a]),
+                                 sweep->velocities[v], sweep->sight_height, sweep->shooting_angle,
+                                 job->zero_angles[b * sweep->velocity_count + v], sweep->wind_speed,
+                                 sweep->wind_angle) < 0) {
+      atomic_store(&job->failed, 1);
+      memset(targets, 0, sizeof(BallisticsTarget) * count);
+    }
+    Sweep_finished(job);
+  }
+  for (r = 0; r < count; r++) velocity_correction[r] = BALLISTICS_CBRT(targets[r].v_fps/(double)2800);
+
+  for (t = 0; t < sweep->twist_count; t++) {
+    for (l = 0; l < sweep->length_count; l++) {
+      double stability = job->stability[t * sweep->length_count + l];
+      BallisticsSweepCell* cell = &job->cells[BallisticsSweep_index(sweep, b, v, t, l, a, 0)];
+
+      for (r = 0; r < count; r++, cell++) {
+        const BallisticsTarget* target = &targets[r];
+        double gs, deflection_moa;
+
+        if (target->v_fps == 0) {
+          memset(cell, 0, sizeof(BallisticsSweepCell));
+          continue;
+        }
+        // The same products and sums, in the same order, as calculateGS() and the solution's spin outputs.
+        gs = stability * velocity_correction[r] * job->temperature[a];
+        deflection_moa = calculateVerticalDeflection(gs, sweep->lengths[l], sweep->caliber) * job->cwind;
+        cell->path_inches = target->path_inches +
+                            tan(deflection_moa * (M_PI / (180.0 * 60.0))) * (target->range_yards*3);
+        cell->moa_correction = target->moa_correction + deflection_moa;
+        cell->seconds = target->seconds;
+        cell->windage_inches = target->windage_inches;
+        cell->spin_drift_inches = calculateSpinDriftOffsetIn(gs, target->seconds);
+        cell->v_fps = target->v_fps;
+        cell->stability = gs;
+        reached++;
+      }
+    }
+  }
+  atomic_fetch_add(&job->reached, reached);
+  free(targets);
+}
+
+// Whether every value of an axis is positive.
+static int Sweep_positive(const double* values, int count) {
+  int i;
+  if (!values || count <= 0) return 0;
+  for (i = 0; i < count; i++) {
+    if (!(values[i] > 0)) return 0;
+  }
+  return 1;
+}
+
+long Ballistics_sweep(const BallisticsSweep* sweep, BallisticsSweepCell* cells, double* zero_angles, int threads) {
+  SweepJob job;
+  int loads, trajectories;
+  int t, l, a;
+  long status;
+
+  if (!Sweep_positive(sweep->drag_coefficients, sweep->drag_coefficient_count) ||
+      !Sweep_positive(sweep->velocities, sweep->velocity_count) ||
+      !Sweep_positive(sweep->twists, sweep->twist_count) ||
+      !Sweep_positive(sweep->lengths, sweep->length_count) ||
+      !sweep->atmospheres || sweep->atmosphere_count <= 0 || !sweep->ranges || sweep->range_count <= 0 ||
+      !(sweep->caliber > 0) || sweep->form_factor < 0) {
+    return SWEEP_E_ARGUMENTS;
+  }
+  loads = sweep->drag_coefficient_count * sweep->velocity_count;
+  trajectories = loads * sweep->atmosphere_count;
+
+  memset(&job, 0, sizeof(job));
+  job.sweep = sweep;
+  job.cells = cells;
+  job.form_factor = sweep->form_factor > 0 ? sweep->form_factor : 1;
+  job.cwind = crosswind(sweep->wind_speed, sweep->wind_angle);
+  job.zero_angles = zero_angles ? zero_angles : malloc(sizeof(double) * loads);
+  job.stability = malloc(sizeof(double) * sweep->twist_count * sweep->length_count);
+  job.temperature = malloc(sizeof(double) * sweep->atmosphere_count);
+  if (!job.zero_angles || !job.stability || !job.temperature) {
+    status = SWEEP_E_NO_MEMORY;
+    goto done;
+  }
+  atomic_init(&job.reached, 0);
+  atomic_init(&job.cancelled, 0);
+  atomic_init(&job.failed, 0);
+  pthread_mutex_init(&job.lock, NULL);
+  job.total = loads + trajectories;
+
+  // At 2800 ft/s, 59 degrees and 29.92 in Hg both corrections are exactly 1, leaving the bullet and twist's part.
+  for (t = 0; t < sweep->twist_count; t++) {
+    for (l = 0; l < sweep->length_count; l++) {
+      job.stability[t * sweep->length_count + l] = calculateGS(sweep->bullet_grains, sweep->twists[t], sweep->caliber,
+                                                               sweep->lengths[l], 2800, 59, 29.92);
+    }
+  }
+  for (a = 0; a < sweep->atmosphere_count; a++) {
+    job.temperature[a] = ((sweep->atmospheres[a].temperature + 460) * 29.92) /
+                         ((59+460) * sweep->atmospheres[a].barometer);
+  }
+  memset(job.zero_angles, 0, sizeof(double) * loads);
+
+  Ballistics_parallel_for(loads, threads, Sweep_zero, &job);
+  Ballistics_parallel_for(trajectories, threads, Sweep_trajectory, &job);
+  pthread_mutex_destroy(&job.lock);
+
+  if (atomic_load(&job.cancelled)) status = SWEEP_E_CANCELLED;
+  else if (atomic_load(&job.failed)) status = SWEEP_E_NO_MEMORY;
+  else status = atomic_load(&job.reached);
+
+done:
+  if (job.zero_angles != zero_angles) free(job.zero_angles);
+  free(job.stability);
+  free(job.temperature);
+  return status;
+}
@@ -0,0 +1,73 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+namespace {
+  // zero_angle() bisects to 0.01 MOA and reads its trajectory at the first 1 ft step past the zero range rather
+  // than interpolating to it, which biases it by a few hundredths of a MOA wherever the projectile is crossing the
+  // line of sight steeply (short zeros, slow projectiles).
+  const double tolerance = moa_to_deg(0.1);
+
+  TEST(ZeroAnglesCheck, MatchesZeroAngle) {
+    double ranges[] = {600, 25, 100, 300, 50, 200, 450, 100};
+    const int count = sizeof(ranges) / sizeof(ranges[0]);
+    double angles[count];
+
+    ASSERT_EQ(0, zero_angles(angles, G7, 0.243, 2750, 1.75, ranges, NULL, count));
+    for (int i = 0; i < count; i++) {
+      EXPECT_NEAR(zero_angle(G7, 0.243, 2750, 1.75, ranges[i], 0), angles[i], tolerance);
+    }
+    EXPECT_EQ(angles[2], angles[7]);
+  }
+
+  TEST(ZeroAnglesCheck, FullTable) {
+    const int count = (600 - 25) / 25 + 1;
+    double ranges[count];
+    double angles[count];
+    for (int i = 0; i < count; i++) {
+      ranges[i] = 25 + 25 * i;
+    }
+
+    ASSERT_EQ(0, zero_angles(angles, G1, 0.5, 1200, 1.6, ranges, NULL, count));
+    for (int i = 0; i < count; i++) {
+      EXPECT_NEAR(zero_angle(G1, 0.5, 1200, 1.6, ranges[i], 0), angles[i], tolerance);
+    }
+  }
+
+  TEST(ZeroAnglesCheck, Intercepts) {
+    double ranges[] = {100, 200};
+    double intercepts[] = {1.5, -3};
+    double angles[2];
+
+    ASSERT_EQ(0, zero_angles(angles, G1, 0.48, 2800, 1.5, ranges, intercepts, 2));
+    for (int i = 0; i < 2; i++) {
+      EXPECT_NEAR(zero_angle(G1, 0.48, 2800, 1.5, ranges[i], intercepts[i]), angles[i], tolerance);
+    }
+  }
+
+  TEST(ZeroAnglesCheck, OutOfRange) {
+    double ranges[] = {100, 60000};
+    double angles[2];
+
+    EXPECT_EQ(ZERO_E_OUT_OF_RANGE, zero_angles(angles, G1, 0.5, 1200, 1.6, ranges, NULL, 2));
+    EXPECT_NEAR(zero_angle(G1, 0.5, 1200, 1.6, 100, 0), angles[0], tolerance);
+    EXPECT_TRUE(std::isnan(angles[1]));
+  }
+} // namespace
@@ -0,0 +1,99 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "ballistics/anytime.h"
+
+#include <cmath>
+
+static AnytimeSolver* start(int rows) {
+  AnytimeSolver* solver = NULL;
+  double angle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+  EXPECT_EQ(0, AnytimeSolver_start(&solver, rows, G7, 0.3, 2700, 1.6, 0, angle, 10, 90, 0.308, 1.24, 59, 29.92, 10,
+                                   2700, 175, 1));
+  return solver;
+}
+
+static Ballistics* solve_reference(int rows) {
+  Ballistics* reference = Ballistics_alloc();
+  double angle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+  Ballistics_set_row_limit(reference, rows);
+  Ballistics_solve_modified_vertDeflect_into(reference, G7, 0.3, 2700, 1.6, 0, angle, 10, 90, 0.308, 1.24, 59,
+                                             29.92, 10, 2700, 175, 1);
+  return reference;
+}
+
+static double max_path_difference(Ballistics* a, Ballistics* b, int rows) {
+  double worst = 0;
+  for (int i = 0; i < rows; i++) worst = fmax(worst, fabs(Ballistics_get_path(a, i) - Ballistics_get_path(b, i)));
+  return worst;
+}
+
+TEST(AnytimeCheck, EstimatesTrackTheError) {
+  AnytimeSolver* solver = start(2000);
+  Ballistics* reference = solve_reference(2000);
+
+  EXPECT_EQ(1, AnytimeSolver_get_level(solver));
+  EXPECT_EQ(16, AnytimeSolver_get_step(solver));
+  double last = INFINITY;
+  while (!AnytimeSolver_is_final(solver)) {
+    Ballistics* solution = AnytimeSolver_get_solution(solver);
+    ASSERT_EQ(2000, Ballistics_get_max_yardage(solution));
+    EXPECT_NEAR(1500, Ballistics_get_range(solution, 1500), 1e-9);
+
+    // The estimate is within a factor of two of the actual error, and shrinks with every level.
+    double error = AnytimeSolver_get_error(solver);
+    double actual = max_path_difference(solution, reference, 2000);
+    EXPECT_LT(error, last);
+    EXPECT_GT(error, actual / 2) << "level " << AnytimeSolver_get_level(solver);
+    EXPECT_LT(error, actual * 2) << "level " << AnytimeSolver_get_level(solver);
+    last = error;
+    // Exactly the steps of the next level, out to 2000 yards at half the step.
+    ASSERT_EQ(1, AnytimeSolver_refine(solver, 0, (long)(2000 * 3 * 2 / AnytimeSolver_get_step(solver))));
+  }
+  EXPECT_EQ(ANYTIME_LEVELS - 1, AnytimeSolver_get_level(solver));
+  EXPECT_EQ(0.5, AnytimeSolver_get_step(solver));
+  EXPECT_EQ(0, AnytimeSolver_get_error(solver));
+  EXPECT_EQ(0, AnytimeSolver_refine(solver, 0, 0));
+
+  // The last level is the full solve, exactly.
+  Ballistics* solution = AnytimeSolver_get_solution(solver);
+  ASSERT_EQ(2000, Ballistics_get_max_yardage(solution));
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_EQ(Ballistics_get_path(reference, i), Ballistics_get_path(solution, i)) << i;
+    ASSERT_EQ(Ballistics_get_time(reference, i), Ballistics_get_time(solution, i)) << i;
+    ASSERT_EQ(Ballistics_get_corrected_windage(reference, i), Ballistics_get_corrected_windage(solution, i)) << i;
+  }
+
+  Ballistics_free(reference);
+  AnytimeSolver_free(solver);
+}
+
+TEST(AnytimeCheck, KeepsToTheBudget) {
+  AnytimeSolver* solver = start(0);
+
+  // The next level steps every 8 feet over more than 5000 yards.
+  EXPECT_EQ(0, AnytimeSolver_refine(solver, 0, 1000));
+  EXPECT_EQ(1, AnytimeSolver_get_level(solver));
+  EXPECT_EQ(1, AnytimeSolver_refine(solver, 0, 3000));
+  EXPECT_EQ(2, AnytimeSolver_get_level(solver));
+
+  // A time budget far below the last level's time starts nothing; an ample one finishes.
+  EXPECT_EQ(0, AnytimeSolver_refine(solver, 1e-9, 0));
+  EXPECT_EQ(ANYTIME_LEVELS - 3, AnytimeSolver_refine(solver, 60, 0));
+  EXPECT_TRUE(AnytimeSolver_is_final(solver));
+  AnytimeSolver_free(solver);
+}
@@ -41,3 +41,229 @@ TEST(BallisticsCheck, PassMe) {
   EXPECT_DOUBLE_EQ(-1229.0334190298465, Ballistics_get_path(solution, 900));
   EXPECT_DOUBLE_EQ(-1580.0152706594765, Ballistics_get_path(solution, 1000));
 }
+
+TEST(BallisticsCheck, SolveTargetsMatchesTable) {
+  Ballistics* solution;
+  double bc = 0.5;
+  double fps = 1200;
+  double sightHeight = 1.6;
+  double zeroAngle = zero_angle(G1, bc, fps, sightHeight, 100, 0);
+  int nsoln = Ballistics_solve(&solution, G1, bc, fps, sightHeight, 0, zeroAngle, 10, 90);
+
+  // Deliberately unsorted, with a duplicate and a target the projectile never reaches.
+  int yards[] = {900, 100, 600, 300, 100, 60000};
+  const int count = sizeof(yards) / sizeof(yards[0]);
+  BallisticsTarget targets[count];
+  for (int i = 0; i < count; i++) {
+    // Each table row is recorded at the start of an integration step, so asking for exactly that range
+    // must land on the same point of the trajectory.
+    targets[i].range_yards = yards[i] < nsoln ? Ballistics_get_range(solution, yards[i]) : yards[i];
+  }
+  EXPECT_EQ(count - 1, Ballistics_solve_targets(targets, count, G1, bc, fps, sightHeight, 0, zeroAngle, 10, 90));
+
+  for (int i = 0; i < count - 1; i++) {
+    ASSERT_LT(yards[i], nsoln);
+    EXPECT_NEAR(Ballistics_get_path(solution, yards[i]), targets[i].path_inches, 1e-6);
+    EXPECT_NEAR(Ballistics_get_moa(solution, yards[i]), targets[i].moa_correction, 1e-6);
+    // The table pairs the range at the start of a step with the time at its end, so allow one step of time.
+    EXPECT_NEAR(Ballistics_get_time(solution, yards[i]), targets[i].seconds, 0.501 / targets[i].v_fps);
+    EXPECT_NEAR(Ballistics_get_v_fps(solution, yards[i]), targets[i].v_fps, 1e-6);
+  }
+  EXPECT_DOUBLE_EQ(targets[1].path_inches, targets[4].path_inches);
+  EXPECT_EQ(0, targets[5].path_inches);
+  EXPECT_EQ(0, targets[5].seconds);
+
+  Ballistics_free(solution);
+}
+
+TEST(BallisticsCheck, GetRowsMatchesAccessors) {
+  typedef double (*Accessor)(Ballistics*, int);
+  const Accessor accessors[] = {
+    Ballistics_get_range, Ballistics_get_path, Ballistics_get_moa, Ballistics_get_time,
+    Ballistics_get_windage, Ballistics_get_windage_moa, Ballistics_get_spindrift,
+    Ballistics_get_corrected_windage, Ballistics_get_corrected_windage_moa,
+    Ballistics_get_v_fps, Ballistics_get_vx_fps, Ballistics_get_vy_fps
+  };
+  double zeroAngle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+  Ballistics* solutions[2];
+  int nsoln[2];
+  nsoln[0] = Ballistics_solve(&solutions[0], G7, 0.3, 2700, 1.6, 0, zeroAngle, 10, 90);
+  nsoln[1] = Ballistics_solve_modified_vertDeflect(&solutions[1], G7, 0.3, 2700, 1.6, 0, zeroAngle, 10, 90,
+                                                   0.308, 1.24, 59, 29.92, 10, 2700, 175, 1);
+  double out[1000];
+  for (int s = 0; s < 2; s++) {
+    for (int f = BALLISTICS_RANGE; f <= BALLISTICS_VY; f++) {
+      ASSERT_EQ(1000, Ballistics_get_rows(solutions[s], (BallisticsField) f, 1, 1000, out));
+      for (int i = 0; i < 1000; i++) {
+        EXPECT_DOUBLE_EQ(accessors[f](solutions[s], i + 1), out[i]) << "field " << f << " yard " << i + 1;
+      }
+    }
+    EXPECT_EQ(10, Ballistics_get_rows(solutions[s], BALLISTICS_PATH, nsoln[s] - 10, 1000, out));
+    EXPECT_EQ(0, Ballistics_get_rows(solutions[s], BALLISTICS_PATH, nsoln[s], 1000, out));
+  }
+  EXPECT_NE(0, Ballistics_get_spindrift(solutions[1], 500));
+  EXPECT_EQ(0, Ballistics_get_spindrift(solutions[0], 500));
+
+  double path = Ballistics_get_path(solutions[1], 500);
+  Ballistics_compact(solutions[1]);
+  EXPECT_DOUBLE_EQ(path, Ballistics_get_path(solutions[1], 500));
+  Ballistics_free(solutions[0]);
+  Ballistics_free(solutions[1]);
+}
+
+// Every stored column of two solutions, compared bit for bit.
+static void ExpectSameRows(Ballistics* expected, Ballistics* actual, int rows) {
+  const BallisticsField stored[] = {BALLISTICS_TIME, BALLISTICS_V, BALLISTICS_VX, BALLISTICS_VY};
+  for (BallisticsField f : stored) {
+    const double* a = Ballistics_get_column(expected, f);
+    const double* b = Ballistics_get_column(actual, f);
+    for (int i = 0; i < rows; i++) ASSERT_EQ(a[i], b[i]) << "field " << f << " yard " << i;
+  }
+  for (int i = 0; i < rows; i++) {
+    ASSERT_EQ(Ballistics_get_range(expected, i), Ballistics_get_range(actual, i)) << "yard " << i;
+    ASSERT_EQ(Ballistics_get_path(expected, i), Ballistics_get_path(actual, i)) << "yard " << i;
+  }
+}
+
+TEST(BallisticsCheck, ExtendMatchesFullSolve) {
+  double zeroAngle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+  Ballistics* full;
+  int rows = Ballistics_solve_modified_vertDeflect(&full, G7, 0.3, 2700, 1.6, 5, zeroAngle, 10, 90,
+                                                   0.308, 1.24, 59, 29.92, 10, 2700, 175, 1);
+  ASSERT_GT(rows, 3000);
+  EXPECT_TRUE(Ballistics_is_complete(full));
+
+  Ballistics* pieces = Ballistics_alloc();
+  Ballistics_set_row_limit(pieces, 1000);
+  ASSERT_EQ(1000, Ballistics_solve_modified_vertDeflect_into(pieces, G7, 0.3, 2700, 1.6, 5, zeroAngle, 10, 90,
+                                                             0.308, 1.24, 59, 29.92, 10, 2700, 175, 1));
+  EXPECT_FALSE(Ballistics_is_complete(pieces));
+  ExpectSameRows(full, pieces, 1000);
+
+  // Compacting first makes the extension grow the columns again.
+  Ballistics_compact(pieces);
+  EXPECT_EQ(2000, Ballistics_extend(pieces, 2000));
+  EXPECT_EQ(2000, Ballistics_extend(pieces, 1500));
+  EXPECT_EQ(3000, Ballistics_extend(pieces, 3000));
+  ExpectSameRows(full, pieces, 3000);
+
+  EXPECT_EQ(rows, Ballistics_extend(pieces, BALLISTICS_COMPUTATION_MAX_YARDS));
+  EXPECT_TRUE(Ballistics_is_complete(pieces));
+  ExpectSameRows(full, pieces, rows);
+  EXPECT_EQ(rows, Ballistics_extend(pieces, BALLISTICS_COMPUTATION_MAX_YARDS));
+
+  Ballistics_free(full);
+  Ballistics_free(pieces);
+}
+
+TEST(BallisticsCheck, GetStateLandsOnTrajectory) {
+  double zeroAngle = zero_angle(G1, 0.5, 2800, 1.5, 200, 0);
+  Ballistics* solution;
+  int rows = Ballistics_solve(&solution, G1, 0.5, 2800, 1.5, 0, zeroAngle, 0, 0);
+  ASSERT_GT(rows, 1000);
+
+  const double ranges[] = {0, 0.25, 150.5, 199.99, 200, 400.3, 999.9};
+  for (double range : ranges) {
+    BallisticsState state;
+    ASSERT_EQ(0, Ballistics_get_state(solution, range, &state));
+    EXPECT_NEAR(range * 3, state.x, 1e-9) << range;
+
+    // Event location integrates the same trajectory from the muzzle and refines the same partial step.
+    BallisticsEvent event = {BallisticsEvent_range, &range, EVENTS_RISING, 1};
+    BallisticsEventHit hit;
+    if (range > 0) {
+      ASSERT_EQ(1, Ballistics_find_events(&hit, 1, &event, 1, G1, 0.5, 2800, 1.5, 0, zeroAngle, 0, 0, 0, 0));
+      EXPECT_NEAR(hit.state.y, state.y, 1e-9) << range;
+      EXPECT_NEAR(hit.state.t, state.t, 1e-9) << range;
+      EXPECT_NEAR(hit.state.v, state.v, 1e-6) << range;
+    }
+  }
+
+  BallisticsState state;
+  EXPECT_EQ(BALLISTICS_E_OUT_OF_RANGE, Ballistics_get_state(solution, -1, &state));
+  EXPECT_EQ(BALLISTICS_E_OUT_OF_RANGE, Ballistics_get_state(solution, rows + 1, &state));
+  Ballistics_free(solution);
+}
+
+TEST(BallisticsCheck, InclinedMatchesFullSolveWithinBound) {
+  double zeroAngle = zero_angle(G7, 0.243, 2750, 1.6, 100, 0);
+  Ballistics* level = Ballistics_alloc();
+  Ballistics_set_row_limit(level, 1500);
+  ASSERT_EQ(1500, Ballistics_solve_into(level, G7, 0.243, 2750, 1.6, 0, zeroAngle, 10, 90));
+  BallisticsIncline* incline;
+  ASSERT_EQ(0, BallisticsIncline_build(&incline, level));
+
+  Ballistics* derived = Ballistics_alloc();
+  Ballistics* full = Ballistics_alloc();
+  const double angles[] = {-60, -30, -5, 5, 15, 30, 60};
+  for (double angle : angles) {
+    double bound;
+    int rows = Ballistics_solve_inclined_into(derived, incline, angle, 2, &bound);
+    ASSERT_EQ(1500, rows) << angle;
+    EXPECT_GT(bound, 0) << angle;
+    EXPECT_LE(bound, 2) << angle;
+    ASSERT_GT(Ballistics_solve_into(full, G7, 0.243, 2750, 1.6, angle, zeroAngle, 10, 90), rows) << angle;
+
+    // The derived rows fall where the level shot's did, so the full solve is read at exactly the same ranges.
+    for (int i = 0; i < rows; i += 50) {
+      BallisticsState state;
+      ASSERT_EQ(0, Ballistics_get_state(full, Ballistics_get_range(derived, i), &state));
+      EXPECT_NEAR(state.y*12, Ballistics_get_path(derived, i), bound) << angle << " yard " << i;
+      EXPECT_NEAR(state.t, Ballistics_get_time(derived, i) - 0.5/Ballistics_get_v_fps(derived, i), 1e-3)
+          << angle << " yard " << i;
+      EXPECT_NEAR(state.v, Ballistics_get_v_fps(derived, i), 0.5) << angle << " yard " << i;
+    }
+
+    // And it carries on, like any solution, past the end of the cached shot.
+    EXPECT_EQ(2000, Ballistics_extend(derived, 2000)) << angle;
+    BallisticsState a, b;
+    ASSERT_EQ(0, Ballistics_get_state(derived, 1998.5, &a));
+    ASSERT_EQ(0, Ballistics_get_state(full, 1998.5, &b));
+    EXPECT_NEAR(b.y*12, a.y*12, 2*bound) << angle;
+  }
+
+  // At the cached angle the cached rows come back exactly.
+  double bound = -1;
+  ASSERT_EQ(1500, Ballistics_solve_inclined_into(derived, incline, 0, 0, &bound));
+  EXPECT_EQ(0, bound);
+  ExpectSameRows(level, derived, 1500);
+
+  // Past the tolerance, the shot is solved in full, exactly as its solver would.
+  Ballistics_set_row_limit(full, 0);
+  int rows = Ballistics_solve_inclined_into(derived, incline, 30, 1e-6, &bound);
+  EXPECT_EQ(0, bound);
+  EXPECT_EQ(Ballistics_solve_into(full, G7, 0.243, 2750, 1.6, 30, zeroAngle, 10, 90), rows);
+  ExpectSameRows(full, derived, rows);
+  EXPECT_TRUE(Ballistics_is_complete(derived));
+
+  BallisticsIncline_free(incline);
+  Ballistics_free(level);
+  Ballistics_free(derived);
+  Ballistics_free(full);
+}
+
+TEST(BallisticsCheck, InclinedKeepsSpinInputs) {
+  double zeroAngle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+  Ballistics* level;
+  Ballistics_solve_modified_vertDeflect(&level, G7, 0.3, 2700, 1.6, 0, zeroAngle, 10, 90,
+                                        0.308, 1.24, 59, 29.92, 10, 2700, 175, 1);
+  BallisticsIncline* incline;
+  ASSERT_EQ(0, BallisticsIncline_build(&incline, level));
+  Ballistics_free(level);
+
+  Ballistics* derived = Ballistics_alloc();
+  Ballistics* full;
+  double bound;
+  Ballistics_set_row_limit(derived, 1000);
+  ASSERT_EQ(1000, Ballistics_solve_inclined_into(derived, incline, 20, 1, &bound));
+  EXPECT_GT(bound, 0);
+  Ballistics_solve_modified_vertDeflect(&full, G7, 0.3, 2700, 1.6, 20, zeroAngle, 10, 90,
+                                        0.308, 1.24, 59, 29.92, 10, 2700, 175, 1);
+  EXPECT_NE(0, Ballistics_get_spindrift(derived, 800));
+  EXPECT_NEAR(Ballistics_get_spindrift(full, 800), Ballistics_get_spindrift(derived, 800), 0.01);
+  EXPECT_NEAR(Ballistics_get_corrected_windage(full, 800), Ballistics_get_corrected_windage(derived, 800), 0.05);
+
+  BallisticsIncline_free(incline);
+  Ballistics_free(derived);
+  Ballistics_free(full);
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/batch.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+static void count_visit(void* context, int index) {
+  (*static_cast<std::vector<std::atomic<int>>*>(context))[index]++;
+}
+
+TEST(BatchCheck, ParallelForVisitsEachIndexOnce) {
+  for (int threads : {1, 3, 0}) {
+    std::vector<std::atomic<int>> visits(1001);
+    Ballistics_parallel_for(1001, threads, count_visit, &visits);
+    for (int i = 0; i < 1001; i++) {
+      ASSERT_EQ(1, visits[i]) << "threads " << threads << " index " << i;
+    }
+  }
+}
+
+TEST(BatchCheck, MatchesScalarSolves) {
+  const int count = 40;
+  const int ranges = 5;
+  std::vector<BallisticsBatchItem> items(count);
+  std::vector<BallisticsTarget> targets(count * ranges);
+
+  for (int threads : {1, 4}) {
+    for (int i = 0; i < count; i++) {
+      BallisticsBatchItem& item = items[i];
+      item.drag_function = i % 2 ? G7 : G1;
+      item.drag_coefficient = 0.2 + 0.01 * i;
+      item.vi = 2000 + 25 * i;
+      item.sight_height = 1.5;
+      item.zero_range = 100 + 5 * i;
+      item.y_intercept = 0;
+      item.shooting_angle = i % 3;
+      item.wind_speed = 10;
+      item.wind_angle = 90;
+      item.targets = &targets[i * ranges];
+      item.target_count = ranges;
+      for (int r = 0; r < ranges; r++) item.targets[r].range_yards = 200 * (r + 1);
+    }
+    Ballistics_solve_batch(items.data(), count, threads);
+
+    for (int i = 0; i < count; i++) {
+      const BallisticsBatchItem& item = items[i];
+      double angle = zero_angle(item.drag_function, item.drag_coefficient, item.vi, item.sight_height,
+                                item.zero_range, 0);
+      BallisticsTarget expected[ranges];
+      for (int r = 0; r < ranges; r++) expected[r].range_yards = 200 * (r + 1);
+      int status = Ballistics_solve_targets(expected, ranges, item.drag_function, item.drag_coefficient, item.vi,
+                                            item.sight_height, item.shooting_angle, angle, 10, 90);
+      ASSERT_EQ(angle, item.zero_angle);
+      ASSERT_EQ(status, item.status);
+      for (int r = 0; r < ranges; r++) {
+        EXPECT_EQ(expected[r].path_inches, item.targets[r].path_inches);
+        EXPECT_EQ(expected[r].windage_inches, item.targets[r].windage_inches);
+        EXPECT_EQ(expected[r].seconds, item.targets[r].seconds);
+      }
+    }
+  }
+}
+
+// Every output of every row, bit for bit.
+static void expect_same_bits(Ballistics* expected, Ballistics* actual) {
+  int rows = Ballistics_get_max_yardage(expected);
+  ASSERT_EQ(rows, Ballistics_get_max_yardage(actual));
+  std::vector<double> a(rows), b(rows);
+  for (int field = BALLISTICS_RANGE; field <= BALLISTICS_VY; field++) {
+    Ballistics_get_rows(expected, (BallisticsField)field, 0, rows, a.data());
+    Ballistics_get_rows(actual, (BallisticsField)field, 0, rows, b.data());
+    EXPECT_EQ(0, memcmp(a.data(), b.data(), sizeof(double) * rows)) << "field " << field;
+  }
+}
+
+TEST(BatchCheck, SolutionsAreBitwiseScalarWhateverThreadsOrPosition) {
+  const int count = 24;
+  std::vector<BallisticsBatchItem> loads(count);
+  std::vector<Ballistics*> expected(count);
+
+  for (int i = 0; i < count; i++) {
+    BallisticsBatchItem& item = loads[i];
+    item.drag_function = i % 3 ? G7 : G1;
+    item.drag_coefficient = 0.22 + 0.013 * i;
+    item.vi = 2300 + 37 * i;
+    item.sight_height = 1.5 + 0.1 * (i % 4);
+    item.zero_range = 100 + 10 * (i % 5);
+    item.y_intercept = i % 2;
+    item.shooting_angle = i % 7 - 3;
+    item.wind_speed = i % 15;
+    item.wind_angle = 20 * i;
+
+    double angle = zero_angle(item.drag_function, item.drag_coefficient, item.vi, item.sight_height,
+                              item.zero_range, item.y_intercept);
+    ASSERT_GT(Ballistics_solve(&expected[i], item.drag_function, item.drag_coefficient, item.vi, item.sight_height,
+                               item.shooting_angle, angle, item.wind_speed, item.wind_angle), 0);
+  }
+
+  for (int threads : {1, 3, 0}) {
+    for (int reversed : {0, 1}) {
+      // Each load takes a different place in the batch when it is reversed.
+      std::vector<BallisticsBatchItem> items(count);
+      std::vector<Ballistics*> solutions(count);
+      for (int i = 0; i < count; i++) {
+        items[i] = loads[reversed ? count - 1 - i : i];
+        solutions[i] = Ballistics_alloc();
+      }
+      Ballistics_solve_batch_into(solutions.data(), items.data(), count, threads);
+
+      for (int i = 0; i < count; i++) {
+        int load = reversed ? count - 1 - i : i;
+        ASSERT_EQ(Ballistics_get_max_yardage(expected[load]), items[i].status);
+        expect_same_bits(expected[load], solutions[i]);
+        Ballistics_free(solutions[i]);
+      }
+    }
+  }
+  for (Ballistics* solution : expected) Ballistics_free(solution);
+}
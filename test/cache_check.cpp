@@ -0,0 +1,160 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+namespace {
+  class CacheTest : public ::testing::Test {
+  protected:
+    BallisticsCache* cache;
+
+    virtual void SetUp() {
+      cache = BallisticsCache_alloc(NULL);
+      ASSERT_TRUE(cache != NULL);
+    }
+
+    virtual void TearDown() {
+      BallisticsCache_free(cache);
+    }
+  };
+
+  TEST_F(CacheTest, SharesQuantizedSolutions) {
+    BallisticsCacheEntry* first;
+    BallisticsCacheEntry* second;
+    BallisticsCacheStats stats;
+
+    int n = BallisticsCache_solve(cache, &first, G1, 0.5, 1200, 1.6, 0, 0.2, 10.02, 90);
+    // Rounds to the same wind speed and bore angle.
+    EXPECT_EQ(n, BallisticsCache_solve(cache, &second, G1, 0.5, 1200, 1.6, 0, 0.200001, 9.98, 90));
+    EXPECT_EQ(BallisticsCacheEntry_ballistics(first), BallisticsCacheEntry_ballistics(second));
+
+    Ballistics* solution;
+    Ballistics_solve(&solution, G1, 0.5, 1200, 1.6, 0, 0.2, 10, 90);
+    EXPECT_EQ(Ballistics_get_windage(solution, 500), Ballistics_get_windage(BallisticsCacheEntry_ballistics(first), 500));
+    Ballistics_free(solution);
+
+    BallisticsCache_release(first);
+    BallisticsCache_release(second);
+
+    BallisticsCache_stats(cache, &stats);
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(1u, stats.entries);
+  }
+
+  TEST_F(CacheTest, ZeroAngleAndPBR) {
+    EXPECT_EQ(zero_angle(G1, 0.5, 1200, 1.6, 100, 0), BallisticsCache_zero_angle(cache, G1, 0.5, 1200, 1.6, 100, 0));
+    EXPECT_EQ(zero_angle(G1, 0.5, 1200, 1.6, 100, 0), BallisticsCache_zero_angle(cache, G1, 0.5, 1200, 1.6, 100, 0));
+
+    BallisticsCacheEntry* entry;
+    ASSERT_EQ(0, BallisticsCache_PBR_solve(cache, &entry, G1, 0.48, 2800, 1.5, 4));
+    EXPECT_EQ(238, PBR_get_max_PBR_yards(BallisticsCacheEntry_pbr(entry)));
+    BallisticsCache_release(entry);
+
+    BallisticsCacheStats stats;
+    BallisticsCache_stats(cache, &stats);
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+  }
+
+  TEST_F(CacheTest, RefusesInputsWithNoMultiple) {
+    BallisticsCacheEntry* entry = NULL;
+    // An unreachable zero from zero_angles() is NaN; solving with it would never end.
+    double unreachable = NAN;
+    EXPECT_EQ(BALLISTICS_E_ARGUMENTS, BallisticsCache_solve(cache, &entry, G1, 0.5, 1200, 1.6, 0, unreachable, 0, 0));
+    EXPECT_EQ(NULL, entry);
+    EXPECT_EQ(BALLISTICS_E_ARGUMENTS, BallisticsCache_solve(cache, &entry, G1, 0.5, INFINITY, 1.6, 0, 0.2, 0, 0));
+    EXPECT_TRUE(std::isnan(BallisticsCache_zero_angle(cache, G1, 0.5, 1200, 1.6, NAN, 0)));
+    EXPECT_EQ(PBR_E_ARGUMENTS, BallisticsCache_PBR_solve(cache, &entry, G1, 0.48, 2800, 1.5, -INFINITY));
+    EXPECT_EQ(NULL, entry);
+
+    // Inputs far too large to round are kept exactly, each with an entry of its own.
+    BallisticsCacheEntry* first;
+    BallisticsCacheEntry* second;
+    int n = BallisticsCache_solve(cache, &first, G1, 0.5, 1200, 1.6, 0, 0.2, 10, 1e300);
+    EXPECT_EQ(n, BallisticsCache_solve(cache, &second, G1, 0.5, 1200, 1.6, 0, 0.2, 10, -1e300));
+    EXPECT_NE(BallisticsCacheEntry_ballistics(first), BallisticsCacheEntry_ballistics(second));
+    Ballistics* solution;
+    Ballistics_solve(&solution, G1, 0.5, 1200, 1.6, 0, 0.2, 10, -1e300);
+    EXPECT_EQ(Ballistics_get_windage(solution, 300),
+              Ballistics_get_windage(BallisticsCacheEntry_ballistics(second), 300));
+    Ballistics_free(solution);
+    BallisticsCache_release(first);
+    BallisticsCache_release(second);
+
+    BallisticsCacheStats stats;
+    BallisticsCache_stats(cache, &stats);
+    EXPECT_EQ(0u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+  }
+
+  TEST(CacheCheck, EvictsWithinBudget) {
+    BallisticsCacheConfig config;
+    BallisticsCache_default_config(&config);
+    config.memory_budget = 16 << 20;
+    BallisticsCache* cache = BallisticsCache_alloc(&config);
+
+    // Hold on to one entry across its eviction; it must stay readable.
+    BallisticsCacheEntry* held;
+    BallisticsCache_solve(cache, &held, G1, 0.5, 1200, 1.6, 0, 0.2, 0, 0);
+    double path = Ballistics_get_path(BallisticsCacheEntry_ballistics(held), 300);
+
+    for (int i = 1; i <= 100; i++) {
+      BallisticsCacheEntry* entry;
+      BallisticsCache_solve(cache, &entry, G1, 0.5, 1200 + i, 1.6, 0, 0.2, 0, 0);
+      BallisticsCache_release(entry);
+    }
+
+    BallisticsCacheStats stats;
+    BallisticsCache_stats(cache, &stats);
+    EXPECT_LE(stats.bytes, config.memory_budget);
+    EXPECT_LT(0u, stats.evictions);
+    EXPECT_EQ(101u, stats.misses);
+    EXPECT_EQ(stats.misses, stats.entries + stats.evictions);
+    EXPECT_EQ(path, Ballistics_get_path(BallisticsCacheEntry_ballistics(held), 300));
+
+    BallisticsCache_release(held);
+    BallisticsCache_free(cache);
+  }
+
+  TEST_F(CacheTest, Concurrent) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+      threads.push_back(std::thread([this, t]() {
+        for (int i = 0; i < 40; i++) {
+          BallisticsCacheEntry* entry;
+          int n = BallisticsCache_solve(cache, &entry, G7, 0.25, 2700 + (i + t) % 10, 1.5, 0, 0.05, 0, 0);
+          EXPECT_LT(1000, n);
+          EXPECT_GT(0, Ballistics_get_path(BallisticsCacheEntry_ballistics(entry), 1000));
+          BallisticsCache_release(entry);
+        }
+      }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+    }
+
+    BallisticsCacheStats stats;
+    BallisticsCache_stats(cache, &stats);
+    EXPECT_EQ(320u, stats.hits + stats.misses);
+    EXPECT_EQ(10u, stats.entries);
+  }
+} // namespace
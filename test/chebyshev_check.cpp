@@ -0,0 +1,91 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/chebyshev.h"
+
+#include <cmath>
+#include <vector>
+
+static Ballistics* solve(DragFunction df, double bc, double vi, int rows) {
+  Ballistics* solution = Ballistics_alloc();
+  double angle = zero_angle(df, bc, vi, 1.5, 100, 0);
+  Ballistics_set_row_limit(solution, rows);
+  Ballistics_solve_into(solution, df, bc, vi, 1.5, 0, angle, 10, 90);
+  return solution;
+}
+
+TEST(ChebyshevCheck, FitIsWithinToleranceAtEveryRow) {
+  const double tolerances[CHEBYSHEV_CHANNELS] = {0.005, 2e-6, 0.05, 2e-6};
+  // G7 puts the most kinks in the velocity through the transonic region.
+  for (DragFunction df : {G1, G7}) {
+    Ballistics* solution = solve(df, 0.25, 2800, 2001);
+    ChebyshevTrajectory* fit = NULL;
+    ASSERT_EQ(0, ChebyshevTrajectory_fit(&fit, solution, tolerances));
+
+    int rows = Ballistics_get_max_yardage(solution);
+    EXPECT_DOUBLE_EQ(Ballistics_get_range(solution, rows - 1), ChebyshevTrajectory_get_max_range(fit));
+    EXPECT_LT(ChebyshevTrajectory_size(fit), 4000u);
+    for (int i = 0; i < rows; i++) {
+      double range = Ballistics_get_range(solution, i);
+      ASSERT_NEAR(Ballistics_get_path(solution, i), ChebyshevTrajectory_get(fit, CHEBYSHEV_PATH, range),
+                  tolerances[CHEBYSHEV_PATH]) << df << " " << i;
+      ASSERT_NEAR(Ballistics_get_time(solution, i), ChebyshevTrajectory_get(fit, CHEBYSHEV_TIME, range),
+                  tolerances[CHEBYSHEV_TIME]) << df << " " << i;
+      ASSERT_NEAR(Ballistics_get_v_fps(solution, i), ChebyshevTrajectory_get(fit, CHEBYSHEV_VELOCITY, range),
+                  tolerances[CHEBYSHEV_VELOCITY]) << df << " " << i;
+      // The solution's 10 mi/hr wind is straight across.
+      ASSERT_NEAR(Ballistics_get_windage(solution, i), ChebyshevTrajectory_get_windage(fit, range, 10),
+                  10*17.6*tolerances[CHEBYSHEV_LAG]) << df << " " << i;
+    }
+    EXPECT_EQ(0, ChebyshevTrajectory_get(fit, CHEBYSHEV_PATH, -1));
+    EXPECT_EQ(0, ChebyshevTrajectory_get(fit, CHEBYSHEV_PATH, ChebyshevTrajectory_get_max_range(fit) + 1));
+
+    ChebyshevTrajectory_free(fit);
+    Ballistics_free(solution);
+  }
+}
+
+TEST(ChebyshevCheck, BytesLoadBackExactly) {
+  Ballistics* solution = solve(G1, 0.5, 2900, 1001);
+  ChebyshevTrajectory* fit = NULL;
+  ChebyshevTrajectory* loaded = NULL;
+  ASSERT_EQ(0, ChebyshevTrajectory_fit(&fit, solution, NULL));
+
+  const unsigned char* bytes = (const unsigned char*)ChebyshevTrajectory_bytes(fit);
+  std::vector<unsigned char> copy(bytes, bytes + ChebyshevTrajectory_size(fit));
+  ASSERT_EQ(0, ChebyshevTrajectory_load(&loaded, copy.data(), copy.size()));
+  for (double range = 0; range <= 1000; range += 12.5) {
+    for (int c = 0; c < CHEBYSHEV_CHANNELS; c++) {
+      EXPECT_EQ(ChebyshevTrajectory_get(fit, (ChebyshevChannel)c, range),
+                ChebyshevTrajectory_get(loaded, (ChebyshevChannel)c, range));
+    }
+  }
+  ChebyshevTrajectory_free(loaded);
+
+  // Truncated, or damaged, it is refused.
+  EXPECT_EQ(CHEBYSHEV_E_FORMAT, ChebyshevTrajectory_load(&loaded, copy.data(), copy.size() - 8));
+  copy[0] = 'X';
+  EXPECT_EQ(CHEBYSHEV_E_FORMAT, ChebyshevTrajectory_load(&loaded, copy.data(), copy.size()));
+  EXPECT_EQ(NULL, loaded);
+
+  const double zero[CHEBYSHEV_CHANNELS] = {0.01, 0, 0.1, 1e-5};
+  EXPECT_EQ(CHEBYSHEV_E_ARGUMENTS, ChebyshevTrajectory_fit(&loaded, solution, zero));
+
+  ChebyshevTrajectory_free(fit);
+  Ballistics_free(solution);
+}
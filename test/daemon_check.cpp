@@ -0,0 +1,252 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/batch.h"
+#include "ballistics/daemon.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs ballisticsd on a socket of its own for the length of a test.
+class Daemon {
+ public:
+  Daemon() {
+    snprintf(path_, sizeof(path_), "/tmp/daemon_check%d.sock", (int)getpid());
+    pid_ = fork();
+    if (pid_ == 0) {
+      execl(BALLISTICSD_PATH, "ballisticsd", "-s", path_, "-j", "2", "-w", "0", (char*)NULL);
+      _exit(127);
+    }
+  }
+
+  ~Daemon() {
+    if (pid_ > 0) {
+      kill(pid_, SIGTERM);
+      waitpid(pid_, NULL, 0);
+    }
+  }
+
+  // Connects, waiting for the daemon to start listening.
+  int connect_to() const {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path_);
+    for (int attempt = 0; attempt < 500; attempt++) {
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0) return fd;
+      if (fd >= 0) close(fd);
+      usleep(10000);
+    }
+    return -1;
+  }
+
+  // The daemon's resident memory, in kB, or -1 if it can't be read.
+  long resident_kb() const {
+    char path[64], line[256];
+    long kb = -1;
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid_);
+    FILE* status = fopen(path, "r");
+    if (!status) return -1;
+    while (fgets(line, sizeof(line), status)) {
+      if (sscanf(line, "VmRSS: %ld", &kb) == 1) break;
+    }
+    fclose(status);
+    return kb;
+  }
+
+ private:
+  char path_[64];
+  pid_t pid_;
+};
+
+static bool write_all(int fd, const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t n = write(fd, bytes, size);
+    if (n <= 0) return false;
+    bytes += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+static bool read_all(int fd, void* data, size_t size) {
+  char* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t n = read(fd, bytes, size);
+    if (n <= 0) return false;
+    bytes += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+// Reads one response, header first and then as many targets as it says it has.
+static bool read_response(int fd, BallisticsdResponse* response) {
+  size_t header = BallisticsdResponse_size(0);
+  if (!read_all(fd, response, header)) return false;
+  if (response->target_count < 0 || response->target_count > BALLISTICSD_MAX_TARGETS) return false;
+  return read_all(fd, (char*)response + header, BallisticsdResponse_size(response->target_count) - header);
+}
+
+static BallisticsdRequest load(uint32_t id, double vi) {
+  BallisticsdRequest request;
+  memset(&request, 0, sizeof(request));
+  request.magic = BALLISTICSD_MAGIC;
+  request.id = id;
+  request.drag_function = G7;
+  request.target_count = 3;
+  request.drag_coefficient = 0.3;
+  request.vi = vi;
+  request.sight_height = 1.5;
+  request.zero_range = 100;
+  request.y_intercept = 0.5;
+  request.shooting_angle = 5;
+  request.wind_speed = 10;
+  request.wind_angle = 90;
+  request.ranges[0] = 100;
+  request.ranges[1] = 350;
+  request.ranges[2] = 600;
+  return request;
+}
+
+TEST(DaemonCheck, AnswersAsTheBatchSolverDoes) {
+  Daemon daemon;
+  int fd = daemon.connect_to();
+  ASSERT_GE(fd, 0);
+
+  // The same solve Ballistics_solve_batch() makes locally.
+  BallisticsdRequest request = load(7, 2700);
+  BallisticsTarget targets[3];
+  BallisticsBatchItem item;
+  memset(&item, 0, sizeof(item));
+  item.drag_function = G7;
+  item.drag_coefficient = request.drag_coefficient;
+  item.vi = request.vi;
+  item.sight_height = request.sight_height;
+  item.zero_range = request.zero_range;
+  item.y_intercept = request.y_intercept;
+  item.shooting_angle = request.shooting_angle;
+  item.wind_speed = request.wind_speed;
+  item.wind_angle = request.wind_angle;
+  item.targets = targets;
+  item.target_count = 3;
+  for (int i = 0; i < 3; i++) targets[i].range_yards = request.ranges[i];
+  Ballistics_solve_batch(&item, 1, 1);
+
+  // Once solved and once from the cache, both answered in full and matched by id.
+  for (uint32_t id : {7u, 8u}) {
+    request.id = id;
+    ASSERT_TRUE(write_all(fd, &request, BallisticsdRequest_size(request.target_count)));
+    BallisticsdResponse response;
+    ASSERT_TRUE(read_response(fd, &response));
+    EXPECT_EQ(BALLISTICSD_MAGIC, response.magic);
+    EXPECT_EQ(id, response.id);
+    EXPECT_EQ(item.status, response.status);
+    EXPECT_EQ(3, response.target_count);
+    EXPECT_EQ(item.zero_angle, response.zero_angle);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_EQ(targets[i].path_inches, response.targets[i].path_inches) << i;
+      EXPECT_EQ(targets[i].windage_inches, response.targets[i].windage_inches) << i;
+      EXPECT_EQ(targets[i].seconds, response.targets[i].seconds) << i;
+    }
+  }
+
+  // A request the solver can't take is answered with an error rather than dropped.
+  BallisticsdRequest bad = load(9, 2700);
+  bad.drag_function = 0;
+  ASSERT_TRUE(write_all(fd, &bad, BallisticsdRequest_size(bad.target_count)));
+  BallisticsdResponse response;
+  ASSERT_TRUE(read_response(fd, &response));
+  EXPECT_EQ(9u, response.id);
+  EXPECT_EQ(BALLISTICSD_E_BAD_REQUEST, response.status);
+  EXPECT_EQ(0, response.target_count);
+  close(fd);
+}
+
+TEST(DaemonCheck, AnswersEveryPipelinedRequest) {
+  Daemon daemon;
+  int fd = daemon.connect_to();
+  ASSERT_GE(fd, 0);
+
+  // Duplicates sent back to back are joined onto one solve, but each still gets its own response.
+  const int count = 12;
+  for (int i = 0; i < count; i++) {
+    BallisticsdRequest request = load(100 + i, 2600 + 50 * (i % 3));
+    ASSERT_TRUE(write_all(fd, &request, BallisticsdRequest_size(request.target_count)));
+  }
+  bool seen[count] = {};
+  double angles[3] = {0, 0, 0};
+  for (int i = 0; i < count; i++) {
+    BallisticsdResponse response;
+    ASSERT_TRUE(read_response(fd, &response));
+    ASSERT_GE(response.id, 100u);
+    ASSERT_LT(response.id, 100u + count);
+    int index = (int)response.id - 100;
+    EXPECT_FALSE(seen[index]) << index;
+    seen[index] = true;
+    EXPECT_EQ(3, response.status);
+    if (angles[index % 3] == 0) angles[index % 3] = response.zero_angle;
+    EXPECT_EQ(angles[index % 3], response.zero_angle) << index;
+  }
+  close(fd);
+}
+
+TEST(DaemonCheck, StopsReadingAClientThatDoesntRead) {
+  Daemon daemon;
+  int fd = daemon.connect_to();
+  ASSERT_GE(fd, 0);
+
+  // Each response is about 4 kB, so these come to 16 MB of answers, four times what a connection may have queued.
+  const int count = 4000;
+  BallisticsdRequest request = load(0, 2700);
+  request.target_count = BALLISTICSD_MAX_TARGETS;
+  for (int i = 0; i < BALLISTICSD_MAX_TARGETS; i++) request.ranges[i] = 10 * (i + 1);
+  ASSERT_TRUE(write_all(fd, &request, BallisticsdRequest_size(request.target_count)));
+  BallisticsdResponse response;
+  ASSERT_TRUE(read_response(fd, &response));
+  long before = daemon.resident_kb();
+
+  std::thread writer([&] {
+    for (int i = 1; i <= count; i++) {
+      BallisticsdRequest copy = request;
+      copy.id = i;
+      if (!write_all(fd, &copy, BallisticsdRequest_size(copy.target_count))) return;
+    }
+  });
+  // Let the daemon answer all it will while nothing is read.
+  usleep(300000);
+  long stalled = daemon.resident_kb();
+  if (before > 0 && stalled > 0) EXPECT_LT(stalled - before, 8 << 10);
+
+  // Once the client reads, every request is answered after all.
+  for (int i = 1; i <= count; i++) {
+    ASSERT_TRUE(read_response(fd, &response)) << i;
+    ASSERT_EQ((uint32_t)i, response.id);
+    ASSERT_EQ(BALLISTICSD_MAX_TARGETS, response.target_count);
+  }
+  writer.join();
+  close(fd);
+}
@@ -0,0 +1,156 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+namespace {
+  class DragFitTest : public ::testing::Test {
+  protected:
+    std::vector<std::string> paths;
+
+    // Writes simulated radar tracks of a G7 projectile, two shots to a file.
+    virtual void SetUp() {
+      for (int f = 0; f < 3; f++) {
+        Ballistics* solution;
+        double vi = 2700 + 100 * f;
+        int n = Ballistics_solve(&solution, G7, 0.25, vi, 0, 0, 0, 0, 0);
+        paths.push_back(::testing::TempDir() + "dragfit_track" + std::to_string(f) + ".txt");
+        FILE* track = fopen(paths.back().c_str(), "w");
+        ASSERT_TRUE(track != NULL);
+        for (int shot = 0; shot < 2; shot++) {
+          fprintf(track, "# shot %d\n", shot);
+          for (int yards = 0; yards < n && yards <= 2000; yards++) {
+            fprintf(track, "%.6f, %.6f\n", Ballistics_get_range(solution, yards) * 3,
+                    Ballistics_get_v_fps(solution, yards));
+          }
+        }
+        fclose(track);
+        Ballistics_free(solution);
+      }
+    }
+
+    virtual void TearDown() {
+      for (size_t i = 0; i < paths.size(); i++) {
+        remove(paths[i].c_str());
+      }
+    }
+
+    long Fit(DragTable* table, int threads) {
+      double edges[DRAG_TABLE_MAX_BANDS];
+      int bands = 0;
+      for (double v = 500; v < 3500; v += 50) {
+        edges[bands++] = v;
+      }
+      std::vector<const char*> files;
+      for (size_t i = 0; i < paths.size(); i++) {
+        files.push_back(paths[i].c_str());
+      }
+      return DragFit_fit_files(table, files.data(), (int)files.size(), edges, bands, 0.25, 4, threads);
+    }
+  };
+
+  TEST_F(DragFitTest, ReproducesTrajectory) {
+    DragTable table;
+    ASSERT_LT(0, Fit(&table, 0));
+
+    Ballistics* reference;
+    Ballistics* fitted;
+    Ballistics_solve(&reference, G7, 0.25, 2800, 1.5, 0, 0.05, 0, 0);
+    Ballistics_solve_table(&fitted, &table, 0.25, 2800, 1.5, 0, 0.05, 0, 0);
+    for (int yards = 100; yards <= 1500; yards += 100) {
+      EXPECT_NEAR(Ballistics_get_v_fps(reference, yards), Ballistics_get_v_fps(fitted, yards), 3) << yards;
+      EXPECT_NEAR(Ballistics_get_time(reference, yards), Ballistics_get_time(fitted, yards), 2e-3) << yards;
+    }
+    EXPECT_NEAR(zero_angle(G7, 0.25, 2800, 1.5, 300, 0), zero_angle_table(&table, 0.25, 2800, 1.5, 300, 0), 1e-3);
+    Ballistics_free(reference);
+    Ballistics_free(fitted);
+  }
+
+  TEST_F(DragFitTest, IndependentOfThreadCount) {
+    DragTable one, many;
+    ASSERT_EQ(Fit(&one, 1), Fit(&many, 3));
+    ASSERT_EQ(one.count, many.count);
+    for (int i = 0; i < one.count; i++) {
+      EXPECT_EQ(one.bands[i].acceleration, many.bands[i].acceleration);
+      EXPECT_EQ(one.bands[i].mass, many.bands[i].mass);
+    }
+  }
+
+  TEST_F(DragFitTest, TableRoundTrip) {
+    DragTable table, read;
+    ASSERT_LT(0, Fit(&table, 2));
+    std::string path = ::testing::TempDir() + "dragfit_table.txt";
+    FILE* file = fopen(path.c_str(), "w+");
+    ASSERT_EQ(0, DragTable_write(&table, file));
+    rewind(file);
+    ASSERT_EQ(0, DragTable_read(&read, file));
+    fclose(file);
+    remove(path.c_str());
+
+    ASSERT_EQ(table.count, read.count);
+    for (int i = 0; i < table.count; i++) {
+      EXPECT_EQ(table.bands[i].velocity, read.bands[i].velocity);
+      EXPECT_EQ(table.bands[i].acceleration, read.bands[i].acceleration);
+      EXPECT_EQ(table.bands[i].mass, read.bands[i].mass);
+    }
+  }
+
+  // Reads a table from text, as a file would hold it.
+  static int ReadTable(DragTable* table, const std::string& text) {
+    FILE* file = tmpfile();
+    fputs(text.c_str(), file);
+    rewind(file);
+    int status = DragTable_read(table, file);
+    fclose(file);
+    return status;
+  }
+
+  TEST(DragFitCheck, TableReadRefusesMalformedTables) {
+    DragTable table;
+    ASSERT_EQ(0, ReadTable(&table, "# velocity acceleration mass\n\n3000 1e-4 1.5\n  \n1000 2e-4 1.4\n"));
+    EXPECT_EQ(2, table.count);
+    EXPECT_EQ(1000, table.bands[1].velocity);
+
+    // retard_table() takes the first band the velocity is above, so out of order the slow band would shadow the
+    // fast one.
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, "1000 2e-4 1.4\n3000 1e-4 1.5\n"));
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, "3000 1e-4 1.5\n3000 2e-4 1.4\n"));
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, "3000 1e-4 1.5\n1000 2e-4\n"));
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, "3000 1e-4 1.5 fast\n"));
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, "3000 nan 1.5\n"));
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, "3000 1e-4 inf\n"));
+    EXPECT_EQ(DRAGFIT_E_NO_DATA, ReadTable(&table, "# nothing\n"));
+
+    std::string full;
+    for (int i = 0; i <= DRAG_TABLE_MAX_BANDS; i++) full += std::to_string(5000 - 10*i) + " 1e-4 1.5\n";
+    EXPECT_EQ(DRAGFIT_E_FORMAT, ReadTable(&table, full));
+    full.erase(full.rfind('\n', full.size() - 2) + 1);
+    EXPECT_EQ(0, ReadTable(&table, full));
+    EXPECT_EQ(DRAG_TABLE_MAX_BANDS, table.count);
+  }
+
+  TEST(DragFitCheck, MissingFile) {
+    DragTable table;
+    const char* paths[] = {"/nonexistent/track.txt"};
+    double edges[] = {1000};
+    EXPECT_EQ(DRAGFIT_E_IO, DragFit_fit_files(&table, paths, 1, edges, 1, 1, 4, 1));
+  }
+} // namespace
@@ -0,0 +1,98 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+#include <cmath>
+
+TEST(EmbeddedCheck, FastMathMatchesLibm) {
+  for (double x = 1e-3; x < 1e5; x *= 1.0137) {
+    EXPECT_NEAR(std::log2(x), fast_log2(x), 1e-12) << x;
+    EXPECT_NEAR(std::cbrt(x), fast_cbrt(x), 1e-12 * std::cbrt(x)) << x;
+    EXPECT_NEAR(std::cbrt(-x), fast_cbrt(-x), 1e-12 * std::cbrt(x)) << x;
+    EXPECT_NEAR(std::atan(x), fast_atan(x), 1e-12) << x;
+    EXPECT_NEAR(std::atan(-x), fast_atan(-x), 1e-12) << x;
+  }
+  // The drag functions' exponents run from about 1.1 to 7.9 over velocities up to 10000 ft/s.
+  for (double vp = 1; vp < 10000; vp *= 1.0371) {
+    for (double mass = 1.1; mass < 8; mass += 0.37) {
+      double expected = std::pow(vp, mass);
+      EXPECT_NEAR(expected, fast_pow(vp, mass), 1e-11 * expected) << vp << "^" << mass;
+    }
+  }
+  for (double z = -60; z < 60; z += 0.173) {
+    EXPECT_NEAR(std::exp2(z), fast_exp2(z), 1e-13 * std::exp2(z)) << z;
+  }
+  EXPECT_EQ(0, fast_cbrt(0));
+  EXPECT_EQ(0, fast_atan(0));
+  EXPECT_EQ(0, fast_pow(0, 2));
+}
+
+TEST(EmbeddedCheck, SolveMatchesFullPrecision) {
+  // The full-precision build's table from BallisticsCheck.PassMe.
+  const double paths[] = {
+    0.021086942030323762, -25.871778035601729, -82.458422497938699, -172.74938891261581, -299.58523278666632,
+    -465.99531684228566, -674.45631229315825, -927.58052626524727, -1229.0334190298465, -1580.0152706594765
+  };
+  Ballistics* solution;
+  double zeroAngle = zero_angle(G1, 0.5, 1200, 1.6, 100, 0);
+  ASSERT_LT(1000, Ballistics_solve(&solution, G1, 0.5, 1200, 1.6, 0, zeroAngle, 10, 90));
+  for (int i = 0; i < 10; i++) {
+    EXPECT_NEAR(paths[i], Ballistics_get_path(solution, 100 * (i + 1)), 1e-6);
+  }
+  Ballistics_free(solution);
+
+  struct PBR* pbr;
+  ASSERT_EQ(0, PBR_solve(&pbr, G1, 0.48, 2800, 1.5, 4));
+  EXPECT_EQ(238, PBR_get_max_PBR_yards(pbr));
+  PBR_free(pbr);
+}
+
+#ifdef BALLISTICS_EMBEDDED
+TEST(EmbeddedCheck, PoolsAreBounded) {
+  Ballistics* solutions[BALLISTICS_EMBEDDED_SOLUTIONS + 1];
+  double zeroAngle = zero_angle(G7, 0.3, 3000, 1.6, 100, 0);
+
+  for (int i = 0; i < BALLISTICS_EMBEDDED_SOLUTIONS; i++) {
+    // A flat, fast shot would carry well past the table, so it has to stop at the end of it.
+    EXPECT_EQ(BALLISTICS_EMBEDDED_MAX_YARDS,
+              Ballistics_solve(&solutions[i], G7, 0.3, 3000, 1.6, 0, zeroAngle, 0, 0));
+  }
+  EXPECT_EQ(BALLISTICS_E_NO_MEMORY,
+            Ballistics_solve(&solutions[BALLISTICS_EMBEDDED_SOLUTIONS], G7, 0.3, 3000, 1.6, 0, zeroAngle, 0, 0));
+  Ballistics_free(solutions[0]);
+  EXPECT_EQ(BALLISTICS_EMBEDDED_MAX_YARDS, Ballistics_solve(&solutions[0], G7, 0.3, 3000, 1.6, 0, zeroAngle, 0, 0));
+  for (int i = 0; i < BALLISTICS_EMBEDDED_SOLUTIONS; i++) {
+    Ballistics_free(solutions[i]);
+  }
+
+  struct PBR* pbrs[BALLISTICS_EMBEDDED_PBRS + 1];
+  for (int i = 0; i < BALLISTICS_EMBEDDED_PBRS; i++) {
+    ASSERT_EQ(0, PBR_solve(&pbrs[i], G1, 0.5, 3000, 1.6, 6));
+  }
+  EXPECT_EQ(PBR_E_NO_MEMORY, PBR_solve(&pbrs[BALLISTICS_EMBEDDED_PBRS], G1, 0.5, 3000, 1.6, 6));
+  for (int i = 0; i < BALLISTICS_EMBEDDED_PBRS; i++) {
+    PBR_free(pbrs[i]);
+  }
+
+  double zeros[33], angles[33];
+  for (int i = 0; i < 33; i++) zeros[i] = 100 + 10 * i;
+  EXPECT_EQ(ZERO_E_NO_MEMORY, zero_angles(angles, G7, 0.3, 3000, 1.6, zeros, NULL, 33));
+  EXPECT_EQ(0, zero_angles(angles, G7, 0.3, 3000, 1.6, zeros, NULL, 32));
+}
+#endif
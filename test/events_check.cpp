@@ -0,0 +1,178 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+static double path_at(double range_yards, double angle) {
+  BallisticsTarget target = {range_yards};
+  EXPECT_EQ(1, Ballistics_solve_targets(&target, 1, G1, 0.5, 2800, 1.6, 0, angle, 0, 0));
+  return target.path_inches;
+}
+
+TEST(EventsCheck, ZeroCrossingsLieOnTheTrajectory) {
+  double angle = zero_angle(G1, 0.5, 2800, 1.6, 200, 0);
+  double zero = 0;
+  BallisticsEvent events[] = {
+    {BallisticsEvent_height, &zero, EVENTS_EITHER, 0},
+    {BallisticsEvent_apex, NULL, EVENTS_FALLING, 0}
+  };
+  BallisticsEventHit hits[3];
+
+  ASSERT_EQ(3, Ballistics_find_events(hits, 3, events, 2, G1, 0.5, 2800, 1.6, 0, angle, 0, 0, 0, 0));
+  EXPECT_EQ(0, hits[0].event);
+  EXPECT_EQ(EVENTS_RISING, hits[0].direction);
+  EXPECT_EQ(1, hits[1].event);
+  EXPECT_EQ(0, hits[2].event);
+  EXPECT_EQ(EVENTS_FALLING, hits[2].direction);
+  EXPECT_LT(hits[0].state.t, hits[1].state.t);
+  EXPECT_LT(hits[1].state.t, hits[2].state.t);
+
+  EXPECT_NEAR(0, hits[0].state.y, 1e-9);
+  EXPECT_NEAR(0, hits[1].state.vy, 1e-9);
+  EXPECT_NEAR(0, hits[2].state.y, 1e-9);
+  EXPECT_NEAR(200, hits[2].state.x / 3, 0.5);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(hits[i].state.y * 12, path_at(hits[i].state.x / 3, angle), 1e-3) << i;
+  }
+}
+
+TEST(EventsCheck, TerminalEventsStopTheIntegration) {
+  double angle = zero_angle(G1, 0.5, 2800, 1.6, 200, 0);
+  double zero = 0;
+  BallisticsEvent events[] = {
+    {BallisticsEvent_apex, NULL, EVENTS_FALLING, 1},
+    {BallisticsEvent_height, &zero, EVENTS_FALLING, 0}
+  };
+  BallisticsEventHit hits[4];
+
+  ASSERT_EQ(1, Ballistics_find_events(hits, 4, events, 2, G1, 0.5, 2800, 1.6, 0, angle, 0, 0, 0, 0));
+  EXPECT_EQ(0, hits[0].event);
+  EXPECT_EQ(EVENTS_E_ARGUMENTS, Ballistics_find_events(hits, 4, events, EVENTS_MAX + 1, G1, 0.5, 2800, 1.6, 0,
+                                                       angle, 0, 0, 0, 0));
+}
+
+TEST(EventsCheck, LongStepsStillLocateEvents) {
+  double angle = zero_angle(G1, 0.5, 2800, 1.6, 200, 0);
+  double zero = 0;
+  BallisticsEvent event = {BallisticsEvent_height, &zero, EVENTS_FALLING, 1};
+  BallisticsEventHit fine, coarse;
+
+  ASSERT_EQ(1, Ballistics_find_events(&fine, 1, &event, 1, G1, 0.5, 2800, 1.6, 0, angle, 0, 0, 0, 0.5));
+  ASSERT_EQ(1, Ballistics_find_events(&coarse, 1, &event, 1, G1, 0.5, 2800, 1.6, 0, angle, 0, 0, 0, 10));
+  EXPECT_NEAR(0, coarse.state.y, 1e-9);
+  EXPECT_NEAR(fine.state.x / 3, coarse.state.x / 3, 0.5);
+}
+
+TEST(EventsCheck, RefinedZeroMatchesZeroAngle) {
+  for (double zero_range : {100.0, 200.0, 500.0}) {
+    double angle;
+    ASSERT_EQ(0, zero_angle_refined(&angle, G1, 0.5, 2800, 1.6, zero_range, 0, 0));
+    EXPECT_NEAR(zero_angle(G1, 0.5, 2800, 1.6, zero_range, 0), angle, 0.02 / 60) << zero_range;
+    EXPECT_NEAR(0, path_at(zero_range, angle), 0.001) << zero_range;
+  }
+  double angle;
+  EXPECT_EQ(0, zero_angle_refined(&angle, G1, 0.5, 2800, 1.6, 100, 1.5, 0));
+  EXPECT_NEAR(1.5, path_at(100, angle), 0.001);
+  // Both take the intercept in inches.
+  EXPECT_NEAR(zero_angle(G1, 0.5, 2800, 1.6, 100, 1.5), angle, 0.02 / 60);
+}
+
+TEST(EventsCheck, TransonicRange) {
+  Ballistics* solution;
+  double angle = zero_angle(G7, 0.243, 2750, 1.5, 100, 0);
+  double range = Ballistics_range_at_velocity(G7, 0.243, 2750, 1.5, 0, angle, EVENTS_TRANSONIC_FPS, 0);
+  ASSERT_GT(range, 0);
+
+  Ballistics_solve(&solution, G7, 0.243, 2750, 1.5, 0, angle, 0, 0);
+  int yard = (int)range;
+  EXPECT_GT(Ballistics_get_v_fps(solution, yard - 1), EVENTS_TRANSONIC_FPS);
+  EXPECT_LT(Ballistics_get_v_fps(solution, yard + 2), EVENTS_TRANSONIC_FPS);
+  Ballistics_free(solution);
+
+  EXPECT_EQ(-1, Ballistics_range_at_velocity(G7, 0.243, 2750, 1.5, 0, angle, 10, 0));
+}
+
+TEST(EventsCheck, RefinedPBRMatchesPBRSolve) {
+  struct { DragFunction drag_function; double bc, vi, sight_height, vital_size; } loads[] = {
+    {G1, 0.48, 2800, 1.5, 4}, {G1, 0.3, 2400, 2.5, 4}, {G7, 0.243, 3000, 1.5, 8}, {G1, 0.48, 2800, 1.5, 10}
+  };
+  for (auto& load : loads) {
+    struct PBR* expected;
+    struct PBR* refined;
+    ASSERT_EQ(0, PBR_solve(&expected, load.drag_function, load.bc, load.vi, load.sight_height, load.vital_size));
+    ASSERT_EQ(0, PBR_solve_refined(&refined, load.drag_function, load.bc, load.vi, load.sight_height,
+                                   load.vital_size, 0));
+    EXPECT_NEAR(PBR_get_near_zero_yards(expected), PBR_get_near_zero_yards(refined), 1);
+    EXPECT_NEAR(PBR_get_far_zero_yards(expected), PBR_get_far_zero_yards(refined), 1);
+    EXPECT_NEAR(PBR_get_min_PBR_yards(expected), PBR_get_min_PBR_yards(refined), 1);
+    EXPECT_NEAR(PBR_get_max_PBR_yards(expected), PBR_get_max_PBR_yards(refined), 1);
+    EXPECT_NEAR(PBR_get_sight_in_at_100yards(expected), PBR_get_sight_in_at_100yards(refined), 2);
+    PBR_free(expected);
+    PBR_free(refined);
+  }
+}
+
+TEST(EventsCheck, PBRGridMatchesRefinedPBR) {
+  const double vitals[] = {4, 6, 8, 10};
+  const double sights[] = {1.5, 2, 2.5, 3};
+  PBRResult results[16];
+  ASSERT_EQ(16, PBR_solve_grid(results, G1, 0.48, 2800, vitals, 4, sights, 4, 0, 3));
+
+  for (int v = 0; v < 4; v++) {
+    for (int s = 0; s < 4; s++) {
+      const PBRResult& result = results[v*4 + s];
+      struct PBR* refined;
+      ASSERT_EQ(0, result.status);
+      ASSERT_EQ(0, PBR_solve_refined(&refined, G1, 0.48, 2800, sights[s], vitals[v], 0));
+      EXPECT_NEAR(PBR_get_near_zero_yards(refined), result.near_zero_yards, 1);
+      EXPECT_NEAR(PBR_get_far_zero_yards(refined), result.far_zero_yards, 1);
+      EXPECT_NEAR(PBR_get_min_PBR_yards(refined), result.min_PBR_yards, 1);
+      EXPECT_NEAR(PBR_get_max_PBR_yards(refined), result.max_PBR_yards, 1);
+      EXPECT_NEAR(PBR_get_sight_in_at_100yards(refined), result.sight_in_at_100yards, 1);
+      PBR_free(refined);
+    }
+  }
+
+  // 4/2 + 3 and 6/2 + 2 reach the same height above the bore, so they share a bore angle.
+  EXPECT_EQ(results[0*4 + 3].angle, results[1*4 + 1].angle);
+  // The first cell of each apex height is exactly the refined PBR.
+  struct PBR* refined;
+  ASSERT_EQ(0, PBR_solve_refined(&refined, G1, 0.48, 2800, 1.5, 4, 0));
+  EXPECT_EQ(PBR_get_max_PBR_yards(refined), results[0].max_PBR_yards);
+  EXPECT_EQ(PBR_get_far_zero_yards(refined), results[0].far_zero_yards);
+  PBR_free(refined);
+
+  EXPECT_EQ(PBR_E_ARGUMENTS, PBR_solve_grid(results, G1, 0.48, 2800, vitals, 0, sights, 4, 0, 1));
+}
+
+TEST(EventsCheck, PBRGridCellsDontInheritAnotherCellsReadFailure) {
+  // -2/2 + 4 and 2/2 + 2 share a bore angle, solved by the first.  Its vital zone lies wholly below the line of
+  // sight, so reading it fails, but the angle is good, and the second cell reads its own result from it.
+  const double vitals[] = {-2, 2};
+  const double sights[] = {4, 2};
+  PBRResult results[4];
+  PBR_solve_grid(results, G1, 0.48, 2800, vitals, 2, sights, 2, 0, 2);
+  EXPECT_NE(0, results[0].status);
+  ASSERT_EQ(0, results[3].status);
+
+  struct PBR* refined;
+  ASSERT_EQ(0, PBR_solve_refined(&refined, G1, 0.48, 2800, 2, 2, 0));
+  EXPECT_NEAR(PBR_get_far_zero_yards(refined), results[3].far_zero_yards, 1);
+  EXPECT_NEAR(PBR_get_max_PBR_yards(refined), results[3].max_PBR_yards, 1);
+  PBR_free(refined);
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/export.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static std::vector<char> contents(FILE* file) {
+  std::vector<char> data;
+  char chunk[65536];
+  size_t n;
+  rewind(file);
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) data.insert(data.end(), chunk, chunk + n);
+  return data;
+}
+
+class ExportCheck : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    double zeroAngle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+    nsoln = Ballistics_solve_modified_vertDeflect(&solution, G7, 0.3, 2700, 1.6, 0, zeroAngle, 10, 90,
+                                                  0.308, 1.24, 59, 29.92, 10, 2700, 175, 1);
+    file = tmpfile();
+    ASSERT_NE(nullptr, file);
+  }
+  void TearDown() override {
+    fclose(file);
+    Ballistics_free(solution);
+  }
+
+  Ballistics* solution;
+  int nsoln;
+  FILE* file;
+};
+
+TEST_F(ExportCheck, BinaryReadsBackExactly) {
+  const BallisticsField fields[] = {BALLISTICS_RANGE, BALLISTICS_PATH, BALLISTICS_TIME, BALLISTICS_SPINDRIFT};
+  BallisticsWriter* writer;
+  ASSERT_EQ(0, BallisticsWriter_open(&writer, file, BALLISTICS_EXPORT_BINARY, fields, 4, 0));
+  EXPECT_EQ(nsoln, BallisticsWriter_write(writer, solution, 7, 0, 1 << 30, 1));
+  EXPECT_EQ(11, BallisticsWriter_write(writer, solution, 8, 0, 11, 100));
+  ASSERT_EQ(0, BallisticsWriter_close(writer));
+
+  std::vector<char> data = contents(file);
+  const char* p = data.data();
+  ASSERT_EQ(0, memcmp(p, "BLSTCOL1", 8));
+  uint32_t header[2];
+  memcpy(header, p + 8, sizeof(header));
+  EXPECT_EQ(0x01020304u, header[0]);
+  ASSERT_EQ(4u, header[1]);
+  p += 8 + 4 * (2 + 4);
+
+  const int strides[] = {1, 100};
+  for (int block = 0; block < 2; block++) {
+    uint64_t id;
+    uint32_t rows;
+    memcpy(&id, p, 8);
+    memcpy(&rows, p + 8, 4);
+    p += 16;
+    EXPECT_EQ(7u + block, id);
+    for (int f = 0; f < 4; f++) {
+      for (uint32_t i = 0; i < rows; i++) {
+        double value, expected;
+        memcpy(&value, p, 8);
+        p += 8;
+        Ballistics_get_rows(solution, fields[f], i * strides[block], 1, &expected);
+        ASSERT_EQ(expected, value) << "block " << block << " field " << f << " row " << i;
+      }
+    }
+  }
+  EXPECT_EQ(data.data() + data.size(), p);
+}
+
+TEST_F(ExportCheck, CsvMatchesAccessors) {
+  const BallisticsField fields[] = {BALLISTICS_RANGE, BALLISTICS_PATH, BALLISTICS_CORRECTED_WINDAGE, BALLISTICS_V};
+  for (int precision = -1; precision <= 6; precision += 7) {
+    BallisticsWriter* writer;
+    ASSERT_EQ(0, BallisticsWriter_open(&writer, file, BALLISTICS_EXPORT_CSV, fields, 4, precision));
+    EXPECT_EQ(nsoln - 1000, BallisticsWriter_write(writer, solution, 42, 1000, 1 << 30, 1));
+    ASSERT_EQ(0, BallisticsWriter_close(writer));
+
+    std::vector<char> data = contents(file);
+    data.push_back('\0');
+    char* line = data.data();
+    char* next = strchr(line, '\n');
+    ASSERT_EQ("id,range_yards,path_inches,corrected_windage_inches,v_fps", std::string(line, next));
+    for (int row = 1000; row < nsoln; row++) {
+      line = next + 1;
+      char* end;
+      ASSERT_EQ(42, strtol(line, &end, 10));
+      for (int f = 0; f < 4; f++) {
+        ASSERT_EQ(',', *end);
+        double value = strtod(end + 1, &end);
+        double expected;
+        Ballistics_get_rows(solution, fields[f], row, 1, &expected);
+        if (precision < 0) {
+          ASSERT_EQ(expected, value);
+        } else {
+          ASSERT_NEAR(expected, value, 0.5000001e-6) << end;
+        }
+      }
+      ASSERT_EQ('\n', *end);
+      next = end;
+    }
+    EXPECT_EQ('\0', next[1]);
+
+    fclose(file);
+    file = tmpfile();
+  }
+}
+
+TEST_F(ExportCheck, RejectsBadArguments) {
+  const BallisticsField fields[] = {BALLISTICS_PATH};
+  const BallisticsField bad[] = {(BallisticsField) 99};
+  BallisticsWriter* writer;
+  EXPECT_EQ(EXPORT_E_ARGUMENTS, BallisticsWriter_open(&writer, file, BALLISTICS_EXPORT_CSV, fields, 0, 3));
+  EXPECT_EQ(EXPORT_E_ARGUMENTS, BallisticsWriter_open(&writer, file, BALLISTICS_EXPORT_CSV, fields, 1, 10));
+  EXPECT_EQ(EXPORT_E_ARGUMENTS, BallisticsWriter_open(&writer, file, BALLISTICS_EXPORT_CSV, bad, 1, 3));
+  ASSERT_EQ(0, BallisticsWriter_open(&writer, file, BALLISTICS_EXPORT_CSV, fields, 1, 3));
+  EXPECT_EQ(EXPORT_E_ARGUMENTS, BallisticsWriter_write(writer, solution, 0, 0, 10, 0));
+  EXPECT_EQ(0, BallisticsWriter_write(writer, solution, 0, nsoln, 10, 1));
+  EXPECT_EQ(0, BallisticsWriter_close(writer));
+}
@@ -0,0 +1,113 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/lead.h"
+
+#include <vector>
+
+static LeadTimeline* solve_timeline() {
+  Ballistics* solution = NULL;
+  LeadTimeline* timeline = NULL;
+  double angle = zero_angle(G7, 0.243, 2750, 1.5, 100, 0);
+  Ballistics_solve(&solution, G7, 0.243, 2750, 1.5, 0, angle, 0, 0);
+  EXPECT_EQ(0, LeadTimeline_build(&timeline, solution));
+  Ballistics_free(solution);
+  return timeline;
+}
+
+TEST(LeadCheck, TimelineMatchesInterpolatedTargets) {
+  LeadTimeline* timeline = solve_timeline();
+  double angle = zero_angle(G7, 0.243, 2750, 1.5, 100, 0);
+  ASSERT_TRUE(timeline);
+
+  for (double range : {0.0, 1.0, 99.5, 650.0, 1234.25, 1800.0}) {
+    BallisticsTarget target = {range};
+    ASSERT_EQ(1, Ballistics_solve_targets(&target, 1, G7, 0.243, 2750, 1.5, 0, angle, 0, 0));
+    double seconds = LeadTimeline_time_at(timeline, range);
+    EXPECT_NEAR(target.seconds, seconds, 1e-5) << range;
+    EXPECT_NEAR(range, LeadTimeline_range_at(timeline, seconds), 0.01) << range;
+  }
+  EXPECT_EQ(-1, LeadTimeline_time_at(timeline, LeadTimeline_get_max_range(timeline) + 1));
+  EXPECT_EQ(-1, LeadTimeline_range_at(timeline, LeadTimeline_get_max_time(timeline) + 0.1));
+  LeadTimeline_free(timeline);
+}
+
+TEST(LeadCheck, CrossingAndRecedingTargets) {
+  LeadTimeline* timeline = solve_timeline();
+  Lead lead;
+  ASSERT_TRUE(timeline);
+
+  // 3 mi/hr straight across at 650 yards: the target moves 52.8 inches for each second of flight.
+  ASSERT_EQ(0, Lead_solve(timeline, 650, 3, 90, &lead));
+  double seconds = LeadTimeline_time_at(timeline, 650);
+  EXPECT_NEAR(650, lead.range_yards, 1e-9);
+  EXPECT_DOUBLE_EQ(seconds, lead.seconds);
+  EXPECT_NEAR(3 * 17.6 * seconds, lead.inches, 1e-9);
+  EXPECT_NEAR(lead.inches / 1.047 / 6.5, lead.moa, 0.01 * lead.moa);
+  EXPECT_NEAR(lead.moa * 0.2909, lead.mil, 0.001 * lead.mil);
+
+  // Right to left leads the other way.
+  Lead mirrored;
+  ASSERT_EQ(0, Lead_solve(timeline, 650, 3, -90, &mirrored));
+  EXPECT_NEAR(-lead.inches, mirrored.inches, 1e-9);
+
+  // A target running away at 30 mi/hr is met further out, where the time of flight agrees with its motion.
+  ASSERT_EQ(0, Lead_solve(timeline, 650, 30, 0, &lead));
+  EXPECT_GT(lead.range_yards, 650);
+  EXPECT_NEAR(650 + 30 * 1760.0 / 3600 * lead.seconds, lead.range_yards, 1e-6);
+  EXPECT_NEAR(LeadTimeline_time_at(timeline, lead.range_yards), lead.seconds, 1e-9);
+  EXPECT_NEAR(0, lead.inches, 1e-9);
+
+  EXPECT_EQ(LEAD_E_OUT_OF_RANGE, Lead_solve(timeline, LeadTimeline_get_max_range(timeline) - 1, 30, 0, &lead));
+  EXPECT_EQ(0, lead.seconds);
+  LeadTimeline_free(timeline);
+}
+
+TEST(LeadCheck, GridMatchesSingleLeads) {
+  LeadTimeline* timeline = solve_timeline();
+  ASSERT_TRUE(timeline);
+  std::vector<double> ranges, speeds = {1, 3, 12.5}, headings = {0, 45, 90, 200, 270};
+  for (int r = 0; r < 40; r++) ranges.push_back(50 * r + 0.5);
+  // Near the end of the timeline, targets moving away are out of reach.
+  ranges.push_back(LeadTimeline_get_max_range(timeline) - 0.5);
+  std::vector<double> out(ranges.size() * speeds.size() * headings.size());
+
+  for (LeadUnit unit : {LEAD_INCHES, LEAD_MOA, LEAD_MIL}) {
+    int reached = Lead_grid(timeline, ranges.data(), (int)ranges.size(), speeds.data(), (int)speeds.size(),
+                            headings.data(), (int)headings.size(), unit, out.data());
+    int expected = 0;
+    for (size_t s = 0; s < speeds.size(); s++) {
+      for (size_t h = 0; h < headings.size(); h++) {
+        for (size_t r = 0; r < ranges.size(); r++) {
+          Lead lead;
+          double cell = out[(s * headings.size() + h) * ranges.size() + r];
+          if (Lead_solve(timeline, ranges[r], speeds[s], headings[h], &lead)) {
+            EXPECT_EQ(0, cell);
+            continue;
+          }
+          expected++;
+          EXPECT_EQ(unit == LEAD_INCHES ? lead.inches : unit == LEAD_MOA ? lead.moa : lead.mil, cell)
+              << s << " " << h << " " << r;
+        }
+      }
+    }
+    EXPECT_EQ(expected, reached);
+    EXPECT_LT(reached, (int)out.size());
+  }
+  LeadTimeline_free(timeline);
+}
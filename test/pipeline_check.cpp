@@ -0,0 +1,118 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "ballistics/pipeline.h"
+
+static BallisticsPipeline* make_pipeline() {
+  static const double ranges[] = {100, 300, 600};
+  BallisticsPipeline* pipeline = BallisticsPipeline_alloc();
+  BallisticsPipeline_set(pipeline, PIPELINE_DRAG_FUNCTION, G7);
+  BallisticsPipeline_set(pipeline, PIPELINE_DRAG_COEFFICIENT, 0.243);
+  BallisticsPipeline_set(pipeline, PIPELINE_VELOCITY, 2750);
+  BallisticsPipeline_set(pipeline, PIPELINE_SIGHT_HEIGHT, 1.5);
+  BallisticsPipeline_set(pipeline, PIPELINE_ZERO_RANGE, 100);
+  BallisticsPipeline_set(pipeline, PIPELINE_ALTITUDE, 1500);
+  BallisticsPipeline_set(pipeline, PIPELINE_WIND_SPEED, 10);
+  BallisticsPipeline_set(pipeline, PIPELINE_WIND_ANGLE, 90);
+  BallisticsPipeline_set_card(pipeline, ranges, 3);
+  return pipeline;
+}
+
+TEST(PipelineCheck, MatchesRunningEveryStage) {
+  BallisticsPipeline* pipeline = make_pipeline();
+  ASSERT_EQ(PIPELINE_CORRECTION | PIPELINE_ZERO | PIPELINE_SOLVE | PIPELINE_CARD,
+            BallisticsPipeline_update(pipeline));
+  // Nothing changed, so nothing reruns.
+  EXPECT_EQ(0, BallisticsPipeline_update(pipeline));
+
+  double bc = atmosphere_correction(0.243, 1500, 29.53, 59, 0.78);
+  double angle = zero_angle(G7, bc, 2750, 1.5, 100, 0);
+  EXPECT_EQ(bc, BallisticsPipeline_get(pipeline, PIPELINE_CORRECTED_DRAG_COEFFICIENT));
+  EXPECT_EQ(angle, BallisticsPipeline_get(pipeline, PIPELINE_ZERO_ANGLE));
+
+  Ballistics* expected;
+  ASSERT_GT(Ballistics_solve(&expected, G7, bc, 2750, 1.5, 0, angle, 10, 90), 600);
+  int count;
+  const BallisticsTarget* card = BallisticsPipeline_get_card(pipeline, &count);
+  ASSERT_EQ(3, count);
+  EXPECT_EQ(300, card[1].range_yards);
+  EXPECT_EQ(Ballistics_get_path(expected, 300), card[1].path_inches);
+  EXPECT_EQ(Ballistics_get_windage(expected, 600), card[2].windage_inches);
+  EXPECT_EQ(Ballistics_get_v_fps(expected, 100), card[0].v_fps);
+  Ballistics_free(expected);
+  BallisticsPipeline_free(pipeline);
+}
+
+TEST(PipelineCheck, RerunsOnlyWhatChangesInvalidate) {
+  BallisticsPipeline* pipeline = make_pipeline();
+  ASSERT_GT(BallisticsPipeline_update(pipeline), 0);
+  double angle = BallisticsPipeline_get(pipeline, PIPELINE_ZERO_ANGLE);
+
+  // Wind doesn't touch the corrected coefficient or the zero.
+  BallisticsPipeline_set(pipeline, PIPELINE_WIND_SPEED, 15);
+  EXPECT_EQ(PIPELINE_SOLVE | PIPELINE_CARD, BallisticsPipeline_update(pipeline));
+  EXPECT_EQ(angle, BallisticsPipeline_get(pipeline, PIPELINE_ZERO_ANGLE));
+
+  // New card ranges only reread the card.
+  const double ranges[] = {200};
+  BallisticsPipeline_set_card(pipeline, ranges, 1);
+  EXPECT_EQ(PIPELINE_CARD, BallisticsPipeline_update(pipeline));
+
+  // Weather reruns everything, without tolerances.
+  BallisticsPipeline_set(pipeline, PIPELINE_TEMPERATURE, 60);
+  EXPECT_EQ(PIPELINE_CORRECTION | PIPELINE_ZERO | PIPELINE_SOLVE | PIPELINE_CARD,
+            BallisticsPipeline_update(pipeline));
+
+  // With a tolerance, small ticks are ignored until they add up to more than it.
+  ASSERT_EQ(0, BallisticsPipeline_set_tolerance(pipeline, PIPELINE_TEMPERATURE, 1));
+  BallisticsPipeline_set(pipeline, PIPELINE_TEMPERATURE, 60.6);
+  EXPECT_EQ(0, BallisticsPipeline_update(pipeline));
+  BallisticsPipeline_set(pipeline, PIPELINE_TEMPERATURE, 61.2);
+  EXPECT_EQ(PIPELINE_CORRECTION | PIPELINE_ZERO | PIPELINE_SOLVE | PIPELINE_CARD,
+            BallisticsPipeline_update(pipeline));
+
+  // And a tolerance on the corrected coefficient stops a small change of it at the correction.
+  ASSERT_EQ(0, BallisticsPipeline_set_tolerance(pipeline, PIPELINE_CORRECTED_DRAG_COEFFICIENT, 0.001));
+  BallisticsPipeline_set(pipeline, PIPELINE_TEMPERATURE, 63);
+  EXPECT_EQ(PIPELINE_CORRECTION, BallisticsPipeline_update(pipeline));
+
+  EXPECT_EQ(PIPELINE_E_ARGUMENTS, BallisticsPipeline_set(pipeline, PIPELINE_ZERO_ANGLE, 1));
+  EXPECT_EQ(PIPELINE_E_ARGUMENTS, BallisticsPipeline_set_tolerance(pipeline, PIPELINE_VELOCITY, -1));
+  BallisticsPipeline_free(pipeline);
+}
+
+TEST(PipelineCheck, DefaultsToStandardAir) {
+  BallisticsPipeline* pipeline = BallisticsPipeline_alloc();
+  BallisticsPipeline_set(pipeline, PIPELINE_DRAG_COEFFICIENT, 0.5);
+  BallisticsPipeline_set(pipeline, PIPELINE_VELOCITY, 2800);
+  BallisticsPipeline_set(pipeline, PIPELINE_ZERO_RANGE, 100);
+  ASSERT_GT(BallisticsPipeline_update(pipeline), 0);
+  EXPECT_NEAR(0.5, BallisticsPipeline_get(pipeline, PIPELINE_CORRECTED_DRAG_COEFFICIENT), 1e-3);
+  BallisticsPipeline_free(pipeline);
+}
+
+TEST(PipelineCheck, InterceptIsInInchesAsForZeroAngle) {
+  BallisticsPipeline* pipeline = make_pipeline();
+  BallisticsPipeline_set(pipeline, PIPELINE_Y_INTERCEPT, 1.5);
+  ASSERT_GT(BallisticsPipeline_update(pipeline), 0);
+
+  double bc = BallisticsPipeline_get(pipeline, PIPELINE_CORRECTED_DRAG_COEFFICIENT);
+  EXPECT_EQ(zero_angle(G7, bc, 2750, 1.5, 100, 1.5), BallisticsPipeline_get(pipeline, PIPELINE_ZERO_ANGLE));
+  // 1.5 inches high at the zero range.
+  EXPECT_NEAR(1.5, Ballistics_get_path(BallisticsPipeline_get_solution(pipeline), 100), 0.1);
+  BallisticsPipeline_free(pipeline);
+}
@@ -0,0 +1,251 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/rt.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static RtChannel* new_channel() {
+  void* memory = NULL;
+  if (posix_memalign(&memory, 64, RtChannel_size())) return NULL;
+  return RtChannel_init(memory);
+}
+
+static RtInput range_input(double range_yards, uint64_t timestamp_ns) {
+  RtInput input;
+  memset(&input, 0, sizeof(input));
+  input.fields = RT_INPUT_RANGE;
+  input.range_yards = range_yards;
+  input.timestamp_ns = timestamp_ns;
+  return input;
+}
+
+TEST(RtCheck, RingKeepsOrderAndRefusesWhenFull) {
+  RtChannel* channel = new_channel();
+  RtInput input;
+
+  ASSERT_EQ(0, RtChannel_pop(channel, &input));
+  for (int i = 0; i < RT_RING_CAPACITY; i++) {
+    RtInput pushed = range_input(i, i);
+    ASSERT_EQ(0, RtChannel_push(channel, &pushed));
+  }
+  RtInput extra = range_input(-1, 0);
+  EXPECT_EQ(RT_E_FULL, RtChannel_push(channel, &extra));
+
+  for (int i = 0; i < RT_RING_CAPACITY; i++) {
+    ASSERT_EQ(1, RtChannel_pop(channel, &input));
+    ASSERT_EQ(i, input.range_yards);
+  }
+  EXPECT_EQ(0, RtChannel_pop(channel, &input));
+  EXPECT_EQ(0, RtChannel_push(channel, &extra));
+  free(channel);
+}
+
+TEST(RtCheck, RingPassesEveryInputBetweenThreads) {
+  RtChannel* channel = new_channel();
+  const int count = 20000;
+
+  std::thread producer([channel] {
+    for (int i = 0; i < count;) {
+      RtInput input = range_input(i, i);
+      if (!RtChannel_push(channel, &input)) i++;
+    }
+  });
+  for (int i = 0; i < count;) {
+    RtInput input;
+    if (RtChannel_pop(channel, &input)) {
+      ASSERT_EQ((uint64_t)i, input.timestamp_ns);
+      i++;
+    }
+  }
+  producer.join();
+  free(channel);
+}
+
+TEST(RtCheck, ReadersNeverSeeATornSolution) {
+  RtChannel* channel = new_channel();
+  RtSolution solution;
+  const int count = 100000;
+
+  EXPECT_EQ(0u, RtChannel_read(channel, &solution));
+
+  std::thread writer([channel] {
+    RtSolution published;
+    memset(&published, 0, sizeof(published));
+    for (int i = 1; i <= count; i++) {
+      published.inputs = i;
+      published.range_yards = i;
+      published.path_inches = -i;
+      published.v_fps = 2 * i;
+      RtChannel_publish(channel, &published);
+    }
+  });
+  uint64_t last = 0;
+  while (last < (uint64_t)count) {
+    uint64_t version = RtChannel_read(channel, &solution);
+    ASSERT_GE(version, last);
+    if (version) {
+      ASSERT_EQ(version, solution.inputs);
+      ASSERT_EQ((double)solution.inputs, solution.range_yards);
+      ASSERT_EQ(-(double)solution.inputs, solution.path_inches);
+      ASSERT_EQ(2 * (double)solution.inputs, solution.v_fps);
+    }
+    last = version;
+  }
+  writer.join();
+  free(channel);
+}
+
+TEST(RtCheck, SolverMatchesAColdSolve) {
+  RtSolver solver;
+  RtSolution solution;
+  RtInput input;
+
+  RtSolver_init(&solver, G1, 0.5, 2800, 1.6, 200);
+  memset(&input, 0, sizeof(input));
+  input.fields = RT_INPUT_RANGE | RT_INPUT_ANGLE | RT_INPUT_WIND | RT_INPUT_ATMOSPHERE;
+  input.range_yards = 600;
+  input.shooting_angle = 5;
+  input.wind_speed = 10;
+  input.wind_angle = 60;
+  input.altitude = 5000;
+  input.barometer = 29.5;
+  input.temperature = 30;
+  input.relative_humidity = 0.4;
+  RtSolver_update(&solver, &input);
+  RtSolver_solve(&solver, &solution);
+
+  double bc = atmosphere_correction(0.5, 5000, 29.5, 30, 0.4);
+  double angle = zero_angle(G1, bc, 2800, 1.6, 200, 0);
+  BallisticsTarget target = {600};
+  ASSERT_EQ(1, Ballistics_solve_targets(&target, 1, G1, bc, 2800, 1.6, 5, angle, 10, 60));
+
+  EXPECT_EQ(1, solution.status);
+  EXPECT_EQ(1, solution.zeroed);
+  EXPECT_EQ(1, solution.resolved);
+  EXPECT_EQ(bc, solution.drag_coefficient);
+  // zero_angle() itself only resolves the zero to about 0.01 MOA, and with a coarser integrator.
+  EXPECT_NEAR(angle, solution.zero_angle, 0.03 / 60);
+  EXPECT_NEAR(target.path_inches, solution.path_inches, 0.2);
+  EXPECT_NEAR(target.moa_correction, solution.moa_correction, 0.03);
+  EXPECT_NEAR(target.windage_inches, solution.windage_inches, 0.01);
+  EXPECT_NEAR(target.seconds, solution.seconds, 1e-6);
+  EXPECT_NEAR(target.v_fps, solution.v_fps, 0.01);
+
+  // A wind that turns to come from the other side of the line of fire flips the headwind, so it is solved again.
+  input.fields = RT_INPUT_WIND;
+  input.wind_angle = 90 + (90 - 60);
+  RtSolver_update(&solver, &input);
+  RtSolver_solve(&solver, &solution);
+  ASSERT_EQ(1, Ballistics_solve_targets(&target, 1, G1, bc, 2800, 1.6, 5, solution.zero_angle, 10, 120));
+  EXPECT_EQ(0, solution.zeroed);
+  EXPECT_EQ(1, solution.resolved);
+  EXPECT_DOUBLE_EQ(target.windage_inches, solution.windage_inches);
+  EXPECT_DOUBLE_EQ(target.path_inches, solution.path_inches);
+}
+
+TEST(RtCheck, CrosswindAloneReusesTheTrajectory) {
+  RtSolver solver;
+  RtSolution solution;
+  RtInput input;
+
+  RtSolver_init(&solver, G7, 0.243, 2750, 1.5, 100);
+  memset(&input, 0, sizeof(input));
+  input.fields = RT_INPUT_RANGE | RT_INPUT_WIND;
+  input.range_yards = 800;
+  input.wind_speed = 10;
+  input.wind_angle = 90;
+  RtSolver_update(&solver, &input);
+  RtSolver_solve(&solver, &solution);
+  ASSERT_EQ(1, solution.status);
+  EXPECT_EQ(1, solution.resolved);
+  double path = solution.path_inches;
+
+  // Straight across, only the crosswind changes with the speed, even though headwind() isn't exactly 0 there;
+  // the trajectory stands and the windage scales with the speed.
+  for (double speed : {5.0, 20.0, 0.0}) {
+    BallisticsTarget target = {800};
+    input.fields = RT_INPUT_WIND;
+    input.wind_speed = speed;
+    RtSolver_update(&solver, &input);
+    RtSolver_solve(&solver, &solution);
+    EXPECT_EQ(0, solution.resolved) << speed;
+    EXPECT_EQ(path, solution.path_inches) << speed;
+    ASSERT_EQ(1, Ballistics_solve_targets(&target, 1, G7, 0.243, 2750, 1.5, 0, solution.zero_angle, speed, 90));
+    EXPECT_NEAR(target.windage_inches, solution.windage_inches, 1e-9) << speed;
+    EXPECT_NEAR(target.windage_moa, solution.windage_moa, 1e-9) << speed;
+  }
+
+  // A headwind of its own is a new trajectory.
+  input.wind_speed = 10;
+  input.wind_angle = 0;
+  RtSolver_update(&solver, &input);
+  RtSolver_solve(&solver, &solution);
+  EXPECT_EQ(1, solution.resolved);
+}
+
+TEST(RtCheck, PollDrainsThenPublishesOnce) {
+  RtChannel* channel = new_channel();
+  RtSolver solver;
+  RtSolution solution;
+
+  RtSolver_init(&solver, G7, 0.243, 2750, 1.5, 100);
+  EXPECT_EQ(0, RtSolver_poll(&solver, channel));
+  EXPECT_EQ(0u, RtChannel_read(channel, &solution));
+
+  for (int i = 1; i <= 3; i++) {
+    RtInput input = range_input(100 * i, 1000 * i);
+    ASSERT_EQ(0, RtChannel_push(channel, &input));
+  }
+  EXPECT_EQ(3, RtSolver_poll(&solver, channel));
+  EXPECT_EQ(1u, RtChannel_read(channel, &solution));
+  EXPECT_EQ(300, solution.range_yards);
+  EXPECT_EQ(3000u, solution.input_timestamp_ns);
+  EXPECT_EQ(3u, solution.inputs);
+  EXPECT_EQ(1, solution.status);
+  EXPECT_EQ(0, solution.zeroed);
+
+  // Repeated readings change nothing, but still publish a fresh solution.
+  RtInput repeat = range_input(300, 4000);
+  ASSERT_EQ(0, RtChannel_push(channel, &repeat));
+  EXPECT_EQ(1, RtSolver_poll(&solver, channel));
+  EXPECT_EQ(2u, RtChannel_read(channel, &solution));
+  EXPECT_EQ(4000u, solution.input_timestamp_ns);
+  free(channel);
+}
+
+TEST(RtCheck, SharedMemoryChannelsAttach) {
+  const char* name = "/ballistics-rt-check";
+  RtChannel* solver_side;
+  RtChannel* sensor_side;
+  RtChannel* none;
+
+  ASSERT_EQ(0, RtChannel_open(&solver_side, name, 1));
+  ASSERT_EQ(0, RtChannel_open(&sensor_side, name, 0));
+  RtInput input = range_input(450, 1), received;
+  ASSERT_EQ(0, RtChannel_push(sensor_side, &input));
+  ASSERT_EQ(1, RtChannel_pop(solver_side, &received));
+  EXPECT_EQ(450, received.range_yards);
+  RtChannel_close(sensor_side);
+  RtChannel_close(solver_side);
+  EXPECT_EQ(0, RtChannel_unlink(name));
+  EXPECT_EQ(RT_E_IO, RtChannel_open(&none, name, 0));
+  EXPECT_EQ(NULL, none);
+}
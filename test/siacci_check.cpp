@@ -0,0 +1,145 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/siacci.h"
+
+TEST(SiacciCheck, BuildsTablesForEveryDragFunction) {
+  SiacciTables* tables = NULL;
+  for (DragFunction df : {G1, G2, G5, G6, G7, G8}) {
+    ASSERT_EQ(0, SiacciTables_build(&tables, df)) << df;
+    EXPECT_EQ(df, SiacciTables_get_drag_function(tables));
+    SiacciTables_free(tables);
+  }
+  // retard() has no tables for G3 and G4.
+  EXPECT_EQ(SIACCI_E_ARGUMENTS, SiacciTables_build(&tables, G3));
+  EXPECT_EQ(SIACCI_E_ARGUMENTS, SiacciTables_build(&tables, (DragFunction)99));
+  EXPECT_EQ(NULL, tables);
+}
+
+TEST(SiacciCheck, LevelFireMatchesSolverWithinEnvelope) {
+  SiacciTables* tables = NULL;
+  Ballistics* solved = NULL;
+  Ballistics* estimated = NULL;
+  ASSERT_EQ(0, SiacciTables_build(&tables, G7));
+  double angle = zero_angle(G7, 0.243, 2750, 1.6, 100, 0);
+  Ballistics_solve(&solved, G7, 0.243, 2750, 1.6, 0, angle, 10, 90);
+  int rows = Ballistics_solve_siacci(&estimated, tables, 0.243, 2750, 1.6, 0, angle, 10, 90);
+  EXPECT_EQ(Ballistics_get_max_yardage(estimated), rows);
+  ASSERT_GT(rows, 1000);
+
+  for (int yards : {0, 100, 300, 600, 1000}) {
+    EXPECT_NEAR(Ballistics_get_path(solved, yards), Ballistics_get_path(estimated, yards), 0.1) << yards;
+    EXPECT_NEAR(Ballistics_get_time(solved, yards), Ballistics_get_time(estimated, yards), 1e-3) << yards;
+    EXPECT_NEAR(Ballistics_get_v_fps(solved, yards), Ballistics_get_v_fps(estimated, yards), 2) << yards;
+  }
+
+  // Point queries agree with the rows they would have filled, give or take the half foot step the rows' times are
+  // taken at the end of.
+  BallisticsTarget targets[] = {{250}, {500}, {1000}, {1e6}};
+  ASSERT_EQ(3, Siacci_solve_targets(targets, 4, tables, 0.243, 2750, 1.6, 0, angle, 10, 90));
+  for (int i = 0; i < 3; i++) {
+    int yards = (int)targets[i].range_yards;
+    EXPECT_NEAR(Ballistics_get_path(estimated, yards), targets[i].path_inches, 0.05) << yards;
+    EXPECT_NEAR(Ballistics_get_windage(estimated, yards), targets[i].windage_inches, 0.1) << yards;
+    EXPECT_NEAR(Ballistics_get_v_fps(estimated, yards), targets[i].v_fps, 1) << yards;
+  }
+
+  Ballistics_free(solved);
+  Ballistics_free(estimated);
+  SiacciTables_free(tables);
+}
+
+TEST(SiacciCheck, ExtensionLeavesOutTheHeadwindAsTheTablesDo) {
+  SiacciTables* tables = NULL;
+  ASSERT_EQ(0, SiacciTables_build(&tables, G7));
+  double angle = zero_angle(G7, 0.243, 2750, 1.6, 100, 0);
+
+  // A wind straight down the range changes nothing, in the rows from the tables or the ones integrated after them.
+  Ballistics* calm = Ballistics_alloc();
+  Ballistics* headwind = Ballistics_alloc();
+  Ballistics_set_row_limit(calm, 500);
+  Ballistics_set_row_limit(headwind, 500);
+  ASSERT_EQ(500, Ballistics_solve_siacci_into(calm, tables, 0.243, 2750, 1.6, 0, angle, 0, 0));
+  ASSERT_EQ(500, Ballistics_solve_siacci_into(headwind, tables, 0.243, 2750, 1.6, 0, angle, 20, 0));
+  ASSERT_EQ(1000, Ballistics_extend(calm, 1000));
+  ASSERT_EQ(1000, Ballistics_extend(headwind, 1000));
+  for (int yards : {100, 499, 500, 700, 999}) {
+    EXPECT_EQ(Ballistics_get_path(calm, yards), Ballistics_get_path(headwind, yards)) << yards;
+    EXPECT_EQ(Ballistics_get_v_fps(calm, yards), Ballistics_get_v_fps(headwind, yards)) << yards;
+  }
+
+  Ballistics_free(calm);
+  Ballistics_free(headwind);
+  SiacciTables_free(tables);
+}
+
+TEST(SiacciCheck, TargetsMatchSolverAcrossDocumentedEnvelope) {
+  // The loads siacci.h measures, with the largest path difference it gives at 500, 1000, 1500 and 2000 yards, and 0
+  // past where it stops.  A tenth is allowed over, for the sight height and zero these are taken at.
+  struct {
+    DragFunction drag_function;
+    double drag_coefficient, vi;
+    double path[4];
+  } loads[] = {
+    {G7, 0.243, 2750, {0.01, 0.07, 0.7, 3.7}},
+    {G1, 0.5, 2900, {0.01, 0.05, 0.4, 2.5}},
+    {G7, 0.15, 3200, {0.01, 0.2, 1.6, 8.2}},
+    {G1, 0.2, 1100, {0.25, 4.3, 44, 410}},
+    {G1, 0.1, 1000, {0.8, 43, 0, 0}},
+  };
+
+  for (const auto& load : loads) {
+    SiacciTables* tables = NULL;
+    ASSERT_EQ(0, SiacciTables_build(&tables, load.drag_function));
+    double angle = zero_angle(load.drag_function, load.drag_coefficient, load.vi, 1.5, 100, 0);
+    BallisticsTarget solved[] = {{500}, {1000}, {1500}, {2000}};
+    BallisticsTarget estimated[] = {{500}, {1000}, {1500}, {2000}};
+    Ballistics_solve_targets(solved, 4, load.drag_function, load.drag_coefficient, load.vi, 1.5, 0, angle, 0, 0);
+    Siacci_solve_targets(estimated, 4, tables, load.drag_coefficient, load.vi, 1.5, 0, angle, 0, 0);
+    for (int i = 0; i < 4 && load.path[i] > 0; i++) {
+      EXPECT_NEAR(solved[i].path_inches, estimated[i].path_inches, 0.01 + 1.1*load.path[i])
+          << load.drag_coefficient << " at " << load.vi << ", " << solved[i].range_yards;
+      // Within a millisecond and 2 ft/s to 1000 yards while supersonic.
+      if (i < 2 && load.vi > 2000) {
+        EXPECT_NEAR(solved[i].seconds, estimated[i].seconds, 1e-3) << load.vi << ", " << solved[i].range_yards;
+        EXPECT_NEAR(solved[i].v_fps, estimated[i].v_fps, 2) << load.vi << ", " << solved[i].range_yards;
+      }
+    }
+
+    // At the muzzle the tables give back the muzzle velocity exactly, even between their speeds, and just past it
+    // a little less.
+    for (double vi : {load.vi, load.vi + 0.5, load.vi + 0.999}) {
+      BallisticsTarget muzzle[] = {{0}, {0.01}};
+      ASSERT_EQ(2, Siacci_solve_targets(muzzle, 2, tables, load.drag_coefficient, vi, 1.5, 0, 0, 0, 0)) << vi;
+      EXPECT_NEAR(vi, muzzle[0].v_fps, 1e-9) << vi;
+      EXPECT_LT(muzzle[1].v_fps, vi) << vi;
+      EXPECT_GT(muzzle[1].v_fps, vi - 0.1) << vi;
+    }
+    SiacciTables_free(tables);
+  }
+
+  // The fastest muzzle velocity the tables take, and the first they don't.
+  SiacciTables* tables = NULL;
+  ASSERT_EQ(0, SiacciTables_build(&tables, G7));
+  BallisticsTarget fast[] = {{0}, {100}};
+  ASSERT_EQ(2, Siacci_solve_targets(fast, 2, tables, 0.3, SIACCI_MAX_FPS - 0.5, 1.5, 0, 0, 0, 0));
+  EXPECT_NEAR(SIACCI_MAX_FPS - 0.5, fast[0].v_fps, 1e-9);
+  EXPECT_LT(fast[1].v_fps, fast[0].v_fps);
+  EXPECT_EQ(0, Siacci_solve_targets(fast, 2, tables, 0.3, SIACCI_MAX_FPS, 1.5, 0, 0, 0, 0));
+  SiacciTables_free(tables);
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+namespace {
+  int markers[BALLISTICS_PHASES][2];
+
+  void CountMarkers(void* context, BallisticsPhase phase, int begin) {
+    (void)context;
+    markers[phase][begin]++;
+  }
+
+  TEST(StatsCheck, CountsSolves) {
+    Ballistics* solution;
+    BallisticsSolveStats last;
+    BallisticsThreadStats totals;
+
+    BallisticsStats_reset();
+    BallisticsStats_set_hook(CountMarkers, NULL);
+    double angle = zero_angle(G1, 0.5, 1200, 1.6, 100, 0);
+    BallisticsStats_last(&last);
+    int n = Ballistics_solve(&solution, G1, 0.5, 1200, 1.6, 0, angle, 0, 0);
+    Ballistics_free(solution);
+    BallisticsStats_set_hook(NULL, NULL);
+    BallisticsStats_thread(&totals);
+
+#ifdef BALLISTICS_STATS
+    EXPECT_EQ(BALLISTICS_PHASE_ZERO, last.phase);
+    EXPECT_LT(10u, last.iterations);
+    EXPECT_LT(last.iterations, last.steps);
+
+    BallisticsStats_last(&last);
+    EXPECT_EQ(BALLISTICS_PHASE_SOLVE, last.phase);
+    // Two steps for every foot along the path, which is longer than the range once the projectile falls steeply.
+    EXPECT_LE(6u * (n - 1), last.steps);
+    unsigned long retards = 0;
+    for (int i = 0; i < BALLISTICS_STATS_VELOCITY_BANDS; i++) {
+      retards += last.retard_calls[i];
+    }
+    EXPECT_EQ(last.steps, retards);
+    EXPECT_LT(0u, last.retard_calls[1150 / BALLISTICS_STATS_VELOCITY_BAND_WIDTH]);
+    EXPECT_EQ(0u, last.retard_calls[1300 / BALLISTICS_STATS_VELOCITY_BAND_WIDTH]);
+
+    EXPECT_EQ(1u, totals.calls[BALLISTICS_PHASE_ZERO]);
+    EXPECT_EQ(1u, totals.calls[BALLISTICS_PHASE_SOLVE]);
+    unsigned long latencies = 0;
+    for (int i = 0; i < BALLISTICS_STATS_LATENCY_BUCKETS; i++) {
+      latencies += totals.latency[BALLISTICS_PHASE_SOLVE][i];
+    }
+    EXPECT_EQ(1u, latencies);
+    EXPECT_EQ(1, markers[BALLISTICS_PHASE_SOLVE][1]);
+    EXPECT_EQ(1, markers[BALLISTICS_PHASE_SOLVE][0]);
+#else
+    (void)n;
+    EXPECT_EQ(0u, last.steps);
+    EXPECT_EQ(0u, totals.calls[BALLISTICS_PHASE_SOLVE]);
+    EXPECT_EQ(0, markers[BALLISTICS_PHASE_SOLVE][1]);
+#endif
+  }
+
+  TEST(StatsCheck, NestedSolvesRollUp) {
+    TruingObservation observations[] = {{300, -4.5}, {600, -60}};
+    double bc = 0.3, v = 2700;
+    BallisticsSolveStats last;
+
+    Truing_solve(&bc, &v, NULL, TRUING_FIT_DRAG_COEFFICIENT, observations, 2, G7, 1.75, 0, 100, 0);
+    BallisticsStats_last(&last);
+#ifdef BALLISTICS_STATS
+    EXPECT_EQ(BALLISTICS_PHASE_TRUING, last.phase);
+    EXPECT_LT(0u, last.steps);
+#else
+    EXPECT_EQ(0u, last.steps);
+#endif
+    EXPECT_STREQ("truing", BallisticsStats_phase_name(BALLISTICS_PHASE_TRUING));
+  }
+} // namespace
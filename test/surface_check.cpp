@@ -0,0 +1,160 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/surface.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+
+static const BallisticsSurfaceConfig config = {
+  G7, 1.5, {{0.25, 0.35, 3}, {2600, 2800, 3}, {100, 200, 2}, {0, 20, 3}, {0, 600, 25}}
+};
+
+static void solve(BallisticsTarget* target, double bc, double vi, double zero_range, double angle, double crosswind) {
+  double za = zero_angle(G7, bc, vi, 1.5, zero_range, 0);
+  Ballistics_solve_targets(target, 1, G7, bc, vi, 1.5, angle, za, crosswind, 90);
+}
+
+TEST(SurfaceCheck, QueriesAreWithinTheEstimatedError) {
+  BallisticsSurface* surface = NULL;
+  ASSERT_EQ(0, BallisticsSurface_build(&surface, &config, 2));
+
+  // At a grid point the surface is the solver.
+  BallisticsTarget grid = {300}, solved = {300};
+  EXPECT_EQ(SURFACE_INTERPOLATED, BallisticsSurface_query(surface, &grid, 0.3, 2700, 100, 1, 10, 0));
+  solve(&solved, 0.3, 2700, 100, 10, 0);
+  EXPECT_NEAR(solved.path_inches, grid.path_inches, 1e-9);
+  EXPECT_NEAR(solved.seconds, grid.seconds, 1e-12);
+
+  // Anywhere else, within what the builder measured.  The density ratio divides the coefficient.
+  srand(7);
+  for (int i = 0; i < 40; i++) {
+    double bc = 0.25 + 0.1*rand()/RAND_MAX, vi = 2600 + 200.0*rand()/RAND_MAX;
+    double zero = 100 + 100.0*rand()/RAND_MAX, angle = 20.0*rand()/RAND_MAX, range = 600.0*rand()/RAND_MAX;
+    BallisticsTarget query = {range}, target = {range};
+    ASSERT_EQ(SURFACE_INTERPOLATED, BallisticsSurface_query(surface, &query, bc*0.9, vi, zero, 0.9, angle, 10));
+    solve(&target, bc, vi, zero, angle, 10);
+    EXPECT_NEAR(target.path_inches, query.path_inches,
+                BallisticsSurface_get_estimated_error(surface, SURFACE_PATH)) << i;
+    EXPECT_NEAR(target.seconds, query.seconds, BallisticsSurface_get_estimated_error(surface, SURFACE_SECONDS)) << i;
+    EXPECT_NEAR(target.windage_inches, query.windage_inches,
+                10*17.6*BallisticsSurface_get_estimated_error(surface, SURFACE_LAG)) << i;
+    EXPECT_NEAR(target.v_fps, query.v_fps, BallisticsSurface_get_estimated_error(surface, SURFACE_V)) << i;
+  }
+  EXPECT_LT(BallisticsSurface_get_estimated_error(surface, SURFACE_PATH), 3.0);
+
+  // Outside the grid, the solver answers.
+  BallisticsTarget outside = {800}, expected = {800};
+  EXPECT_EQ(SURFACE_SOLVED, BallisticsSurface_query(surface, &outside, 0.3, 2700, 100, 1, 10, 5));
+  solve(&expected, 0.3, 2700, 100, 10, 5);
+  EXPECT_EQ(expected.path_inches, outside.path_inches);
+  EXPECT_EQ(expected.windage_inches, outside.windage_inches);
+  EXPECT_EQ(SURFACE_E_ARGUMENTS, BallisticsSurface_query(surface, &outside, 0.3, 2700, 100, 0, 10, 5));
+
+  // A target past where the solver stops is an error, not an answer.
+  BallisticsTarget unreached = {60000};
+  EXPECT_EQ(SURFACE_E_OUT_OF_RANGE, BallisticsSurface_query(surface, &unreached, 0.3, 2700, 100, 1, 10, 5));
+
+  BallisticsSurface_free(surface);
+}
+
+TEST(SurfaceCheck, CellsPastToleranceAreSolved) {
+  BallisticsSurface* surface = NULL;
+  ASSERT_EQ(0, BallisticsSurface_build(&surface, &config, 2));
+
+  // Just under the worst cell's estimate leaves some cells interpolated and sends the rest to the solver.
+  double tolerance = BallisticsSurface_get_estimated_error(surface, SURFACE_PATH) * 0.9;
+  BallisticsSurface_set_tolerance(surface, SURFACE_PATH, tolerance);
+  int interpolated = 0, solved = 0;
+  srand(11);
+  for (int i = 0; i < 60; i++) {
+    double bc = 0.25 + 0.1*rand()/RAND_MAX, vi = 2600 + 200.0*rand()/RAND_MAX;
+    double zero = 100 + 100.0*rand()/RAND_MAX, angle = 20.0*rand()/RAND_MAX, range = 600.0*rand()/RAND_MAX;
+    BallisticsTarget query = {range}, target = {range};
+    int status = BallisticsSurface_query(surface, &query, bc, vi, zero, 1, angle, 10);
+    solve(&target, bc, vi, zero, angle, 10);
+    if (status == SURFACE_SOLVED) {
+      solved++;
+      EXPECT_EQ(target.path_inches, query.path_inches) << i;
+      EXPECT_EQ(target.windage_inches, query.windage_inches) << i;
+    } else {
+      ASSERT_EQ(SURFACE_INTERPOLATED, status) << i;
+      interpolated++;
+      EXPECT_NEAR(target.path_inches, query.path_inches, tolerance) << i;
+    }
+  }
+  EXPECT_GT(interpolated, 0);
+  EXPECT_GT(solved, 0);
+
+  // With no error tolerated, nothing is interpolated, even at a grid point.
+  BallisticsSurface_set_tolerance(surface, SURFACE_LAG, 0);
+  BallisticsTarget grid = {300};
+  EXPECT_EQ(SURFACE_SOLVED, BallisticsSurface_query(surface, &grid, 0.3, 2700, 100, 1, 10, 0));
+  BallisticsSurface_free(surface);
+}
+
+TEST(SurfaceCheck, MappedFileAnswersTheSame) {
+  BallisticsSurfaceConfig small = config;
+  small.axes[SURFACE_ANGLE].count = 2;
+  small.axes[SURFACE_RANGE].count = 7;
+  BallisticsSurface* built = NULL;
+  BallisticsSurface* mapped = NULL;
+  ASSERT_EQ(0, BallisticsSurface_build(&built, &small, 1));
+
+  char path[] = "/tmp/surface_checkXXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  FILE* file = fdopen(fd, "wb");
+  ASSERT_EQ(0, BallisticsSurface_write(built, file));
+  fclose(file);
+
+  ASSERT_EQ(0, BallisticsSurface_map(&mapped, path));
+  BallisticsSurfaceConfig read;
+  BallisticsSurface_get_config(mapped, &read);
+  EXPECT_EQ(G7, read.drag_function);
+  EXPECT_EQ(7, read.axes[SURFACE_RANGE].count);
+  for (int o = 0; o < SURFACE_OUTPUTS; o++) {
+    EXPECT_EQ(BallisticsSurface_get_estimated_error(built, (BallisticsSurfaceOutput)o),
+              BallisticsSurface_get_estimated_error(mapped, (BallisticsSurfaceOutput)o));
+  }
+  BallisticsTarget a = {333.3}, b = {333.3};
+  EXPECT_EQ(SURFACE_INTERPOLATED, BallisticsSurface_query(built, &a, 0.31, 2650, 150, 1, 7, 10));
+  EXPECT_EQ(SURFACE_INTERPOLATED, BallisticsSurface_query(mapped, &b, 0.31, 2650, 150, 1, 7, 10));
+  EXPECT_EQ(a.path_inches, b.path_inches);
+  EXPECT_EQ(a.windage_moa, b.windage_moa);
+
+  // The cells' estimates are mapped back too.
+  BallisticsSurface_set_tolerance(built, SURFACE_PATH, 0);
+  BallisticsSurface_set_tolerance(mapped, SURFACE_PATH, 0);
+  EXPECT_EQ(SURFACE_SOLVED, BallisticsSurface_query(built, &a, 0.31, 2650, 150, 1, 7, 10));
+  EXPECT_EQ(SURFACE_SOLVED, BallisticsSurface_query(mapped, &b, 0.31, 2650, 150, 1, 7, 10));
+  EXPECT_EQ(a.path_inches, b.path_inches);
+  BallisticsSurface_free(mapped);
+
+  // A truncated file is refused.
+  ASSERT_EQ(0, truncate(path, 1000));
+  EXPECT_EQ(SURFACE_E_FORMAT, BallisticsSurface_map(&mapped, path));
+  EXPECT_EQ(NULL, mapped);
+  unlink(path);
+  EXPECT_EQ(SURFACE_E_IO, BallisticsSurface_map(&mapped, path));
+
+  small.axes[SURFACE_VELOCITY].count = 1;
+  EXPECT_EQ(SURFACE_E_ARGUMENTS, BallisticsSurface_build(&mapped, &small, 1));
+  BallisticsSurface_free(built);
+}
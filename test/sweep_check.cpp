@@ -0,0 +1,153 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "ballistics/sweep.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static const double bcs[] = {0.25, 0.31};
+static const double velocities[] = {2600, 2850};
+static const double twists[] = {7, 8.5, 10};
+static const double lengths[] = {1.2, 1.35};
+static const BallisticsSweepAtmosphere atmospheres[] = {{0, 29.92, 59, 0.5}, {5000, 25, 20, 0.2}};
+static const double ranges[] = {0, 100, 347.5, 800, 1000};
+
+static BallisticsSweep make_sweep() {
+  BallisticsSweep sweep = {};
+  sweep.drag_function = G7;
+  sweep.form_factor = 1.05;
+  sweep.sight_height = 1.5;
+  sweep.bullet_grains = 140;
+  sweep.caliber = 0.264;
+  sweep.zero_range = 100;
+  sweep.zero_atmosphere = atmospheres[0];
+  sweep.wind_speed = 10;
+  sweep.wind_angle = 90;
+  sweep.drag_coefficients = bcs;
+  sweep.drag_coefficient_count = 2;
+  sweep.velocities = velocities;
+  sweep.velocity_count = 2;
+  sweep.twists = twists;
+  sweep.twist_count = 3;
+  sweep.lengths = lengths;
+  sweep.length_count = 2;
+  sweep.atmospheres = atmospheres;
+  sweep.atmosphere_count = 2;
+  sweep.ranges = ranges;
+  sweep.range_count = 5;
+  return sweep;
+}
+
+static double corrected(double bc, const BallisticsSweepAtmosphere& air) {
+  return atmosphere_correction(bc, air.altitude, air.barometer, air.temperature, air.relative_humidity);
+}
+
+TEST(SweepCheck, CellsMatchTheSolverAndTheSpinFormulas) {
+  BallisticsSweep sweep = make_sweep();
+  std::vector<BallisticsSweepCell> cells(BallisticsSweep_size(&sweep));
+  double zeros[4];
+  ASSERT_EQ(2*2*3*2*2*5u, cells.size());
+  ASSERT_EQ((long)cells.size(), Ballistics_sweep(&sweep, cells.data(), zeros, 3));
+
+  for (int b = 0; b < 2; b++) {
+    for (int v = 0; v < 2; v++) {
+      double za = zero_angle(G7, corrected(bcs[b], atmospheres[0]) / 1.05, velocities[v], 1.5, 100, 0);
+      EXPECT_EQ(za, zeros[b*2 + v]);
+
+      for (int a = 0; a < 2; a++) {
+        double bc = corrected(bcs[b], atmospheres[a]);
+        BallisticsTarget targets[5];
+        for (int r = 0; r < 5; r++) targets[r].range_yards = ranges[r];
+        ASSERT_EQ(5, Ballistics_solve_targets(targets, 5, G7, bc / 1.05, velocities[v], 1.5, 0, za, 10, 90));
+
+        // The modified solver with its spin outputs, for the rows nearest a target.
+        Ballistics* solution = NULL;
+        ASSERT_GT(Ballistics_solve_modified_vertDeflect(&solution, G7, bc, velocities[v], 1.5, 0, za, 10, 90, 0.264,
+                                                        lengths[1], atmospheres[a].temperature,
+                                                        atmospheres[a].barometer, twists[1], 0, 140, 1.05), 800);
+
+        for (int t = 0; t < 3; t++) {
+          for (int l = 0; l < 2; l++) {
+            for (int r = 0; r < 5; r++) {
+              const BallisticsSweepCell& cell = cells[BallisticsSweep_index(&sweep, b, v, t, l, a, r)];
+              double gs = calculateGS(140, twists[t], 0.264, lengths[l], targets[r].v_fps,
+                                      atmospheres[a].temperature, atmospheres[a].barometer);
+              EXPECT_DOUBLE_EQ(gs, cell.stability);
+              EXPECT_DOUBLE_EQ(calculateSpinDriftOffsetIn(gs, targets[r].seconds), cell.spin_drift_inches);
+              EXPECT_EQ(targets[r].seconds, cell.seconds);
+              EXPECT_EQ(targets[r].windage_inches, cell.windage_inches);
+              EXPECT_EQ(targets[r].v_fps, cell.v_fps);
+
+              if (t == 1 && l == 1 && r == 3) {
+                // Rows fall up to half a foot past their yard and record the time at the end of their step.
+                EXPECT_NEAR(Ballistics_get_path(solution, 800), cell.path_inches, 0.2);
+                EXPECT_NEAR(Ballistics_get_moa(solution, 800), cell.moa_correction, 0.01);
+                EXPECT_NEAR(Ballistics_get_spindrift(solution, 800), cell.spin_drift_inches, 0.02);
+                EXPECT_NEAR(calculateGS(140, twists[1], 0.264, lengths[1], Ballistics_get_v_fps(solution, 800),
+                                        atmospheres[a].temperature, atmospheres[a].barometer), cell.stability, 1e-3);
+              }
+            }
+          }
+        }
+        Ballistics_free(solution);
+      }
+    }
+  }
+
+  // A tighter twist is more stable, and a stabler bullet drifts further.
+  const BallisticsSweepCell& fast = cells[BallisticsSweep_index(&sweep, 0, 0, 0, 0, 0, 4)];
+  const BallisticsSweepCell& slow = cells[BallisticsSweep_index(&sweep, 0, 0, 2, 0, 0, 4)];
+  EXPECT_GT(fast.stability, slow.stability);
+  EXPECT_LT(fast.spin_drift_inches, slow.spin_drift_inches);
+}
+
+static int cancel_after(void* context, int done, int total) {
+  int* calls = (int*)context;
+  EXPECT_LE(done, total);
+  return ++*calls >= 3;
+}
+
+TEST(SweepCheck, ProgressCancels) {
+  BallisticsSweep sweep = make_sweep();
+  std::vector<BallisticsSweepCell> cells(BallisticsSweep_size(&sweep));
+  int calls = 0;
+  sweep.progress = cancel_after;
+  sweep.progress_context = &calls;
+
+  EXPECT_EQ(SWEEP_E_CANCELLED, Ballistics_sweep(&sweep, cells.data(), NULL, 1));
+  EXPECT_EQ(3, calls);
+  // On one thread the zeroing is all that ran, so every cell is left zeroed.
+  for (const BallisticsSweepCell& cell : cells) EXPECT_EQ(0, cell.v_fps);
+}
+
+TEST(SweepCheck, RejectsEmptyAxes) {
+  BallisticsSweep sweep = make_sweep();
+  sweep.twist_count = 0;
+  EXPECT_EQ(SWEEP_E_ARGUMENTS, Ballistics_sweep(&sweep, NULL, NULL, 1));
+  sweep = make_sweep();
+  sweep.caliber = 0;
+  EXPECT_EQ(SWEEP_E_ARGUMENTS, Ballistics_sweep(&sweep, NULL, NULL, 1));
+}
+
+TEST(SweepCheck, SameBitsWhateverTheThreadCount) {
+  BallisticsSweep sweep = make_sweep();
+  std::vector<BallisticsSweepCell> one(BallisticsSweep_size(&sweep)), many(one.size());
+  ASSERT_EQ(Ballistics_sweep(&sweep, one.data(), NULL, 1), Ballistics_sweep(&sweep, many.data(), NULL, 0));
+  EXPECT_EQ(0, memcmp(one.data(), many.data(), sizeof(BallisticsSweepCell) * one.size()));
+}
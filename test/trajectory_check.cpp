@@ -0,0 +1,119 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "gtest/gtest.h"
+#include "ballistics/trajectory.hpp"
+
+#include <type_traits>
+#include <utility>
+
+using ballistics::Span;
+using ballistics::Trajectory;
+using ballistics::TrajectoryPool;
+
+static_assert(!std::is_copy_constructible<Trajectory>::value, "trajectories own their storage");
+static_assert(std::is_nothrow_move_constructible<Trajectory>::value, "trajectories move without allocating");
+
+TEST(TrajectoryCheck, ColumnsMatchAccessors) {
+  double zeroAngle = zero_angle(G1, 0.5, 1200, 1.6, 100, 0);
+  Ballistics* solution;
+  int nsoln = Ballistics_solve(&solution, G1, 0.5, 1200, 1.6, 0, zeroAngle, 10, 90);
+
+  Trajectory trajectory;
+  ASSERT_EQ(nsoln, trajectory.solve(G1, 0.5, 1200, 1.6, 0, zeroAngle, 10, 90));
+  ASSERT_EQ((std::size_t) nsoln, trajectory.size());
+  Span<const double> path = trajectory.path();
+  Span<const double> time = trajectory.time();
+  Span<const double> windage = trajectory.windage();
+  ASSERT_EQ((std::size_t) nsoln, path.size());
+  for (int i = 0; i < nsoln; i++) {
+    EXPECT_EQ(Ballistics_get_path(solution, i), path[i]);
+    EXPECT_EQ(Ballistics_get_time(solution, i), time[i]);
+    EXPECT_EQ(Ballistics_get_windage(solution, i), windage[i]);
+  }
+  EXPECT_DOUBLE_EQ(0.021086942030323762, path[100]);
+  EXPECT_EQ(10u, path.subspan(nsoln - 10, 100).size());
+  Ballistics_free(solution);
+}
+
+TEST(TrajectoryCheck, ResolvingReusesStorage) {
+  Trajectory trajectory;
+  double zeroAngle = zero_angle(G7, 0.3, 2700, 1.6, 100, 0);
+  trajectory.solve_spin(G7, 0.3, 2700, 1.6, 0, zeroAngle, 10, 90, 0.308, 1.24, 59, 29.92, 10, 2700, 175, 1);
+  const double* time = trajectory.time().data();
+  const double* spindrift = trajectory.spindrift().data();
+  double drift = trajectory.spindrift()[500];
+  EXPECT_NE(0, drift);
+
+  trajectory.solve_spin(G7, 0.3, 2600, 1.6, 0, zeroAngle, 10, 90, 0.308, 1.24, 59, 29.92, 10, 2600, 175, 1);
+  EXPECT_EQ(time, trajectory.time().data());
+  EXPECT_EQ(spindrift, trajectory.spindrift().data());
+  // The derived column was converted again for the new solve.
+  EXPECT_NE(drift, trajectory.spindrift()[500]);
+  EXPECT_EQ(Ballistics_get_spindrift(trajectory.get(), 500), trajectory.spindrift()[500]);
+
+  // The form factor reaches the solver as it does from C.
+  Ballistics* expected;
+  ASSERT_GT(Ballistics_solve_modified_vertDeflect(&expected, G7, 0.3, 2600, 1.6, 0, zeroAngle, 10, 90, 0.308, 1.24,
+                                                  59, 29.92, 10, 2600, 175, 1.1), 500);
+  trajectory.solve_spin(G7, 0.3, 2600, 1.6, 0, zeroAngle, 10, 90, 0.308, 1.24, 59, 29.92, 10, 2600, 175, 1.1);
+  EXPECT_EQ(Ballistics_get_spindrift(expected, 500), trajectory.spindrift()[500]);
+  EXPECT_EQ(Ballistics_get_path(expected, 500), trajectory.path()[500]);
+  Ballistics_free(expected);
+
+  // A plain solve into the same storage drops the spin outputs.
+  trajectory.solve(G7, 0.3, 2600, 1.6, 0, zeroAngle, 10, 90);
+  EXPECT_EQ(0, trajectory.spindrift()[500]);
+}
+
+TEST(TrajectoryCheck, MovesAndPools) {
+  TrajectoryPool pool;
+  pool.reserve(2);
+  EXPECT_EQ(2u, pool.available());
+
+  Ballistics* first;
+  {
+    Trajectory a = pool.acquire();
+    EXPECT_EQ(1u, pool.available());
+    first = a.get();
+    a.solve(G1, 0.5, 1200, 1.6, 0, 0, 0, 0);
+
+    Trajectory b(std::move(a));
+    EXPECT_EQ(nullptr, a.get());
+    EXPECT_EQ(0u, a.size());
+    EXPECT_TRUE(a.path().empty());
+    // Moved from, it has nothing to solve into.
+    EXPECT_EQ(BALLISTICS_E_NO_MEMORY, a.solve(G1, 0.5, 1200, 1.6, 0, 0, 0, 0));
+    EXPECT_EQ(BALLISTICS_E_NO_MEMORY, a.solve_spin(G1, 0.5, 1200, 1.6, 0, 0, 10, 90, 0.308, 1.24, 59, 29.92, 10,
+                                                   1200, 175, 1));
+    EXPECT_EQ(BALLISTICS_E_NO_MEMORY, a.extend(100));
+    EXPECT_EQ(0u, a.size());
+    EXPECT_EQ(first, b.get());
+    EXPECT_LT(1000u, b.size());
+
+    Trajectory c = pool.acquire();
+    EXPECT_EQ(0u, pool.available());
+    c = std::move(b); // c's own storage goes back to the pool
+    EXPECT_EQ(1u, pool.available());
+    EXPECT_EQ(first, c.get());
+  }
+  EXPECT_EQ(2u, pool.available());
+
+  // Recycled storage comes back out of the pool.
+  Trajectory d = pool.acquire();
+  EXPECT_EQ(first, d.get());
+}
@@ -0,0 +1,72 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "ballistics/ballistics.h"
+
+namespace {
+  class TruingTest : public ::testing::Test {
+  protected:
+    TruingObservation observations[4];
+
+    // Generates observed impacts from a "true" load the fit should recover.
+    virtual void SetUp() {
+      double angle;
+      double zeroRange = 100;
+      BallisticsTarget targets[] = {{800}, {300}, {1000}, {600}};
+
+      ASSERT_EQ(0, zero_angles(&angle, G7, 0.262, 2710, 1.75, &zeroRange, NULL, 1));
+      ASSERT_EQ(4, Ballistics_solve_targets(targets, 4, G7, 0.262, 2710, 1.75, 0, angle, 0, 0));
+      for (int i = 0; i < 4; i++) {
+        observations[i].range_yards = targets[i].range_yards;
+        observations[i].path_inches = targets[i].path_inches;
+      }
+    }
+  };
+
+  TEST_F(TruingTest, DragCoefficient) {
+    double bc = 0.3;
+    double v = 2710;
+    double rms;
+
+    EXPECT_LT(0, Truing_solve(&bc, &v, &rms, TRUING_FIT_DRAG_COEFFICIENT, observations, 4, G7, 1.75, 0, 100, 0));
+    EXPECT_NEAR(0.262, bc, 1e-4);
+    EXPECT_EQ(2710, v);
+    EXPECT_LT(rms, 0.01);
+  }
+
+  TEST_F(TruingTest, DragCoefficientAndVelocity) {
+    double bc = 0.24;
+    double v = 2800;
+    double rms;
+
+    EXPECT_LT(0, Truing_solve(&bc, &v, &rms, TRUING_FIT_DRAG_COEFFICIENT | TRUING_FIT_VELOCITY, observations, 4,
+                              G7, 1.75, 0, 100, 0));
+    EXPECT_NEAR(0.262, bc, 1e-3);
+    EXPECT_NEAR(2710, v, 2);
+    EXPECT_LT(rms, 0.05);
+  }
+
+  TEST_F(TruingTest, OutOfRange) {
+    double bc = 0.262;
+    double v = 2710;
+    observations[0].range_yards = 60000;
+
+    EXPECT_EQ(TRUING_E_OUT_OF_RANGE, Truing_solve(&bc, &v, NULL, TRUING_FIT_DRAG_COEFFICIENT, observations, 4,
+                                                  G7, 1.75, 0, 100, 0));
+    EXPECT_EQ(0.262, bc);
+  }
+} // namespace
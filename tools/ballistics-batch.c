@@ -0,0 +1,253 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Zeroes and solves a file of loads, in parallel, and writes a range card for each one in input order.
+//
+//   ballistics-batch [-j threads] [-b batch] [-r first,last,step] [-p vital_size] [records [results]]
+//
+// Each input line is one record, fields separated by whitespace or commas:
+//
+//   id drag_function bc vi sight_height zero_range [altitude barometer temperature humidity [angle [wind_speed wind_angle]]]
+//
+// where drag_function is G1..G8.  Without the atmosphere, the bc is used as given.  Blank lines and lines
+// starting with '#' are skipped.  Each record gets one output line per card range:
+//
+//   id,range_yards,path_inches,moa_correction,windage_inches,windage_moa,seconds,v_fps
+//
+// or, with -p, one point-blank-range line for the given vital zone size:
+//
+//   id,near_zero_yards,far_zero_yards,min_PBR_yards,max_PBR_yards,sight_in_at_100yards
+//
+// Records are read, solved and written a batch at a time, so memory stays bounded however long the input is.
+// Records that can't be parsed or solved are reported on stderr and left out.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ballistics/batch.h"
+
+#define MAX_CARD_RANGES 1024
+#define MAX_ID 64
+
+typedef struct {
+  char id[MAX_ID];
+  long line;
+  BallisticsBatchItem item;
+  double vital_size;
+  struct PBR* pbr;
+  int pbr_status;
+} Record;
+
+static void usage(void) {
+  fprintf(stderr, "usage: ballistics-batch [-j threads] [-b batch] [-r first,last,step] [-p vital_size] "
+                  "[records [results]]\n");
+  exit(2);
+}
+
+static int parse_drag_function(const char* text, DragFunction* drag_function) {
+  if ((text[0] == 'G' || text[0] == 'g') && text[1] >= '1' && text[1] <= '8' && text[2] == '\0') {
+    *drag_function = (DragFunction)(text[1] - '0');
+    return 0;
+  }
+  return -1;
+}
+
+// Parses one record line.  Returns 1 for a record, 0 for a line to skip, or -1 for a malformed line.
+static int parse_record(char* line, Record* record) {
+  char* fields[15];
+  char* save;
+  char* token;
+  double values[15];
+  int count = 0;
+  int i;
+
+  for (token = strtok_r(line, " \t,\r\n", &save); token; token = strtok_r(NULL, " \t,\r\n", &save)) {
+    if (count == 0 && token[0] == '#') return 0;
+    if (count == 15) return -1;
+    fields[count++] = token;
+  }
+  if (count == 0) return 0;
+  if (count != 6 && count != 10 && count != 11 && count != 13) return -1;
+
+  if (strlen(fields[0]) >= MAX_ID || parse_drag_function(fields[1], &record->item.drag_function)) return -1;
+  strcpy(record->id, fields[0]);
+  for (i = 2; i < count; i++) {
+    char* end;
+    values[i] = strtod(fields[i], &end);
+    if (end == fields[i] || *end) return -1;
+  }
+
+  record->item.drag_coefficient = values[2];
+  record->item.vi = values[3];
+  record->item.sight_height = values[4];
+  record->item.zero_range = values[5];
+  record->item.y_intercept = 0;
+  record->item.shooting_angle = count > 10 ? values[10] : 0;
+  record->item.wind_speed = count > 11 ? values[11] : 0;
+  record->item.wind_angle = count > 11 ? values[12] : 0;
+  if (count >= 10) {
+    record->item.drag_coefficient = atmosphere_correction(record->item.drag_coefficient, values[6], values[7],
+                                                          values[8], values[9]);
+  }
+  if (record->item.drag_coefficient <= 0 || record->item.vi <= 0 || record->item.zero_range <= 0) return -1;
+  return 1;
+}
+
+static void solve_pbr(void* context, int index) {
+  Record* record = &((Record*)context)[index];
+  record->pbr = NULL;
+  record->pbr_status = PBR_solve(&record->pbr, record->item.drag_function, record->item.drag_coefficient,
+                                 record->item.vi, record->item.sight_height, record->vital_size);
+}
+
+static double seconds_since(const struct timespec* start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+int main(int argc, char** argv) {
+  int threads = 0;
+  int batch = 4096;
+  double first = 100, last = 1000, step = 100;
+  double vital_size = 0;
+  int card_ranges = 0;
+  FILE* in = stdin;
+  FILE* out = stdout;
+  Record* records;
+  BallisticsBatchItem* items;
+  BallisticsTarget* targets;
+  char line[1024];
+  long line_number = 0;
+  long solved = 0, failed = 0;
+  struct timespec start;
+  int c, eof = 0;
+
+  while ((c = getopt(argc, argv, "j:b:r:p:")) != -1) {
+    switch (c) {
+      case 'j': threads = atoi(optarg); break;
+      case 'b': batch = atoi(optarg); break;
+      case 'r': if (sscanf(optarg, "%lf,%lf,%lf", &first, &last, &step) != 3) usage(); break;
+      case 'p': vital_size = atof(optarg); break;
+      default: usage();
+    }
+  }
+  if (argc - optind > 2 || batch <= 0 || step <= 0 || first < 0 || last < first) usage();
+  card_ranges = (int)((last - first) / step) + 1;
+  if (card_ranges > MAX_CARD_RANGES) usage();
+
+  if (argc - optind >= 1 && strcmp(argv[optind], "-") && !(in = fopen(argv[optind], "r"))) {
+    fprintf(stderr, "ballistics-batch: can't read %s\n", argv[optind]);
+    return 1;
+  }
+  if (argc - optind == 2 && !(out = fopen(argv[optind + 1], "w"))) {
+    fprintf(stderr, "ballistics-batch: can't write %s\n", argv[optind + 1]);
+    return 1;
+  }
+
+  // Everything is allocated once, for one batch.
+  records = malloc(sizeof(Record) * batch);
+  items = malloc(sizeof(BallisticsBatchItem) * batch);
+  targets = malloc(sizeof(BallisticsTarget) * batch * card_ranges);
+  if (!records || !items || !targets) {
+    fprintf(stderr, "ballistics-batch: out of memory\n");
+    return 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (!eof) {
+    int count = 0;
+    int i, r;
+
+    while (count < batch) {
+      int parsed;
+      if (!fgets(line, sizeof(line), in)) {
+        eof = 1;
+        break;
+      }
+      line_number++;
+      parsed = parse_record(line, &records[count]);
+      if (parsed < 0) {
+        fprintf(stderr, "ballistics-batch: line %ld: malformed record\n", line_number);
+        failed++;
+      }
+      else if (parsed > 0) {
+        records[count].line = line_number;
+        records[count].vital_size = vital_size;
+        count++;
+      }
+    }
+    if (count == 0) break;
+
+    if (vital_size > 0) {
+      Ballistics_parallel_for(count, threads, solve_pbr, records);
+    }
+    else {
+      for (i = 0; i < count; i++) {
+        items[i] = records[i].item;
+        items[i].targets = &targets[(size_t)i * card_ranges];
+        items[i].target_count = card_ranges;
+        for (r = 0; r < card_ranges; r++) {
+          items[i].targets[r].range_yards = first + r * step;
+        }
+      }
+      Ballistics_solve_batch(items, count, threads);
+    }
+
+    for (i = 0; i < count; i++) {
+      Record* record = &records[i];
+      if (vital_size > 0) {
+        if (record->pbr_status) {
+          fprintf(stderr, "ballistics-batch: line %ld: no point blank range (%d)\n", record->line,
+                  record->pbr_status);
+          failed++;
+          continue;
+        }
+        fprintf(out, "%s,%d,%d,%d,%d,%.2f\n", record->id, PBR_get_near_zero_yards(record->pbr),
+                PBR_get_far_zero_yards(record->pbr), PBR_get_min_PBR_yards(record->pbr),
+                PBR_get_max_PBR_yards(record->pbr), PBR_get_sight_in_at_100yards(record->pbr) / 100.0);
+        PBR_free(record->pbr);
+      }
+      else {
+        BallisticsBatchItem* item = &items[i];
+        if (item->status < 0) {
+          fprintf(stderr, "ballistics-batch: line %ld: can't solve (%d)\n", record->line, item->status);
+          failed++;
+          continue;
+        }
+        // Ranges the projectile never reaches are left off the card.
+        for (r = 0; r < item->status; r++) {
+          BallisticsTarget* target = &item->targets[r];
+          fprintf(out, "%s,%.0f,%.2f,%.2f,%.2f,%.2f,%.4f,%.0f\n", record->id, target->range_yards,
+                  target->path_inches, target->moa_correction, target->windage_inches, target->windage_moa,
+                  target->seconds, target->v_fps);
+        }
+      }
+      solved++;
+    }
+  }
+
+  if (ferror(in) || fflush(out) || ferror(out)) {
+    fprintf(stderr, "ballistics-batch: I/O error\n");
+    return 1;
+  }
+  double elapsed = seconds_since(&start);
+  fprintf(stderr, "ballistics-batch: %ld records solved, %ld failed, in %.2f s (%.0f records/s)\n", solved, failed,
+          elapsed, elapsed > 0 ? solved / elapsed : 0);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Load generator for ballisticsd.
+//
+//   ballistics-load [-s socket] [-c clients] [-n requests] [-d distinct_loads] [-t targets]
+//
+// Each client thread opens its own connection and sends requests one at a time, waiting for each response,
+// cycling through distinct_loads different loads from a per-client starting point so clients overlap.  At the end
+// it reports throughput and the latency distribution over every request.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "ballistics/daemon.h"
+
+typedef struct {
+  const char* path;
+  int index;
+  int requests;
+  int distinct;
+  int targets;
+  double* latencies; // in microseconds, one per request
+  int failures;
+} Client;
+
+static void usage(void) {
+  fprintf(stderr, "usage: ballistics-load [-s socket] [-c clients] [-n requests] [-d distinct_loads] [-t targets]\n");
+  exit(2);
+}
+
+static double now_us(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec * 1e6 + (double)now.tv_nsec * 1e-3;
+}
+
+static int connect_to(const char* path) {
+  struct sockaddr_un address;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  if (connect(fd, (struct sockaddr*)&address, sizeof(address))) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int transfer(int fd, void* data, size_t size, int sending) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = sending ? write(fd, (char*)data + done, size - done) : read(fd, (char*)data + done, size - done);
+    if (n <= 0) return -1;
+    done += (size_t)n;
+  }
+  return 0;
+}
+
+static void* run_client(void* arg) {
+  Client* client = arg;
+  BallisticsdRequest request;
+  BallisticsdResponse response;
+  int fd = connect_to(client->path);
+  int i, t;
+
+  if (fd < 0) {
+    client->failures = client->requests;
+    return NULL;
+  }
+
+  memset(&request, 0, sizeof(request));
+  request.magic = BALLISTICSD_MAGIC;
+  request.drag_function = G7;
+  request.sight_height = 1.5;
+  request.zero_range = 100;
+  request.wind_speed = 10;
+  request.wind_angle = 90;
+  request.target_count = client->targets;
+  for (t = 0; t < client->targets; t++) request.ranges[t] = 100 * (t + 1);
+
+  for (i = 0; i < client->requests; i++) {
+    int load = (client->index * 7919 + i) % client->distinct;
+    double start;
+
+    request.id = (uint32_t)i;
+    request.drag_coefficient = 0.2 + 0.0001 * (load % 2000);
+    request.vi = 2400 + load / 2000;
+
+    start = now_us();
+    if (transfer(fd, &request, BallisticsdRequest_size(request.target_count), 1) ||
+        transfer(fd, &response, offsetof(BallisticsdResponse, targets), 0) ||
+        transfer(fd, response.targets, sizeof(BallisticsTarget) * (size_t)response.target_count, 0)) {
+      client->failures += client->requests - i;
+      break;
+    }
+    client->latencies[i] = now_us() - start;
+    if (response.id != request.id || response.status < 0) client->failures++;
+  }
+  close(fd);
+  return NULL;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+  double da = *(const double*)a;
+  double db = *(const double*)b;
+  return (da > db) - (da < db);
+}
+
+int main(int argc, char** argv) {
+  const char* path = BALLISTICSD_SOCKET;
+  int clients = 8, requests = 1000, distinct = 100, targets = 10;
+  Client* state;
+  pthread_t* threads;
+  double* latencies;
+  double start, elapsed;
+  long total, failures = 0;
+  int c, i;
+
+  while ((c = getopt(argc, argv, "s:c:n:d:t:")) != -1) {
+    switch (c) {
+      case 's': path = optarg; break;
+      case 'c': clients = atoi(optarg); break;
+      case 'n': requests = atoi(optarg); break;
+      case 'd': distinct = atoi(optarg); break;
+      case 't': targets = atoi(optarg); break;
+      default: usage();
+    }
+  }
+  if (optind != argc || clients <= 0 || requests <= 0 || distinct <= 0 || targets < 0 ||
+      targets > BALLISTICSD_MAX_TARGETS) {
+    usage();
+  }
+
+  total = (long)clients * requests;
+  state = calloc(clients, sizeof(Client));
+  threads = calloc(clients, sizeof(pthread_t));
+  latencies = calloc(total, sizeof(double));
+  if (!state || !threads || !latencies) {
+    fprintf(stderr, "ballistics-load: out of memory\n");
+    return 1;
+  }
+
+  start = now_us();
+  for (i = 0; i < clients; i++) {
+    state[i].path = path;
+    state[i].index = i;
+    state[i].requests = requests;
+    state[i].distinct = distinct;
+    state[i].targets = targets;
+    state[i].latencies = &latencies[(long)i * requests];
+    pthread_create(&threads[i], NULL, run_client, &state[i]);
+  }
+  for (i = 0; i < clients; i++) {
+    pthread_join(threads[i], NULL);
+    failures += state[i].failures;
+  }
+  elapsed = (now_us() - start) * 1e-6;
+
+  qsort(latencies, total, sizeof(double), compare_doubles);
+  printf("%ld requests in %.2f s: %.0f requests/s, %ld failed\n", total, elapsed, total / elapsed, failures);
+  printf("latency us: p50 %.0f  p90 %.0f  p99 %.0f  max %.0f\n", latencies[total / 2],
+         latencies[(long)(total * 0.9)], latencies[(long)(total * 0.99)], latencies[total - 1]);
+  return failures ? 1 : 0;
+}
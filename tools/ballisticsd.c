@@ -0,0 +1,566 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A solver daemon, so many processes can share one set of solver threads and one cache.
+//
+//   ballisticsd [-s socket] [-j threads] [-b max_batch] [-w window_us] [-c cache_slots]
+//
+// Requests arrive over a Unix domain socket in the protocol of ballistics/daemon.h.  The event loop answers
+// repeated requests from a cache, and joins a request identical to one already being solved onto that solve
+// instead of starting another.  Everything else is queued for the solver thread, which waits up to window_us for
+// more requests to arrive and solves up to max_batch at once with Ballistics_solve_batch().
+//
+// On SIGINT or SIGTERM the daemon removes its socket and prints its counters on stderr.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "ballistics/batch.h"
+#include "ballistics/daemon.h"
+
+#define MAX_CONNECTIONS 1024
+#define INFLIGHT_BUCKETS 4096
+// The most response bytes a connection may have queued or coming before the daemon stops reading its requests.
+#define MAX_OUTPUT (4 << 20)
+
+// The part of a request that decides its result: everything after the magic and id.
+#define KEY_OFFSET offsetof(BallisticsdRequest, drag_function)
+
+typedef struct {
+  int connection;
+  unsigned generation;
+  uint32_t id;
+} Waiter;
+
+/**
+ * One distinct request being solved, and every client waiting for it.
+ */
+typedef struct Job {
+  BallisticsdRequest request;
+  size_t key_size;
+  uint64_t hash;
+  BallisticsBatchItem item;
+  BallisticsTarget targets[BALLISTICSD_MAX_TARGETS];
+
+  Waiter* waiters;
+  int waiter_count;
+  int waiter_capacity;
+
+  struct Job* next_inflight; // in its in-flight bucket
+  struct Job* next_queued;   // in the pending or done queue
+} Job;
+
+typedef struct {
+  uint64_t hash;
+  size_t key_size;
+  BallisticsdRequest request;
+  BallisticsdResponse response;
+} CacheEntry;
+
+typedef struct {
+  int fd;
+  unsigned generation;
+  unsigned char in[sizeof(BallisticsdRequest)];
+  size_t in_used;
+  unsigned char* out;
+  size_t out_used;
+  size_t out_capacity;
+  int waiting;          // requests being solved that this connection waits on
+} Connection;
+
+static volatile sig_atomic_t stopping = 0;
+
+static Connection connections[MAX_CONNECTIONS];
+static Job* inflight[INFLIGHT_BUCKETS];
+static CacheEntry** cache;
+static size_t cache_slots;
+
+// Shared between the event loop and the solver thread.
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER;
+static Job* pending_head;
+static Job* pending_tail;
+static int pending_count;
+static Job* done_head;
+static int wake_pipe[2];
+
+static int max_batch = 64;
+static long window_us = 200;
+static int threads = 0;
+
+static unsigned long requests, cache_hits, coalesced, solves, batches;
+
+static void on_signal(int signal) {
+  (void)signal;
+  stopping = 1;
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: ballisticsd [-s socket] [-j threads] [-b max_batch] [-w window_us] [-c cache_slots]\n");
+  exit(2);
+}
+
+static uint64_t hash_key(const void* key, size_t size) {
+  const unsigned char* bytes = key;
+  uint64_t hash = 14695981039346656037ULL; // FNV-1a
+  size_t i;
+  for (i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static int same_key(const BallisticsdRequest* a, size_t a_size, const BallisticsdRequest* b, size_t b_size) {
+  return a_size == b_size && memcmp((const char*)a + KEY_OFFSET, (const char*)b + KEY_OFFSET, a_size) == 0;
+}
+
+static void close_connection(int c) {
+  Connection* connection = &connections[c];
+  close(connection->fd);
+  free(connection->out);
+  connection->fd = -1;
+  connection->out = NULL;
+  connection->out_used = connection->out_capacity = 0;
+  connection->in_used = 0;
+  connection->waiting = 0;
+  connection->generation++; // responses still being solved for this client are dropped
+}
+
+/**
+ * Whether a connection has as much output queued, counting the responses still being solved for it, as it may.
+ * A client that sends without reading stops being read until it catches up, rather than growing the daemon.
+ */
+static int output_full(int c) {
+  const Connection* connection = &connections[c];
+  return connection->out_used + (size_t)connection->waiting * sizeof(BallisticsdResponse) >= MAX_OUTPUT;
+}
+
+static void queue_output(int c, const void* data, size_t size) {
+  Connection* connection = &connections[c];
+  if (connection->out_used + size > connection->out_capacity) {
+    size_t capacity = connection->out_capacity ? connection->out_capacity * 2 : 65536;
+    unsigned char* out;
+    while (capacity < connection->out_used + size) capacity *= 2;
+    out = realloc(connection->out, capacity);
+    if (!out) {
+      // A client that silently misses a response would wait for it forever; hanging up tells it at once.
+      fprintf(stderr, "ballisticsd: out of memory for a response; closing the connection\n");
+      close_connection(c);
+      return;
+    }
+    connection->out = out;
+    connection->out_capacity = capacity;
+  }
+  memcpy(connection->out + connection->out_used, data, size);
+  connection->out_used += size;
+}
+
+static void flush_output(int c) {
+  Connection* connection = &connections[c];
+  size_t sent = 0;
+  while (sent < connection->out_used) {
+    ssize_t n = write(connection->fd, connection->out + sent, connection->out_used - sent);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      close_connection(c);
+      return;
+    }
+    sent += (size_t)n;
+  }
+  memmove(connection->out, connection->out + sent, connection->out_used - sent);
+  connection->out_used -= sent;
+}
+
+static void respond(int c, const BallisticsdResponse* response, uint32_t id) {
+  BallisticsdResponse copy;
+  size_t size = BallisticsdResponse_size(response->target_count);
+  memcpy(&copy, response, size);
+  copy.id = id;
+  queue_output(c, &copy, size);
+}
+
+static void reject(int c, const BallisticsdRequest* request, int status) {
+  BallisticsdResponse response;
+  memset(&response, 0, sizeof(response));
+  response.magic = BALLISTICSD_MAGIC;
+  response.status = status;
+  response.target_count = 0;
+  respond(c, &response, request->id);
+}
+
+static int add_waiter(Job* job, int c, uint32_t id) {
+  if (job->waiter_count == job->waiter_capacity) {
+    int capacity = job->waiter_capacity ? job->waiter_capacity * 2 : 4;
+    Waiter* waiters = realloc(job->waiters, sizeof(Waiter) * capacity);
+    if (!waiters) return -1;
+    job->waiters = waiters;
+    job->waiter_capacity = capacity;
+  }
+  job->waiters[job->waiter_count].connection = c;
+  job->waiters[job->waiter_count].generation = connections[c].generation;
+  job->waiters[job->waiter_count].id = id;
+  job->waiter_count++;
+  connections[c].waiting++;
+  return 0;
+}
+
+static void handle_request(int c, const BallisticsdRequest* request) {
+  size_t size = BallisticsdRequest_size(request->target_count);
+  size_t key_size = size - KEY_OFFSET;
+  uint64_t hash = hash_key((const char*)request + KEY_OFFSET, key_size);
+  CacheEntry* entry = cache_slots ? cache[hash % cache_slots] : NULL;
+  Job** bucket = &inflight[hash % INFLIGHT_BUCKETS];
+  Job* job;
+  int i;
+
+  requests++;
+  if (request->drag_function < G1 || request->drag_function > G8 || !(request->drag_coefficient > 0) ||
+      !(request->vi > 0)) {
+    reject(c, request, BALLISTICSD_E_BAD_REQUEST);
+    return;
+  }
+
+  if (entry && entry->hash == hash && same_key(&entry->request, entry->key_size, request, key_size)) {
+    cache_hits++;
+    respond(c, &entry->response, request->id);
+    return;
+  }
+
+  for (job = *bucket; job; job = job->next_inflight) {
+    if (job->hash == hash && same_key(&job->request, job->key_size, request, key_size)) {
+      if (add_waiter(job, c, request->id)) reject(c, request, BALLISTICSD_E_NO_MEMORY);
+      else coalesced++;
+      return;
+    }
+  }
+
+  job = calloc(1, sizeof(Job));
+  if (!job || add_waiter(job, c, request->id)) {
+    free(job);
+    reject(c, request, BALLISTICSD_E_NO_MEMORY);
+    return;
+  }
+  memcpy(&job->request, request, size);
+  job->key_size = key_size;
+  job->hash = hash;
+  job->item.drag_function = (DragFunction)request->drag_function;
+  job->item.drag_coefficient = request->drag_coefficient;
+  job->item.vi = request->vi;
+  job->item.sight_height = request->sight_height;
+  job->item.zero_range = request->zero_range;
+  job->item.y_intercept = request->y_intercept;
+  job->item.shooting_angle = request->shooting_angle;
+  job->item.wind_speed = request->wind_speed;
+  job->item.wind_angle = request->wind_angle;
+  job->item.targets = job->targets;
+  job->item.target_count = request->target_count;
+  for (i = 0; i < request->target_count; i++) {
+    job->targets[i].range_yards = request->ranges[i];
+  }
+  job->next_inflight = *bucket;
+  *bucket = job;
+
+  pthread_mutex_lock(&queue_lock);
+  if (pending_tail) pending_tail->next_queued = job;
+  else pending_head = job;
+  pending_tail = job;
+  pending_count++;
+  pthread_cond_signal(&queue_ready);
+  pthread_mutex_unlock(&queue_lock);
+}
+
+static void read_requests(int c) {
+  Connection* connection = &connections[c];
+
+  for (;;) {
+    BallisticsdRequest* request = (BallisticsdRequest*)connection->in;
+    size_t needed = offsetof(BallisticsdRequest, drag_coefficient);
+    ssize_t n;
+
+    if (connection->in_used >= needed) {
+      if (request->magic != BALLISTICSD_MAGIC || request->target_count < 0 ||
+          request->target_count > BALLISTICSD_MAX_TARGETS) {
+        close_connection(c);
+        return;
+      }
+      needed = BallisticsdRequest_size(request->target_count);
+      if (connection->in_used == needed) {
+        handle_request(c, request);
+        if (connection->fd < 0) return; // closed for want of memory to answer on
+        connection->in_used = 0;
+        continue;
+      }
+    }
+
+    // Whatever is left of a request waits in the socket until the client has taken some of its responses.
+    if (output_full(c)) return;
+    n = read(connection->fd, connection->in + connection->in_used, needed - connection->in_used);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (n <= 0) {
+      close_connection(c);
+      return;
+    }
+    connection->in_used += (size_t)n;
+  }
+}
+
+static void finish_jobs(void) {
+  char drain[64];
+  Job* job;
+  Job* next;
+
+  while (read(wake_pipe[0], drain, sizeof(drain)) > 0) {}
+
+  pthread_mutex_lock(&queue_lock);
+  job = done_head;
+  done_head = NULL;
+  pthread_mutex_unlock(&queue_lock);
+
+  for (; job; job = next) {
+    BallisticsdResponse response;
+    Job** link = &inflight[job->hash % INFLIGHT_BUCKETS];
+    int i;
+
+    next = job->next_queued;
+    response.magic = BALLISTICSD_MAGIC;
+    response.status = job->item.status;
+    response.target_count = job->item.target_count;
+    response.zero_angle = job->item.zero_angle;
+    memcpy(response.targets, job->targets, sizeof(BallisticsTarget) * job->item.target_count);
+
+    for (i = 0; i < job->waiter_count; i++) {
+      Waiter* waiter = &job->waiters[i];
+      Connection* connection = &connections[waiter->connection];
+      if (connection->fd >= 0 && connection->generation == waiter->generation) {
+        connection->waiting--;
+        respond(waiter->connection, &response, waiter->id);
+      }
+    }
+
+    if (cache_slots) {
+      CacheEntry** slot = &cache[job->hash % cache_slots];
+      if (!*slot) *slot = malloc(sizeof(CacheEntry));
+      if (*slot) {
+        (*slot)->hash = job->hash;
+        (*slot)->key_size = job->key_size;
+        (*slot)->request = job->request;
+        (*slot)->response = response;
+      }
+    }
+
+    while (*link != job) link = &(*link)->next_inflight;
+    *link = job->next_inflight;
+    free(job->waiters);
+    free(job);
+  }
+}
+
+static void* solver(void* arg) {
+  BallisticsBatchItem* items = malloc(sizeof(BallisticsBatchItem) * max_batch);
+  Job** jobs = malloc(sizeof(Job*) * max_batch);
+  (void)arg;
+  if (!items || !jobs) {
+    fprintf(stderr, "ballisticsd: out of memory\n");
+    exit(1);
+  }
+
+  pthread_mutex_lock(&queue_lock);
+  while (!stopping) {
+    struct timespec deadline;
+    int count = 0;
+    int i;
+
+    if (!pending_head) {
+      pthread_cond_wait(&queue_ready, &queue_lock);
+      continue;
+    }
+
+    // Give concurrent requests a moment to arrive, so they can share the batch.
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += window_us * 1000;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+    while (!stopping && pending_count < max_batch) {
+      if (pthread_cond_timedwait(&queue_ready, &queue_lock, &deadline) == ETIMEDOUT) break;
+    }
+
+    while (pending_head && count < max_batch) {
+      jobs[count] = pending_head;
+      items[count] = pending_head->item;
+      pending_head = pending_head->next_queued;
+      pending_count--;
+      count++;
+    }
+    if (!pending_head) pending_tail = NULL;
+    pthread_mutex_unlock(&queue_lock);
+
+    Ballistics_solve_batch(items, count, threads);
+
+    pthread_mutex_lock(&queue_lock);
+    for (i = 0; i < count; i++) {
+      jobs[i]->item = items[i];
+      jobs[i]->next_queued = done_head;
+      done_head = jobs[i];
+    }
+    solves += count;
+    batches++;
+    if (write(wake_pipe[1], "", 1) < 0) {} // the pipe is non-blocking; a full pipe is already awake
+  }
+  pthread_mutex_unlock(&queue_lock);
+  free(items);
+  free(jobs);
+  return NULL;
+}
+
+static int listen_on(const char* path) {
+  struct sockaddr_un address;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (fd < 0 || strlen(path) >= sizeof(address.sun_path)) return -1;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+  unlink(path);
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) || listen(fd, 128)) {
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+int main(int argc, char** argv) {
+  const char* path = BALLISTICSD_SOCKET;
+  static struct pollfd fds[2 + MAX_CONNECTIONS];
+  static int fd_connection[2 + MAX_CONNECTIONS];
+  struct sigaction action;
+  pthread_t solver_thread;
+  int listener;
+  int c, i;
+
+  cache_slots = 16384;
+  while ((c = getopt(argc, argv, "s:j:b:w:c:")) != -1) {
+    switch (c) {
+      case 's': path = optarg; break;
+      case 'j': threads = atoi(optarg); break;
+      case 'b': max_batch = atoi(optarg); break;
+      case 'w': window_us = atol(optarg); break;
+      case 'c': cache_slots = (size_t)atol(optarg); break;
+      default: usage();
+    }
+  }
+  if (optind != argc || max_batch <= 0 || window_us < 0) usage();
+
+  cache = calloc(cache_slots ? cache_slots : 1, sizeof(CacheEntry*));
+  if (!cache || pipe(wake_pipe)) {
+    fprintf(stderr, "ballisticsd: out of memory\n");
+    return 1;
+  }
+  fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+  for (i = 0; i < MAX_CONNECTIONS; i++) connections[i].fd = -1;
+
+  listener = listen_on(path);
+  if (listener < 0) {
+    fprintf(stderr, "ballisticsd: can't listen on %s\n", path);
+    return 1;
+  }
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (pthread_create(&solver_thread, NULL, solver, NULL)) {
+    fprintf(stderr, "ballisticsd: can't start the solver\n");
+    return 1;
+  }
+
+  while (!stopping) {
+    int count = 2;
+
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_pipe[0];
+    fds[1].events = POLLIN;
+    for (i = 0; i < MAX_CONNECTIONS; i++) {
+      if (connections[i].fd < 0) continue;
+      fds[count].fd = connections[i].fd;
+      fds[count].events = (output_full(i) ? 0 : POLLIN) | (connections[i].out_used ? POLLOUT : 0);
+      fd_connection[count] = i;
+      count++;
+    }
+
+    if (poll(fds, count, -1) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    if (fds[1].revents) finish_jobs();
+
+    for (i = 2; i < count; i++) {
+      int connection = fd_connection[i];
+      if (connections[connection].fd != fds[i].fd) continue;
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+        // A full connection that hung up can't take its output, so it is only read to notice the hang-up.
+        if (output_full(connection) && (fds[i].revents & (POLLHUP | POLLERR))) close_connection(connection);
+        else read_requests(connection);
+      }
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int fd;
+      while ((fd = accept(listener, NULL, NULL)) >= 0) {
+        for (i = 0; i < MAX_CONNECTIONS && connections[i].fd >= 0; i++) {}
+        if (i == MAX_CONNECTIONS) {
+          close(fd);
+          continue;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        connections[i].fd = fd;
+      }
+    }
+
+    // Cache hits and finished solves were queued above; send them all in as few writes as possible.
+    for (i = 0; i < MAX_CONNECTIONS; i++) {
+      if (connections[i].fd >= 0 && connections[i].out_used) flush_output(i);
+    }
+  }
+
+  pthread_mutex_lock(&queue_lock);
+  pthread_cond_signal(&queue_ready);
+  pthread_mutex_unlock(&queue_lock);
+  pthread_join(solver_thread, NULL);
+  close(listener);
+  unlink(path);
+
+  fprintf(stderr, "ballisticsd: %lu requests, %lu cache hits, %lu coalesced, %lu solved in %lu batches "
+                  "(%.1f per batch)\n", requests, cache_hits, coalesced, solves, batches,
+          batches ? (double)solves / batches : 0);
+  return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fits a custom drag table to doppler radar tracks.
+//
+//   drag-fit [-j threads] [-s stride] [-c drag_coefficient] [-w band_width] table.out track...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "ballistics/ballistics.h"
+
+static void usage(void) {
+  fprintf(stderr, "usage: drag-fit [-j threads] [-s stride] [-c drag_coefficient] [-w band_width] "
+                  "table.out track...\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  int threads = 0;
+  int stride = 8;
+  double drag_coefficient = 1;
+  double band_width = 100;
+  double edges[DRAG_TABLE_MAX_BANDS];
+  int bands = 0;
+  DragTable table;
+  FILE* out;
+  long used;
+  int c;
+
+  while ((c = getopt(argc, argv, "j:s:c:w:")) != -1) {
+    switch (c) {
+      case 'j': threads = atoi(optarg); break;
+      case 's': stride = atoi(optarg); break;
+      case 'c': drag_coefficient = atof(optarg); break;
+      case 'w': band_width = atof(optarg); break;
+      default: usage();
+    }
+  }
+  if (argc - optind < 2 || band_width <= 0) usage();
+
+  // Bands from subsonic up to the fastest small arms projectiles.
+  for (double v = 300; v < 4500 && bands < DRAG_TABLE_MAX_BANDS; v += band_width) {
+    edges[bands++] = v;
+  }
+
+  used = DragFit_fit_files(&table, (const char* const*)&argv[optind + 1], argc - optind - 1, edges, bands,
+                           drag_coefficient, stride, threads);
+  if (used < 0) {
+    fprintf(stderr, "drag-fit: fit failed (%ld)\n", used);
+    return 1;
+  }
+
+  out = fopen(argv[optind], "w");
+  if (!out || DragTable_write(&table, out) || fclose(out)) {
+    fprintf(stderr, "drag-fit: can't write %s\n", argv[optind]);
+    return 1;
+  }
+  fprintf(stderr, "drag-fit: %d bands from %ld decelerations\n", table.count, used);
+  return 0;
+}
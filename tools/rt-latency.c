@@ -0,0 +1,217 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency harness for the real-time loop in ballistics/rt.h.
+//
+//   rt-latency [-n updates] [-r rate_hz] [-m shm_name] [-i idle_us] [-l]
+//
+// A sensor thread pushes updates through a shared-memory channel at rate_hz, cycling through rangefinder,
+// inclinometer, wind and weather readings, while a solver thread polls the channel and publishes a solution for
+// each batch it drains.  Every published solution's latency (from the newest reading it reflects to its publish)
+// and its solve time are recorded in preallocated arrays and summarized at the end.
+//
+// The solver spins while the channel is empty unless idle_us is given, in which case it sleeps that long between
+// empty polls.  -l locks memory and runs both threads SCHED_FIFO, which needs the privilege to do so; run it on
+// an isolated core for numbers worth comparing.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "ballistics/rt.h"
+
+typedef struct {
+  RtChannel* channel;
+  RtSolver solver;
+  int updates;
+  double rate;
+  long idle_us;
+  atomic_int done;
+  long full;           // pushes refused because the solver fell behind
+  long published;
+  double* latencies;   // in microseconds, one per published solution
+  double* solve_times; // likewise
+} Harness;
+
+static void usage(void) {
+  fprintf(stderr, "usage: rt-latency [-n updates] [-r rate_hz] [-m shm_name] [-i idle_us] [-l]\n");
+  exit(2);
+}
+
+static void realtime(void) {
+  struct sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+  if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+    fprintf(stderr, "rt-latency: can't run SCHED_FIFO; continuing without it\n");
+  }
+}
+
+static void* run_sensors(void* arg) {
+  Harness* harness = arg;
+  struct timespec next;
+  long period = (long)(1e9 / harness->rate);
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for (i = 0; i < harness->updates; i++) {
+    RtInput input;
+    memset(&input, 0, sizeof(input));
+
+    switch (i % 4) {
+      case 0:
+        input.fields = RT_INPUT_RANGE;
+        input.range_yards = 300 + (i % 400);
+        break;
+      case 1:
+        input.fields = RT_INPUT_ANGLE;
+        input.shooting_angle = (i % 20) - 10;
+        break;
+      case 2:
+        input.fields = RT_INPUT_WIND;
+        input.wind_speed = 5 + (i % 10);
+        input.wind_angle = 90;
+        break;
+      default:
+        input.fields = RT_INPUT_ATMOSPHERE;
+        input.altitude = 1000;
+        input.barometer = 29.53;
+        input.temperature = 40 + (i % 40);
+        input.relative_humidity = 0.5;
+        break;
+    }
+
+    next.tv_nsec += period;
+    while (next.tv_nsec >= 1000000000) {
+      next.tv_nsec -= 1000000000;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+    input.timestamp_ns = RtChannel_now_ns();
+    if (RtChannel_push(harness->channel, &input)) harness->full++;
+  }
+  atomic_store(&harness->done, 1);
+  return NULL;
+}
+
+static void* run_solver(void* arg) {
+  Harness* harness = arg;
+  struct timespec idle = {0, harness->idle_us * 1000};
+
+  for (;;) {
+    // Read before polling, so the sensors' last update can't slip in between an empty poll and the check.
+    int finished = atomic_load(&harness->done);
+    uint64_t start = RtChannel_now_ns();
+    RtSolution solution;
+
+    if (RtSolver_poll(&harness->solver, harness->channel)) {
+      RtChannel_read(harness->channel, &solution);
+      harness->latencies[harness->published] = (solution.solved_timestamp_ns - solution.input_timestamp_ns) * 1e-3;
+      harness->solve_times[harness->published] = (solution.solved_timestamp_ns - start) * 1e-3;
+      harness->published++;
+    }
+    else if (finished) {
+      break;
+    }
+    else if (harness->idle_us) {
+      nanosleep(&idle, NULL);
+    }
+  }
+  return NULL;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+  double da = *(const double*)a;
+  double db = *(const double*)b;
+  return (da > db) - (da < db);
+}
+
+static void report(const char* name, double* values, long count) {
+  qsort(values, count, sizeof(double), compare_doubles);
+  printf("%s us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", name, values[count / 2],
+         values[(long)(count * 0.99)], values[(long)(count * 0.999)], values[count - 1]);
+}
+
+int main(int argc, char** argv) {
+  const char* name = NULL;
+  int locked = 0;
+  Harness harness;
+  pthread_t sensors, solver;
+  void* memory = NULL;
+  int c;
+
+  memset(&harness, 0, sizeof(harness));
+  harness.updates = 10000;
+  harness.rate = 100;
+  while ((c = getopt(argc, argv, "n:r:m:i:l")) != -1) {
+    switch (c) {
+      case 'n': harness.updates = atoi(optarg); break;
+      case 'r': harness.rate = atof(optarg); break;
+      case 'm': name = optarg; break;
+      case 'i': harness.idle_us = atol(optarg); break;
+      case 'l': locked = 1; break;
+      default: usage();
+    }
+  }
+  if (optind != argc || harness.updates <= 0 || harness.rate <= 0 || harness.idle_us < 0) usage();
+
+  // All allocation happens here, before either loop starts.
+  harness.latencies = calloc(harness.updates, sizeof(double));
+  harness.solve_times = calloc(harness.updates, sizeof(double));
+  if (name) {
+    if (RtChannel_open(&harness.channel, name, 1)) {
+      fprintf(stderr, "rt-latency: can't create shared memory %s\n", name);
+      return 1;
+    }
+  }
+  else if (!posix_memalign(&memory, 64, RtChannel_size())) {
+    harness.channel = RtChannel_init(memory);
+  }
+  if (!harness.latencies || !harness.solve_times || !harness.channel) {
+    fprintf(stderr, "rt-latency: out of memory\n");
+    return 1;
+  }
+  RtSolver_init(&harness.solver, G7, 0.243, 2750, 1.5, 100);
+
+  if (locked) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE)) fprintf(stderr, "rt-latency: can't lock memory; continuing\n");
+    realtime();
+  }
+  pthread_create(&solver, NULL, run_solver, &harness);
+  pthread_create(&sensors, NULL, run_sensors, &harness);
+  pthread_join(sensors, NULL);
+  pthread_join(solver, NULL);
+
+  printf("%d updates at %.0f Hz: %ld solutions published, %ld updates refused\n", harness.updates, harness.rate,
+         harness.published, harness.full);
+  if (harness.published) {
+    report("latency", harness.latencies, harness.published);
+    report("solve", harness.solve_times, harness.published);
+  }
+
+  if (name) {
+    RtChannel_close(harness.channel);
+    RtChannel_unlink(name);
+  }
+  free(memory);
+  return 0;
+}
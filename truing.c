@@ -0,0 +1,221 @@
+/**
+ * Copyright 2017 William Grim
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ballistics/ballistics.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#define TRUING_MAX_ITERATIONS 50
+#define TRUING_MAX_PARAMETERS 2
+
+/**
+ * Everything an evaluation of the model needs, allocated once per Truing_solve().
+ */
+typedef struct {
+  const TruingObservation* observations;
+  int count;
+  DragFunction drag_function;
+  double sight_height;
+  double shooting_angle;
+  double zero_range;
+  double y_intercept;
+
+  BallisticsTarget* targets;
+} Truing;
+
+/**
+ * Computes the residuals (observed - predicted) for a drag coefficient and muzzle velocity.
+ * @return the sum of squared residuals, or -1 if the model can't reach every observation.
+ */
+static double Truing_residuals(Truing* truing, double drag_coefficient, double vi, double* residuals) {
+  double angle;
+  double sse=0;
+  int i;
+
+  if (drag_coefficient<=0 || vi<=0) return -1;
+  if (zero_angles(&angle, truing->drag_function, drag_coefficient, vi, truing->sight_height, &truing->zero_range,
+                  &truing->y_intercept, 1)) {
+    return -1;
+  }
+
+  if (Ballistics_solve_targets(truing->targets, truing->count, truing->drag_function, drag_coefficient, vi,
+                               truing->sight_height, truing->shooting_angle, angle, 0, 0) < truing->count) {
+    return -1;
+  }
+
+  for (i=0;i<truing->count;i++) {
+    residuals[i]=truing->observations[i].path_inches-truing->targets[i].path_inches;
+    sse+=residuals[i]*residuals[i];
+  }
+  return sse;
+}
+
+int Truing_solve(double* drag_coefficient, double* vi, double* rms_inches, int fit,
+                 const TruingObservation* observations, int count, DragFunction drag_function, double sight_height,
+                 double shooting_angle, double zero_range, double y_intercept) {
+  Truing truing;
+  double scale[TRUING_MAX_PARAMETERS];
+  double p[TRUING_MAX_PARAMETERS];     // parameters, relative to their starting values
+  int fitted[TRUING_MAX_PARAMETERS];   // which of the parameters are being fitted
+  double* residuals;
+  double* trial;
+  double* jacobian[TRUING_MAX_PARAMETERS];
+  double lambda=1e-3;
+  double sse;
+  int iteration;
+  int converged=0;
+  int n=0;
+  int i, j;
+
+  if (count<=0 || !(fit & (TRUING_FIT_DRAG_COEFFICIENT|TRUING_FIT_VELOCITY))) return TRUING_E_NO_OBSERVATIONS;
+
+  truing.observations=observations;
+  truing.count=count;
+  truing.drag_function=drag_function;
+  truing.sight_height=sight_height;
+  truing.shooting_angle=shooting_angle;
+  truing.zero_range=zero_range;
+  truing.y_intercept=y_intercept;
+
+  // One block holds the targets, the residuals, a trial set of residuals, and a Jacobian column per parameter.
+  truing.targets=malloc(sizeof(BallisticsTarget)*count + sizeof(double)*count*(2+TRUING_MAX_PARAMETERS));
+  if (!truing.targets) return TRUING_E_NO_MEMORY;
+  BALLISTICS_STATS_BEGIN(BALLISTICS_PHASE_TRUING);
+  residuals=(double*)(truing.targets+count);
+  trial=residuals+count;
+  for (j=0;j<TRUING_MAX_PARAMETERS;j++) {
+    jacobian[j]=trial+count*(j+1);
+  }
+  for (i=0;i<count;i++) {
+    truing.targets[i].range_yards=observations[i].range_yards;
+  }
+
+  // Work in parameters scaled to their starting values so both are of order 1.
+  scale[0]=*drag_coefficient;
+  scale[1]=*vi;
+  fitted[0]=(fit & TRUING_FIT_DRAG_COEFFICIENT)!=0;
+  fitted[1]=(fit & TRUING_FIT_VELOCITY)!=0;
+  p[0]=1;
+  p[1]=1;
+
+  sse=Truing_residuals(&truing, scale[0]*p[0], scale[1]*p[1], residuals);
+  if (sse<0) {
+    free(truing.targets);
+    BALLISTICS_STATS_END(BALLISTICS_PHASE_TRUING);
+    return TRUING_E_OUT_OF_RANGE;
+  }
+
+  for (iteration=0;iteration<TRUING_MAX_ITERATIONS && !converged;iteration++) {
+    double jtj[TRUING_MAX_PARAMETERS][TRUING_MAX_PARAMETERS]={{0}};
+    double jtr[TRUING_MAX_PARAMETERS]={0};
+
+    BALLISTICS_STATS_ITERATION();
+
+    // Forward-difference Jacobian of the residuals.
+    for (j=0;j<TRUING_MAX_PARAMETERS;j++) {
+      double h=1e-5;
+      double q[TRUING_MAX_PARAMETERS]={p[0], p[1]};
+      if (!fitted[j]) continue;
+      q[j]+=h;
+      if (Truing_residuals(&truing, scale[0]*q[0], scale[1]*q[1], trial)<0) {
+        h=-h;
+        q[j]=p[j]+h;
+        if (Truing_residuals(&truing, scale[0]*q[0], scale[1]*q[1], trial)<0) {
+          free(truing.targets);
+          BALLISTICS_STATS_END(BALLISTICS_PHASE_TRUING);
+          return TRUING_E_OUT_OF_RANGE;
+        }
+      }
+      for (i=0;i<count;i++) {
+        jacobian[j][i]=(trial[i]-residuals[i])/h;
+      }
+    }
+
+    for (j=0;j<TRUING_MAX_PARAMETERS;j++) {
+      int k;
+      if (!fitted[j]) continue;
+      for (k=0;k<TRUING_MAX_PARAMETERS;k++) {
+        if (!fitted[k]) continue;
+        for (i=0;i<count;i++) jtj[j][k]+=jacobian[j][i]*jacobian[k][i];
+      }
+      for (i=0;i<count;i++) jtr[j]+=jacobian[j][i]*residuals[i];
+    }
+
+    // Increase the damping until a step reduces the error.
+    for (;;) {
+      double a[TRUING_MAX_PARAMETERS][TRUING_MAX_PARAMETERS];
+      double step[TRUING_MAX_PARAMETERS]={0, 0};
+      double q[TRUING_MAX_PARAMETERS];
+      double trial_sse;
+
+      for (j=0;j<TRUING_MAX_PARAMETERS;j++) {
+        int k;
+        for (k=0;k<TRUING_MAX_PARAMETERS;k++) a[j][k]=jtj[j][k];
+        a[j][j]+=lambda*(jtj[j][j]>0 ? jtj[j][j] : 1);
+      }
+
+      // The residuals are observed - predicted, so the step solves (JtJ + lambda*D) step = -Jt r.
+      if (fitted[0] && fitted[1]) {
+        double det=a[0][0]*a[1][1]-a[0][1]*a[1][0];
+        if (det!=0) {
+          step[0]=-(a[1][1]*jtr[0]-a[0][1]*jtr[1])/det;
+          step[1]=-(a[0][0]*jtr[1]-a[1][0]*jtr[0])/det;
+        }
+      }
+      else {
+        j=fitted[0] ? 0 : 1;
+        step[j]=-jtr[j]/a[j][j];
+      }
+
+      q[0]=p[0]+step[0];
+      q[1]=p[1]+step[1];
+      trial_sse=Truing_residuals(&truing, scale[0]*q[0], scale[1]*q[1], trial);
+
+      if (trial_sse>=0 && trial_sse<=sse) {
+        double* swap=residuals;
+        residuals=trial;
+        trial=swap;
+        converged=fabs(step[0])<1e-7 && fabs(step[1])<1e-7;
+        converged|=sse-trial_sse<=1e-12*sse;
+        p[0]=q[0];
+        p[1]=q[1];
+        sse=trial_sse;
+        lambda/=10;
+        break;
+      }
+
+      lambda*=10;
+      if (lambda>1e10) {
+        // No step makes it any better: we're at the minimum as far as the model can tell.
+        converged=1;
+        break;
+      }
+    }
+    n=iteration+1;
+  }
+
+  // residuals and trial may have been swapped; the block always starts at the targets.
+  free(truing.targets);
+  BALLISTICS_STATS_END(BALLISTICS_PHASE_TRUING);
+
+  if (!converged) return TRUING_E_NO_CONVERGENCE;
+
+  *drag_coefficient=scale[0]*p[0];
+  *vi=scale[1]*p[1];
+  if (rms_inches) *rms_inches=sqrt(sse/count);
+  return n;
+}